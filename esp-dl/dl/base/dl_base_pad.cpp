@@ -16,25 +16,26 @@ std::vector<int> get_pad_shape(const std::vector<int> &shape, const std::vector<
     return output_shape;
 }
 
+/**
+ * @brief Pad a row, without the vectors of pad1D() for the rows of pad2D().
+ */
 template <typename T>
-void pad1D(T *input_element,
-           T *output_element,
-           const std::vector<int> input_shape,
-           const std::vector<int> pads,
-           const padding_mode_t mode,
-           const T const_value)
+static inline void pad_row(T *input_element,
+                           T *output_element,
+                           const int input_len,
+                           const int left,
+                           const int right,
+                           const padding_mode_t mode,
+                           const T const_value)
 {
-    int input_len = input_shape[0];
-    int left = pads[0];
-    int right = pads[1];
     int right_start = left + input_len;
     tool::copy_memory(output_element + left, input_element, input_len * sizeof(T));
     if (mode == PADDING_CONSTANT) {
-        for (int i = 0; i < left; i++) {
-            output_element[i] = const_value;
+        if (left > 0) {
+            tool::set_value<T>(output_element, const_value, left);
         }
-        for (int i = 0; i < right; i++) {
-            output_element[i + right_start] = const_value;
+        if (right > 0) {
+            tool::set_value<T>(output_element + right_start, const_value, right);
         }
     } else if (mode == PADDING_EDGE) {
         for (int i = 0; i < left; i++) {
@@ -62,6 +63,17 @@ void pad1D(T *input_element,
     }
 }
 
+template <typename T>
+void pad1D(T *input_element,
+           T *output_element,
+           const std::vector<int> input_shape,
+           const std::vector<int> pads,
+           const padding_mode_t mode,
+           const T const_value)
+{
+    pad_row<T>(input_element, output_element, input_shape[0], pads[0], pads[1], mode, const_value);
+}
+
 template void pad1D(int8_t *input_element,
                     int8_t *output_element,
                     const std::vector<int> input_shape,
@@ -256,10 +268,15 @@ void pad2D(T *input_element,
     int input_offset = input_shape[1];
     T *output_ptr = output_element + pad_head * output_offset;
     T *input_prt = input_element;
-    for (int i = 0; i < input_shape[0]; i++) {
-        pad1D(input_prt, output_ptr, {input_offset}, {left, right}, mode, const_value);
-        input_prt += input_offset;
-        output_ptr += output_offset;
+    if (left == 0 && right == 0) {
+        // the rows are contiguous in the output
+        tool::copy_memory(output_ptr, input_prt, input_shape[0] * input_offset * sizeof(T));
+    } else {
+        for (int i = 0; i < input_shape[0]; i++) {
+            pad_row<T>(input_prt, output_ptr, input_offset, left, right, mode, const_value);
+            input_prt += input_offset;
+            output_ptr += output_offset;
+        }
     }
 
     pad_head_and_tail<T>(
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "dl_define.hpp"
+#include <stdint.h>
+
+namespace dl {
+namespace math {
+/**
+ * @brief Decode DFL (Distribution Focal Loss) box regression directly from quantized logits.
+ *
+ * The softmax of a side is evaluated as exp(-(max - q) * scale), where max - q is the distance to the largest logit
+ * in the quantized domain. exp() is read from a Q16 lookup table built for the tensor exponent, wide int16 distances
+ * index the table with a shift and linear interpolation. The expectation is accumulated in integers, one division per
+ * side is left.
+ */
+class DFLDecoder {
+private:
+    static const int s_lut_size = 256; /*!< number of table steps, one extra entry is stored for interpolation */
+    int m_reg_max;                     /*!< number of bins of each side */
+    int m_exponent;                    /*!< exponent the table is built for */
+    int m_max_distance;                /*!< largest logit distance of the data type the table is built for */
+    int m_shift;                       /*!< distance >> m_shift is the table index */
+    uint32_t m_lut[s_lut_size + 1];    /*!< Q16 exp(-distance * scale) */
+
+    inline uint32_t exp_lut(int distance) const
+    {
+        int index = distance >> m_shift;
+        if (index >= s_lut_size) {
+            return 0;
+        }
+        int frac = distance & ((1 << m_shift) - 1);
+        return m_lut[index] - (((m_lut[index] - m_lut[index + 1]) * frac) >> m_shift);
+    }
+
+public:
+    /**
+     * @brief Construct a new DFLDecoder object.
+     *
+     * @param reg_max number of bins of each side, 16 for YOLO11.
+     */
+    DFLDecoder(const int reg_max = 16);
+
+    /**
+     * @brief Rebuild the exp table if the exponent of the box tensor changes. Call it once per stage.
+     *
+     * @tparam T        int8_t or int16_t
+     * @param exponent  exponent of the box tensor
+     */
+    template <typename T>
+    void set_exponent(const int exponent);
+
+    /**
+     * @brief Decode one side.
+     *
+     * @param logits reg_max quantized logits
+     * @return expected distance in bins, in [0, reg_max - 1]
+     */
+    template <typename T>
+    float decode_side(const T *logits) const
+    {
+        int max_logit = logits[0];
+        for (int i = 1; i < m_reg_max; i++) {
+            max_logit = DL_MAX(max_logit, (int)logits[i]);
+        }
+
+        uint32_t sum = 0;
+        uint32_t weighted_sum = 0;
+        for (int i = 0; i < m_reg_max; i++) {
+            uint32_t e = exp_lut(max_logit - logits[i]);
+            sum += e;
+            weighted_sum += e * i;
+        }
+        return (float)weighted_sum / sum;
+    }
+
+    /**
+     * @brief Decode the four sides [left, top, right, bottom] of a box.
+     *
+     * @param logits    4 * reg_max quantized logits
+     * @param distance  output, 4 distances in bins
+     */
+    template <typename T>
+    void decode(const T *logits, float *distance) const
+    {
+        for (int i = 0; i < 4; i++) {
+            distance[i] = decode_side(logits + i * m_reg_max);
+        }
+    }
+};
+} // namespace math
+} // namespace dl
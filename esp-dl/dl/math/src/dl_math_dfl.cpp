@@ -0,0 +1,36 @@
+#include "dl_math_dfl.hpp"
+#include <cmath>
+#include <limits>
+
+namespace dl {
+namespace math {
+DFLDecoder::DFLDecoder(const int reg_max) : m_reg_max(reg_max), m_exponent(0), m_max_distance(0), m_shift(0)
+{
+}
+
+template <typename T>
+void DFLDecoder::set_exponent(const int exponent)
+{
+    int max_distance = std::numeric_limits<T>::max() - std::numeric_limits<T>::min();
+    if (exponent == m_exponent && max_distance == m_max_distance) {
+        return;
+    }
+    m_exponent = exponent;
+    m_max_distance = max_distance;
+
+    // exp(-distance * scale) is below one Q16 step beyond 17 * ln(2) / scale, the table only needs to cover that.
+    float scale = DL_SCALE(exponent);
+    int range = DL_MIN((float)max_distance, ceilf(17.f * logf(2.f) / scale));
+    m_shift = 0;
+    while ((range >> m_shift) >= s_lut_size) {
+        m_shift++;
+    }
+    for (int i = 0; i <= s_lut_size; i++) {
+        m_lut[i] = (uint32_t)roundf(expf(-(float)(i << m_shift) * scale) * 65536.f);
+    }
+}
+
+template void DFLDecoder::set_exponent<int8_t>(const int exponent);
+template void DFLDecoder::set_exponent<int16_t>(const int exponent);
+} // namespace math
+} // namespace dl
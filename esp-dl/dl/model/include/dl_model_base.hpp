@@ -40,6 +40,24 @@ namespace dl {
 // currently only support MEMORY_MANAGER_GREEDY
 typedef enum { MEMORY_MANAGER_GREEDY = 0, LINEAR_MEMORY_MANAGER = 1 } memory_manager_t;
 
+/**
+ * @brief A model input which reads a streaming window, see Model::bind_streaming_input().
+ */
+typedef struct {
+    TensorBase *input;  /*!< The model input */
+    TensorBase *window; /*!< The bound window, its data pointer may move between runs */
+    void *input_data;   /*!< The planned data of the model input */
+} streaming_input_t;
+
+/**
+ * @brief A streaming cache of the model, see Model::bind_streaming_cache().
+ */
+typedef struct {
+    TensorBase *input;  /*!< The model input of the cache of the last run */
+    TensorBase *output; /*!< The model output of the new cache */
+    TensorBase *buffer; /*!< The buffer shared by input and output, nullptr if output is copied to input */
+} streaming_cache_t;
+
 /**
  * @brief Neural Network Model.
  */
@@ -58,6 +76,31 @@ private:
     size_t m_internal_size;                        /*!< Internal RAM usage */
     size_t m_psram_size;                           /*!< PSRAM usage */
 
+    std::vector<streaming_input_t> m_streaming_inputs;     /*!< Inputs bound to streaming windows */
+    std::vector<streaming_cache_t> m_streaming_caches;     /*!< Streaming caches kept between runs */
+    std::vector<dl::module::Module *> m_streaming_modules; /*!< Modules keeping streaming state between runs */
+    bool m_streaming_skipped = false;                      /*!< Runs were skipped since the last run */
+
+    /**
+     * @brief Whether a model input is bound to a streaming window.
+     */
+    bool is_streaming_input(TensorBase *input);
+
+    /**
+     * @brief Point the bound inputs to their windows before the modules run.
+     */
+    void streaming_begin();
+
+    /**
+     * @brief Restore the bound inputs and update the copied caches after the modules ran.
+     */
+    void streaming_end();
+
+    /**
+     * @brief Drop all streaming bindings and free the cache buffers.
+     */
+    void clear_streaming();
+
 public:
     Model() {}
 
@@ -259,7 +302,8 @@ public:
     /**
      * @brief Run the model module by module.
      *
-     * @param input  The model input.
+     * @param input  The model input. If the input is bound by bind_streaming_input(), the run takes the window and
+     *               ignores it.
      * @param mode   Runtime mode.
      */
     virtual void run(TensorBase *input, runtime_mode_t mode = RUNTIME_MODE_SINGLE_CORE);
@@ -277,6 +321,74 @@ public:
                      runtime_mode_t mode = RUNTIME_MODE_SINGLE_CORE,
                      std::map<std::string, TensorBase *> user_outputs = {});
 
+    /**
+     * @brief Bind a model input to a streaming window, e.g. a TensorBase fed by push() with enable_ring_buffer(). Every
+     * run() takes this input from the current data of window: without a copy if window has the dtype, exponent and
+     * size of the input and its data is aligned to 16 bytes, otherwise window is assigned to the input. The data given
+     * for a bound input to run(input) or run(user_inputs) is ignored.
+     *
+     * @param name    The name of the model input
+     * @param window  The window tensor, it must outlive the model or be unbound by passing nullptr
+     * @return
+     *      - ESP_OK               Success
+     *      - ESP_ERR_INVALID_ARG  The input is not found or the size of window doesn't match
+     */
+    esp_err_t bind_streaming_input(const std::string &name, TensorBase *window);
+
+    /**
+     * @brief Keep a streaming cache of the model between runs. input_cache_name is the model input which takes the
+     * cache of the last run, output_cache_name the model output of the new cache. If every module reading the input
+     * cache runs before the module writing the output cache, both share one buffer outside the memory plan and the
+     * cache is updated in place by the model. Otherwise the output cache is copied to the input cache after each run.
+     * The cache starts with zeros.
+     *
+     * @param input_cache_name   The name of the model input of the cache
+     * @param output_cache_name  The name of the model output of the cache
+     * @param share_buffer       Set to false to copy the output cache after each run even if the buffer could be shared
+     * @return
+     *      - ESP_OK               Success
+     *      - ESP_ERR_INVALID_ARG  The tensors are not found or their shape, dtype or exponent don't match
+     *      - ESP_ERR_NO_MEM       Failed to allocate the cache buffer
+     */
+    esp_err_t bind_streaming_cache(const std::string &input_cache_name,
+                                   const std::string &output_cache_name,
+                                   bool share_buffer = true);
+
+    /**
+     * @brief Let a module keep state between runs of a streaming model whose input window moves by hop frames along
+     * axis 1 between two runs. A Conv module then computes only the output frames which read the new frames or the
+     * padding, and takes the others from its output of the last run, the outputs are the same as without it. The
+     * window must really move by hop frames between runs, call reset_streaming_cache() when it doesn't.
+     * A GRU or LSTM module, whose sequence is axis 0, runs only the last hop frames from its states of the last run,
+     * its outputs are the same as running once over the whole stream.
+     * The modules listed in the metadata prop "streaming_hops" of the model, e.g. "conv_0:4,conv_1:2", are bound by
+     * build().
+     *
+     * @param node_name  The name of the node in the model graph
+     * @param hop        New frames of the input of the module per run, 0 unbinds the module
+     * @return
+     *      - ESP_OK                 Success
+     *      - ESP_ERR_NOT_FOUND      The node is not found
+     *      - ESP_ERR_NOT_SUPPORTED  The module keeps no streaming state
+     *      - ESP_ERR_INVALID_ARG    The module can't run with this hop
+     *      - ESP_ERR_NO_MEM         Failed to allocate the state
+     */
+    esp_err_t bind_streaming_module(const std::string &node_name, int hop);
+
+    /**
+     * @brief Zero the streaming caches and drop the state of the streaming modules, e.g. before a new utterance.
+     */
+    void reset_streaming_cache();
+
+    /**
+     * @brief Skip the run of a step of a streaming model, e.g. when dl_vad_check() found no activity in the new
+     * frames. The streaming caches keep their values of the last run, and the bound windows keep receiving frames.
+     * The streaming modules can't reuse their state once a window moved by more than hop frames, so the next run
+     * drops it like reset_streaming_cache() without zeroing the caches: a Conv module computes the whole window, a GRU
+     * or LSTM module runs the whole window from the initial states.
+     */
+    void skip_run();
+
     /**
      * @brief Minimize the model.
      */
@@ -4,6 +4,7 @@
 #include "dl_model_base.hpp"
 #include "dl_module_creator.hpp"
 #include "fbs_model.hpp"
+#include <algorithm>
 #include <format>
 
 static const char *TAG = "dl::Model";
@@ -90,6 +91,7 @@ Model::~Model()
         }
     }
 
+    this->clear_streaming();
     if (m_model_context) {
         delete m_model_context;
     }
@@ -186,6 +188,7 @@ esp_err_t Model::load(fbs::FbsModel *fbs_model)
 void Model::build(size_t max_internal_size, memory_manager_t mm_type, bool preload)
 {
     // If memory manager has been created, delete it and reset all modules
+    this->clear_streaming();
     m_fbs_model->load_map();
     MemoryManagerBase *memory_manager = nullptr;
 
@@ -211,12 +214,28 @@ void Model::build(size_t max_internal_size, memory_manager_t mm_type, bool prelo
         m_outputs.emplace(outputs_tmp[i], output_tensor);
     }
 
+    // modules listed as "name:hop,name:hop" run as streaming modules
+    std::string streaming_hops = this->get_metadata_prop("streaming_hops");
+    size_t begin = 0;
+    while (begin < streaming_hops.size()) {
+        size_t end = streaming_hops.find(',', begin);
+        end = end == std::string::npos ? streaming_hops.size() : end;
+        std::string item = streaming_hops.substr(begin, end - begin);
+        size_t colon = item.rfind(':');
+        if (colon == std::string::npos ||
+            this->bind_streaming_module(item.substr(0, colon), atoi(item.c_str() + colon + 1)) != ESP_OK) {
+            ESP_LOGW(TAG, "Failed to bind the streaming module %s, run it on the whole input.", item.c_str());
+        }
+        begin = end + 1;
+    }
+
     m_fbs_model->clear_map();
     delete memory_manager;
 }
 
 void Model::run(runtime_mode_t mode)
 {
+    this->streaming_begin();
     // execute each module.
     for (int i = 0; i < m_execution_plan.size(); i++) {
         dl::module::Module *module = m_execution_plan[i];
@@ -226,6 +245,7 @@ void Model::run(runtime_mode_t mode)
             break;
         }
     }
+    this->streaming_end();
 }
 
 void Model::run(TensorBase *input, runtime_mode_t mode)
@@ -235,7 +255,11 @@ void Model::run(TensorBase *input, runtime_mode_t mode)
     }
 
     TensorBase *model_input = m_inputs.begin()->second;
-    if (!model_input->assign(input)) {
+    if (this->is_streaming_input(model_input)) {
+        ESP_LOGW(TAG,
+                 "The input %s is bound to a streaming window, run the model on the window.",
+                 m_inputs.begin()->first.c_str());
+    } else if (!model_input->assign(input)) {
         ESP_LOGE(TAG, "Assign input failed");
         return;
     }
@@ -265,6 +289,12 @@ void Model::run(std::map<std::string, TensorBase *> &user_inputs,
             return;
         }
         TensorBase *graph_input_tensor = graph_input_iter->second;
+        if (this->is_streaming_input(graph_input_tensor)) {
+            ESP_LOGW(TAG,
+                     "The input %s is bound to a streaming window, run the model on the window.",
+                     user_input_name.c_str());
+            continue;
+        }
         if (!graph_input_tensor->assign(user_input_tensor)) {
             ESP_LOGE(TAG, "Assign input failed");
             return;
@@ -272,6 +302,7 @@ void Model::run(std::map<std::string, TensorBase *> &user_inputs,
     }
 
     // execute each module.
+    this->streaming_begin();
     for (int i = 0; i < m_execution_plan.size(); i++) {
         dl::module::Module *module = m_execution_plan[i];
         if (module) {
@@ -297,9 +328,196 @@ void Model::run(std::map<std::string, TensorBase *> &user_inputs,
             break;
         }
     }
+    this->streaming_end();
     return;
 }
 
+esp_err_t Model::bind_streaming_input(const std::string &name, TensorBase *window)
+{
+    auto input_iter = m_inputs.find(name);
+    if (input_iter == m_inputs.end()) {
+        ESP_LOGE(TAG, "%s not found in inputs.", name.c_str());
+        return ESP_ERR_INVALID_ARG;
+    }
+    TensorBase *input = input_iter->second;
+    for (auto it = m_streaming_inputs.begin(); it != m_streaming_inputs.end(); it++) {
+        if (it->input == input) {
+            m_streaming_inputs.erase(it);
+            break;
+        }
+    }
+    if (!window) {
+        return ESP_OK;
+    }
+    if (window->get_size() != input->get_size()) {
+        ESP_LOGE(TAG,
+                 "The size of window(%d) doesn't match input %s(%d).",
+                 window->get_size(),
+                 name.c_str(),
+                 input->get_size());
+        return ESP_ERR_INVALID_ARG;
+    }
+    m_streaming_inputs.push_back({input, window, input->data});
+    return ESP_OK;
+}
+
+esp_err_t Model::bind_streaming_cache(const std::string &input_cache_name,
+                                     const std::string &output_cache_name,
+                                     bool share_buffer)
+{
+    auto input_iter = m_inputs.find(input_cache_name);
+    auto output_iter = m_outputs.find(output_cache_name);
+    if (input_iter == m_inputs.end() || output_iter == m_outputs.end()) {
+        ESP_LOGE(TAG,
+                 "%s not found in inputs or %s not found in outputs.",
+                 input_cache_name.c_str(),
+                 output_cache_name.c_str());
+        return ESP_ERR_INVALID_ARG;
+    }
+    TensorBase *input = input_iter->second;
+    TensorBase *output = output_iter->second;
+    if (input->get_shape() != output->get_shape() || input->get_dtype() != output->get_dtype() ||
+        input->get_exponent() != output->get_exponent()) {
+        ESP_LOGE(TAG, "The cache %s doesn't match %s.", output_cache_name.c_str(), input_cache_name.c_str());
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // The cache can be updated in place if the input cache is no longer read when the output cache is written.
+    int input_index = m_model_context->get_tensor_index(const_cast<std::string &>(input_cache_name));
+    int output_index = m_model_context->get_tensor_index(const_cast<std::string &>(output_cache_name));
+    int last_reader = -1;
+    int writer = -1;
+    for (int i = 0; i < m_execution_plan.size() && m_execution_plan[i]; i++) {
+        dl::module::Module *module = m_execution_plan[i];
+        if (std::find(module->m_inputs_index.begin(), module->m_inputs_index.end(), input_index) !=
+            module->m_inputs_index.end()) {
+            last_reader = i;
+        }
+        if (std::find(module->m_outputs_index.begin(), module->m_outputs_index.end(), output_index) !=
+            module->m_outputs_index.end()) {
+            writer = i;
+        }
+    }
+
+    TensorBase *buffer = nullptr;
+    if (share_buffer && writer > last_reader) {
+        buffer = new TensorBase(
+            input->get_shape(), nullptr, input->get_exponent(), input->get_dtype(), true, input->get_caps());
+        if (!buffer->data) {
+            delete buffer;
+            return ESP_ERR_NO_MEM;
+        }
+        input->set_element_ptr(buffer->data);
+        output->set_element_ptr(buffer->data);
+    } else {
+        if (share_buffer) {
+            ESP_LOGW(TAG,
+                     "The cache %s is read after %s is written, copy it after each run.",
+                     input_cache_name.c_str(),
+                     output_cache_name.c_str());
+        }
+        tool::set_zero(input->data, input->get_bytes());
+    }
+    m_streaming_caches.push_back({input, output, buffer});
+    return ESP_OK;
+}
+
+esp_err_t Model::bind_streaming_module(const std::string &node_name, int hop)
+{
+    // the execution plan follows the topological sort of the nodes
+    std::vector<std::string> sorted_nodes = m_fbs_model->topological_sort();
+    auto node_iter = std::find(sorted_nodes.begin(), sorted_nodes.end(), node_name);
+    if (node_iter == sorted_nodes.end() || sorted_nodes.size() != m_execution_plan.size()) {
+        ESP_LOGE(TAG, "%s not found in the model.", node_name.c_str());
+        return ESP_ERR_NOT_FOUND;
+    }
+    dl::module::Module *module = m_execution_plan[node_iter - sorted_nodes.begin()];
+    esp_err_t ret = module->set_streaming(m_model_context, hop);
+    auto module_iter = std::find(m_streaming_modules.begin(), m_streaming_modules.end(), module);
+    if (ret == ESP_OK && hop > 0) {
+        if (module_iter == m_streaming_modules.end()) {
+            m_streaming_modules.push_back(module);
+        }
+    } else if (module_iter != m_streaming_modules.end()) {
+        m_streaming_modules.erase(module_iter);
+    }
+    return ret;
+}
+
+void Model::reset_streaming_cache()
+{
+    for (auto &cache : m_streaming_caches) {
+        tool::set_zero(cache.input->data, cache.input->get_bytes());
+    }
+    for (auto module : m_streaming_modules) {
+        module->reset_streaming();
+    }
+}
+
+void Model::skip_run()
+{
+    m_streaming_skipped = true;
+}
+
+bool Model::is_streaming_input(TensorBase *input)
+{
+    for (auto &binding : m_streaming_inputs) {
+        if (binding.input == input) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Model::streaming_begin()
+{
+    if (m_streaming_skipped) {
+        for (auto module : m_streaming_modules) {
+            module->reset_streaming();
+        }
+        m_streaming_skipped = false;
+    }
+    for (auto &binding : m_streaming_inputs) {
+        TensorBase *window = binding.window;
+        if (window->get_dtype() == binding.input->get_dtype() &&
+            window->get_exponent() == binding.input->get_exponent() && ((uintptr_t)window->data & 0xf) == 0) {
+            binding.input->set_element_ptr(window->data);
+        } else {
+            binding.input->set_element_ptr(binding.input_data);
+            binding.input->assign(window);
+        }
+    }
+}
+
+void Model::streaming_end()
+{
+    // restore the planned data, so the bound inputs can still be assigned by the user
+    for (auto &binding : m_streaming_inputs) {
+        binding.input->set_element_ptr(binding.input_data);
+    }
+    for (auto &cache : m_streaming_caches) {
+        if (!cache.buffer) {
+            cache.input->assign(cache.output);
+        }
+    }
+}
+
+void Model::clear_streaming()
+{
+    for (auto &cache : m_streaming_caches) {
+        if (cache.buffer) {
+            delete cache.buffer;
+        }
+    }
+    m_streaming_caches.clear();
+    m_streaming_inputs.clear();
+    for (auto module : m_streaming_modules) {
+        module->set_streaming(m_model_context, 0);
+    }
+    m_streaming_modules.clear();
+    m_streaming_skipped = false;
+}
+
 std::map<std::string, TensorBase *> &Model::get_inputs()
 {
     return m_inputs;
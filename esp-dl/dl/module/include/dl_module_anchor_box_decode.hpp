@@ -0,0 +1,153 @@
+#pragma once
+
+#include "dl_module_base.hpp"
+
+namespace dl {
+namespace module {
+/**
+ * @brief: Anchor box decoding of one detection stage, ESP-DL custom operator.
+ *         Input is [N, H, W, A * 4] offsets of [x1, y1, x2, y2] relative to the size of each of the A anchor boxes
+ *         centered on the cell. Output is [N, H * W * A, 4] float boxes [x1, y1, x2, y2] in model input pixels.
+ *         Supports float, int16_t and int8_t input.
+ */
+class AnchorBoxDecode : public Module {
+private:
+    int m_stride_y;                  /*!< stride of the stage in height */
+    int m_stride_x;                  /*!< stride of the stage in width */
+    int m_offset_y;                  /*!< center of the first cell in height */
+    int m_offset_x;                  /*!< center of the first cell in width */
+    std::vector<int> m_anchor_shape; /*!< [h0, w0, h1, w1, ...] of the anchor boxes */
+
+public:
+    /**
+     * @brief Construct a new AnchorBoxDecode object.
+     *
+     * @param name            name of module
+     * @param stride_y        stride of the stage in height
+     * @param stride_x        stride of the stage in width
+     * @param offset_y        center of the first cell in height
+     * @param offset_x        center of the first cell in width
+     * @param anchor_shape    [h0, w0, h1, w1, ...] of the anchor boxes
+     * @param inplace         inplace type.
+     * @param quant_type      quantization type.
+     */
+    AnchorBoxDecode(const char *name,
+                    int stride_y,
+                    int stride_x,
+                    int offset_y,
+                    int offset_x,
+                    const std::vector<int> &anchor_shape,
+                    module_inplace_t inplace = MODULE_NON_INPLACE,
+                    quant_type_t quant_type = QUANT_TYPE_NONE) :
+        Module(name, inplace, quant_type),
+        m_stride_y(stride_y),
+        m_stride_x(stride_x),
+        m_offset_y(offset_y),
+        m_offset_x(offset_x),
+        m_anchor_shape(anchor_shape)
+    {
+        assert(m_anchor_shape.size() > 0 && m_anchor_shape.size() % 2 == 0);
+    }
+
+    /**
+     * @brief Destroy the AnchorBoxDecode object.
+     */
+    ~AnchorBoxDecode() {}
+
+    std::vector<std::vector<int>> get_output_shape(std::vector<std::vector<int>> &input_shapes)
+    {
+        int A = m_anchor_shape.size() / 2;
+        assert(input_shapes[0].size() == 4 && input_shapes[0][3] == A * 4);
+        std::vector<int> output_shape = {input_shapes[0][0], input_shapes[0][1] * input_shapes[0][2] * A, 4};
+        return std::vector<std::vector<int>>(1, output_shape);
+    }
+
+    void forward(ModelContext *context, runtime_mode_t mode = RUNTIME_MODE_AUTO)
+    {
+        TensorBase *input = context->get_tensor(m_inputs_index[0]);
+        TensorBase *output = context->get_tensor(m_outputs_index[0]);
+        assert(output->get_dtype() == DATA_TYPE_FLOAT);
+
+        // the input of a quantized node may still be float, e.g. the output of DFL
+        if (input->get_dtype() == DATA_TYPE_INT8) {
+            forward_template<int8_t>(input, output, DL_SCALE(input->exponent));
+        } else if (input->get_dtype() == DATA_TYPE_INT16) {
+            forward_template<int16_t>(input, output, DL_SCALE(input->exponent));
+        } else if (input->get_dtype() == DATA_TYPE_FLOAT) {
+            forward_template<float>(input, output, 1.f);
+        } else {
+            ESP_LOGE("AnchorBoxDecode", "Unsupported input dtype: %s", dtype_to_string(input->get_dtype()));
+        }
+    }
+
+    template <typename T>
+    void forward_template(TensorBase *input, TensorBase *output, float scale)
+    {
+        int N = input->get_shape()[0];
+        int H = input->get_shape()[1];
+        int W = input->get_shape()[2];
+        int A = m_anchor_shape.size() / 2;
+        T *input_ptr = (T *)input->get_element_ptr();
+        float *output_ptr = (float *)output->get_element_ptr();
+
+        for (int n = 0; n < N; n++) {
+            for (int y = 0; y < H; y++) {
+                int center_y = y * m_stride_y + m_offset_y;
+                for (int x = 0; x < W; x++) {
+                    int center_x = x * m_stride_x + m_offset_x;
+                    for (int a = 0; a < A; a++) {
+                        int anchor_h = m_anchor_shape[2 * a];
+                        int anchor_w = m_anchor_shape[2 * a + 1];
+                        float scale_h = anchor_h * scale;
+                        float scale_w = anchor_w * scale;
+                        output_ptr[0] = center_x - (anchor_w >> 1) + input_ptr[0] * scale_w;
+                        output_ptr[1] = center_y - (anchor_h >> 1) + input_ptr[1] * scale_h;
+                        output_ptr[2] = center_x + anchor_w - (anchor_w >> 1) + input_ptr[2] * scale_w;
+                        output_ptr[3] = center_y + anchor_h - (anchor_h >> 1) + input_ptr[3] * scale_h;
+                        input_ptr += 4;
+                        output_ptr += 4;
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief deserialize AnchorBoxDecode module instance by node serialization information
+     */
+    static Module *deserialize(fbs::FbsModel *fbs_model, std::string node_name)
+    {
+        Module *op = nullptr;
+        quant_type_t quant_type;
+        int stride_y = 8;
+        int stride_x = 8;
+        int offset_y = 4;
+        int offset_x = 4;
+        std::vector<int> anchor_shape;
+        fbs_model->get_operation_attribute(node_name, "quant_type", quant_type);
+        fbs_model->get_operation_attribute(node_name, "stride_y", stride_y);
+        fbs_model->get_operation_attribute(node_name, "stride_x", stride_x);
+        fbs_model->get_operation_attribute(node_name, "offset_y", offset_y);
+        fbs_model->get_operation_attribute(node_name, "offset_x", offset_x);
+        fbs_model->get_operation_attribute(node_name, "anchor_shape", anchor_shape);
+
+        // Create module
+        op = new AnchorBoxDecode(
+            node_name.c_str(), stride_y, stride_x, offset_y, offset_x, anchor_shape, MODULE_NON_INPLACE, quant_type);
+        return op;
+    }
+
+    void print()
+    {
+        ESP_LOGI("AnchorBoxDecode",
+                 "quant_type: %s, stride: (%d, %d), offset: (%d, %d), anchor num: %d.",
+                 quant_type_to_string(quant_type),
+                 m_stride_y,
+                 m_stride_x,
+                 m_offset_y,
+                 m_offset_x,
+                 (int)m_anchor_shape.size() / 2);
+    }
+};
+} // namespace module
+} // namespace dl
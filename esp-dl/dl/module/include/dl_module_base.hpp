@@ -122,6 +122,26 @@ public:
         this->m_outputs_index.clear();
     }
 
+    /**
+     * @brief Keep state between runs of a streaming model whose inputs move by hop frames along the temporal axis
+     * (axis 1, axis 0 for GRU and LSTM) between two runs, e.g. to compute only the new frames. See
+     * Model::bind_streaming_module().
+     *
+     * @param context  Model context with the planned tensors
+     * @param hop      New input frames per run, 0 drops the state
+     * @return
+     *      - ESP_OK                 Success
+     *      - ESP_ERR_NOT_SUPPORTED  The module keeps no streaming state
+     *      - ESP_ERR_INVALID_ARG    The module can't run with this hop
+     *      - ESP_ERR_NO_MEM         Failed to allocate the state
+     */
+    virtual esp_err_t set_streaming(ModelContext *context, int hop) { return ESP_ERR_NOT_SUPPORTED; }
+
+    /**
+     * @brief Drop the streaming state, the next run starts like the first one.
+     */
+    virtual void reset_streaming() {}
+
     /**
      * @brief Run the module with single input and single output
      *
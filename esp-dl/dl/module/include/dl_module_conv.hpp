@@ -3,6 +3,7 @@
 #include "dl_base_conv2d.hpp"
 #include "dl_base_depthwise_conv2d.hpp"
 #include "dl_module_base.hpp"
+#include <algorithm>
 #include <typeinfo>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -22,6 +23,10 @@ private:
     activation_type_t activation; /*!< activation of Conv, if you don't specify anything, no activation is applied */
     std::vector<int> m_pads;      /*!< pads size needed in [top, bottom, left, right] of this operation */
     bool is_bias_reseted;
+    int m_stream_hop;             /*!< new input frames per run in streaming mode, 0 if disabled */
+    int m_stream_reuse[2];        /*!< [begin, end) of the output frames taken from the last run */
+    TensorBase *m_stream_output;  /*!< output of the last run in streaming mode */
+    bool m_stream_valid;          /*!< whether m_stream_output holds the output of the last run */
 
     void reset_bias(ModelContext *context)
     {
@@ -63,13 +68,21 @@ public:
         m_pads(pads)
     {
         is_bias_reseted = false;
+        m_stream_hop = 0;
+        m_stream_output = nullptr;
+        m_stream_valid = false;
     }
 
     /**
      * @brief Destroy the Conv object.
      *
      */
-    ~Conv() {}
+    ~Conv()
+    {
+        if (m_stream_output) {
+            delete m_stream_output;
+        }
+    }
 
     /**
      * @brief Calculate the output shape
@@ -140,10 +153,78 @@ public:
         }
         TensorBase *output = context->get_tensor(m_outputs_index[0]);
 
+        if (!m_stream_hop) {
+            forward_frames<T>(input, filter, bias, output, 0, output->shape[1], mode);
+            return;
+        }
+
+        // The input moved by m_stream_hop frames since the last run, so the output moved by m_stream_hop / stride
+        // frames. Only the frames whose receptive field contains new frames or padding are computed again.
+        int begin = m_stream_reuse[0];
+        int end = m_stream_reuse[1];
+        if (m_stream_valid) {
+            size_t frame_bytes = output->get_bytes() / output->shape[1];
+            int shift = m_stream_hop / m_strides[0];
+            tool::copy_memory((int8_t *)output->data + begin * frame_bytes,
+                              (int8_t *)m_stream_output->data + (begin + shift) * frame_bytes,
+                              (end - begin) * frame_bytes);
+            forward_frames<T>(input, filter, bias, output, 0, begin, mode);
+            forward_frames<T>(input, filter, bias, output, end, output->shape[1], mode);
+        } else {
+            forward_frames<T>(input, filter, bias, output, 0, output->shape[1], mode);
+            m_stream_valid = true;
+        }
+        tool::copy_memory(m_stream_output->data, output->data, output->get_bytes());
+    }
+
+    /**
+     * @brief Compute the output frames [begin, end) along axis 1 from the input frames they depend on.
+     */
+    template <typename T>
+    void forward_frames(TensorBase *input,
+                        TensorBase *filter,
+                        TensorBase *bias,
+                        TensorBase *output,
+                        int begin,
+                        int end,
+                        runtime_mode_t mode)
+    {
+        if (begin >= end) {
+            return;
+        }
+        TensorBase *input_frames = input;
+        TensorBase *output_frames = output;
+        std::vector<int> pads = m_pads;
+        int input_len = input->shape[1];
+        if (begin != 0 || end != output->shape[1]) {
+            // input frames [first, last) of output frames [begin, end), out of range frames are padding
+            int first = begin * m_strides[0] - m_pads[0];
+            int last = (end - 1) * m_strides[0] - m_pads[0] + m_dilations[0] * (filter->shape[0] - 1) + 1;
+            pads[0] = std::max(-first, 0);
+            pads[1] = std::max(last - input_len, 0);
+            first = std::max(first, 0);
+            last = std::min(last, input_len);
+
+            std::vector<int> shape = input->shape;
+            shape[1] = last - first;
+            input_frames = new TensorBase(shape,
+                                          (T *)input->data + first * (input->get_size() / input_len),
+                                          input->exponent,
+                                          input->dtype,
+                                          false);
+            shape = output->shape;
+            shape[1] = end - begin;
+            output_frames = new TensorBase(shape,
+                                           (T *)output->data + begin * (output->get_size() / output->shape[1]),
+                                           output->exponent,
+                                           output->dtype,
+                                           false);
+        }
+
         std::vector<base::ArgsType<T>> m_args =
-            base::get_conv_operation_args<T>(output,
-                                             input,
-                                             m_pads,
+            base::get_conv_operation_args<T>(output_frames,
+                                             input_frames,
+                                             pads,
                                              filter,
                                              m_strides,
                                              m_dilations,
@@ -160,8 +241,59 @@ public:
         } else {
             ESP_LOGE("Conv", "Only support task size is 1 or 2, currently task size is %d", task_size);
         }
+
+        if (input_frames != input) {
+            delete input_frames;
+            delete output_frames;
+        }
     }
 
+    esp_err_t set_streaming(ModelContext *context, int hop)
+    {
+        if (m_stream_output) {
+            delete m_stream_output;
+            m_stream_output = nullptr;
+        }
+        m_stream_hop = 0;
+        m_stream_valid = false;
+        if (hop <= 0) {
+            return ESP_OK;
+        }
+
+        TensorBase *input = context->get_tensor(m_inputs_index[0]);
+        TensorBase *filter = context->get_tensor(m_inputs_index[1]);
+        TensorBase *output = context->get_tensor(m_outputs_index[0]);
+        if (hop % m_strides[0]) {
+            ESP_LOGE("Conv", "The hop %d is not a multiple of the stride %d.", hop, m_strides[0]);
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        // An output frame of this run equals the output frame shift later of the last run, if the receptive fields
+        // of both are inside the input. The first frames read the top padding and the last frames the new input.
+        int input_len = input->shape[1];
+        int receptive = m_dilations[0] * (filter->shape[0] - 1) + 1;
+        int begin = (m_pads[0] + m_strides[0] - 1) / m_strides[0];
+        int end = input_len - hop + m_pads[0] - receptive;
+        end = end < 0 ? 0 : end / m_strides[0] + 1;
+        if (begin >= end) {
+            ESP_LOGE("Conv", "No output frame can be kept with the hop %d and the input length %d.", hop, input_len);
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        m_stream_output = new TensorBase(output->shape, nullptr, output->exponent, output->dtype, true, output->caps);
+        if (!m_stream_output->data) {
+            delete m_stream_output;
+            m_stream_output = nullptr;
+            return ESP_ERR_NO_MEM;
+        }
+        m_stream_hop = hop;
+        m_stream_reuse[0] = begin;
+        m_stream_reuse[1] = end;
+        return ESP_OK;
+    }
+
+    void reset_streaming() { m_stream_valid = false; }
+
     /**
      * @brief deserialize Conv module instance by node serialization information
      */
@@ -1,9 +1,12 @@
 #pragma once
 #include "dl_module_add.hpp"
+#include "dl_module_anchor_box_decode.hpp"
+#include "dl_module_anchor_point_decode.hpp"
 #include "dl_module_average_pool.hpp"
 #include "dl_module_clip.hpp"
 #include "dl_module_concat.hpp"
 #include "dl_module_conv.hpp"
+#include "dl_module_dfl.hpp"
 #include "dl_module_div.hpp"
 #include "dl_module_elu.hpp"
 #include "dl_module_equal.hpp"
@@ -14,6 +17,7 @@
 #include "dl_module_global_average_pool.hpp"
 #include "dl_module_greater.hpp"
 #include "dl_module_greater_or_equal.hpp"
+#include "dl_module_gru.hpp"
 #include "dl_module_hard_sigmoid.hpp"
 #include "dl_module_hard_swish.hpp"
 #include "dl_module_identity.hpp"
@@ -21,10 +25,12 @@
 #include "dl_module_less.hpp"
 #include "dl_module_less_or_equal.hpp"
 #include "dl_module_log.hpp"
+#include "dl_module_lstm.hpp"
 #include "dl_module_lut.hpp"
 #include "dl_module_matmul.hpp"
 #include "dl_module_max_pool.hpp"
 #include "dl_module_mul.hpp"
+#include "dl_module_non_max_suppression.hpp"
 #include "dl_module_pad.hpp"
 #include "dl_module_prelu.hpp"
 #include "dl_module_relu.hpp"
@@ -152,6 +158,12 @@ public:
             this->register_module("LessOrEqual", LessOrEqual::deserialize);
             this->register_module("ReverseSequence", ReverseSequence::deserialize);
             this->register_module("Identity", Identity::deserialize);
+            this->register_module("NonMaxSuppression", NonMaxSuppression::deserialize);
+            this->register_module("DFL", DFL::deserialize);
+            this->register_module("GRU", GRU::deserialize);
+            this->register_module("LSTM", LSTM::deserialize);
+            this->register_module("AnchorPointDecode", AnchorPointDecode::deserialize);
+            this->register_module("AnchorBoxDecode", AnchorBoxDecode::deserialize);
         }
     }
 
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "dl_math.hpp"
+#include "dl_math_dfl.hpp"
+#include "dl_module_base.hpp"
+
+namespace dl {
+namespace module {
+/**
+ * @brief: DFL (Distribution Focal Loss) box regression decoding, ESP-DL custom operator.
+ *         Input is [..., 4 * reg_max] logits of [left, top, right, bottom], output is [..., 4] float distances in bins.
+ *         Supports float, int16_t and int8_t input, the quantized input is decoded without dequantizing it.
+ */
+class DFL : public Module {
+private:
+    int m_reg_max;              /*!< number of bins of each side */
+    math::DFLDecoder m_decoder; /*!< quantized decoder */
+
+public:
+    /**
+     * @brief Construct a new DFL object.
+     *
+     * @param name            name of module
+     * @param reg_max         number of bins of each side
+     * @param inplace         inplace type.
+     * @param quant_type      quantization type.
+     */
+    DFL(const char *name = NULL,
+        int reg_max = 16,
+        module_inplace_t inplace = MODULE_NON_INPLACE,
+        quant_type_t quant_type = QUANT_TYPE_NONE) :
+        Module(name, inplace, quant_type), m_reg_max(reg_max), m_decoder(reg_max)
+    {
+    }
+
+    /**
+     * @brief Destroy the DFL object.
+     */
+    ~DFL() {}
+
+    std::vector<std::vector<int>> get_output_shape(std::vector<std::vector<int>> &input_shapes)
+    {
+        assert(input_shapes[0].back() == 4 * m_reg_max);
+        std::vector<int> output_shape = input_shapes[0];
+        output_shape.back() = 4;
+        return std::vector<std::vector<int>>(1, output_shape);
+    }
+
+    void forward(ModelContext *context, runtime_mode_t mode = RUNTIME_MODE_AUTO)
+    {
+        TensorBase *input = context->get_tensor(m_inputs_index[0]);
+        TensorBase *output = context->get_tensor(m_outputs_index[0]);
+        assert(output->get_dtype() == DATA_TYPE_FLOAT);
+
+        if (input->get_dtype() == DATA_TYPE_INT8) {
+            forward_template<int8_t>(input, output);
+        } else if (input->get_dtype() == DATA_TYPE_INT16) {
+            forward_template<int16_t>(input, output);
+        } else if (input->get_dtype() == DATA_TYPE_FLOAT) {
+            float *input_ptr = (float *)input->get_element_ptr();
+            float *output_ptr = (float *)output->get_element_ptr();
+            int boxes = input->get_size() / (4 * m_reg_max);
+            std::vector<float> side(m_reg_max);
+            for (int i = 0; i < boxes * 4; i++) {
+                memcpy(side.data(), input_ptr + i * m_reg_max, m_reg_max * sizeof(float));
+                output_ptr[i] = math::dfl_integral(side.data(), m_reg_max - 1);
+            }
+        } else {
+            ESP_LOGE("DFL", "Unsupported input dtype: %s", dtype_to_string(input->get_dtype()));
+        }
+    }
+
+    template <typename T>
+    void forward_template(TensorBase *input, TensorBase *output)
+    {
+        T *input_ptr = (T *)input->get_element_ptr();
+        float *output_ptr = (float *)output->get_element_ptr();
+        int boxes = input->get_size() / (4 * m_reg_max);
+
+        m_decoder.set_exponent<T>(input->exponent);
+        for (int i = 0; i < boxes; i++) {
+            m_decoder.decode(input_ptr, output_ptr);
+            input_ptr += 4 * m_reg_max;
+            output_ptr += 4;
+        }
+    }
+
+    /**
+     * @brief deserialize DFL module instance by node serialization information
+     */
+    static Module *deserialize(fbs::FbsModel *fbs_model, std::string node_name)
+    {
+        Module *op = nullptr;
+        quant_type_t quant_type;
+        int reg_max = 16;
+        fbs_model->get_operation_attribute(node_name, "quant_type", quant_type);
+        fbs_model->get_operation_attribute(node_name, "reg_max", reg_max);
+
+        // Create module
+        op = new DFL(node_name.c_str(), reg_max, MODULE_NON_INPLACE, quant_type);
+        return op;
+    }
+
+    void print() { ESP_LOGI("DFL", "quant_type: %s, reg_max: %d.", quant_type_to_string(quant_type), m_reg_max); }
+};
+} // namespace module
+} // namespace dl
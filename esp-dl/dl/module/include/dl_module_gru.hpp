@@ -0,0 +1,102 @@
+#pragma once
+
+#include "dl_module_rnn.hpp"
+
+namespace dl {
+namespace module {
+/**
+ * @brief: https://onnx.ai/onnx/operators/onnx__GRU.html
+ *         Outputs are Y [seq_length, 1, batch_size, hidden_size] and Y_h [1, batch_size, hidden_size]. The gates are
+ *         in the order z, r, h like ONNX. Only linear_before_reset = 1 is supported, the default of PyTorch:
+ *             z = sigmoid(x * Wz + h * Rz + Wbz + Rbz)
+ *             r = sigmoid(x * Wr + h * Rr + Wbr + Rbr)
+ *             n = tanh(x * Wh + Wbh + r (.) (h * Rh + Rbh))
+ *             h = (1 - z) (.) n + z (.) h
+ *         See RNN for the layout of the weights and the streaming mode.
+ */
+class GRU : public RNN {
+private:
+    template <typename T>
+    void step_template(const int32_t *gates_x, const int32_t *gates_h, int batch_size)
+    {
+        int hidden_size = m_hidden_size;
+        int32_t *h = m_states;
+        for (int b = 0; b < batch_size; b++) {
+            const int32_t *x = gates_x + b * 3 * hidden_size;
+            const int32_t *g = gates_h + b * 3 * hidden_size;
+            for (int j = 0; j < hidden_size; j++) {
+                int32_t z = lookup<T>(m_sigmoid, x[j] + g[j]);
+                int32_t r = lookup<T>(m_sigmoid, x[hidden_size + j] + g[hidden_size + j]);
+                int32_t n_gate = x[2 * hidden_size + j] + tool::shift_and_round(r * g[2 * hidden_size + j], 15);
+                int32_t n = lookup<T>(m_tanh, n_gate);
+                h[j] = n + tool::shift_and_round(z * (h[j] - n), 15);
+            }
+            h += hidden_size;
+        }
+    }
+
+    void step(const int32_t *gates_x, const int32_t *gates_h, int batch_size)
+    {
+        if (quant_type == QUANT_TYPE_SYMM_8BIT) {
+            step_template<int8_t>(gates_x, gates_h, batch_size);
+        } else {
+            step_template<int16_t>(gates_x, gates_h, batch_size);
+        }
+    }
+
+public:
+    /**
+     * @brief Construct a new GRU object.
+     *
+     * @param name            name of module
+     * @param hidden_size     number of neurons in the hidden layer
+     * @param gate_exponent   exponent of the gates, -4 for int8 and -11 for int16 cover [-8, 8) and [-16, 16)
+     * @param quant_type      quantize type.
+     */
+    GRU(const char *name = NULL,
+        int hidden_size = 1,
+        int gate_exponent = -4,
+        quant_type_t quant_type = QUANT_TYPE_NONE) :
+        RNN(name, hidden_size, 3, 1, gate_exponent, quant_type)
+    {
+    }
+
+    /**
+     * @brief Destroy the GRU object.
+     */
+    ~GRU() {}
+
+    /**
+     * @brief deserialize GRU module instance by node serialization information
+     */
+    static Module *deserialize(fbs::FbsModel *fbs_model, std::string node_name)
+    {
+        Module *op = nullptr;
+        int hidden_size = 0;
+        int gate_exponent = 0;
+        int linear_before_reset = 0;
+        quant_type_t quant_type;
+        fbs_model->get_operation_attribute(node_name, "linear_before_reset", linear_before_reset);
+        if (linear_before_reset != 1) {
+            ESP_LOGE("GRU", "%s: only linear_before_reset = 1 is supported.", node_name.c_str());
+            return nullptr;
+        }
+
+        // Create module
+        if (deserialize_attributes(fbs_model, node_name, 3, hidden_size, gate_exponent, quant_type)) {
+            op = new GRU(node_name.c_str(), hidden_size, gate_exponent, quant_type);
+        }
+        return op;
+    }
+
+    void print()
+    {
+        ESP_LOGI("GRU",
+                 "hidden_size: %d, gate_exponent: %d, quant_type: %s.",
+                 m_hidden_size,
+                 m_gate_exponent,
+                 quant_type_to_string(quant_type));
+    }
+};
+} // namespace module
+} // namespace dl
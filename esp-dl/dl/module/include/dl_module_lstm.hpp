@@ -0,0 +1,105 @@
+#pragma once
+
+#include "dl_module_rnn.hpp"
+
+namespace dl {
+namespace module {
+/**
+ * @brief: https://onnx.ai/onnx/operators/onnx__LSTM.html
+ *         Outputs are Y [seq_length, 1, batch_size, hidden_size], Y_h and Y_c [1, batch_size, hidden_size]. The gates
+ *         are in the order i, o, f, c like ONNX, peepholes P and clip are not supported:
+ *             i = sigmoid(x * Wi + h * Ri + Wbi + Rbi)
+ *             o = sigmoid(x * Wo + h * Ro + Wbo + Rbo)
+ *             f = sigmoid(x * Wf + h * Rf + Wbf + Rbf)
+ *             g = tanh(x * Wc + h * Rc + Wbc + Rbc)
+ *             c = f (.) c + i (.) g
+ *             h = o (.) tanh(c)
+ *         See RNN for the layout of the weights and the streaming mode.
+ */
+class LSTM : public RNN {
+private:
+    template <typename T>
+    void step_template(const int32_t *gates_x, const int32_t *gates_h, int batch_size)
+    {
+        int hidden_size = m_hidden_size;
+        int32_t *h = m_states;
+        int32_t *c = m_states + batch_size * hidden_size;
+        // c in Q15 to the exponent of the gates
+        int c_shift = 15 + m_gate_exponent;
+        for (int b = 0; b < batch_size; b++) {
+            const int32_t *x = gates_x + b * 4 * hidden_size;
+            const int32_t *g = gates_h + b * 4 * hidden_size;
+            for (int j = 0; j < hidden_size; j++) {
+                int64_t i_gate = lookup<T>(m_sigmoid, x[j] + g[j]);
+                int32_t o_gate = lookup<T>(m_sigmoid, x[hidden_size + j] + g[hidden_size + j]);
+                int64_t f_gate = lookup<T>(m_sigmoid, x[2 * hidden_size + j] + g[2 * hidden_size + j]);
+                int64_t c_gate = lookup<T>(m_tanh, x[3 * hidden_size + j] + g[3 * hidden_size + j]);
+                int64_t cell = tool::shift_and_round(f_gate * c[j] + i_gate * c_gate, 15);
+                c[j] = DL_CLIP(cell, INT32_MIN >> 1, INT32_MAX >> 1);
+                int32_t tanh_c = lookup<T>(m_tanh, tool::shift_and_round(c[j], c_shift));
+                h[j] = tool::shift_and_round(o_gate * tanh_c, 15);
+            }
+            h += hidden_size;
+            c += hidden_size;
+        }
+    }
+
+    void step(const int32_t *gates_x, const int32_t *gates_h, int batch_size)
+    {
+        if (quant_type == QUANT_TYPE_SYMM_8BIT) {
+            step_template<int8_t>(gates_x, gates_h, batch_size);
+        } else {
+            step_template<int16_t>(gates_x, gates_h, batch_size);
+        }
+    }
+
+public:
+    /**
+     * @brief Construct a new LSTM object.
+     *
+     * @param name            name of module
+     * @param hidden_size     number of neurons in the hidden layer
+     * @param gate_exponent   exponent of the gates, -4 for int8 and -11 for int16 cover [-8, 8) and [-16, 16)
+     * @param quant_type      quantize type.
+     */
+    LSTM(const char *name = NULL,
+         int hidden_size = 1,
+         int gate_exponent = -4,
+         quant_type_t quant_type = QUANT_TYPE_NONE) :
+        RNN(name, hidden_size, 4, 2, gate_exponent, quant_type)
+    {
+    }
+
+    /**
+     * @brief Destroy the LSTM object.
+     */
+    ~LSTM() {}
+
+    /**
+     * @brief deserialize LSTM module instance by node serialization information
+     */
+    static Module *deserialize(fbs::FbsModel *fbs_model, std::string node_name)
+    {
+        Module *op = nullptr;
+        int hidden_size = 0;
+        int gate_exponent = 0;
+        quant_type_t quant_type;
+
+        // Create module
+        if (deserialize_attributes(fbs_model, node_name, 4, hidden_size, gate_exponent, quant_type)) {
+            op = new LSTM(node_name.c_str(), hidden_size, gate_exponent, quant_type);
+        }
+        return op;
+    }
+
+    void print()
+    {
+        ESP_LOGI("LSTM",
+                 "hidden_size: %d, gate_exponent: %d, quant_type: %s.",
+                 m_hidden_size,
+                 m_gate_exponent,
+                 quant_type_to_string(quant_type));
+    }
+};
+} // namespace module
+} // namespace dl
@@ -0,0 +1,268 @@
+#pragma once
+
+#include "dl_module_base.hpp"
+#include <algorithm>
+
+namespace dl {
+namespace module {
+/**
+ * @brief: https://onnx.ai/onnx/operators/onnx__NonMaxSuppression.html
+ *         Inputs are boxes [B, N, 4] and scores [B, C, N]. max_output_boxes_per_class, iou_threshold and
+ *         score_threshold must be constant. Supports float, int16_t and int8_t boxes and scores.
+ *         IoU does not depend on the order of the axes, so [x1, y1, x2, y2] boxes of AnchorPointDecode and
+ *         AnchorBoxDecode can be used with center_point_box = 0.
+ *
+ * NOTE: The output [B * C * max_output_boxes_per_class, 3] of (batch_index, class_index, box_index) has a static
+ *       shape, the rows after the selected boxes are filled with -1.
+ */
+class NonMaxSuppression : public Module {
+private:
+    int m_center_point_box;           /*!< 0: boxes are [y1, x1, y2, x2], 1: boxes are [x_center, y_center, w, h] */
+    int m_max_output_boxes_per_class; /*!< max number of boxes selected per batch per class */
+    float m_iou_threshold;            /*!< boxes with higher IoU than it are suppressed */
+    float m_score_threshold;          /*!< boxes with lower or equal score are removed */
+    bool m_has_score_threshold;       /*!< whether score_threshold is given */
+    std::vector<float> m_boxes;       /*!< [x1, y1, x2, y2] of the boxes of one batch */
+    std::vector<float> m_scores;      /*!< scores of one batch */
+    std::vector<int> m_order;         /*!< candidates of one class sorted by score */
+    std::vector<int> m_selected;      /*!< selected boxes of one class */
+
+    template <typename T>
+    static void load(TensorBase *tensor, int offset, int size, float *dst)
+    {
+        T *src = (T *)tensor->get_element_ptr() + offset;
+        float scale = std::is_same<T, float>::value ? 1.f : DL_SCALE(tensor->exponent);
+        for (int i = 0; i < size; i++) {
+            dst[i] = src[i] * scale;
+        }
+    }
+
+    static void load_float(TensorBase *tensor, int offset, int size, float *dst)
+    {
+        if (tensor->get_dtype() == DATA_TYPE_INT8) {
+            load<int8_t>(tensor, offset, size, dst);
+        } else if (tensor->get_dtype() == DATA_TYPE_INT16) {
+            load<int16_t>(tensor, offset, size, dst);
+        } else {
+            load<float>(tensor, offset, size, dst);
+        }
+    }
+
+    bool suppress(const float *a, const float *b)
+    {
+        float inter_w = DL_MIN(a[2], b[2]) - DL_MAX(a[0], b[0]);
+        float inter_h = DL_MIN(a[3], b[3]) - DL_MAX(a[1], b[1]);
+        if (inter_w <= 0 || inter_h <= 0) {
+            return false;
+        }
+        float area_a = (a[2] - a[0]) * (a[3] - a[1]);
+        float area_b = (b[2] - b[0]) * (b[3] - b[1]);
+        float inter_area = inter_w * inter_h;
+        float union_area = area_a + area_b - inter_area;
+        if (area_a <= 0 || area_b <= 0 || union_area <= 0) {
+            return false;
+        }
+        return inter_area > m_iou_threshold * union_area;
+    }
+
+    template <typename T>
+    void forward_template(TensorBase *boxes, TensorBase *scores, TensorBase *output)
+    {
+        int B = boxes->get_shape()[0];
+        int N = boxes->get_shape()[1];
+        int C = scores->get_shape()[1];
+        T *output_ptr = (T *)output->get_element_ptr();
+        int rows = output->get_shape()[0];
+        int count = 0;
+
+        m_boxes.resize(N * 4);
+        m_scores.resize(C * N);
+        for (int b = 0; b < B; b++) {
+            load_float(boxes, b * N * 4, N * 4, m_boxes.data());
+            load_float(scores, b * C * N, C * N, m_scores.data());
+
+            // Convert to [x1, y1, x2, y2] with x1 <= x2 and y1 <= y2.
+            for (int i = 0; i < N; i++) {
+                float *box = m_boxes.data() + i * 4;
+                float x1, y1, x2, y2;
+                if (m_center_point_box) {
+                    x1 = box[0] - box[2] / 2;
+                    y1 = box[1] - box[3] / 2;
+                    x2 = box[0] + box[2] / 2;
+                    y2 = box[1] + box[3] / 2;
+                } else {
+                    x1 = DL_MIN(box[1], box[3]);
+                    y1 = DL_MIN(box[0], box[2]);
+                    x2 = DL_MAX(box[1], box[3]);
+                    y2 = DL_MAX(box[0], box[2]);
+                }
+                box[0] = x1;
+                box[1] = y1;
+                box[2] = x2;
+                box[3] = y2;
+            }
+
+            for (int c = 0; c < C; c++) {
+                const float *score = m_scores.data() + c * N;
+                m_order.clear();
+                for (int i = 0; i < N; i++) {
+                    if (!m_has_score_threshold || score[i] > m_score_threshold) {
+                        m_order.push_back(i);
+                    }
+                }
+                std::stable_sort(
+                    m_order.begin(), m_order.end(), [score](int a, int b) -> bool { return score[a] > score[b]; });
+
+                // Greedy selection, each candidate is only compared with the boxes selected so far.
+                m_selected.clear();
+                for (int i : m_order) {
+                    if ((int)m_selected.size() >= m_max_output_boxes_per_class) {
+                        break;
+                    }
+                    const float *box = m_boxes.data() + i * 4;
+                    bool suppressed = false;
+                    for (int j : m_selected) {
+                        if (suppress(m_boxes.data() + j * 4, box)) {
+                            suppressed = true;
+                            break;
+                        }
+                    }
+                    if (!suppressed) {
+                        m_selected.push_back(i);
+                    }
+                }
+
+                for (int i : m_selected) {
+                    if (count >= rows) {
+                        break;
+                    }
+                    output_ptr[count * 3] = b;
+                    output_ptr[count * 3 + 1] = c;
+                    output_ptr[count * 3 + 2] = i;
+                    count++;
+                }
+            }
+        }
+
+        for (int i = count * 3; i < rows * 3; i++) {
+            output_ptr[i] = -1;
+        }
+    }
+
+public:
+    /**
+     * @brief Construct a new NonMaxSuppression object.
+     *
+     * @param name                        name of module
+     * @param max_output_boxes_per_class  max number of boxes selected per batch per class
+     * @param iou_threshold               boxes with higher IoU than it are suppressed
+     * @param score_threshold             boxes with lower or equal score are removed, only if has_score_threshold
+     * @param has_score_threshold         whether score_threshold is given
+     * @param center_point_box            0: boxes are [y1, x1, y2, x2], 1: boxes are [x_center, y_center, w, h]
+     * @param quant_type                  quantization type.
+     */
+    NonMaxSuppression(const char *name = NULL,
+                      int max_output_boxes_per_class = 0,
+                      float iou_threshold = 0,
+                      float score_threshold = 0,
+                      bool has_score_threshold = false,
+                      int center_point_box = 0,
+                      quant_type_t quant_type = QUANT_TYPE_NONE) :
+        Module(name, MODULE_NON_INPLACE, quant_type),
+        m_center_point_box(center_point_box),
+        m_max_output_boxes_per_class(max_output_boxes_per_class),
+        m_iou_threshold(iou_threshold),
+        m_score_threshold(score_threshold),
+        m_has_score_threshold(has_score_threshold)
+    {
+    }
+
+    /**
+     * @brief Destroy the NonMaxSuppression object.
+     */
+    ~NonMaxSuppression() {}
+
+    std::vector<std::vector<int>> get_output_shape(std::vector<std::vector<int>> &input_shapes)
+    {
+        assert(input_shapes[0].size() == 3 && input_shapes[1].size() == 3);
+        assert(input_shapes[0][1] == input_shapes[1][2]);
+        int rows = input_shapes[0][0] * input_shapes[1][1] * m_max_output_boxes_per_class;
+        std::vector<int> output_shape = {DL_MAX(rows, 1), 3};
+        return std::vector<std::vector<int>>(1, output_shape);
+    }
+
+    void forward(ModelContext *context, runtime_mode_t mode = RUNTIME_MODE_AUTO)
+    {
+        TensorBase *boxes = context->get_tensor(m_inputs_index[0]);
+        TensorBase *scores = context->get_tensor(m_inputs_index[1]);
+        TensorBase *output = context->get_tensor(m_outputs_index[0]);
+
+        if (output->get_dtype() == DATA_TYPE_INT64) {
+            forward_template<int64_t>(boxes, scores, output);
+        } else if (output->get_dtype() == DATA_TYPE_INT32) {
+            forward_template<int32_t>(boxes, scores, output);
+        } else {
+            ESP_LOGE("NonMaxSuppression", "Unsupported output dtype: %s", dtype_to_string(output->get_dtype()));
+        }
+    }
+
+    /**
+     * @brief deserialize NonMaxSuppression module instance by node serialization information
+     */
+    static Module *deserialize(fbs::FbsModel *fbs_model, std::string node_name)
+    {
+        Module *op = nullptr;
+        quant_type_t quant_type;
+        int center_point_box = 0;
+        int max_output_boxes_per_class = 0;
+        float iou_threshold = 0;
+        float score_threshold = 0;
+        bool has_score_threshold = false;
+        fbs_model->get_operation_attribute(node_name, "quant_type", quant_type);
+        fbs_model->get_operation_attribute(node_name, "center_point_box", center_point_box);
+
+        // The optional inputs decide the output shape, so they must be constant.
+        TensorBase *param = fbs_model->get_operation_parameter(node_name, 2);
+        if (param) {
+            if (param->get_dtype() == DATA_TYPE_INT64) {
+                max_output_boxes_per_class = param->get_element<int64_t>(0);
+            } else {
+                max_output_boxes_per_class = param->get_element<int32_t>(0);
+            }
+            delete param;
+        }
+        param = fbs_model->get_operation_parameter(node_name, 3);
+        if (param) {
+            iou_threshold = param->get_element<float>(0);
+            delete param;
+        }
+        param = fbs_model->get_operation_parameter(node_name, 4);
+        if (param) {
+            score_threshold = param->get_element<float>(0);
+            has_score_threshold = true;
+            delete param;
+        }
+
+        // Create module
+        op = new NonMaxSuppression(node_name.c_str(),
+                                   max_output_boxes_per_class,
+                                   iou_threshold,
+                                   score_threshold,
+                                   has_score_threshold,
+                                   center_point_box,
+                                   quant_type);
+        return op;
+    }
+
+    void print()
+    {
+        ESP_LOGI("NonMaxSuppression",
+                 "quant_type: %s, max_output_boxes_per_class: %d, iou_threshold: %f, score_threshold: %f.",
+                 quant_type_to_string(quant_type),
+                 m_max_output_boxes_per_class,
+                 m_iou_threshold,
+                 m_score_threshold);
+    }
+};
+} // namespace module
+} // namespace dl
@@ -0,0 +1,481 @@
+#pragma once
+
+#include "dl_base_conv2d.hpp"
+#include "dl_module_base.hpp"
+#include <math.h>
+
+namespace dl {
+namespace module {
+/**
+ * @brief Base of the GRU and LSTM modules, https://onnx.ai/onnx/operators/onnx__GRU.html and
+ *        https://onnx.ai/onnx/operators/onnx__LSTM.html. Supports int8_t and int16_t, forward direction and layout 0.
+ *
+ * Inputs are X [seq_length, batch_size, input_size], W, R, B, sequence_lens, initial_h (and initial_c).
+ * The weights of all gates are fused into one Gemm filter each, in the gate order of ONNX:
+ *   - W [1, 1, input_size, num_gates * hidden_size], X at its own exponent
+ *   - R [1, 1, hidden_size, num_gates * hidden_size], h at exponent -7 for int8 and -15 for int16
+ *   - B [1, 2 * num_gates * hidden_size], optional, the bias of W then the bias of R, int32 for int8 and int64 for
+ *     int16 like a Gemm bias. Both halves are moved to the exponent of their accumulator when the module first runs.
+ * Other layouts, e.g. the ONNX W [1, num_gates * hidden_size, input_size], are rejected by check_inputs(). No
+ * exporter emits this layout yet, W and R have to be fused and packed like the filters of a Gemm for the target.
+ * X * W of the whole sequence is one Gemm, h * R one Gemm per step. Both output the gates at gate_exponent, then the
+ * gates go through the sigmoid / tanh tables and the states are updated in Q15. sequence_lens is not supported.
+ *
+ * Without streaming every run starts from initial_h (and initial_c) or zeros. With Model::bind_streaming_module() the
+ * states are kept between runs: a run takes the last hop frames of X as new frames and continues from the states of
+ * the last run. Model::reset_streaming_cache() starts again from the initial states.
+ */
+class RNN : public Module {
+protected:
+    int m_hidden_size;        /*!< number of neurons in the hidden layer */
+    int m_num_gates;          /*!< 3 for GRU, 4 for LSTM */
+    int m_num_states;         /*!< h for GRU, h and c for LSTM */
+    int m_gate_exponent;      /*!< exponent of the gates before sigmoid / tanh */
+    int m_stream_hop;         /*!< new frames of X per run in streaming mode, 0 if disabled */
+    bool m_state_valid;       /*!< whether m_states holds the states of the last run */
+    bool is_bias_reseted;     /*!< whether the biases of W and R are split from B */
+    bool m_inputs_valid;      /*!< whether the inputs passed check_inputs() when the module first ran */
+    TensorBase *m_w_bias;     /*!< bias of X * W in the Gemm layout */
+    TensorBase *m_r_bias;     /*!< bias of h * R in the Gemm layout */
+    TensorBase *m_gates_x;    /*!< X * W + Wb of all frames, [seq_length * batch_size, num_gates * hidden_size] */
+    TensorBase *m_gates_h;    /*!< h * R + Rb of one step, [batch_size, num_gates * hidden_size] */
+    TensorBase *m_h;          /*!< quantized h, the input of h * R */
+    TensorBase *m_last_y;     /*!< Y of the last run, if a run computes less frames than seq_length */
+    int32_t *m_states;        /*!< Q15 states, [num_states, batch_size, hidden_size] */
+    int16_t m_sigmoid[257];   /*!< Q15 sigmoid of the gates, see lookup() */
+    int16_t m_tanh[257];      /*!< Q15 tanh of the gates, see lookup() */
+
+    /**
+     * @brief Look up a Q15 table with a gate. int8 gates index the first 256 entries, int16 gates are interpolated
+     * between the 257 entries every 256 values.
+     */
+    template <typename T>
+    static int32_t lookup(const int16_t *table, int32_t gate)
+    {
+        if (sizeof(T) == 1) {
+            gate = DL_CLIP(gate, INT8_MIN, INT8_MAX);
+            return table[gate + 128];
+        }
+        gate = DL_CLIP(gate, INT16_MIN, INT16_MAX);
+        int index = (gate + 32768) >> 8;
+        int frac = (gate + 32768) & 0xff;
+        return table[index] + (((table[index + 1] - table[index]) * frac) >> 8);
+    }
+
+    /**
+     * @brief Q15 value = 2^15 * value * 2^exponent
+     */
+    static int32_t to_q15(int32_t value, int exponent) { return tool::shift_and_round(value, -15 - exponent); }
+
+    template <typename T>
+    static T from_q15(int32_t value, int exponent)
+    {
+        T ret;
+        tool::truncate(ret, tool::shift_and_round(value, 15 + exponent));
+        return ret;
+    }
+
+    template <typename T>
+    void build_tables()
+    {
+        for (int i = 0; i < 257; i++) {
+            int gate = sizeof(T) == 1 ? i - 128 : i * 256 - 32768;
+            float x = gate * DL_SCALE(m_gate_exponent);
+            m_sigmoid[i] = DL_CLIP(lroundf(32768.f / (1.f + expf(-x))), INT16_MIN, INT16_MAX);
+            m_tanh[i] = DL_CLIP(lroundf(32768.f * tanhf(x)), INT16_MIN, INT16_MAX);
+        }
+    }
+
+    /**
+     * @brief Exponent of h in h * R, the whole range of int8 / int16 covers [-1, 1).
+     */
+    int h_exponent() { return quant_type == QUANT_TYPE_SYMM_8BIT ? -7 : -15; }
+
+    /**
+     * @brief Move a Gemm bias to the exponent of its accumulator, exponent(input) + exponent(filter).
+     */
+    static void rescale_bias(TensorBase *bias, int exponent)
+    {
+        int shift = exponent - bias->exponent;
+        for (int i = 0; i < bias->get_size(); i++) {
+            if (bias->dtype == DATA_TYPE_INT32) {
+                int32_t *ptr = (int32_t *)bias->data;
+                ptr[i] = tool::shift_and_round(ptr[i], shift);
+            } else {
+                int64_t *ptr = (int64_t *)bias->data;
+                ptr[i] = tool::shift_and_round(ptr[i], shift);
+            }
+        }
+        bias->exponent = exponent;
+    }
+
+    void reset_bias(ModelContext *context)
+    {
+        if (is_bias_reseted == false) {
+            TensorBase *bias = m_inputs_index.size() > 3 ? context->get_tensor(m_inputs_index[3]) : nullptr;
+            if (bias) {
+                TensorBase *input = context->get_tensor(m_inputs_index[0]);
+                TensorBase *w = context->get_tensor(m_inputs_index[1]);
+                TensorBase *r = context->get_tensor(m_inputs_index[2]);
+                int size = m_num_gates * m_hidden_size;
+                size_t bytes = size * bias->get_dtype_bytes();
+                m_w_bias = new TensorBase({size}, bias->data, bias->exponent, bias->dtype, true, bias->caps);
+                m_r_bias = new TensorBase(
+                    {size}, (int8_t *)bias->data + bytes, bias->exponent, bias->dtype, true, bias->caps);
+                rescale_bias(m_w_bias, input->exponent + w->exponent);
+                rescale_bias(m_r_bias, h_exponent() + r->exponent);
+                m_w_bias->reset_bias_layout(quant_type, false);
+                m_r_bias->reset_bias_layout(quant_type, false);
+            }
+            is_bias_reseted = true;
+        }
+    }
+
+    /**
+     * @brief output = input * filter + bias with the Gemm kernels, input and output are [1, 1, rows, columns].
+     */
+    template <typename T>
+    void gemm(TensorBase *input, TensorBase *filter, TensorBase *bias, TensorBase *output, runtime_mode_t mode)
+    {
+        std::vector<int> padding(4, 0);
+        std::vector<base::ArgsType<T>> args = base::get_conv_operation_args<T>(
+            output, input, padding, filter, {1, 1}, {1, 1}, 1, bias, Linear, nullptr, mode);
+        if (args.size() == 1) {
+            forward_args((void *)&args[0]);
+        } else if (args.size() == 2) {
+            module_forward_dual_core(this, (void *)&args[0], (void *)&args[1]);
+        }
+    }
+
+    /**
+     * @brief Update the states of one step from the gates of x and h, each [batch_size, num_gates * hidden_size].
+     */
+    virtual void step(const int32_t *gates_x, const int32_t *gates_h, int batch_size) = 0;
+
+    template <typename T>
+    void forward_template(ModelContext *context, runtime_mode_t mode)
+    {
+        TensorBase *input = context->get_tensor(m_inputs_index[0]);
+        TensorBase *w = context->get_tensor(m_inputs_index[1]);
+        TensorBase *r = context->get_tensor(m_inputs_index[2]);
+        int seq_length = input->shape[0];
+        int batch_size = input->shape[1];
+        int hidden_size = m_hidden_size;
+        int columns = m_num_gates * hidden_size;
+        int state_size = batch_size * hidden_size;
+        std::vector<TensorBase *> outputs(3, nullptr);
+        for (int i = 0; i < m_outputs_index.size(); i++) {
+            outputs[i] = context->get_tensor(m_outputs_index[i]);
+        }
+        TensorBase *y = outputs[0];
+
+        if (!m_gates_x) {
+            dtype_t dtype = input->dtype;
+            m_gates_x = new TensorBase(
+                {1, 1, seq_length * batch_size, columns}, nullptr, m_gate_exponent, dtype, true, input->caps);
+            m_gates_h = new TensorBase({1, 1, batch_size, columns}, nullptr, m_gate_exponent, dtype, true, input->caps);
+            m_h = new TensorBase({1, 1, batch_size, hidden_size}, nullptr, h_exponent(), dtype, true, input->caps);
+            m_states = (int32_t *)tool::calloc_aligned(16, m_num_states * state_size, sizeof(int32_t), input->caps);
+            build_tables<T>();
+        }
+
+        // frames [first, seq_length) are computed, the others are the frames of the last run
+        int first = 0;
+        if (m_stream_hop && m_state_valid) {
+            first = seq_length - m_stream_hop;
+        } else {
+            for (int s = 0; s < m_num_states; s++) {
+                int index = 5 + s;
+                TensorBase *initial = nullptr;
+                if (index < m_inputs_index.size()) {
+                    initial = context->get_tensor(m_inputs_index[index]);
+                }
+                for (int i = 0; i < state_size; i++) {
+                    m_states[s * state_size + i] = initial ? to_q15(((T *)initial->data)[i], initial->exponent) : 0;
+                }
+            }
+        }
+        m_state_valid = true;
+        size_t y_frame_bytes = state_size * sizeof(T);
+        if (first > 0 && y) {
+            tool::copy_memory(y->data, (int8_t *)m_last_y->data + m_stream_hop * y_frame_bytes, first * y_frame_bytes);
+        }
+
+        // gates of x of the new frames in one Gemm
+        TensorBase *x_frames = new TensorBase({1, 1, (seq_length - first) * batch_size, input->shape[2]},
+                                              (T *)input->data + first * batch_size * input->shape[2],
+                                              input->exponent,
+                                              input->dtype,
+                                              false);
+        TensorBase *gates_x = new TensorBase({1, 1, (seq_length - first) * batch_size, columns},
+                                             m_gates_x->data,
+                                             m_gate_exponent,
+                                             input->dtype,
+                                             false);
+        gemm<T>(x_frames, w, m_w_bias, gates_x, mode);
+        delete x_frames;
+        delete gates_x;
+
+        std::vector<int32_t> gates(2 * batch_size * columns);
+        T *h_ptr = (T *)m_h->data;
+        for (int t = first; t < seq_length; t++) {
+            for (int i = 0; i < state_size; i++) {
+                h_ptr[i] = from_q15<T>(m_states[i], m_h->exponent);
+            }
+            gemm<T>(m_h, r, m_r_bias, m_gates_h, mode);
+
+            T *gates_x_ptr = (T *)m_gates_x->data + (t - first) * batch_size * columns;
+            T *gates_h_ptr = (T *)m_gates_h->data;
+            for (int i = 0; i < batch_size * columns; i++) {
+                gates[i] = gates_x_ptr[i];
+                gates[batch_size * columns + i] = gates_h_ptr[i];
+            }
+            this->step(gates.data(), gates.data() + batch_size * columns, batch_size);
+
+            if (y) {
+                T *y_ptr = (T *)y->data + t * state_size;
+                for (int i = 0; i < state_size; i++) {
+                    y_ptr[i] = from_q15<T>(m_states[i], y->exponent);
+                }
+            }
+        }
+
+        // Y_h and Y_c
+        for (int s = 0; s < m_num_states; s++) {
+            TensorBase *output = outputs[s + 1];
+            if (output) {
+                T *output_ptr = (T *)output->data;
+                for (int i = 0; i < state_size; i++) {
+                    output_ptr[i] = from_q15<T>(m_states[s * state_size + i], output->exponent);
+                }
+            }
+        }
+        if (m_last_y && y) {
+            tool::copy_memory(m_last_y->data, y->data, y->get_bytes());
+        }
+    }
+
+public:
+    /**
+     * @brief Construct a new RNN object.
+     *
+     * @param name            name of module
+     * @param hidden_size     number of neurons in the hidden layer
+     * @param num_gates       3 for GRU, 4 for LSTM
+     * @param num_states      1 for GRU, 2 for LSTM
+     * @param gate_exponent   exponent of the gates, -4 for int8 and -11 for int16 cover [-8, 8) and [-16, 16)
+     * @param quant_type      quantize type.
+     */
+    RNN(const char *name,
+        int hidden_size,
+        int num_gates,
+        int num_states,
+        int gate_exponent,
+        quant_type_t quant_type = QUANT_TYPE_NONE) :
+        Module(name, MODULE_NON_INPLACE, quant_type),
+        m_hidden_size(hidden_size),
+        m_num_gates(num_gates),
+        m_num_states(num_states),
+        m_gate_exponent(gate_exponent)
+    {
+        m_stream_hop = 0;
+        m_state_valid = false;
+        is_bias_reseted = false;
+        m_inputs_valid = false;
+        m_w_bias = nullptr;
+        m_r_bias = nullptr;
+        m_gates_x = nullptr;
+        m_gates_h = nullptr;
+        m_h = nullptr;
+        m_last_y = nullptr;
+        m_states = nullptr;
+    }
+
+    /**
+     * @brief Destroy the RNN object.
+     */
+    virtual ~RNN()
+    {
+        delete m_w_bias;
+        delete m_r_bias;
+        delete m_gates_x;
+        delete m_gates_h;
+        delete m_h;
+        delete m_last_y;
+        if (m_states) {
+            heap_caps_free(m_states);
+        }
+    }
+
+    std::vector<std::vector<int>> get_output_shape(std::vector<std::vector<int>> &input_shapes)
+    {
+        assert(input_shapes[0].size() == 3);
+        int seq_length = input_shapes[0][0];
+        int batch_size = input_shapes[0][1];
+        std::vector<std::vector<int>> output_shapes(1 + m_num_states, {1, batch_size, m_hidden_size});
+        output_shapes[0] = {seq_length, 1, batch_size, m_hidden_size};
+        return output_shapes;
+    }
+
+    void forward_args(void *args)
+    {
+        if (quant_type == QUANT_TYPE_SYMM_8BIT) {
+            base::conv2d<int8_t, int32_t, int32_t>(args);
+        } else if (quant_type == QUANT_TYPE_SYMM_16BIT) {
+            base::conv2d<int16_t, int32_t, int64_t>(args);
+        }
+    }
+
+    void forward(ModelContext *context, runtime_mode_t mode = RUNTIME_MODE_AUTO)
+    {
+        if (!is_bias_reseted) {
+            std::vector<std::vector<int>> shapes;
+            for (int index : m_inputs_index) {
+                TensorBase *input = context->get_tensor(index);
+                shapes.push_back(input ? input->get_shape() : std::vector<int>());
+            }
+            // the name of the module is only kept with DL_LOG_MODULE_NAME
+            m_inputs_valid = check_inputs(name ? name : "", m_num_gates, m_hidden_size, shapes) == ESP_OK;
+        }
+        if (!m_inputs_valid) {
+            is_bias_reseted = true;
+            return;
+        }
+        reset_bias(context);
+
+        if (quant_type == QUANT_TYPE_SYMM_8BIT) {
+            forward_template<int8_t>(context, mode);
+        } else if (quant_type == QUANT_TYPE_SYMM_16BIT) {
+            forward_template<int16_t>(context, mode);
+        }
+    }
+
+    esp_err_t set_streaming(ModelContext *context, int hop)
+    {
+        delete m_last_y;
+        m_last_y = nullptr;
+        m_stream_hop = 0;
+        m_state_valid = false;
+        if (hop <= 0) {
+            return ESP_OK;
+        }
+
+        TensorBase *input = context->get_tensor(m_inputs_index[0]);
+        int seq_length = input->shape[0];
+        if (hop > seq_length) {
+            ESP_LOGE("RNN", "The hop %d is longer than the sequence %d.", hop, seq_length);
+            return ESP_ERR_INVALID_ARG;
+        }
+        TensorBase *y = m_outputs_index.empty() ? nullptr : context->get_tensor(m_outputs_index[0]);
+        if (hop < seq_length && y) {
+            m_last_y = new TensorBase(y->shape, nullptr, y->exponent, y->dtype, true, y->caps);
+            if (!m_last_y->data) {
+                delete m_last_y;
+                m_last_y = nullptr;
+                return ESP_ERR_NO_MEM;
+            }
+        }
+        m_stream_hop = hop;
+        return ESP_OK;
+    }
+
+    void reset_streaming() { m_state_valid = false; }
+
+    /**
+     * @brief Check the shapes of the inputs against the fused layout of the weights, see the class description.
+     *
+     * @param name         name of the module, for the logs
+     * @param num_gates    3 for GRU, 4 for LSTM
+     * @param hidden_size  number of neurons in the hidden layer
+     * @param shapes       shapes of X, W, R, B and sequence_lens, empty for a missing optional input
+     * @return
+     *      - ESP_OK                 Success
+     *      - ESP_ERR_NOT_SUPPORTED  The weights are in another layout, or sequence_lens is given
+     */
+    static esp_err_t check_inputs(const char *name,
+                                  int num_gates,
+                                  int hidden_size,
+                                  const std::vector<std::vector<int>> &shapes)
+    {
+        int columns = num_gates * hidden_size;
+        std::vector<int> empty;
+        const std::vector<int> &x = shapes.size() > 0 ? shapes[0] : empty;
+        const std::vector<int> &w = shapes.size() > 1 ? shapes[1] : empty;
+        const std::vector<int> &r = shapes.size() > 2 ? shapes[2] : empty;
+        const std::vector<int> &b = shapes.size() > 3 ? shapes[3] : empty;
+        if (w.size() != 4 || w[0] != 1 || w[1] != 1 || w[3] != columns || (x.size() == 3 && w[2] != x[2])) {
+            ESP_LOGE("RNN",
+                     "%s: W must be [1, 1, input_size, %d], got %s.",
+                     name,
+                     columns,
+                     vector_to_string(w).c_str());
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+        if (r != std::vector<int>({1, 1, hidden_size, columns})) {
+            ESP_LOGE("RNN",
+                     "%s: R must be [1, 1, %d, %d], got %s.",
+                     name,
+                     hidden_size,
+                     columns,
+                     vector_to_string(r).c_str());
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+        if (!b.empty() && b != std::vector<int>({1, 2 * columns})) {
+            ESP_LOGE("RNN", "%s: B must be [1, %d], got %s.", name, 2 * columns, vector_to_string(b).c_str());
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+        if (shapes.size() > 4 && !shapes[4].empty()) {
+            ESP_LOGE("RNN", "%s: sequence_lens is not supported.", name);
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+        return ESP_OK;
+    }
+
+    /**
+     * @brief Read the attributes shared by GRU and LSTM and check the inputs, return false if they are not supported.
+     */
+    static bool deserialize_attributes(fbs::FbsModel *fbs_model,
+                                       std::string node_name,
+                                       int num_gates,
+                                       int &hidden_size,
+                                       int &gate_exponent,
+                                       quant_type_t &quant_type)
+    {
+        std::string direction = "forward";
+        int layout = 0;
+        fbs_model->get_operation_attribute(node_name, "hidden_size", hidden_size);
+        fbs_model->get_operation_attribute(node_name, "direction", direction);
+        fbs_model->get_operation_attribute(node_name, "layout", layout);
+        fbs_model->get_operation_attribute(node_name, "quant_type", quant_type);
+        if (fbs_model->get_operation_attribute(node_name, "gate_exponent", gate_exponent) != ESP_OK) {
+            gate_exponent = quant_type == QUANT_TYPE_SYMM_8BIT ? -4 : -11;
+        }
+        if (direction != "forward" || layout != 0) {
+            ESP_LOGE("RNN", "%s: only forward direction and layout 0 are supported.", node_name.c_str());
+            return false;
+        }
+
+        // X is a variable, the others are parameters, except sequence_lens which is rejected anyway
+        std::vector<std::string> inputs;
+        std::vector<std::string> outputs;
+        fbs_model->get_operation_inputs_and_outputs(node_name, inputs, outputs);
+        std::vector<std::vector<int>> shapes;
+        for (int i = 0; i < inputs.size() && i < 5; i++) {
+            if (inputs[i].empty()) {
+                shapes.push_back({});
+            } else if (i == 0) {
+                shapes.push_back(fbs_model->get_value_info_shape(inputs[i]));
+            } else if (i == 4) {
+                shapes.push_back({1});
+            } else {
+                shapes.push_back(fbs_model->get_tensor_shape(inputs[i]));
+            }
+        }
+        if (check_inputs(node_name.c_str(), num_gates, hidden_size, shapes) != ESP_OK) {
+            return false;
+        }
+        return quant_type == QUANT_TYPE_SYMM_8BIT || quant_type == QUANT_TYPE_SYMM_16BIT;
+    }
+};
+} // namespace module
+} // namespace dl
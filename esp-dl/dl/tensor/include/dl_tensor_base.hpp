@@ -107,6 +107,9 @@ public:
     void *data;                   ///< data pointer
     void *cache;                  ///< cache pointer， used for preload and do not need to free
     uint32_t caps;                ///< flags indicating the type of memory
+    void *ring_buffer = nullptr;  ///< two copies of the window of a ring buffer tensor, see enable_ring_buffer()
+    int ring_dim = -1;            ///< streaming dimension of a ring buffer tensor
+    int ring_head = 0;            ///< index of the oldest frame of the window in the ring buffer
 
     /**
      * @brief Construct a TensorBase object
@@ -135,6 +138,10 @@ public:
             heap_caps_free(this->data);
             this->data = nullptr;
         }
+        if (this->ring_buffer) {
+            heap_caps_free(this->ring_buffer);
+            this->ring_buffer = nullptr;
+        }
     }
 
 #if CONFIG_SPIRAM
@@ -504,6 +511,19 @@ public:
      */
     void push(TensorBase *new_tensor, int dim);
 
+    /**
+     * @brief Turn push() on dim into a ring buffer push. The tensor keeps two copies of its window back to back, a
+     * push writes the new frames into both copies and moves the data pointer forward, so the window stays contiguous
+     * and a push costs two copies of the new frames instead of moving the whole window. The current data is kept.
+     *
+     * @note The data pointer moves with every push, read it after the push. It is aligned to 16 bytes only if the
+     * bytes of a frame are a multiple of 16. Don't call set_element_ptr() on a ring buffer tensor.
+     *
+     * @param dim  The streaming dimension, all dimensions before it must be 1, e.g. 1 for a [1, W, C] tensor
+     * @return true if successful, otherwise false.
+     */
+    bool enable_ring_buffer(int dim);
+
     /**
      * @brief print the information of TensorBase
      *
@@ -1,6 +1,7 @@
 #include "dl_tensor_base.hpp"
 #include "dl_base_pad.hpp"
 #include "dl_base_requantize_linear.hpp"
+#include <algorithm>
 #include <iostream>
 namespace dl {
 
@@ -503,6 +504,25 @@ void TensorBase::push(TensorBase *new_tensor, int dim)
         return;
     }
 
+    if (this->ring_buffer && dim == this->ring_dim) {
+        // write the new frames over the oldest ones in both copies of the window, then move the window
+        int window = this->shape[dim];
+        int frames = new_tensor->shape[dim];
+        size_t frame_bytes = this->axis_offset[dim] * this->get_dtype_bytes();
+        uint8_t *buffer = static_cast<uint8_t *>(this->ring_buffer);
+        uint8_t *src = static_cast<uint8_t *>(new_tensor->get_element_ptr());
+        for (int done = 0; done < frames;) {
+            int slot = (this->ring_head + done) % window;
+            int n = DL_MIN(frames - done, window - slot);
+            tool::copy_memory(buffer + slot * frame_bytes, src + done * frame_bytes, n * frame_bytes);
+            tool::copy_memory(buffer + (slot + window) * frame_bytes, src + done * frame_bytes, n * frame_bytes);
+            done += n;
+        }
+        this->ring_head = (this->ring_head + frames) % window;
+        this->data = buffer + this->ring_head * frame_bytes;
+        return;
+    }
+
     // NCW or NWC
     int loop_num = 1;
     int move_chunk_size = 1;
@@ -541,11 +561,11 @@ void TensorBase::push(TensorBase *new_tensor, int dim)
             // move chunk
             tool::copy_memory(get_element_ptr<int16_t>() + i * current_loop_stride,
                               get_element_ptr<int16_t>() + i * current_loop_stride + move_offset,
-                              move_chunk_size);
+                              move_chunk_size * sizeof(int16_t));
             // copy new tensor
             tool::copy_memory(get_element_ptr<int16_t>() + i * current_loop_stride + move_chunk_size,
                               new_tensor->get_element_ptr<int16_t>() + i * copy_chunk_size,
-                              copy_chunk_size);
+                              copy_chunk_size * sizeof(int16_t));
         } else {
             ESP_LOGE(__FUNCTION__, "Don't support dtype: %d", this->dtype);
         }
@@ -553,6 +573,43 @@ void TensorBase::push(TensorBase *new_tensor, int dim)
     return;
 }
 
+bool TensorBase::enable_ring_buffer(int dim)
+{
+    if (dim < 0 || dim >= this->shape.size()) {
+        ESP_LOGE(__FUNCTION__, "The dim is out of range.");
+        return false;
+    }
+    for (int i = 0; i < dim; i++) {
+        if (this->shape[i] != 1) {
+            ESP_LOGE(__FUNCTION__, "The dims before the streaming dim must be 1.");
+            return false;
+        }
+    }
+    if (this->ring_buffer) {
+        return dim == this->ring_dim;
+    }
+
+    size_t bytes = this->get_bytes();
+    void *buffer = tool::calloc_aligned(16, 2 * this->size, this->get_dtype_bytes(), this->caps);
+    if (!buffer) {
+        ESP_LOGE(__FUNCTION__, "Failed to alloc %.2fKB RAM for the ring buffer", 2 * bytes / 1024.f);
+        return false;
+    }
+    if (this->data) {
+        tool::copy_memory(buffer, this->data, bytes);
+        tool::copy_memory(static_cast<uint8_t *>(buffer) + bytes, this->data, bytes);
+        if (this->auto_free) {
+            heap_caps_free(this->data);
+        }
+    }
+    this->ring_buffer = buffer;
+    this->ring_dim = dim;
+    this->ring_head = 0;
+    this->data = buffer;
+    this->auto_free = false;
+    return true;
+}
+
 void TensorBase::print(bool print_data)
 {
     ESP_LOGI(__FUNCTION__,
@@ -639,6 +696,148 @@ TensorBase *TensorBase::reshape(std::vector<int> shape)
     return this;
 }
 
+/**
+ * @brief Merge the axes of a transpose which stay adjacent and in order in the output and drop the axes of size 1,
+ * e.g. NHWC->NCHW becomes a transpose of [N, H * W, C] with perm {0, 2, 1}.
+ *
+ * @param shape         input shape
+ * @param perm          permutation of the input axes, without negative axes
+ * @param merged_shape  input shape of the merged axes
+ * @param merged_perm   permutation of the merged axes
+ */
+static void merge_transpose_axes(const std::vector<int> &shape,
+                                 const std::vector<int> &perm,
+                                 std::vector<int> &merged_shape,
+                                 std::vector<int> &merged_perm)
+{
+    int dims = shape.size();
+    std::vector<int> new_axis(dims, -1);
+    int num_axes = 0;
+    for (int i = 0; i < dims; i++) {
+        if (shape[i] != 1) {
+            new_axis[i] = num_axes++;
+        }
+    }
+
+    // groups of input axes in output order, a group starts where the next input axis does not follow
+    std::vector<int> group_first, group_size;
+    int last = -2;
+    for (int i = 0; i < dims; i++) {
+        int axis = new_axis[perm[i]];
+        if (axis < 0) {
+            continue;
+        }
+        if (axis == last + 1) {
+            group_size.back() *= shape[perm[i]];
+        } else {
+            group_first.push_back(axis);
+            group_size.push_back(shape[perm[i]]);
+        }
+        last = axis;
+    }
+
+    int num_groups = group_first.size();
+    merged_shape.assign(num_groups, 0);
+    merged_perm.assign(num_groups, 0);
+    for (int i = 0; i < num_groups; i++) {
+        int rank = 0;
+        for (int j = 0; j < num_groups; j++) {
+            rank += group_first[j] < group_first[i];
+        }
+        merged_shape[rank] = group_size[i];
+        merged_perm[i] = rank;
+    }
+}
+
+/**
+ * @brief Transpose a rows x cols matrix in blocks, which keeps the reads and the writes of a block in cache.
+ *
+ * @param input   input matrix
+ * @param output  output matrix, cols x rows
+ * @param rows    rows of the input
+ * @param cols    columns of the input
+ */
+template <typename T>
+static void transpose_2d(const T *input, T *output, int rows, int cols)
+{
+    const int block = 16;
+    for (int i0 = 0; i0 < rows; i0 += block) {
+        int i1 = DL_MIN(i0 + block, rows);
+        for (int j0 = 0; j0 < cols; j0 += block) {
+            int j1 = DL_MIN(j0 + block, cols);
+            for (int j = j0; j < j1; j++) {
+                const T *input_ptr = input + i0 * cols + j;
+                T *output_ptr = output + j * rows;
+                for (int i = i0; i < i1; i++) {
+                    output_ptr[i] = *input_ptr;
+                    input_ptr += cols;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Transpose on the merged axes of merge_transpose_axes(). A swap of the last two axes is a blocked transpose,
+ * any other permutation copies the rows of the last output axis, or gathers them if the last input axis moves.
+ */
+template <typename T>
+static void transpose_merged(const T *input,
+                             T *output,
+                             const std::vector<int> &merged_shape,
+                             const std::vector<int> &merged_perm,
+                             int size)
+{
+    int dims = merged_shape.size();
+    if (dims <= 1) {
+        tool::copy_memory(output, (void *)input, size * sizeof(T));
+        return;
+    }
+
+    bool batched = merged_perm[dims - 2] == dims - 1;
+    for (int i = 0; i < dims - 2; i++) {
+        batched &= merged_perm[i] == i;
+    }
+    if (batched) {
+        // e.g. NHWC<->NCHW
+        int rows = merged_shape[dims - 2];
+        int cols = merged_shape[dims - 1];
+        for (int offset = 0; offset < size; offset += rows * cols) {
+            transpose_2d<T>(input + offset, output + offset, rows, cols);
+        }
+        return;
+    }
+
+    std::vector<int> input_stride(dims, 1);
+    for (int i = dims - 2; i >= 0; i--) {
+        input_stride[i] = input_stride[i + 1] * merged_shape[i + 1];
+    }
+    int inner = merged_shape[merged_perm[dims - 1]];
+    int inner_stride = input_stride[merged_perm[dims - 1]];
+    std::vector<int> index(dims - 1, 0);
+    for (int offset = 0; offset < size; offset += inner) {
+        const T *input_ptr = input;
+        for (int i = 0; i < dims - 1; i++) {
+            input_ptr += index[i] * input_stride[merged_perm[i]];
+        }
+        if (inner_stride == 1) {
+            tool::copy_memory(output + offset, (void *)input_ptr, inner * sizeof(T));
+        } else {
+            T *output_ptr = output + offset;
+            for (int k = 0; k < inner; k++) {
+                output_ptr[k] = *input_ptr;
+                input_ptr += inner_stride;
+            }
+        }
+        for (int i = dims - 2; i >= 0; i--) {
+            if (++index[i] < merged_shape[merged_perm[i]]) {
+                break;
+            }
+            index[i] = 0;
+        }
+    }
+}
+
 template <typename T>
 TensorBase *TensorBase::transpose(T *input_element,
                                   std::vector<int> &input_shape,
@@ -664,65 +863,9 @@ TensorBase *TensorBase::transpose(T *input_element,
     }
     T *output_element = (T *)this->get_element_ptr();
 
-    std::vector<int> input_axis_index(dims);
-    if (dims == 4) {
-        uint32_t input_idx = 0, output_idx = 0;
-        for (int i = 0; i < input_shape[0]; i++) {
-            for (int j = 0; j < input_shape[1]; j++) {
-                for (int k = 0; k < input_shape[2]; k++) {
-                    for (int l = 0; l < input_shape[3]; l++) {
-                        input_axis_index = {i, j, k, l};
-                        input_idx = l + k * input_axis_offset[2] + j * input_axis_offset[1] + i * input_axis_offset[0];
-                        output_idx = input_axis_index[perm[3]] * this->axis_offset[3] +
-                            input_axis_index[perm[2]] * this->axis_offset[2] +
-                            input_axis_index[perm[1]] * this->axis_offset[1] +
-                            input_axis_index[perm[0]] * this->axis_offset[0];
-                        output_element[output_idx] = input_element[input_idx];
-                    }
-                }
-            }
-        }
-    } else if (dims == 3) {
-        uint32_t input_idx = 0, output_idx = 0;
-        for (int i = 0; i < input_shape[0]; i++) {
-            for (int j = 0; j < input_shape[1]; j++) {
-                for (int k = 0; k < input_shape[2]; k++) {
-                    input_axis_index = {i, j, k};
-                    input_idx = k + j * input_axis_offset[1] + i * input_axis_offset[0];
-                    output_idx = input_axis_index[perm[2]] * this->axis_offset[2] +
-                        input_axis_index[perm[1]] * this->axis_offset[1] +
-                        input_axis_index[perm[0]] * this->axis_offset[0];
-                    output_element[output_idx] = input_element[input_idx];
-                }
-            }
-        }
-    } else if (dims == 2) {
-        uint32_t input_idx = 0, output_idx = 0;
-        for (int i = 0; i < input_shape[0]; i++) {
-            for (int j = 0; j < input_shape[1]; j++) {
-                input_axis_index = {i, j};
-                input_idx = j + i * input_axis_offset[0];
-                output_idx =
-                    input_axis_index[perm[1]] * this->axis_offset[1] + input_axis_index[perm[0]] * this->axis_offset[0];
-                output_element[output_idx] = input_element[input_idx];
-            }
-        }
-    } else {
-        // for any dims
-        std::vector<int> index_old(dims, 0);
-        for (int i = 0; i < size; ++i) {
-            int dim_div_value = i;
-            int index_new = 0;
-            for (int j = dims - 1; j > -1; --j) {
-                index_old[j] = dim_div_value % input_shape[j];
-                dim_div_value /= input_shape[j];
-            }
-            for (int j = dims - 1; j > -1; --j) {
-                index_new += index_old[perm[j]] * this->axis_offset[j];
-            }
-            output_element[index_new] = input_element[i];
-        }
-    }
+    std::vector<int> merged_shape, merged_perm;
+    merge_transpose_axes(input_shape, perm, merged_shape, merged_perm);
+    transpose_merged<T>(input_element, output_element, merged_shape, merged_perm, this->size);
 
     return this;
 }
@@ -742,7 +885,7 @@ TensorBase *TensorBase::transpose(TensorBase *input, std::vector<int> perm)
         transpose<int32_t>((int32_t *)input->get_element_ptr(), input->shape, input->axis_offset, perm);
     } else if (this->dtype == DATA_TYPE_UINT16) {
         transpose<uint16_t>((uint16_t *)input->get_element_ptr(), input->shape, input->axis_offset, perm);
-    } else if (this->dtype == DATA_TYPE_INT32) {
+    } else if (this->dtype == DATA_TYPE_UINT32) {
         transpose<uint32_t>((uint32_t *)input->get_element_ptr(), input->shape, input->axis_offset, perm);
     } else if (this->dtype == DATA_TYPE_FLOAT) {
         transpose<float>((float *)input->get_element_ptr(), input->shape, input->axis_offset, perm);
@@ -920,28 +1063,47 @@ void _flip(TensorBase *input, const std::vector<int> &axes)
         return;
     }
     T *input_element = (T *)input->get_element_ptr();
+    int dims = input->shape.size();
+    int size = input->get_size();
 
-    for (int i = 0; i < input->get_size(); ++i) {
-        // Compute original coordinates
-        std::vector<int> coords = input->get_element_coordinates(i);
-
-        // Flip coordinates
-        for (int axis : axes) {
-            coords[axis] = input->shape[axis] - 1 - coords[axis];
+    // reverse one axis after the other, swapping whole inner blocks
+    for (int axis : axes) {
+        if (axis < 0) {
+            axis += dims;
         }
-
-        // Compute flipped index
-        int j = input->get_element_index(coords);
-
-        // Swap elements if needed
-        if (i < j) {
-            T temp = input_element[i];
-            input_element[i] = input_element[j];
-            input_element[j] = temp;
+        int len = input->shape[axis];
+        int inner = input->axis_offset[axis];
+        int outer_stride = len * inner;
+        for (int offset = 0; offset < size; offset += outer_stride) {
+            T *head = input_element + offset;
+            if (inner == 1) {
+                std::reverse(head, head + len);
+                continue;
+            }
+            T *tail = head + (len - 1) * inner;
+            while (head < tail) {
+                std::swap_ranges(head, head + inner, tail);
+                head += inner;
+                tail -= inner;
+            }
         }
     }
 }
 
+template <typename T>
+TensorBase *TensorBase::flip(const std::vector<int> &axes)
+{
+    _flip<T>(this, axes);
+    return this;
+}
+template TensorBase *TensorBase::flip<int8_t>(const std::vector<int> &axes);
+template TensorBase *TensorBase::flip<uint8_t>(const std::vector<int> &axes);
+template TensorBase *TensorBase::flip<int16_t>(const std::vector<int> &axes);
+template TensorBase *TensorBase::flip<uint16_t>(const std::vector<int> &axes);
+template TensorBase *TensorBase::flip<int32_t>(const std::vector<int> &axes);
+template TensorBase *TensorBase::flip<uint32_t>(const std::vector<int> &axes);
+template TensorBase *TensorBase::flip<float>(const std::vector<int> &axes);
+
 template <typename T>
 void _slice(TensorBase *input,
             TensorBase *output,
@@ -990,6 +1152,11 @@ void _slice(TensorBase *input,
         loop_step[axis] = step_i;
         assert(loop_start[axis] < loop_end[axis]);
     }
+    // the full last axes are contiguous with the axis before them, copy them in one run
+    while (last_axis > 0 && loop_start[last_axis] == 0 && loop_end[last_axis] == input_shape[last_axis] &&
+           loop_step[last_axis] == 1 && loop_step[last_axis - 1] == 1) {
+        last_axis--;
+    }
     int min_offset = loop_end[last_axis] - loop_start[last_axis];
     for (int i = last_axis + 1; i < dims; i++) {
         min_offset *= input_shape[i];
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "esp_heap_caps.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+namespace dl {
+namespace tool {
+/**
+ * @brief Latency and heap statistics of the stages of a pipeline over a sequence of frames.
+ *
+ * The stages of a frame run one after another, start(stage), end(), start(next stage), ..., end_frame(). The
+ * statistics of the whole frames are kept as the stage "frame". The heap is sampled outside of the timed part of a
+ * stage, so it does not add to the latency.
+ */
+class Benchmark {
+public:
+    /**
+     * @brief Function returning the number of allocations so far, e.g. counted by the heap hooks of
+     *        CONFIG_HEAP_USE_HOOKS.
+     */
+    typedef uint32_t (*alloc_counter_t)(void);
+
+    /**
+     * @brief Construct a new Benchmark object.
+     *
+     * @param name           name of the pipeline in the results
+     * @param caps           heap capabilities to sample
+     * @param alloc_counter  allocation counter, nullptr to not count allocations
+     */
+    Benchmark(const char *name, uint32_t caps = MALLOC_CAP_8BIT, alloc_counter_t alloc_counter = nullptr);
+
+    /**
+     * @brief Start a stage of the current frame.
+     *
+     * @param stage  name of the stage, the same stage may run several times in a frame
+     */
+    void start(const char *stage);
+
+    /**
+     * @brief End the running stage.
+     */
+    void end();
+
+    /**
+     * @brief End the current frame.
+     */
+    void end_frame();
+
+    /**
+     * @brief Drop the statistics of all the frames, e.g. of the warm up frames.
+     */
+    void reset();
+
+    /**
+     * @brief Get a latency percentile of a stage.
+     *
+     * @param stage    name of the stage, "frame" for the whole frames
+     * @param percent  0 to 100, e.g. 50 for the median
+     * @return latency in us, 0 if the stage never ran
+     */
+    uint32_t get_percentile(const char *stage, float percent);
+
+    int get_num_frames() { return m_num_frames; }
+
+    /**
+     * @brief Print the statistics as one line of JSON, for regression tracking.
+     *
+     * @param file  output file
+     */
+    void print_json(FILE *file = stdout);
+
+    /**
+     * @brief Log the statistics as a table.
+     */
+    void print();
+
+private:
+    typedef struct {
+        std::string name;
+        std::vector<uint32_t> latency; /*!< latency of each run in us */
+        int64_t heap_delta;            /*!< sum of the heap taken by each run and not freed */
+        size_t peak;                   /*!< max heap used during a run on top of the heap used when it started, only
+                                            the heap left in use at the end of the run before IDF v5.3 */
+        uint32_t allocs;               /*!< allocations of all the runs */
+    } stage_t;
+
+    std::string m_name;
+    uint32_t m_caps;
+    alloc_counter_t m_alloc_counter;
+    std::vector<stage_t> m_stages; /*!< "frame" first, then the stages in the order they first ran */
+    stage_t m_frame;               /*!< heap statistics of the current frame, added to "frame" by end_frame() */
+    uint32_t m_frame_latency;      /*!< latency of the current frame */
+    int m_num_frames;
+    int m_running;                 /*!< index of the running stage, -1 if none */
+    int64_t m_start_time;          /*!< start of the running stage */
+    size_t m_start_free;           /*!< free heap when the running stage started */
+    uint32_t m_start_allocs;       /*!< allocations when the running stage started */
+    size_t m_min_free;             /*!< min free heap since the last reset() */
+
+    stage_t &get_stage(const char *stage);
+    stage_t *find_stage(const char *stage);
+    static uint32_t percentile(std::vector<uint32_t> &sorted, float percent);
+};
+} // namespace tool
+} // namespace dl
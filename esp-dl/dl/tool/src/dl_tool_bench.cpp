@@ -0,0 +1,202 @@
+#include "dl_tool_bench.hpp"
+#include "esp_idf_version.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <algorithm>
+#include <cmath>
+#include <string.h>
+
+// The peak heap of a stage needs the minimum free heap since the stage started, added in IDF v5.3.
+#define DL_BENCH_LOCAL_MIN_FREE (ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 3, 0))
+
+static const char *TAG = "dl::tool::Benchmark";
+
+namespace dl {
+namespace tool {
+
+Benchmark::Benchmark(const char *name, uint32_t caps, alloc_counter_t alloc_counter) :
+    m_name(name), m_caps(caps), m_alloc_counter(alloc_counter)
+{
+    reset();
+}
+
+void Benchmark::reset()
+{
+    m_stages.clear();
+    m_stages.push_back({"frame", {}, 0, 0, 0});
+    m_frame = {"frame", {}, 0, 0, 0};
+    m_frame_latency = 0;
+    m_num_frames = 0;
+    m_running = -1;
+    m_min_free = heap_caps_get_free_size(m_caps);
+}
+
+Benchmark::stage_t *Benchmark::find_stage(const char *stage)
+{
+    for (stage_t &s : m_stages) {
+        if (s.name == stage) {
+            return &s;
+        }
+    }
+    return nullptr;
+}
+
+Benchmark::stage_t &Benchmark::get_stage(const char *stage)
+{
+    stage_t *s = find_stage(stage);
+    if (s) {
+        return *s;
+    }
+    m_stages.push_back({stage, {}, 0, 0, 0});
+    return m_stages.back();
+}
+
+void Benchmark::start(const char *stage)
+{
+    if (m_running >= 0) {
+        ESP_LOGW(TAG, "Stage %s is still running, end it.", m_stages[m_running].name.c_str());
+        end();
+    }
+    m_running = &get_stage(stage) - m_stages.data();
+    m_start_allocs = m_alloc_counter ? m_alloc_counter() : 0;
+    m_start_free = heap_caps_get_free_size(m_caps);
+#if DL_BENCH_LOCAL_MIN_FREE
+    heap_caps_monitor_local_minimum_free_size_start();
+#endif
+    m_start_time = esp_timer_get_time();
+}
+
+void Benchmark::end()
+{
+    int64_t end_time = esp_timer_get_time();
+    if (m_running < 0) {
+        ESP_LOGW(TAG, "No stage is running.");
+        return;
+    }
+    size_t free = heap_caps_get_free_size(m_caps);
+#if DL_BENCH_LOCAL_MIN_FREE
+    size_t min_free = heap_caps_get_minimum_free_size(m_caps);
+    heap_caps_monitor_local_minimum_free_size_stop();
+#else
+    size_t min_free = std::min(free, m_start_free);
+#endif
+    uint32_t allocs = m_alloc_counter ? m_alloc_counter() - m_start_allocs : 0;
+
+    stage_t &stage = m_stages[m_running];
+    uint32_t latency = end_time - m_start_time;
+    int64_t heap_delta = (int64_t)m_start_free - (int64_t)free;
+    size_t peak = m_start_free > min_free ? m_start_free - min_free : 0;
+    stage.latency.push_back(latency);
+    stage.heap_delta += heap_delta;
+    stage.peak = std::max(stage.peak, peak);
+    stage.allocs += allocs;
+    m_frame_latency += latency;
+    m_frame.heap_delta += heap_delta;
+    m_frame.peak = std::max(m_frame.peak, peak);
+    m_frame.allocs += allocs;
+    m_min_free = std::min(m_min_free, min_free);
+    m_running = -1;
+}
+
+void Benchmark::end_frame()
+{
+    if (m_running >= 0) {
+        end();
+    }
+    stage_t &frame = m_stages[0];
+    frame.latency.push_back(m_frame_latency);
+    frame.heap_delta += m_frame.heap_delta;
+    frame.peak = std::max(frame.peak, m_frame.peak);
+    frame.allocs += m_frame.allocs;
+    m_frame = {"frame", {}, 0, 0, 0};
+    m_frame_latency = 0;
+    m_num_frames++;
+}
+
+uint32_t Benchmark::percentile(std::vector<uint32_t> &sorted, float percent)
+{
+    if (sorted.empty()) {
+        return 0;
+    }
+    // nearest rank
+    int rank = (int)ceilf(percent / 100.f * sorted.size());
+    return sorted[std::min(std::max(rank, 1), (int)sorted.size()) - 1];
+}
+
+uint32_t Benchmark::get_percentile(const char *stage, float percent)
+{
+    stage_t *s = find_stage(stage);
+    if (!s) {
+        return 0;
+    }
+    std::vector<uint32_t> sorted = s->latency;
+    std::sort(sorted.begin(), sorted.end());
+    return percentile(sorted, percent);
+}
+
+void Benchmark::print_json(FILE *file)
+{
+    fprintf(file, "{\"benchmark\": \"%s\", \"frames\": %d, \"stages\": [", m_name.c_str(), m_num_frames);
+    std::vector<uint32_t> sorted;
+    for (int i = 0; i < m_stages.size(); i++) {
+        stage_t &stage = m_stages[i];
+        int runs = stage.latency.size();
+        sorted = stage.latency;
+        std::sort(sorted.begin(), sorted.end());
+        uint64_t sum = 0;
+        for (uint32_t latency : sorted) {
+            sum += latency;
+        }
+        fprintf(file,
+                "%s{\"name\": \"%s\", \"runs\": %d, \"mean_us\": %u, \"p50_us\": %u, \"p95_us\": %u, \"p99_us\": %u, "
+                "\"max_us\": %u, \"heap_delta_bytes\": %lld, \"peak_bytes\": %u, \"allocs\": %u}",
+                i ? ", " : "",
+                stage.name.c_str(),
+                runs,
+                runs ? (unsigned)(sum / runs) : 0,
+                (unsigned)percentile(sorted, 50),
+                (unsigned)percentile(sorted, 95),
+                (unsigned)percentile(sorted, 99),
+                runs ? (unsigned)sorted.back() : 0,
+                (long long)stage.heap_delta,
+                (unsigned)stage.peak,
+                (unsigned)stage.allocs);
+    }
+    fprintf(file, "], \"min_free_bytes\": %u}\n", (unsigned)m_min_free);
+    fflush(file);
+}
+
+void Benchmark::print()
+{
+    ESP_LOGI(TAG, "%s, %d frames", m_name.c_str(), m_num_frames);
+    ESP_LOGI(TAG,
+             "%-16s %6s %8s %8s %8s %8s %12s %10s %8s",
+             "stage",
+             "runs",
+             "p50(us)",
+             "p95(us)",
+             "p99(us)",
+             "max(us)",
+             "heap delta",
+             "peak",
+             "allocs");
+    std::vector<uint32_t> sorted;
+    for (stage_t &stage : m_stages) {
+        sorted = stage.latency;
+        std::sort(sorted.begin(), sorted.end());
+        ESP_LOGI(TAG,
+                 "%-16s %6d %8u %8u %8u %8u %12lld %10u %8u",
+                 stage.name.c_str(),
+                 (int)sorted.size(),
+                 (unsigned)percentile(sorted, 50),
+                 (unsigned)percentile(sorted, 95),
+                 (unsigned)percentile(sorted, 99),
+                 sorted.empty() ? 0 : (unsigned)sorted.back(),
+                 (long long)stage.heap_delta,
+                 (unsigned)stage.peak,
+                 (unsigned)stage.allocs);
+    }
+    ESP_LOGI(TAG, "min free heap: %u bytes", (unsigned)m_min_free);
+}
+} // namespace tool
+} // namespace dl
@@ -1,13 +1,67 @@
 #include "dl_detect_base.hpp"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+static const char *TAG = "dl_detect_base";
 
 namespace dl {
 namespace detect {
+#if portNUM_PROCESSORS > 1
+typedef struct {
+    dl::image::ImagePreprocessor *preprocessor;
+    const dl::image::img_t *img;
+    const std::vector<std::vector<int>> *rois;
+    void *dst;
+    float *scales;          /*!< [scale_x, scale_y] of each region */
+    SemaphoreHandle_t free; /*!< given when dst may be overwritten */
+    SemaphoreHandle_t done; /*!< given when the next region is in dst */
+} crop_task_data_t;
+
+/**
+ * @brief Preprocess regions 1..n-1 into dst one at a time, while the caller runs the model on the previous region.
+ */
+static void crop_task(void *args)
+{
+    crop_task_data_t *task = (crop_task_data_t *)args;
+    for (int i = 1; i < task->rois->size(); i++) {
+        xSemaphoreTake(task->free, portMAX_DELAY);
+        task->preprocessor->preprocess(
+            *task->img, (*task->rois)[i], task->dst, task->scales + 2 * i, task->scales + 2 * i + 1);
+        xSemaphoreGive(task->done);
+    }
+    vTaskSuspend(NULL);
+}
+#endif
+
+std::list<dl::detect::result_t> &Detect::run(const dl::image::img_t &img,
+                                             const std::vector<std::vector<int>> &rois,
+                                             runtime_mode_t mode)
+{
+    ESP_LOGW(TAG, "This detector does not support regions, detect in the whole image.");
+    return run(img);
+}
+
+std::list<dl::detect::result_t> &Detect::run(const dl::image::jpeg_img_t &jpeg_img)
+{
+    dl::image::img_t img = dl::image::sw_decode_jpeg(jpeg_img, dl::image::DL_IMAGE_PIX_TYPE_RGB888);
+    if (!img.data) {
+        static std::list<dl::detect::result_t> empty_result;
+        return empty_result;
+    }
+    std::list<dl::detect::result_t> &result = run(img);
+    heap_caps_free(img.data);
+    return result;
+}
 
 DetectImpl::~DetectImpl()
 {
     delete m_model;
     delete m_image_preprocessor;
     delete m_postprocessor;
+    if (m_next_input) {
+        heap_caps_free(m_next_input);
+    }
 }
 
 std::list<dl::detect::result_t> &DetectImpl::run(const dl::image::img_t &img)
@@ -25,6 +79,8 @@ std::list<dl::detect::result_t> &DetectImpl::run(const dl::image::img_t &img)
     m_postprocessor->clear_result();
     m_postprocessor->set_resize_scale_x(m_image_preprocessor->get_resize_scale_x());
     m_postprocessor->set_resize_scale_y(m_image_preprocessor->get_resize_scale_y());
+    m_postprocessor->set_top_left_x(0);
+    m_postprocessor->set_top_left_y(0);
     m_postprocessor->postprocess();
     std::list<dl::detect::result_t> &result = m_postprocessor->get_result(img.width, img.height);
     DL_LOG_INFER_LATENCY_END_PRINT("detect", "post");
@@ -32,5 +88,134 @@ std::list<dl::detect::result_t> &DetectImpl::run(const dl::image::img_t &img)
     return result;
 }
 
+std::list<dl::detect::result_t> &DetectImpl::run(const dl::image::jpeg_img_t &jpeg_img)
+{
+    DL_LOG_INFER_LATENCY_INIT();
+    DL_LOG_INFER_LATENCY_START();
+    int width = 0, height = 0;
+    esp_err_t ret = m_image_preprocessor->preprocess(jpeg_img, &width, &height);
+    DL_LOG_INFER_LATENCY_END_PRINT("detect", "decode + pre");
+
+    m_postprocessor->clear_result();
+    if (ret != ESP_OK) {
+        return m_postprocessor->get_result(width, height);
+    }
+
+    DL_LOG_INFER_LATENCY_START();
+    m_model->run();
+    DL_LOG_INFER_LATENCY_END_PRINT("detect", "model");
+
+    DL_LOG_INFER_LATENCY_START();
+    m_postprocessor->set_resize_scale_x(m_image_preprocessor->get_resize_scale_x());
+    m_postprocessor->set_resize_scale_y(m_image_preprocessor->get_resize_scale_y());
+    m_postprocessor->set_top_left_x(0);
+    m_postprocessor->set_top_left_y(0);
+    m_postprocessor->postprocess();
+    std::list<dl::detect::result_t> &result = m_postprocessor->get_result(width, height);
+    DL_LOG_INFER_LATENCY_END_PRINT("detect", "post");
+
+    return result;
+}
+
+std::list<dl::detect::result_t> &DetectImpl::run(const dl::image::img_t &img,
+                                                 const std::vector<std::vector<int>> &rois,
+                                                 runtime_mode_t mode)
+{
+    int num = rois.size();
+    m_postprocessor->clear_result();
+    m_postprocessor->clear_merged_result();
+    if (num == 0) {
+        m_postprocessor->nms_merged_result();
+        return m_postprocessor->get_result(img.width, img.height);
+    }
+    m_roi_scales.resize(2 * num);
+
+    DL_LOG_INFER_LATENCY_ARRAY_INIT_WITH_SIZE(2, num);
+    DL_LOG_INFER_LATENCY_ARRAY_START(1);
+    TensorBase *input = m_image_preprocessor->m_model_input;
+    m_image_preprocessor->preprocess(img, rois[0], input->data, &m_roi_scales[0], &m_roi_scales[1]);
+
+    // A single core model run leaves the other core free to preprocess the next region.
+#if portNUM_PROCESSORS > 1
+    bool overlap = false;
+    crop_task_data_t task_data;
+    TaskHandle_t task_handle = nullptr;
+    if (num > 1 && mode == RUNTIME_MODE_SINGLE_CORE) {
+        if (!m_next_input) {
+            m_next_input = heap_caps_aligned_alloc(16, input->get_bytes(), MALLOC_CAP_DEFAULT);
+        }
+        if (m_next_input) {
+            task_data = {
+                .preprocessor = m_image_preprocessor,
+                .img = &img,
+                .rois = &rois,
+                .dst = m_next_input,
+                .scales = m_roi_scales.data(),
+                .free = xSemaphoreCreateBinary(),
+                .done = xSemaphoreCreateBinary(),
+            };
+            if (task_data.free && task_data.done) {
+                xSemaphoreGive(task_data.free);
+                BaseType_t core_id = xPortGetCoreID();
+                UBaseType_t priority = uxTaskPriorityGet(xTaskGetCurrentTaskHandle());
+                overlap = xTaskCreatePinnedToCore(
+                              crop_task, NULL, 4096, &task_data, priority, &task_handle, (core_id + 1) % 2) == pdPASS;
+            }
+            if (!overlap) {
+                if (task_data.free) {
+                    vSemaphoreDelete(task_data.free);
+                }
+                if (task_data.done) {
+                    vSemaphoreDelete(task_data.done);
+                }
+            }
+        }
+        if (!overlap) {
+            ESP_LOGW(TAG, "Failed to create the crop task on the other core, crop the regions one after the other");
+        }
+    }
+#endif
+
+    for (int i = 0; i < num; i++) {
+        DL_LOG_INFER_LATENCY_ARRAY_START(0);
+        if (i > 0) {
+#if portNUM_PROCESSORS > 1
+            if (overlap) {
+                xSemaphoreTake(task_data.done, portMAX_DELAY);
+                tool::copy_memory(input->data, m_next_input, input->get_bytes());
+                xSemaphoreGive(task_data.free);
+            } else
+#endif
+            {
+                m_image_preprocessor->preprocess(
+                    img, rois[i], input->data, &m_roi_scales[2 * i], &m_roi_scales[2 * i + 1]);
+            }
+        }
+        m_model->run(mode);
+        m_postprocessor->clear_result();
+        m_postprocessor->set_resize_scale_x(m_roi_scales[2 * i]);
+        m_postprocessor->set_resize_scale_y(m_roi_scales[2 * i + 1]);
+        m_postprocessor->set_top_left_x(rois[i][0]);
+        m_postprocessor->set_top_left_y(rois[i][1]);
+        m_postprocessor->postprocess();
+        m_postprocessor->merge_result();
+        DL_LOG_INFER_LATENCY_ARRAY_END(0);
+    }
+
+#if portNUM_PROCESSORS > 1
+    if (overlap) {
+        vTaskDelete(task_handle);
+        vSemaphoreDelete(task_data.free);
+        vSemaphoreDelete(task_data.done);
+    }
+#endif
+    m_postprocessor->nms_merged_result();
+    std::list<dl::detect::result_t> &result = m_postprocessor->get_result(img.width, img.height);
+    DL_LOG_INFER_LATENCY_ARRAY_END(1);
+    DL_LOG_INFER_LATENCY_ARRAY_PRINT(0, "detect", "per region");
+    DL_LOG_INFER_LATENCY_ARRAY_PRINT(1, "detect", "all regions");
+    return result;
+}
+
 } // namespace detect
 } // namespace dl
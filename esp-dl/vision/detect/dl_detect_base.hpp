@@ -10,6 +10,29 @@ class Detect {
 public:
     virtual ~Detect() {};
     virtual std::list<dl::detect::result_t> &run(const dl::image::img_t &img) = 0;
+
+    /**
+     * @brief Detect in regions of the image, e.g. around the boxes of a first stage detector. Each region is cropped
+     *        and resized straight from img into the model input.
+     *
+     * @param img   input image
+     * @param rois  [x1, y1, x2, y2] of each region, x2 and y2 excluded
+     * @param mode  runtime mode of the model, with RUNTIME_MODE_SINGLE_CORE the next region is preprocessed on the
+     *              other core while the model runs
+     * @return boxes of all the regions in image coordinates
+     */
+    virtual std::list<dl::detect::result_t> &run(const dl::image::img_t &img,
+                                                 const std::vector<std::vector<int>> &rois,
+                                                 runtime_mode_t mode = RUNTIME_MODE_SINGLE_CORE);
+
+    /**
+     * @brief Detect in a jpeg image. The default decodes the whole image and calls run(img), detectors with a model
+     *        decode it straight into the model input instead.
+     *
+     * @param jpeg_img  input jpeg image
+     * @return boxes in the coordinates of the jpeg image
+     */
+    virtual std::list<dl::detect::result_t> &run(const dl::image::jpeg_img_t &jpeg_img);
 };
 
 class DetectWrapper : public Detect {
@@ -19,6 +42,13 @@ protected:
 public:
     ~DetectWrapper() { delete m_model; }
     std::list<dl::detect::result_t> &run(const dl::image::img_t &img) { return m_model->run(img); }
+    std::list<dl::detect::result_t> &run(const dl::image::img_t &img,
+                                         const std::vector<std::vector<int>> &rois,
+                                         runtime_mode_t mode = RUNTIME_MODE_SINGLE_CORE)
+    {
+        return m_model->run(img, rois, mode);
+    }
+    std::list<dl::detect::result_t> &run(const dl::image::jpeg_img_t &jpeg_img) { return m_model->run(jpeg_img); }
 };
 
 class DetectImpl : public Detect {
@@ -26,10 +56,16 @@ protected:
     dl::Model *m_model;
     dl::image::ImagePreprocessor *m_image_preprocessor;
     dl::detect::DetectPostprocessor *m_postprocessor;
+    void *m_next_input = nullptr;    /*!< model input of the next region, preprocessed on the other core */
+    std::vector<float> m_roi_scales; /*!< [scale_x, scale_y] of each region */
 
 public:
     ~DetectImpl();
     std::list<dl::detect::result_t> &run(const dl::image::img_t &img) override;
+    std::list<dl::detect::result_t> &run(const dl::image::img_t &img,
+                                         const std::vector<std::vector<int>> &rois,
+                                         runtime_mode_t mode = RUNTIME_MODE_SINGLE_CORE) override;
+    std::list<dl::detect::result_t> &run(const dl::image::jpeg_img_t &jpeg_img) override;
 };
 } // namespace detect
 } // namespace dl
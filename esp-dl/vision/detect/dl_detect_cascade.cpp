@@ -0,0 +1,41 @@
+#include "dl_detect_cascade.hpp"
+#include <cmath>
+
+namespace dl {
+namespace detect {
+std::vector<int> get_roi(const int *box, int width, int height, float expand, bool square)
+{
+    float center_x = (box[0] + box[2]) / 2.f;
+    float center_y = (box[1] + box[3]) / 2.f;
+    float w = (box[2] - box[0]) * (1 + expand);
+    float h = (box[3] - box[1]) * (1 + expand);
+    if (square) {
+        w = h = DL_MAX(w, h);
+    }
+    int x1 = DL_MAX((int)lroundf(center_x - w / 2), 0);
+    int y1 = DL_MAX((int)lroundf(center_y - h / 2), 0);
+    int x2 = DL_MIN((int)lroundf(center_x + w / 2), width);
+    int y2 = DL_MIN((int)lroundf(center_y + h / 2), height);
+    if (x2 <= x1 || y2 <= y1) {
+        return {};
+    }
+    return {x1, y1, x2, y2};
+}
+
+std::list<result_t> &DetectCascade::run(const dl::image::img_t &img)
+{
+    std::list<result_t> &boxes = m_first_stage->run(img);
+    m_rois.clear();
+    for (const result_t &res : boxes) {
+        if ((int)m_rois.size() >= m_max_rois) {
+            break;
+        }
+        std::vector<int> roi = get_roi(res.box, img.width, img.height, m_expand, m_square);
+        if (!roi.empty()) {
+            m_rois.push_back(std::move(roi));
+        }
+    }
+    return m_second_stage->run(img, m_rois, m_mode);
+}
+} // namespace detect
+} // namespace dl
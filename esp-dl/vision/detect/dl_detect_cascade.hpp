@@ -0,0 +1,73 @@
+#pragma once
+
+#include "dl_detect_base.hpp"
+#include <list>
+#include <vector>
+
+namespace dl {
+namespace detect {
+/**
+ * @brief Get the region around a box in which a second stage model runs.
+ *
+ * @param box     [x1, y1, x2, y2] box
+ * @param width   width of the image
+ * @param height  height of the image
+ * @param expand  the region is (1 + expand) times the box on each side
+ * @param square  use the longer side of the expanded box for both sides
+ * @return [x1, y1, x2, y2] region clipped to the image, x2 and y2 excluded. Empty if nothing is left.
+ */
+std::vector<int> get_roi(const int *box, int width, int height, float expand = 0, bool square = false);
+
+/**
+ * @brief Two stage detection, the second stage detector only runs around the boxes of the first stage, e.g. a pose
+ *        model on the persons found by a small detector.
+ *
+ * The regions are cropped and resized straight from the image into the model input of the second stage, and with
+ * RUNTIME_MODE_SINGLE_CORE the next region is preprocessed on the other core while the model runs.
+ */
+class DetectCascade : public Detect {
+public:
+    /**
+     * @brief Construct a new DetectCascade object.
+     *
+     * @param first_stage   detector of the regions, not owned
+     * @param second_stage  detector run in each region, not owned
+     * @param expand        each region is (1 + expand) times the first stage box on each side
+     * @param square        use square regions, for second stage models with a square input
+     * @param max_rois      max number of regions, the highest scoring first stage boxes are used
+     * @param mode          runtime mode of the second stage model
+     */
+    DetectCascade(Detect *first_stage,
+                  Detect *second_stage,
+                  float expand = 0.2,
+                  bool square = true,
+                  int max_rois = 8,
+                  runtime_mode_t mode = RUNTIME_MODE_SINGLE_CORE) :
+        m_first_stage(first_stage),
+        m_second_stage(second_stage),
+        m_expand(expand),
+        m_square(square),
+        m_max_rois(max_rois),
+        m_mode(mode)
+    {
+    }
+
+    std::list<result_t> &run(const dl::image::img_t &img) override;
+    using Detect::run;
+
+    /**
+     * @brief Regions of the last run(), in descending score order of the first stage boxes.
+     */
+    const std::vector<std::vector<int>> &get_rois() { return m_rois; }
+
+private:
+    Detect *m_first_stage;
+    Detect *m_second_stage;
+    float m_expand;
+    bool m_square;
+    int m_max_rois;
+    runtime_mode_t m_mode;
+    std::vector<std::vector<int>> m_rois;
+};
+} // namespace detect
+} // namespace dl
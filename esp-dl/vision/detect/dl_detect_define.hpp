@@ -6,11 +6,29 @@
 
 namespace dl {
 namespace detect {
+/**
+ * @brief Keypoints of a detected box, [x1, y1, x2, y2, ...]. The values are stored in a pool owned by the
+ * postprocessor, so they are valid until the postprocessor runs again. Copy them to keep them longer.
+ */
 typedef struct {
-    int category;              /*!< category index */
-    float score;               /*!< score of box */
-    std::vector<int> box;      /*!< [left_up_x, left_up_y, right_down_x, right_down_y] */
-    std::vector<int> keypoint; /*!< [x1, y1, x2, y2, ...] */
+    int *data; /*!< pointer to the first value */
+    int num;   /*!< number of values, twice the number of keypoints */
+    int &operator[](int i) { return data[i]; }
+    const int &operator[](int i) const { return data[i]; }
+    int size() const { return num; }
+    bool empty() const { return num == 0; }
+    int *begin() { return data; }
+    int *end() { return data + num; }
+    const int *begin() const { return data; }
+    const int *end() const { return data + num; }
+    operator std::vector<int>() const { return std::vector<int>(data, data + num); }
+} keypoint_view_t;
+
+typedef struct {
+    int category;             /*!< category index */
+    float score;              /*!< score of box */
+    int box[4];               /*!< [left_up_x, left_up_y, right_down_x, right_down_y] */
+    keypoint_view_t keypoint; /*!< [x1, y1, x2, y2, ...] */
     void limit_box(int width, int height)
     {
         box[0] = DL_CLIP(box[0], 0, width - 1);
@@ -20,7 +38,7 @@ typedef struct {
     }
     void limit_keypoint(int width, int height)
     {
-        for (int i = 0; i < keypoint.size(); i++) {
+        for (int i = 0; i < keypoint.num; i++) {
             if (i % 2 == 0)
                 keypoint[i] = DL_CLIP(keypoint[i], 0, width - 1);
             else
@@ -30,11 +48,16 @@ typedef struct {
     int box_area() const { return (box[2] - box[0]) * (box[3] - box[1]); }
 } result_t;
 
-inline bool greater_box(result_t a, result_t b)
+inline bool greater_box(const result_t &a, const result_t &b)
 {
     return a.score > b.score;
 }
 
+typedef enum {
+    NMS_TYPE_HARD, /*!< greedy NMS, a box is filtered by any kept box with higher score */
+    NMS_TYPE_FAST, /*!< Fast NMS, a box is filtered by any box with higher score, whether kept or not */
+} nms_type_t;
+
 typedef struct {
     int stride_y;
     int stride_x;
@@ -26,33 +26,34 @@ void ESPDetPostProcessor::parse_stage(TensorBase *score, TensorBase *box, const
     float inv_resize_scale_x = 1.f / m_resize_scale_x;
     float inv_resize_scale_y = 1.f / m_resize_scale_y;
 
-    for (size_t y = 0; y < H; y++) {
-        for (size_t x = 0; x < W; x++) {
-            for (size_t c = 0; c < C; c++) {
-                if (*score_ptr >= score_thr_quant) {
+    // score >= score_thr_quant <=> score > score_thr_quant - 1
+    int cell_num = filter_cells(score_ptr, H * W, C, score_thr_quant - 1);
+    for (int i = 0; i < cell_num; i++) {
+        int cell = m_cells[i];
+        int y = cell / W;
+        int x = cell % W;
+        T *cell_score = score_ptr + cell * C;
+        T *cell_box = box_ptr + cell * 4;
+        for (int c = 0; c < C; c++) {
+            if (cell_score[c] >= score_thr_quant) {
+                float score_val = dl::math::sigmoid(dequantize(cell_score[c], score_exp));
+                if (m_candidates.accept(score_val)) {
                     int center_y = y * stride_y + offset_y;
                     int center_x = x * stride_x + offset_x;
 
                     float box_data[4];
-                    for (int i = 0; i < 4; i++) {
-                        box_data[i] = dequantize(box_ptr[i], box_exp);
+                    for (int j = 0; j < 4; j++) {
+                        box_data[j] = dequantize(cell_box[j], box_exp);
                     }
 
-                    result_t new_box = {(int)c,
-                                        dl::math::sigmoid(dequantize(*score_ptr, score_exp)),
-                                        {(int)((center_x - box_data[0] * stride_x) * inv_resize_scale_x),
-                                         (int)((center_y - box_data[1] * stride_y) * inv_resize_scale_y),
-                                         (int)((center_x + box_data[2] * stride_x) * inv_resize_scale_x),
-                                         (int)((center_y + box_data[3] * stride_y) * inv_resize_scale_y)},
-                                        {}};
-
-                    m_box_list.insert(std::upper_bound(m_box_list.begin(), m_box_list.end(), new_box, greater_box),
-                                      new_box);
+                    m_candidates.push(c,
+                                      score_val,
+                                      (int)((center_x - box_data[0] * stride_x) * inv_resize_scale_x + m_top_left_x),
+                                      (int)((center_y - box_data[1] * stride_y) * inv_resize_scale_y + m_top_left_y),
+                                      (int)((center_x + box_data[2] * stride_x) * inv_resize_scale_x + m_top_left_x),
+                                      (int)((center_y + box_data[3] * stride_y) * inv_resize_scale_y + m_top_left_y));
                 }
-                score_ptr++;
             }
-
-            box_ptr += 4;
         }
     }
 }
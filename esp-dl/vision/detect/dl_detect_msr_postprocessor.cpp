@@ -28,39 +28,39 @@ void MSRPostprocessor::parse_stage(TensorBase *score, TensorBase *box, const int
     float inv_resize_scale_x = 1.f / m_resize_scale_x;
     float inv_resize_scale_y = 1.f / m_resize_scale_y;
 
-    for (size_t y = 0; y < H; y++) // height
-    {
-        for (size_t x = 0; x < W; x++) // width
+    int cell_num = filter_cells(score_ptr, H * W, A * C, score_thr_quant);
+    for (int i = 0; i < cell_num; i++) {
+        int cell = m_cells[i];
+        int y = cell / W;
+        int x = cell % W;
+        T *cell_score = score_ptr + cell * A * C;
+        T *cell_box = box_ptr + cell * A * C * 4;
+        for (int a = 0; a < A; a++) // anchor number
         {
-            for (size_t a = 0; a < A; a++) // anchor number
+            for (int c = 0; c < C; c++) // category number
             {
-                for (size_t c = 0; c < C; c++) // category number
-                {
-                    if (*score_ptr > score_thr_quant) {
+                if (cell_score[a * C + c] > score_thr_quant) {
+                    float score_val = dl::math::sigmoid(dequantize(cell_score[a * C + c], score_exp));
+                    if (m_candidates.accept(score_val)) {
+                        T *anchor_box = cell_box + (a * C + c) * 4;
                         int center_y = y * stride_y + offset_y;
                         int center_x = x * stride_x + offset_x;
                         int anchor_h = anchor_shape[a][0];
                         int anchor_w = anchor_shape[a][1];
-                        result_t new_box = {
-                            (int)c,
-                            dl::math::sigmoid(dequantize(*score_ptr, score_exp)),
-                            {(int)((center_x - (anchor_w >> 1) + anchor_w * dequantize(box_ptr[0], box_exp)) *
-                                   inv_resize_scale_x),
-                             (int)((center_y - (anchor_h >> 1) + anchor_h * dequantize(box_ptr[1], box_exp)) *
-                                   inv_resize_scale_y),
-                             (int)((center_x + anchor_w - (anchor_w >> 1) +
-                                    anchor_w * dequantize(box_ptr[2], box_exp)) *
-                                   inv_resize_scale_x),
-                             (int)((center_y + anchor_h - (anchor_h >> 1) +
-                                    anchor_h * dequantize(box_ptr[3], box_exp)) *
-                                   inv_resize_scale_y)},
-                            {}};
-
-                        m_box_list.insert(std::upper_bound(m_box_list.begin(), m_box_list.end(), new_box, greater_box),
-                                          new_box);
+                        m_candidates.push(
+                            c,
+                            score_val,
+                            (int)((center_x - (anchor_w >> 1) + anchor_w * dequantize(anchor_box[0], box_exp)) *
+                                  inv_resize_scale_x + m_top_left_x),
+                            (int)((center_y - (anchor_h >> 1) + anchor_h * dequantize(anchor_box[1], box_exp)) *
+                                  inv_resize_scale_y + m_top_left_y),
+                            (int)((center_x + anchor_w - (anchor_w >> 1) +
+                                   anchor_w * dequantize(anchor_box[2], box_exp)) *
+                                  inv_resize_scale_x + m_top_left_x),
+                            (int)((center_y + anchor_h - (anchor_h >> 1) +
+                                   anchor_h * dequantize(anchor_box[3], box_exp)) *
+                                  inv_resize_scale_y + m_top_left_y));
                     }
-                    score_ptr++;
-                    box_ptr += 4;
                 }
             }
         }
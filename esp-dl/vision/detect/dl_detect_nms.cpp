@@ -0,0 +1,219 @@
+#include "dl_detect_nms.hpp"
+#include <algorithm>
+
+namespace dl {
+namespace detect {
+DetectCandidates::DetectCandidates(const int capacity, const int keypoint_num) : m_capacity(0), m_keypoint_num(0)
+{
+    set_capacity(capacity);
+    set_keypoint_num(keypoint_num);
+}
+
+void DetectCandidates::set_capacity(const int capacity)
+{
+    m_capacity = DL_MAX(capacity, 1);
+    m_category.resize(m_capacity);
+    m_score.resize(m_capacity);
+    m_box.resize(4 * m_capacity);
+    m_keypoint.resize(m_keypoint_num * m_capacity);
+    m_anchor.resize(2 * m_capacity);
+    m_heap.reserve(m_capacity);
+    clear();
+}
+
+void DetectCandidates::set_keypoint_num(const int keypoint_num)
+{
+    if (keypoint_num == m_keypoint_num) {
+        return;
+    }
+    m_keypoint_num = keypoint_num;
+    m_keypoint.resize(m_keypoint_num * m_capacity);
+}
+
+void DetectCandidates::heap_sift_up(int pos)
+{
+    int slot = m_heap[pos];
+    while (pos > 0) {
+        int parent = (pos - 1) >> 1;
+        if (!heap_less(slot, m_heap[parent])) {
+            break;
+        }
+        m_heap[pos] = m_heap[parent];
+        pos = parent;
+    }
+    m_heap[pos] = slot;
+}
+
+void DetectCandidates::heap_sift_down(int pos)
+{
+    int n = m_heap.size();
+    int slot = m_heap[pos];
+    while (true) {
+        int child = 2 * pos + 1;
+        if (child >= n) {
+            break;
+        }
+        if (child + 1 < n && heap_less(m_heap[child + 1], m_heap[child])) {
+            child++;
+        }
+        if (!heap_less(m_heap[child], slot)) {
+            break;
+        }
+        m_heap[pos] = m_heap[child];
+        pos = child;
+    }
+    m_heap[pos] = slot;
+}
+
+int DetectCandidates::push(
+    const int category, const float score, const int x1, const int y1, const int x2, const int y2)
+{
+    int slot;
+    bool append = (int)m_heap.size() < m_capacity;
+    if (append) {
+        slot = m_heap.size();
+        m_heap.push_back(slot);
+    } else if (score > m_score[m_heap[0]]) {
+        // Reuse the slot of the lowest scoring candidate.
+        slot = m_heap[0];
+    } else {
+        return -1;
+    }
+
+    m_category[slot] = category;
+    m_score[slot] = score;
+    int *box = m_box.data() + 4 * slot;
+    box[0] = x1;
+    box[1] = y1;
+    box[2] = x2;
+    box[3] = y2;
+
+    if (append) {
+        heap_sift_up(m_heap.size() - 1);
+    } else {
+        heap_sift_down(0);
+    }
+    return slot;
+}
+
+void DetectCandidates::sort_candidates(bool class_aware)
+{
+    int n = m_heap.size();
+    m_order.assign(m_heap.begin(), m_heap.end());
+    std::sort(m_order.begin(), m_order.end(), [this](int a, int b) -> bool {
+        return m_score[a] > m_score[b] || (m_score[a] == m_score[b] && a < b);
+    });
+
+    // Shift boxes of different categories apart so that they never overlap, then one pass of NMS handles all
+    // categories.
+    int offset_unit = 0;
+    if (class_aware && n > 0) {
+        int min_coord = m_box[4 * m_order[0]];
+        int max_coord = min_coord;
+        for (int i = 0; i < n; i++) {
+            const int *box = m_box.data() + 4 * m_order[i];
+            for (int j = 0; j < 4; j++) {
+                min_coord = DL_MIN(min_coord, box[j]);
+                max_coord = DL_MAX(max_coord, box[j]);
+            }
+        }
+        offset_unit = max_coord - min_coord + 2;
+    }
+
+    m_sorted_box.resize(4 * n);
+    m_sorted_area.resize(n);
+    int *x1 = m_sorted_box.data();
+    int *y1 = x1 + n;
+    int *x2 = y1 + n;
+    int *y2 = x2 + n;
+    for (int i = 0; i < n; i++) {
+        int slot = m_order[i];
+        const int *box = m_box.data() + 4 * slot;
+        int offset = offset_unit * m_category[slot];
+        x1[i] = box[0] + offset;
+        y1[i] = box[1] + offset;
+        x2[i] = box[2] + offset;
+        y2[i] = box[3] + offset;
+        m_sorted_area[i] = (box[2] - box[0] + 1) * (box[3] - box[1] + 1);
+    }
+    m_removed.assign(n, 0);
+}
+
+int DetectCandidates::nms_hard(const float iou_thr, const int top_k)
+{
+    int n = m_order.size();
+    const int *x1 = m_sorted_box.data();
+    const int *y1 = x1 + n;
+    const int *x2 = y1 + n;
+    const int *y2 = x2 + n;
+    const int *area = m_sorted_area.data();
+    uint8_t *removed = m_removed.data();
+
+    for (int i = 0; i < n && (int)m_keep.size() < top_k; i++) {
+        if (removed[i]) {
+            continue;
+        }
+        m_keep.push_back(m_order[i]);
+
+        int kept_x1 = x1[i], kept_y1 = y1[i], kept_x2 = x2[i], kept_y2 = y2[i];
+        float kept_area = area[i];
+        // Branch-free inner loop over contiguous arrays, iou > thr is evaluated as inter > thr * union.
+        for (int j = i + 1; j < n; j++) {
+            int inter_w = DL_MIN(kept_x2, x2[j]) - DL_MAX(kept_x1, x1[j]) + 1;
+            int inter_h = DL_MIN(kept_y2, y2[j]) - DL_MAX(kept_y1, y1[j]) + 1;
+            inter_w = DL_MAX(inter_w, 0);
+            inter_h = DL_MAX(inter_h, 0);
+            float inter_area = inter_w * inter_h;
+            removed[j] |= inter_area > iou_thr * (kept_area + area[j] - inter_area);
+        }
+    }
+    return m_keep.size();
+}
+
+int DetectCandidates::nms_fast(const float iou_thr, const int top_k)
+{
+    int n = m_order.size();
+    const int *x1 = m_sorted_box.data();
+    const int *y1 = x1 + n;
+    const int *x2 = y1 + n;
+    const int *y2 = x2 + n;
+    const int *area = m_sorted_area.data();
+    uint8_t *removed = m_removed.data();
+
+    // A box is filtered by every box with higher score, suppressed ones included. The IoU matrix is evaluated
+    // without the data dependency on the kept set, only the top_k survivors are needed.
+    for (int i = 0; i < n; i++) {
+        int kept_x1 = x1[i], kept_y1 = y1[i], kept_x2 = x2[i], kept_y2 = y2[i];
+        float kept_area = area[i];
+        for (int j = i + 1; j < n; j++) {
+            int inter_w = DL_MIN(kept_x2, x2[j]) - DL_MAX(kept_x1, x1[j]) + 1;
+            int inter_h = DL_MIN(kept_y2, y2[j]) - DL_MAX(kept_y1, y1[j]) + 1;
+            inter_w = DL_MAX(inter_w, 0);
+            inter_h = DL_MAX(inter_h, 0);
+            float inter_area = inter_w * inter_h;
+            removed[j] |= inter_area > iou_thr * (kept_area + area[j] - inter_area);
+        }
+        if (!removed[i]) {
+            m_keep.push_back(m_order[i]);
+            if ((int)m_keep.size() >= top_k) {
+                break;
+            }
+        }
+    }
+    return m_keep.size();
+}
+
+int DetectCandidates::nms(const float iou_thr, const int top_k, const nms_type_t type, const bool class_aware)
+{
+    m_keep.clear();
+    if (m_heap.empty() || top_k <= 0) {
+        return 0;
+    }
+    sort_candidates(class_aware);
+    if (type == NMS_TYPE_FAST) {
+        return nms_fast(iou_thr, top_k);
+    }
+    return nms_hard(iou_thr, top_k);
+}
+} // namespace detect
+} // namespace dl
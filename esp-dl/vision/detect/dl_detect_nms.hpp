@@ -0,0 +1,128 @@
+#pragma once
+
+#include "dl_detect_define.hpp"
+#include <vector>
+
+namespace dl {
+namespace detect {
+/**
+ * @brief Flat candidate buffer filled by parse_stage() and consumed by NMS.
+ *
+ * Candidates are stored as structure-of-arrays in storage which is kept across frames. The buffer holds at most
+ * capacity candidates, a min-heap on score evicts the lowest scoring candidate once it is full.
+ */
+class DetectCandidates {
+private:
+    int m_capacity;                 /*!< max number of candidates kept before NMS */
+    int m_keypoint_num;             /*!< number of keypoint values per candidate */
+    std::vector<int> m_category;    /*!< category of each slot */
+    std::vector<float> m_score;     /*!< score of each slot */
+    std::vector<int> m_box;         /*!< [x1, y1, x2, y2] of each slot */
+    std::vector<int> m_keypoint;    /*!< m_keypoint_num values of each slot */
+    std::vector<int> m_anchor;      /*!< [stage_index, cell_index] of each slot */
+    std::vector<int> m_heap;        /*!< min-heap of slots on score */
+    std::vector<int> m_order;       /*!< slots sorted by score in descending order */
+    std::vector<int> m_sorted_box;  /*!< planar [x1..., y1..., x2..., y2...] in m_order order */
+    std::vector<int> m_sorted_area; /*!< areas in m_order order */
+    std::vector<uint8_t> m_removed; /*!< suppression flag in m_order order */
+    std::vector<int> m_keep;        /*!< kept slots in descending score order */
+
+    void heap_sift_up(int pos);
+    void heap_sift_down(int pos);
+    bool heap_less(int slot_a, int slot_b) const
+    {
+        return m_score[slot_a] < m_score[slot_b] || (m_score[slot_a] == m_score[slot_b] && slot_a > slot_b);
+    }
+    void sort_candidates(bool class_aware);
+    int nms_hard(const float iou_thr, const int top_k);
+    int nms_fast(const float iou_thr, const int top_k);
+
+public:
+    /**
+     * @brief Construct a new DetectCandidates object.
+     *
+     * @param capacity      Max number of candidates kept before NMS.
+     * @param keypoint_num  Number of keypoint values per candidate, e.g. 34 for 17 (x, y) keypoints.
+     */
+    DetectCandidates(const int capacity = 1000, const int keypoint_num = 0);
+
+    /**
+     * @brief Change the max number of candidates. Clears the buffer.
+     *
+     * @param capacity Max number of candidates kept before NMS.
+     */
+    void set_capacity(const int capacity);
+
+    /**
+     * @brief Change the number of keypoint values per candidate. No-op if unchanged.
+     *
+     * @param keypoint_num Number of keypoint values per candidate.
+     */
+    void set_keypoint_num(const int keypoint_num);
+
+    int get_capacity() const { return m_capacity; }
+    int get_keypoint_num() const { return m_keypoint_num; }
+    int size() const { return m_heap.size(); }
+    void clear()
+    {
+        m_heap.clear();
+        m_keep.clear();
+    }
+
+    /**
+     * @brief Whether push() would keep a candidate with this score. Use it to skip decoding rejected boxes.
+     *
+     * @param score Candidate score.
+     * @return true if the candidate would be kept.
+     */
+    bool accept(const float score) const { return (int)m_heap.size() < m_capacity || score > m_score[m_heap[0]]; }
+
+    /**
+     * @brief Add a candidate, evicting the lowest scoring one if the buffer is full.
+     *
+     * @return Slot index of the candidate, -1 if rejected.
+     */
+    int push(const int category, const float score, const int x1, const int y1, const int x2, const int y2);
+
+    int get_category(const int slot) const { return m_category[slot]; }
+    float get_score(const int slot) const { return m_score[slot]; }
+    int *get_box(const int slot) { return m_box.data() + 4 * slot; }
+    int *get_keypoint(const int slot) { return m_keypoint.data() + m_keypoint_num * slot; }
+
+    /**
+     * @brief Record where a candidate was decoded from, so that its other outputs (e.g. keypoints) can be decoded
+     * after NMS, only for the kept boxes.
+     *
+     * @param slot         Slot index returned by push().
+     * @param stage_index  Index of the detection stage.
+     * @param cell_index   Index of the anchor cell in the stage, y * W + x.
+     */
+    void set_anchor(const int slot, const int stage_index, const int cell_index)
+    {
+        m_anchor[2 * slot] = stage_index;
+        m_anchor[2 * slot + 1] = cell_index;
+    }
+    int get_anchor_stage(const int slot) const { return m_anchor[2 * slot]; }
+    int get_anchor_cell(const int slot) const { return m_anchor[2 * slot + 1]; }
+
+    /**
+     * @brief Run NMS over the candidates.
+     *
+     * @param iou_thr      Candidate box with higher IoU than iou_thr will be filtered.
+     * @param top_k        Keep top_k number of boxes.
+     * @param type         NMS variant.
+     * @param class_aware  If true, only boxes of the same category suppress each other.
+     * @return Number of kept boxes, see get_keep().
+     */
+    int nms(const float iou_thr,
+            const int top_k,
+            const nms_type_t type = NMS_TYPE_HARD,
+            const bool class_aware = false);
+
+    /**
+     * @brief Slots kept by the last nms() call, in descending score order.
+     */
+    const std::vector<int> &get_keep() const { return m_keep; }
+};
+} // namespace detect
+} // namespace dl
@@ -1,45 +1,150 @@
 #include "dl_detect_postprocessor.hpp"
+#include <limits>
 
 namespace dl {
 namespace detect {
+void DetectPostprocessor::set_keypoint_num(int keypoint_num)
+{
+    if (keypoint_num == m_keypoint_num) {
+        return;
+    }
+    m_keypoint_num = keypoint_num;
+    m_keypoint_pool.assign(m_top_k * m_keypoint_num, 0);
+
+    // Each result node owns a fixed chunk of the pool, rebind all of them to the new pool.
+    m_free_list.splice(m_free_list.end(), m_box_list);
+    int i = 0;
+    for (result_t &res : m_free_list) {
+        res.keypoint = {m_keypoint_pool.data() + i * m_keypoint_num, m_keypoint_num};
+        i++;
+    }
+}
+
+void DetectPostprocessor::decode_keypoint(int slot, int *keypoint)
+{
+    memcpy(keypoint, m_candidates.get_keypoint(slot), m_keypoint_num * sizeof(int));
+}
+
 void DetectPostprocessor::nms()
 {
-    int kept_number = 0;
-    for (std::list<result_t>::iterator kept = m_box_list.begin(); kept != m_box_list.end(); kept++) {
-        kept_number++;
+    collect_result(m_candidates);
+}
+
+void DetectPostprocessor::collect_result(DetectCandidates &candidates)
+{
+    m_free_list.splice(m_free_list.end(), m_box_list);
+    candidates.nms(m_nms_thr, m_top_k, m_nms_type, m_class_aware_nms);
+    for (int slot : candidates.get_keep()) {
+        if (m_free_list.empty()) {
+            // At most m_top_k nodes are ever created, node i owns the i-th chunk of the keypoint pool.
+            int index = m_box_list.size();
+            m_free_list.push_back(
+                {0, 0.f, {0, 0, 0, 0}, {m_keypoint_pool.data() + index * m_keypoint_num, m_keypoint_num}});
+        }
+        m_box_list.splice(m_box_list.end(), m_free_list, m_free_list.begin());
+
+        result_t &res = m_box_list.back();
+        const int *box = candidates.get_box(slot);
+        res.category = candidates.get_category(slot);
+        res.score = candidates.get_score(slot);
+        res.box[0] = box[0];
+        res.box[1] = box[1];
+        res.box[2] = box[2];
+        res.box[3] = box[3];
+        if (m_keypoint_num > 0) {
+            if (&candidates == &m_candidates) {
+                decode_keypoint(slot, res.keypoint.data);
+            } else {
+                memcpy(res.keypoint.data, candidates.get_keypoint(slot), m_keypoint_num * sizeof(int));
+            }
+        }
+    }
+}
+
+void DetectPostprocessor::merge_result()
+{
+    m_merged.set_keypoint_num(m_keypoint_num);
+    for (const result_t &res : m_box_list) {
+        int slot = m_merged.push(res.category, res.score, res.box[0], res.box[1], res.box[2], res.box[3]);
+        if (slot >= 0 && m_keypoint_num > 0) {
+            memcpy(m_merged.get_keypoint(slot), res.keypoint.data, m_keypoint_num * sizeof(int));
+        }
+    }
+}
+
+void DetectPostprocessor::nms_merged_result()
+{
+    collect_result(m_merged);
+}
+
+void DetectPostprocessor::clear_result()
+{
+    m_candidates.clear();
+    m_free_list.splice(m_free_list.end(), m_box_list);
+}
 
-        if (kept_number >= m_top_k) {
-            m_box_list.erase(++kept, m_box_list.end());
-            break;
+template <typename T>
+int DetectPostprocessor::filter_cells(const T *score,
+                                      const int cell_num,
+                                      const int channel_num,
+                                      const int score_thr_quant)
+{
+    m_cells.resize(cell_num);
+    int *cells = m_cells.data();
+    int n = 0;
+
+    if (score_thr_quant >= std::numeric_limits<T>::max()) {
+        m_cells.clear();
+        return 0;
+    }
+    if (score_thr_quant < std::numeric_limits<T>::min()) {
+        for (int i = 0; i < cell_num; i++) {
+            cells[i] = i;
         }
+        return cell_num;
+    }
 
-        int kept_area = (kept->box[2] - kept->box[0] + 1) * (kept->box[3] - kept->box[1] + 1);
-
-        std::list<result_t>::iterator other = kept;
-        other++;
-        for (; other != m_box_list.end();) {
-            int inter_lt_x = DL_MAX(kept->box[0], other->box[0]);
-            int inter_lt_y = DL_MAX(kept->box[1], other->box[1]);
-            int inter_rb_x = DL_MIN(kept->box[2], other->box[2]);
-            int inter_rb_y = DL_MIN(kept->box[3], other->box[3]);
-
-            int inter_height = inter_rb_y - inter_lt_y + 1;
-            int inter_width = inter_rb_x - inter_lt_x + 1;
-
-            if (inter_height > 0 && inter_width > 0) {
-                int other_area = (other->box[2] - other->box[0] + 1) * (other->box[3] - other->box[1] + 1);
-                int inter_area = inter_height * inter_width;
-                float iou = (float)inter_area / (kept_area + other_area - inter_area);
-                if (iou > m_nms_thr) {
-                    other = m_box_list.erase(other);
-                    continue;
-                }
+    if (sizeof(T) == 1 && (channel_num & 3) == 0 && ((uintptr_t)score & 3) == 0) {
+        // Bytes are biased to unsigned, score > thr <=> (score ^ 0x80) >= thr + 129. Even and odd bytes are spread
+        // to 16-bit lanes, bit 8 of a lane is left after subtracting thr + 129 only if its byte passes.
+        const uint32_t *word = (const uint32_t *)score;
+        uint32_t thr = (uint32_t)(score_thr_quant + 129) * 0x00010001;
+        int word_num = channel_num >> 2;
+        for (int i = 0; i < cell_num; i++) {
+            uint32_t hit = 0;
+            for (int j = 0; j < word_num; j++) {
+                uint32_t u = word[j] ^ 0x80808080;
+                hit |= ((u & 0x00ff00ff) | 0x01000100) - thr;
+                hit |= (((u >> 8) & 0x00ff00ff) | 0x01000100) - thr;
+            }
+            word += word_num;
+            cells[n] = i;
+            n += (hit & 0x01000100) != 0;
+        }
+    } else {
+        for (int i = 0; i < cell_num; i++) {
+            T max_score = score[0];
+            for (int j = 1; j < channel_num; j++) {
+                max_score = DL_MAX(max_score, score[j]);
             }
-            other++;
+            score += channel_num;
+            cells[n] = i;
+            n += max_score > score_thr_quant;
         }
     }
+    m_cells.resize(n);
+    return n;
 }
 
+template int DetectPostprocessor::filter_cells<int8_t>(const int8_t *score,
+                                                       const int cell_num,
+                                                       const int channel_num,
+                                                       const int score_thr_quant);
+template int DetectPostprocessor::filter_cells<int16_t>(const int16_t *score,
+                                                        const int cell_num,
+                                                        const int channel_num,
+                                                        const int score_thr_quant);
+
 std::list<result_t> &DetectPostprocessor::get_result(int width, int height)
 {
     for (result_t &res : m_box_list) {
@@ -1,5 +1,6 @@
 #pragma once
 #include "dl_detect_define.hpp"
+#include "dl_detect_nms.hpp"
 #include "dl_model_base.hpp"
 #include "dl_tensor_base.hpp"
 #include <list>
@@ -17,11 +18,64 @@ protected:
     float m_resize_scale_y;
     float m_top_left_x;
     float m_top_left_y;
-    std::list<result_t> m_box_list; /*!< Detected box list */
+    nms_type_t m_nms_type;            /*!< NMS variant */
+    bool m_class_aware_nms;           /*!< If true, only boxes of the same category suppress each other */
+    DetectCandidates m_candidates;    /*!< Candidate boxes before NMS */
+    DetectCandidates m_merged;        /*!< Results of several image regions, see merge_result() */
+    int m_keypoint_num;               /*!< Number of keypoint values of each result */
+    std::vector<int> m_keypoint_pool; /*!< Keypoint storage of the results, m_top_k * m_keypoint_num */
+    std::list<result_t> m_box_list;   /*!< Detected box list */
+    std::list<result_t> m_free_list;  /*!< Result nodes of previous frames, reused by nms() */
+    std::vector<int> m_cells;         /*!< Cells kept by filter_cells() */
+
+    /**
+     * @brief Find the cells of a score tensor which have at least one channel above the threshold, so that
+     * parse_stage() only visits them. The max over channels is computed several elements per word for int8.
+     *
+     * @param score            score data, [cell_num, channel_num]
+     * @param cell_num         number of cells, H * W
+     * @param channel_num      number of score channels of each cell
+     * @param score_thr_quant  a cell is kept if any score > score_thr_quant
+     * @return number of kept cells, their indices are in m_cells
+     */
+    template <typename T>
+    int filter_cells(const T *score, const int cell_num, const int channel_num, const int score_thr_quant);
+
+    /**
+     * @brief Set the number of keypoint values of each result. If it changes, the keypoint pool is reallocated and
+     * the results of the previous nms() are dropped.
+     *
+     * @param keypoint_num number of keypoint values, twice the number of keypoints
+     */
+    void set_keypoint_num(int keypoint_num);
+
+    /**
+     * @brief Write the keypoints of a candidate kept by NMS. By default they are copied from the candidate buffer,
+     * postprocessors which decode keypoints lazily override it.
+     *
+     * @param slot      slot index of the candidate
+     * @param keypoint  output, m_keypoint_num values
+     */
+    virtual void decode_keypoint(int slot, int *keypoint);
+
+    /**
+     * @brief Run NMS on the candidates and turn the kept ones into the results.
+     *
+     * @param candidates  m_candidates or m_merged
+     */
+    void collect_result(DetectCandidates &candidates);
 
 public:
     DetectPostprocessor(Model *model, const float score_thr, const float nms_thr, const int top_k) :
-        m_model(model), m_score_thr(score_thr), m_nms_thr(nms_thr), m_top_k(top_k) {};
+        m_model(model),
+        m_score_thr(score_thr),
+        m_nms_thr(nms_thr),
+        m_top_k(top_k),
+        m_top_left_x(0),
+        m_top_left_y(0),
+        m_nms_type(NMS_TYPE_HARD),
+        m_class_aware_nms(false),
+        m_keypoint_num(0) {};
     virtual ~DetectPostprocessor() {};
     virtual void postprocess() = 0;
     void nms();
@@ -29,8 +83,25 @@ public:
     void set_resize_scale_y(float resize_scale_y) { m_resize_scale_y = resize_scale_y; };
     void set_top_left_x(float top_left_x) { m_top_left_x = top_left_x; };
     void set_top_left_y(float top_left_y) { m_top_left_y = top_left_y; };
-    void clear_result() { m_box_list.clear(); };
+    void set_nms_type(nms_type_t nms_type) { m_nms_type = nms_type; };
+    void set_class_aware_nms(bool class_aware) { m_class_aware_nms = class_aware; };
+    /**
+     * @brief Set the max number of candidate boxes kept before NMS, the lowest scoring ones are dropped first.
+     *
+     * @param max_candidates max number of candidate boxes
+     */
+    void set_max_candidates(int max_candidates) { m_candidates.set_capacity(max_candidates); };
+    void clear_result();
     std::list<result_t> &get_result(int width, int height);
+
+    /**
+     * @brief Detect on several regions of one image. Set the top left corner of each region and call clear_result(),
+     *        postprocess() and merge_result(), then nms_merged_result() gives the results of all regions, without
+     *        the boxes found twice in overlapping regions. The keypoints are decoded before the next region runs.
+     */
+    void clear_merged_result() { m_merged.clear(); }
+    void merge_result();
+    void nms_merged_result();
 };
 
 class AnchorPointDetectPostprocessor : public DetectPostprocessor {
@@ -0,0 +1,214 @@
+#include "dl_detect_tracker.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace dl {
+namespace detect {
+// Weight of a new velocity measurement, lower is smoother but follows changes of motion later.
+static const float s_velocity_gain = 0.5f;
+
+static float box_iou(const int *a, const int *b)
+{
+    int inter_w = DL_MIN(a[2], b[2]) - DL_MAX(a[0], b[0]);
+    int inter_h = DL_MIN(a[3], b[3]) - DL_MAX(a[1], b[1]);
+    if (inter_w <= 0 || inter_h <= 0) {
+        return 0;
+    }
+    float inter_area = inter_w * inter_h;
+    float union_area = (a[2] - a[0]) * (a[3] - a[1]) + (b[2] - b[0]) * (b[3] - b[1]) - inter_area;
+    return union_area > 0 ? inter_area / union_area : 0;
+}
+
+DetectTracker::DetectTracker(
+    Detect *detect, int detect_interval, float motion_thr, float iou_thr, int max_missed, float keypoint_alpha) :
+    m_detect(detect),
+    m_detect_interval(DL_MAX(detect_interval, 1)),
+    m_motion_thr(motion_thr),
+    m_iou_thr(iou_thr),
+    m_max_missed(max_missed),
+    m_keypoint_alpha(keypoint_alpha)
+{
+    reset();
+}
+
+void DetectTracker::reset()
+{
+    m_tracks.clear();
+    m_result.clear();
+    m_frames_since_detection = m_detect_interval;
+    m_num_frames = 0;
+    m_num_detections = 0;
+    m_last_detected = false;
+}
+
+bool DetectTracker::need_detection()
+{
+    if (m_frames_since_detection >= m_detect_interval) {
+        return true;
+    }
+    for (const track_t &track : m_tracks) {
+        if (track.hits == 1 && !track.missed) {
+            return true;
+        }
+    }
+    if (m_motion_thr > 0) {
+        for (const track_t &track : m_tracks) {
+            float dx = track.state[0] - track.anchor[0];
+            float dy = track.state[1] - track.anchor[1];
+            float max_motion = m_motion_thr * DL_MAX(track.state[2], track.state[3]);
+            if (dx * dx + dy * dy > max_motion * max_motion) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void DetectTracker::get_box(const track_t &track, int *box)
+{
+    box[0] = lroundf(track.state[0] - track.state[2] / 2);
+    box[1] = lroundf(track.state[1] - track.state[3] / 2);
+    box[2] = lroundf(track.state[0] + track.state[2] / 2);
+    box[3] = lroundf(track.state[1] + track.state[3] / 2);
+}
+
+void DetectTracker::update(std::list<result_t> &detections)
+{
+    int num_detections = detections.size();
+    int num_tracks = m_tracks.size();
+
+    // Greedy association, pairs with the highest IoU first.
+    m_pairs.clear();
+    int d = 0;
+    for (const result_t &det : detections) {
+        for (int t = 0; t < num_tracks; t++) {
+            if (m_tracks[t].category != det.category) {
+                continue;
+            }
+            int box[4];
+            get_box(m_tracks[t], box);
+            float iou = box_iou(box, det.box);
+            if (iou >= m_iou_thr) {
+                m_pairs.emplace_back(iou, d * num_tracks + t);
+            }
+        }
+        d++;
+    }
+    std::stable_sort(m_pairs.begin(),
+                     m_pairs.end(),
+                     [](const std::pair<float, int> &a, const std::pair<float, int> &b) { return a.first > b.first; });
+    // [0, num_detections) holds the track of each detection, the rest the detection of each track.
+    m_matched.assign(num_detections + num_tracks, -1);
+    for (const auto &pair : m_pairs) {
+        int det = pair.second / num_tracks;
+        int t = pair.second % num_tracks;
+        if (m_matched[det] < 0 && m_matched[num_detections + t] < 0) {
+            m_matched[det] = t;
+            m_matched[num_detections + t] = det;
+        }
+    }
+
+    float dt = DL_MAX(m_frames_since_detection, 1);
+    d = 0;
+    for (const result_t &det : detections) {
+        float z[4] = {(det.box[0] + det.box[2]) / 2.f,
+                      (det.box[1] + det.box[3]) / 2.f,
+                      (float)(det.box[2] - det.box[0]),
+                      (float)(det.box[3] - det.box[1])};
+        int t = m_matched[d++];
+        if (t < 0) {
+            track_t track;
+            track.keypoint.assign(det.keypoint.begin(), det.keypoint.end());
+            for (int i = 0; i < 4; i++) {
+                track.state[i] = z[i];
+                track.velocity[i] = 0;
+            }
+            track.category = det.category;
+            track.score = det.score;
+            track.hits = 1;
+            track.missed = 0;
+            track.anchor[0] = z[0];
+            track.anchor[1] = z[1];
+            m_tracks.push_back(std::move(track));
+            continue;
+        }
+
+        track_t &track = m_tracks[t];
+        if ((int)track.keypoint.size() == det.keypoint.size()) {
+            float dx = track.state[0] - track.anchor[0];
+            float dy = track.state[1] - track.anchor[1];
+            for (int i = 0; i < det.keypoint.size(); i++) {
+                float predicted = track.keypoint[i] + (i % 2 ? dy : dx);
+                track.keypoint[i] = predicted + m_keypoint_alpha * (det.keypoint[i] - predicted);
+            }
+        } else {
+            track.keypoint.assign(det.keypoint.begin(), det.keypoint.end());
+        }
+        // The second detection measures the velocity, later ones correct it.
+        float gain = track.hits == 1 ? 1.f : s_velocity_gain;
+        for (int i = 0; i < 4; i++) {
+            track.velocity[i] += gain * (z[i] - track.state[i]) / dt;
+            track.state[i] = z[i];
+        }
+        track.category = det.category;
+        track.score = det.score;
+        track.hits++;
+        track.missed = 0;
+        track.anchor[0] = z[0];
+        track.anchor[1] = z[1];
+    }
+
+    for (int t = 0; t < num_tracks; t++) {
+        if (m_matched[num_detections + t] < 0) {
+            m_tracks[t].missed++;
+        }
+    }
+    m_tracks.erase(std::remove_if(m_tracks.begin(),
+                                  m_tracks.end(),
+                                  [this](const track_t &track) { return track.missed > m_max_missed; }),
+                   m_tracks.end());
+}
+
+std::list<result_t> &DetectTracker::run(const dl::image::img_t &img)
+{
+    m_num_frames++;
+    m_frames_since_detection++;
+    for (track_t &track : m_tracks) {
+        for (int i = 0; i < 4; i++) {
+            track.state[i] += track.velocity[i];
+        }
+    }
+
+    m_last_detected = need_detection();
+    if (m_last_detected) {
+        update(m_detect->run(img));
+        m_frames_since_detection = 0;
+        m_num_detections++;
+    }
+
+    // Tracks missed by the last detection are kept to be matched again, but not reported.
+    m_result.clear();
+    for (track_t &track : m_tracks) {
+        if (track.missed) {
+            continue;
+        }
+        result_t res;
+        res.category = track.category;
+        res.score = track.score;
+        get_box(track, res.box);
+        res.limit_box(img.width, img.height);
+        float dx = track.state[0] - track.anchor[0];
+        float dy = track.state[1] - track.anchor[1];
+        track.output.resize(track.keypoint.size());
+        for (int i = 0; i < (int)track.keypoint.size(); i++) {
+            track.output[i] = lroundf(track.keypoint[i] + (i % 2 ? dy : dx));
+        }
+        res.keypoint = {track.output.data(), (int)track.output.size()};
+        res.limit_keypoint(img.width, img.height);
+        m_result.push_back(res);
+    }
+    m_result.sort(greater_box);
+    return m_result;
+}
+} // namespace detect
+} // namespace dl
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "dl_detect_base.hpp"
+#include <list>
+#include <vector>
+
+namespace dl {
+namespace detect {
+/**
+ * @brief Run a detector on part of the frames of a video stream and predict the boxes of the other frames.
+ *
+ * Detections are associated with tracks by IoU. A track keeps the center and size of its box with their velocities,
+ * the velocity is updated by a constant velocity filter with a fixed gain. The detector runs every detect_interval
+ * frames, earlier if a track moved more than motion_thr of its size since the last detection, and on the frame after
+ * a new track appears to measure its velocity. The other frames return the predicted boxes, with the keypoints moved
+ * along with them. Objects entering the frame are found by the next detector run.
+ *
+ * NOTE: Like the results of the detector, the keypoints of the results are valid until run() is called again.
+ */
+class DetectTracker : public Detect {
+public:
+    /**
+     * @brief Construct a new DetectTracker object.
+     *
+     * @param detect           detector to run, not owned
+     * @param detect_interval  run the detector at least every detect_interval frames, 1 runs it on every frame
+     * @param motion_thr       run the detector once a track moved this fraction of its size, <= 0 disables it
+     * @param iou_thr          min IoU between a detection and the predicted box of a track to associate them
+     * @param max_missed       a track is dropped after this many detector runs without a matching detection
+     * @param keypoint_alpha   weight of the detected keypoints against the predicted ones, 1 disables smoothing
+     */
+    DetectTracker(Detect *detect,
+                  int detect_interval = 3,
+                  float motion_thr = 0.25,
+                  float iou_thr = 0.3,
+                  int max_missed = 1,
+                  float keypoint_alpha = 1.f);
+
+    using Detect::run;
+    std::list<result_t> &run(const dl::image::img_t &img) override;
+
+    /**
+     * @brief Drop all the tracks and the statistics, call it when the stream restarts.
+     */
+    void reset();
+
+    bool is_last_detected() { return m_last_detected; }
+    int get_num_frames() { return m_num_frames; }
+    int get_num_detections() { return m_num_detections; }
+
+private:
+    typedef struct {
+        int category;                /*!< category of the last detection */
+        float score;                 /*!< score of the last detection */
+        float state[4];              /*!< [center_x, center_y, width, height] */
+        float velocity[4];           /*!< change of state per frame */
+        float anchor[2];             /*!< center at the last detection */
+        int hits;                    /*!< number of matching detections */
+        int missed;                  /*!< detector runs since the last matching detection */
+        std::vector<float> keypoint; /*!< smoothed keypoints at the last detection */
+        std::vector<int> output;     /*!< keypoints of the current frame */
+    } track_t;
+
+    Detect *m_detect;
+    int m_detect_interval;
+    float m_motion_thr;
+    float m_iou_thr;
+    int m_max_missed;
+    float m_keypoint_alpha;
+    int m_frames_since_detection;
+    int m_num_frames;
+    int m_num_detections;
+    bool m_last_detected;
+    std::vector<track_t> m_tracks;
+    std::vector<int> m_matched;                 /*!< track of each detection and detection of each track, -1 if none */
+    std::vector<std::pair<float, int>> m_pairs; /*!< IoU and detection * num_tracks + track of the candidate pairs */
+    std::list<result_t> m_result;
+
+    bool need_detection();
+    void update(std::list<result_t> &detections);
+    void get_box(const track_t &track, int *box);
+};
+} // namespace detect
+} // namespace dl
@@ -21,45 +21,38 @@ void yolo11PostProcessor::parse_stage(TensorBase *score, TensorBase *box, const
     T *score_ptr = (T *)score->data;
     T *box_ptr = (T *)box->data;
     float score_exp = DL_SCALE(score->exponent);
-    float box_exp = DL_SCALE(box->exponent);
     T score_thr_quant = quantize<T>(dl::math::inverse_sigmoid(m_score_thr), 1.f / score_exp);
     float inv_resize_scale_x = 1.f / m_resize_scale_x;
     float inv_resize_scale_y = 1.f / m_resize_scale_y;
 
     int reg_max = 16;
+    m_dfl.set_exponent<T>(box->exponent);
 
-    for (size_t y = 0; y < H; y++) {
-        for (size_t x = 0; x < W; x++) {
-            for (size_t c = 0; c < C; c++) {
-                if (*score_ptr > score_thr_quant) {
+    int cell_num = filter_cells(score_ptr, H * W, C, score_thr_quant);
+    for (int i = 0; i < cell_num; i++) {
+        int cell = m_cells[i];
+        int y = cell / W;
+        int x = cell % W;
+        T *cell_score = score_ptr + cell * C;
+        T *cell_box = box_ptr + cell * 4 * reg_max;
+        for (int c = 0; c < C; c++) {
+            if (cell_score[c] > score_thr_quant) {
+                float score_val = dl::math::sigmoid(dequantize(cell_score[c], score_exp));
+                if (m_candidates.accept(score_val)) {
                     int center_y = y * stride_y + offset_y;
                     int center_x = x * stride_x + offset_x;
 
-                    float box_data[reg_max * 4];
-                    for (int i = 0; i < reg_max * 4; i++) {
-                        box_data[i] = dequantize(box_ptr[i], box_exp);
-                    }
+                    float distance[4];
+                    m_dfl.decode(cell_box, distance);
 
-                    result_t new_box = {
-                        (int)c,
-                        dl::math::sigmoid(dequantize(*score_ptr, score_exp)),
-                        {(int)((center_x - dl::math::dfl_integral(box_data, reg_max - 1) * stride_x) *
-                               inv_resize_scale_x),
-                         (int)((center_y - dl::math::dfl_integral(box_data + reg_max, reg_max - 1) * stride_y) *
-                               inv_resize_scale_y),
-                         (int)((center_x + dl::math::dfl_integral(box_data + 2 * reg_max, reg_max - 1) * stride_x) *
-                               inv_resize_scale_x),
-                         (int)((center_y + dl::math::dfl_integral(box_data + 3 * reg_max, reg_max - 1) * stride_y) *
-                               inv_resize_scale_y)},
-                        {}};
-
-                    m_box_list.insert(std::upper_bound(m_box_list.begin(), m_box_list.end(), new_box, greater_box),
-                                      new_box);
+                    m_candidates.push(c,
+                                      score_val,
+                                      (int)((center_x - distance[0] * stride_x) * inv_resize_scale_x + m_top_left_x),
+                                      (int)((center_y - distance[1] * stride_y) * inv_resize_scale_y + m_top_left_y),
+                                      (int)((center_x + distance[2] * stride_x) * inv_resize_scale_x + m_top_left_x),
+                                      (int)((center_y + distance[3] * stride_y) * inv_resize_scale_y + m_top_left_y));
                 }
-                score_ptr++;
             }
-
-            box_ptr += 4 * reg_max;
         }
     }
 }
@@ -1,10 +1,13 @@
 #pragma once
+#include "dl_math_dfl.hpp"
 #include "dl_detect_postprocessor.hpp"
 
 namespace dl {
 namespace detect {
 class yolo11PostProcessor : public AnchorPointDetectPostprocessor {
 private:
+    dl::math::DFLDecoder m_dfl; /*!< Box decoder working on the quantized logits */
+
     template <typename T>
     void parse_stage(TensorBase *score, TensorBase *box, const int stage_index);
 
@@ -6,7 +6,7 @@
 namespace dl {
 namespace detect {
 template <typename T>
-void yolo11posePostProcessor::parse_stage(TensorBase *score, TensorBase *box, TensorBase *kpt, const int stage_index)
+void yolo11posePostProcessor::parse_stage(TensorBase *score, TensorBase *box, const int stage_index)
 {
     int stride_y = m_stages[stage_index].stride_y;
     int stride_x = m_stages[stage_index].stride_x;
@@ -18,91 +18,106 @@ void yolo11posePostProcessor::parse_stage(TensorBase *score, TensorBase *box, Te
     int W = score->shape[2];
     int C = score->shape[3];
 
-    int coco_kpt_num = 17;
-    int coco_kpt_ch = 3; //(x, y, visibility)
-    int coco_kpt_total = coco_kpt_num * coco_kpt_ch;
-    int coco_kpt_res_total = coco_kpt_num * 2; //(x, y)
-    float coco_kpt_conf_th = 0.5;
-
     T *score_ptr = (T *)score->data;
     T *box_ptr = (T *)box->data;
-    T *kpt_ptr = (T *)kpt->data;
 
     float score_exp = DL_SCALE(score->exponent);
-    float box_exp = DL_SCALE(box->exponent);
-    float kpt_exp = DL_SCALE(kpt->exponent);
 
     T score_thr_quant = quantize<T>(dl::math::inverse_sigmoid(m_score_thr), 1.f / score_exp);
     float inv_resize_scale_x = 1.f / m_resize_scale_x;
     float inv_resize_scale_y = 1.f / m_resize_scale_y;
 
     int reg_max = 16;
-
-    for (size_t y = 0; y < H; y++) {
-        for (size_t x = 0; x < W; x++) {
-            for (size_t c = 0; c < C; c++) {
-                if (*score_ptr > score_thr_quant) {
+    m_dfl.set_exponent<T>(box->exponent);
+
+    int cell_num = filter_cells(score_ptr, H * W, C, score_thr_quant);
+    for (int i = 0; i < cell_num; i++) {
+        int cell = m_cells[i];
+        int y = cell / W;
+        int x = cell % W;
+        T *cell_score = score_ptr + cell * C;
+        T *cell_box = box_ptr + cell * 4 * reg_max;
+        for (int c = 0; c < C; c++) {
+            if (cell_score[c] > score_thr_quant) {
+                float score_val = dl::math::sigmoid(dequantize(cell_score[c], score_exp));
+                if (m_candidates.accept(score_val)) {
                     int center_y = y * stride_y + offset_y;
                     int center_x = x * stride_x + offset_x;
 
-                    float box_data[reg_max * 4];
-                    for (int i = 0; i < reg_max * 4; i++) {
-                        box_data[i] = dequantize(box_ptr[i], box_exp);
+                    float distance[4];
+                    m_dfl.decode(cell_box, distance);
+
+                    int slot = m_candidates.push(
+                        c,
+                        score_val,
+                        (int)((center_x - distance[0] * stride_x) * inv_resize_scale_x + m_top_left_x),
+                        (int)((center_y - distance[1] * stride_y) * inv_resize_scale_y + m_top_left_y),
+                        (int)((center_x + distance[2] * stride_x) * inv_resize_scale_x + m_top_left_x),
+                        (int)((center_y + distance[3] * stride_y) * inv_resize_scale_y + m_top_left_y));
+                    if (slot >= 0) {
+                        // Keypoints are only decoded for the boxes kept by NMS.
+                        m_candidates.set_anchor(slot, stage_index, cell);
                     }
-
-                    std::vector<int> keypoints_vec(coco_kpt_res_total);
-                    for (int k = 0; k < coco_kpt_num; k++) {
-                        int idx = k * coco_kpt_ch;
-                        float kpt_x = dequantize(kpt_ptr[idx], kpt_exp);
-                        float kpt_y = dequantize(kpt_ptr[idx + 1], kpt_exp);
-                        float kpt_conf = dequantize(kpt_ptr[idx + 2], kpt_exp);
-
-                        if (kpt_conf >= coco_kpt_conf_th) {
-                            keypoints_vec[2 * k] =
-                                static_cast<int>((kpt_x * 2.0 * stride_x + (center_x - offset_x)) * inv_resize_scale_x);
-                            keypoints_vec[2 * k + 1] =
-                                static_cast<int>((kpt_y * 2.0 * stride_y + (center_y - offset_y)) * inv_resize_scale_y);
-                        } else {
-                            keypoints_vec[2 * k] = 0;
-                            keypoints_vec[2 * k + 1] = 0;
-                        }
-                    }
-
-                    result_t new_box = {
-                        (int)c,
-                        dl::math::sigmoid(dequantize(*score_ptr, score_exp)),
-                        {(int)((center_x - dl::math::dfl_integral(box_data, reg_max - 1) * stride_x) *
-                               inv_resize_scale_x),
-                         (int)((center_y - dl::math::dfl_integral(box_data + reg_max, reg_max - 1) * stride_y) *
-                               inv_resize_scale_y),
-                         (int)((center_x + dl::math::dfl_integral(box_data + 2 * reg_max, reg_max - 1) * stride_x) *
-                               inv_resize_scale_x),
-                         (int)((center_y + dl::math::dfl_integral(box_data + 3 * reg_max, reg_max - 1) * stride_y) *
-                               inv_resize_scale_y)},
-                        keypoints_vec,
-                    };
-
-                    m_box_list.insert(std::upper_bound(m_box_list.begin(), m_box_list.end(), new_box, greater_box),
-                                      new_box);
                 }
-                score_ptr++;
             }
-
-            box_ptr += 4 * reg_max;
-            kpt_ptr += coco_kpt_total;
         }
     }
 }
 
 template void yolo11posePostProcessor::parse_stage<int8_t>(TensorBase *score,
                                                            TensorBase *box,
-                                                           TensorBase *kpt,
                                                            const int stage_index);
 template void yolo11posePostProcessor::parse_stage<int16_t>(TensorBase *score,
                                                             TensorBase *box,
-                                                            TensorBase *kpt,
                                                             const int stage_index);
 
+template <typename T>
+void yolo11posePostProcessor::decode_stage_keypoint(TensorBase *kpt,
+                                                    const int stage_index,
+                                                    const int cell_index,
+                                                    int *keypoint)
+{
+    int stride_y = m_stages[stage_index].stride_y;
+    int stride_x = m_stages[stage_index].stride_x;
+    int W = kpt->shape[2];
+    int y = cell_index / W;
+    int x = cell_index % W;
+
+    float kpt_conf_th = 0.5;
+    float kpt_exp = DL_SCALE(kpt->exponent);
+    float inv_resize_scale_x = 1.f / m_resize_scale_x;
+    float inv_resize_scale_y = 1.f / m_resize_scale_y;
+    T *kpt_ptr = (T *)kpt->data + cell_index * s_kpt_num * s_kpt_ch;
+
+    for (int k = 0; k < s_kpt_num; k++) {
+        int idx = k * s_kpt_ch;
+        float kpt_x = dequantize(kpt_ptr[idx], kpt_exp);
+        float kpt_y = dequantize(kpt_ptr[idx + 1], kpt_exp);
+        float kpt_conf = dequantize(kpt_ptr[idx + 2], kpt_exp);
+
+        if (kpt_conf >= kpt_conf_th) {
+            keypoint[2 * k] =
+                static_cast<int>((kpt_x * 2.0 * stride_x + x * stride_x) * inv_resize_scale_x + m_top_left_x);
+            keypoint[2 * k + 1] =
+                static_cast<int>((kpt_y * 2.0 * stride_y + y * stride_y) * inv_resize_scale_y + m_top_left_y);
+        } else {
+            keypoint[2 * k] = 0;
+            keypoint[2 * k + 1] = 0;
+        }
+    }
+}
+
+void yolo11posePostProcessor::decode_keypoint(int slot, int *keypoint)
+{
+    int stage_index = m_candidates.get_anchor_stage(slot);
+    TensorBase *kpt = m_kpt[stage_index];
+    if (kpt->dtype == DATA_TYPE_INT8) {
+        decode_stage_keypoint<int8_t>(kpt, stage_index, m_candidates.get_anchor_cell(slot), keypoint);
+    } else {
+        decode_stage_keypoint<int16_t>(kpt, stage_index, m_candidates.get_anchor_cell(slot), keypoint);
+    }
+}
+
 void yolo11posePostProcessor::postprocess()
 {
     TensorBase *bbox0 = m_model->get_output("box0");
@@ -114,18 +129,19 @@ void yolo11posePostProcessor::postprocess()
     TensorBase *bbox2 = m_model->get_output("box2");
     TensorBase *score2 = m_model->get_output("score2");
 
-    TensorBase *kpt0 = m_model->get_output("kpt0");
-    TensorBase *kpt1 = m_model->get_output("kpt1");
-    TensorBase *kpt2 = m_model->get_output("kpt2");
+    m_kpt[0] = m_model->get_output("kpt0");
+    m_kpt[1] = m_model->get_output("kpt1");
+    m_kpt[2] = m_model->get_output("kpt2");
+    set_keypoint_num(s_kpt_num * 2);
 
     if (bbox0->dtype == DATA_TYPE_INT8) {
-        parse_stage<int8_t>(score0, bbox0, kpt0, 0);
-        parse_stage<int8_t>(score1, bbox1, kpt1, 1);
-        parse_stage<int8_t>(score2, bbox2, kpt2, 2);
+        parse_stage<int8_t>(score0, bbox0, 0);
+        parse_stage<int8_t>(score1, bbox1, 1);
+        parse_stage<int8_t>(score2, bbox2, 2);
     } else {
-        parse_stage<int16_t>(score0, bbox0, kpt0, 0);
-        parse_stage<int16_t>(score1, bbox1, kpt1, 1);
-        parse_stage<int16_t>(score2, bbox2, kpt2, 2);
+        parse_stage<int16_t>(score0, bbox0, 0);
+        parse_stage<int16_t>(score1, bbox1, 1);
+        parse_stage<int16_t>(score2, bbox2, 2);
     }
     nms();
 }
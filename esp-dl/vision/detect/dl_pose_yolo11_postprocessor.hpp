@@ -1,12 +1,23 @@
 #pragma once
+#include "dl_math_dfl.hpp"
 #include "dl_detect_postprocessor.hpp"
 
 namespace dl {
 namespace detect {
 class yolo11posePostProcessor : public AnchorPointDetectPostprocessor {
 private:
+    dl::math::DFLDecoder m_dfl;      /*!< Box decoder working on the quantized logits */
+    static const int s_kpt_num = 17; /*!< COCO keypoints */
+    static const int s_kpt_ch = 3;   /*!< (x, y, visibility) */
+    TensorBase *m_kpt[3];            /*!< Keypoint outputs of the stages, decoded after NMS */
+
+    template <typename T>
+    void parse_stage(TensorBase *score, TensorBase *box, const int stage_index);
     template <typename T>
-    void parse_stage(TensorBase *score, TensorBase *box, TensorBase *kpt, const int stage_index);
+    void decode_stage_keypoint(TensorBase *kpt, const int stage_index, const int cell_index, int *keypoint);
+
+protected:
+    void decode_keypoint(int slot, int *keypoint) override;
 
 public:
     void postprocess() override;
@@ -4,3 +4,4 @@
 #include "dl_image_draw.hpp"
 #include "dl_image_jpeg.hpp"
 #include "dl_image_process.hpp"
+#include "dl_image_sequence.hpp"
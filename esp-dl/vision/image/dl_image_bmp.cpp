@@ -101,7 +101,7 @@ esp_err_t write_bmp_base(const img_t &img, const char *file_name)
     }
 
     // write img data
-    uint8_t *img_ptr = (uint8_t *)img.data + (img.height - 1) * row_stride;
+    uint8_t *img_ptr = (uint8_t *)get_img_row(img, img.height - 1);
     if (row_stride_padded == row_stride) {
         for (int i = 0; i < img.height; i++) {
             size = fwrite(img_ptr, row_stride, 1, f);
@@ -110,7 +110,7 @@ esp_err_t write_bmp_base(const img_t &img, const char *file_name)
                 fclose(f);
                 return ESP_FAIL;
             }
-            img_ptr -= row_stride;
+            img_ptr -= get_img_stride(img);
         }
     } else {
         uint8_t padding[row_stride_padded - row_stride]{};
@@ -127,7 +127,7 @@ esp_err_t write_bmp_base(const img_t &img, const char *file_name)
                 fclose(f);
                 return ESP_FAIL;
             }
-            img_ptr -= row_stride;
+            img_ptr -= get_img_stride(img);
         }
     }
     fclose(f);
@@ -146,6 +146,7 @@ esp_err_t write_bmp(const img_t &img, const char *file_name, uint32_t caps)
     if (img.pix_type == DL_IMAGE_PIX_TYPE_RGB565 ||
         (img.pix_type == DL_IMAGE_PIX_TYPE_RGB888 && (caps & DL_IMAGE_CAP_RGB_SWAP))) {
         img2write.pix_type = DL_IMAGE_PIX_TYPE_RGB888;
+        img2write.stride = 0;
         img2write.data = heap_caps_malloc(get_img_byte_size(img2write), MALLOC_CAP_DEFAULT);
         convert_img(img, img2write, caps);
         free = true;
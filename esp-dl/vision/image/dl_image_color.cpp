@@ -9,7 +9,7 @@ void convert_img_loop(
     int step_src = DL_IMAGE_IS_PIX_TYPE_RGB888(src_img.pix_type) ? 3 : 1;
     int step_dst = DL_IMAGE_IS_PIX_TYPE_RGB888(dst_img.pix_type) ? 3 : 1;
 
-    if (crop_area.empty()) {
+    if (crop_area.empty() && is_img_packed(src_img) && is_img_packed(dst_img)) {
         T1 *src_pix_ptr = (T1 *)src_img.data;
         T2 *dst_pix_ptr = (T2 *)dst_img.data;
         pix_t src_pix;
@@ -24,14 +24,15 @@ void convert_img_loop(
             dst_pix_ptr += step_dst;
         }
     } else {
-        int src_gap = step_src * src_img.width - step_src * dst_img.width;
-        T1 *src_pix_ptr = (T1 *)src_img.data + crop_area[0] * step_src + crop_area[1] * step_src * src_img.width;
-        T2 *dst_pix_ptr = (T2 *)dst_img.data;
+        int x0 = crop_area.empty() ? 0 : crop_area[0];
+        int y0 = crop_area.empty() ? 0 : crop_area[1];
         pix_t src_pix;
         src_pix.type = src_img.pix_type;
         pix_t dst_pix;
         dst_pix.type = dst_img.pix_type;
         for (int i = 0; i < dst_img.height; i++) {
+            T1 *src_pix_ptr = (T1 *)get_img_row(src_img, y0 + i) + x0 * step_src;
+            T2 *dst_pix_ptr = (T2 *)get_img_row(dst_img, i);
             for (int j = 0; j < dst_img.width; j++) {
                 src_pix.data = (void *)src_pix_ptr;
                 dst_pix.data = (void *)dst_pix_ptr;
@@ -39,7 +40,6 @@ void convert_img_loop(
                 src_pix_ptr += step_src;
                 dst_pix_ptr += step_dst;
             }
-            src_pix_ptr += src_gap;
         }
     }
 }
@@ -92,7 +92,8 @@ void convert_img(const img_t &src_img, img_t &dst_img, uint32_t caps, void *norm
                (src_img.pix_type == DL_IMAGE_PIX_TYPE_RGB565 && dst_img.pix_type == DL_IMAGE_PIX_TYPE_GRAY_QINT16)) {
         convert_img_loop<uint16_t, int16_t>(src_img, dst_img, caps, norm_lut, crop_area);
     } else if ((src_img.pix_type == DL_IMAGE_PIX_TYPE_RGB888 && dst_img.pix_type == DL_IMAGE_PIX_TYPE_RGB888) ||
-               (src_img.pix_type == DL_IMAGE_PIX_TYPE_RGB888 && dst_img.pix_type == DL_IMAGE_PIX_TYPE_GRAY)) {
+               (src_img.pix_type == DL_IMAGE_PIX_TYPE_RGB888 && dst_img.pix_type == DL_IMAGE_PIX_TYPE_GRAY) ||
+               (src_img.pix_type == DL_IMAGE_PIX_TYPE_GRAY && dst_img.pix_type == DL_IMAGE_PIX_TYPE_GRAY)) {
         convert_img_loop<uint8_t, uint8_t>(src_img, dst_img, caps, norm_lut, crop_area);
     } else if (src_img.pix_type == DL_IMAGE_PIX_TYPE_RGB888 && dst_img.pix_type == DL_IMAGE_PIX_TYPE_RGB565) {
         convert_img_loop<uint8_t, uint16_t>(src_img, dst_img, caps, norm_lut, crop_area);
@@ -136,6 +137,10 @@ esp_err_t convert_img_ppa(const img_t &src_img,
     if (convert_pix_type_to_ppa_srm_fmt(src_img.pix_type, &output_srm_color_mode) == ESP_FAIL) {
         return ESP_FAIL;
     }
+    // ppa reads the rows of the input picture pic_w pixels apart.
+    if (get_img_stride(src_img) % get_pix_byte_size(src_img.pix_type)) {
+        return ESP_FAIL;
+    }
     assert(ppa_handle);
     assert(ppa_buffer);
     assert(src_img.data);
@@ -168,7 +173,7 @@ esp_err_t convert_img_ppa(const img_t &src_img,
     }
     srm_oper_config.in.buffer = (const void *)src_img.data;
     srm_oper_config.in.pic_h = src_img.height;
-    srm_oper_config.in.pic_w = src_img.width;
+    srm_oper_config.in.pic_w = get_img_stride(src_img) / get_pix_byte_size(src_img.pix_type);
     srm_oper_config.in.srm_cm = input_srm_color_mode;
     srm_oper_config.rgb_swap = caps & DL_IMAGE_CAP_RGB_SWAP;
     srm_oper_config.byte_swap =
@@ -193,7 +198,14 @@ esp_err_t convert_img_ppa(const img_t &src_img,
 
     ESP_ERROR_CHECK(ppa_do_scale_rotate_mirror(ppa_handle, &srm_oper_config));
     // additional memory copy needed, performance tradeoff should be considered.
-    tool::copy_memory(dst_img.data, ppa_buffer, get_img_byte_size(dst_img));
+    if (is_img_packed(dst_img)) {
+        tool::copy_memory(dst_img.data, ppa_buffer, get_img_byte_size(dst_img));
+    } else {
+        size_t row_bytes = dst_img.width * get_pix_byte_size(dst_img.pix_type);
+        for (int i = 0; i < dst_img.height; i++) {
+            tool::copy_memory(get_img_row(dst_img, i), (uint8_t *)ppa_buffer + i * row_bytes, row_bytes);
+        }
+    }
     return ESP_OK;
 }
 #endif
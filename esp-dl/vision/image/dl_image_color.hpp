@@ -124,6 +124,10 @@ inline void convert_pixel_from_rgb565_to_gray_quant(uint16_t *src_ptr, T *dst_pt
     convert_pixel_from_rgb565_to_rgb888(src_ptr, tmp, caps);
     convert_pixel_from_rgb888_to_gray_quant<T>(tmp, dst_ptr, 0, norm_lut);
 }
+inline void convert_pixel_from_gray_to_gray(uint8_t *src_ptr, uint8_t *dst_ptr)
+{
+    *dst_ptr = *src_ptr;
+}
 template <typename T>
 inline void convert_pixel_from_gray_to_gray_quant(uint8_t *src_ptr, T *dst_ptr, T *norm_lut)
 {
@@ -225,6 +229,8 @@ inline void convert_pixel(const pix_t &src_pix, pix_t &dst_pix, uint32_t caps, v
     } else if (src_pix.type == DL_IMAGE_PIX_TYPE_RGB888 && dst_pix.type == DL_IMAGE_PIX_TYPE_RGB888_QINT16) {
         convert_pixel_from_rgb888_to_rgb888_quant<int16_t>(
             (uint8_t *)src_pix.data, (int16_t *)dst_pix.data, caps, (int16_t *)norm_lut);
+    } else if (src_pix.type == DL_IMAGE_PIX_TYPE_GRAY && dst_pix.type == DL_IMAGE_PIX_TYPE_GRAY) {
+        convert_pixel_from_gray_to_gray((uint8_t *)src_pix.data, (uint8_t *)dst_pix.data);
     } else if (src_pix.type == DL_IMAGE_PIX_TYPE_GRAY && dst_pix.type == DL_IMAGE_PIX_TYPE_GRAY_QINT8) {
         convert_pixel_from_gray_to_gray_quant<int8_t>(
             (uint8_t *)src_pix.data, (int8_t *)dst_pix.data, (int8_t *)norm_lut);
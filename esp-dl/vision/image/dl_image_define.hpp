@@ -3,6 +3,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <string>
+#include <vector>
 #if CONFIG_IDF_TARGET_ESP32P4
 #include "driver/ppa.h"
 #endif
@@ -74,27 +75,78 @@ typedef struct {
     uint16_t width;
     uint16_t height;
     pix_type_t pix_type;
+    uint32_t stride = 0; /*!< bytes from one row to the next, 0 if the rows are packed */
 } img_t;
 
-inline size_t get_img_byte_size(const img_t &img)
+inline size_t get_pix_byte_size(pix_type_t pix_type)
 {
-    switch (img.pix_type) {
+    switch (pix_type) {
     case DL_IMAGE_PIX_TYPE_RGB888:
     case DL_IMAGE_PIX_TYPE_RGB888_QINT8:
-        return img.height * img.width * 3;
+        return 3;
     case DL_IMAGE_PIX_TYPE_RGB565:
     case DL_IMAGE_PIX_TYPE_GRAY_QINT16:
-        return img.height * img.width * 2;
+        return 2;
     case DL_IMAGE_PIX_TYPE_GRAY:
     case DL_IMAGE_PIX_TYPE_GRAY_QINT8:
-        return img.height * img.width;
+        return 1;
     case DL_IMAGE_PIX_TYPE_RGB888_QINT16:
-        return img.height * img.width * 6;
+        return 6;
     default:
         return 0;
     }
 }
 
+/**
+ * @brief Byte size of the pixels of an image, without the padding of the rows. It is the size of the buffer of a
+ * packed image.
+ */
+inline size_t get_img_byte_size(const img_t &img)
+{
+    return img.height * img.width * get_pix_byte_size(img.pix_type);
+}
+
+/**
+ * @brief Bytes from one row of an image to the next.
+ */
+inline size_t get_img_stride(const img_t &img)
+{
+    return img.stride ? img.stride : img.width * get_pix_byte_size(img.pix_type);
+}
+
+/**
+ * @brief Whether the rows of an image follow each other without padding.
+ */
+inline bool is_img_packed(const img_t &img)
+{
+    return get_img_stride(img) == img.width * get_pix_byte_size(img.pix_type);
+}
+
+/**
+ * @brief Pointer to the first pixel of a row.
+ */
+inline void *get_img_row(const img_t &img, int y)
+{
+    return (uint8_t *)img.data + y * get_img_stride(img);
+}
+
+/**
+ * @brief A rectangle of an image, which shares the buffer of the image, nothing is copied. Like camera DMA buffers
+ * with padded rows, it is consumed in place by resize(), convert_img(), warp_affine() and the draw functions.
+ *
+ * @param img The image.
+ * @param area [left_up_x, left_up_y, right_down_x, right_down_y] of the rectangle, right_down is excluded.
+ * @return img_t
+ */
+inline img_t get_sub_img(const img_t &img, const std::vector<int> &area)
+{
+    return {.data = (uint8_t *)get_img_row(img, area[1]) + area[0] * get_pix_byte_size(img.pix_type),
+            .width = (uint16_t)(area[2] - area[0]),
+            .height = (uint16_t)(area[3] - area[1]),
+            .pix_type = img.pix_type,
+            .stride = (uint32_t)get_img_stride(img)};
+}
+
 inline int get_img_channel(const img_t &img)
 {
     switch (img.pix_type) {
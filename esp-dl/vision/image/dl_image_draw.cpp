@@ -5,7 +5,6 @@ namespace image {
 template <typename T>
 void draw_point(const img_t &img, int x, int y, uint8_t radius, const pix_t &pix)
 {
-    T *img_ptr = (T *)img.data;
     T *pix_ptr = (T *)pix.data;
 
     int step = DL_IMAGE_IS_PIX_TYPE_RGB888(pix.type) ? 3 : 1;
@@ -18,7 +17,7 @@ void draw_point(const img_t &img, int x, int y, uint8_t radius, const pix_t &pix
             int x_ = DL_CLIP(x + j, 0, img.width - 1);
             int j_pow = j * j;
             if (i_pow + j_pow <= radius_pow) {
-                T *ptr = img_ptr + y_ * img.width * step + x_ * step;
+                T *ptr = (T *)get_img_row(img, y_) + x_ * step;
                 for (int s = 0; s < step; s++) {
                     *ptr++ = pix_ptr[s];
                 }
@@ -60,7 +59,6 @@ void draw_point(const img_t &img, int x, int y, const std::vector<uint8_t> &colo
 template <typename T>
 void draw_hollow_rectangle(const img_t &img, int x1, int y1, int x2, int y2, uint8_t line_width, const pix_t &pix)
 {
-    T *img_ptr = (T *)img.data;
     T *pix_ptr = (T *)pix.data;
 
     int step = DL_IMAGE_IS_PIX_TYPE_RGB888(pix.type) ? 3 : 1;
@@ -69,8 +67,8 @@ void draw_hollow_rectangle(const img_t &img, int x1, int y1, int x2, int y2, uin
     for (int i = -line_width / 2; i < line_width - line_width / 2; i++) {
         int y1_ = DL_CLIP(y1 + i, 0, img.height - 1);
         int y2_ = DL_CLIP(y2 + i, 0, img.height - 1);
-        T *row_up = img_ptr + y1_ * img.width * step + x1 * step;
-        T *row_down = img_ptr + y2_ * img.width * step + x1 * step;
+        T *row_up = (T *)get_img_row(img, y1_) + x1 * step;
+        T *row_down = (T *)get_img_row(img, y2_) + x1 * step;
         for (int x = x1; x <= x2; x++) {
             for (int s = 0; s < step; s++) {
                 *row_up++ = pix_ptr[s];
@@ -83,15 +81,13 @@ void draw_hollow_rectangle(const img_t &img, int x1, int y1, int x2, int y2, uin
     for (int i = -line_width / 2; i < line_width - line_width / 2; i++) {
         int x1_ = DL_CLIP(x1 + i, 0, img.width - 1);
         int x2_ = DL_CLIP(x2 + i, 0, img.width - 1);
-        T *colum_left = img_ptr + y1 * img.width * step + x1_ * step;
-        T *colum_right = img_ptr + y1 * img.width * step + x2_ * step;
         for (int y = y1; y <= y2; y++) {
+            T *colum_left = (T *)get_img_row(img, y) + x1_ * step;
+            T *colum_right = (T *)get_img_row(img, y) + x2_ * step;
             for (int s = 0; s < step; s++) {
                 *colum_left++ = pix_ptr[s];
                 *colum_right++ = pix_ptr[s];
             }
-            colum_left += (img.width - 1) * step;
-            colum_right += (img.width - 1) * step;
         }
     }
 }
@@ -9,11 +9,91 @@
 static const char *TAG = "dl_image_jpeg";
 namespace dl {
 namespace image {
-img_t sw_decode_jpeg(const jpeg_img_t &jpeg_img, pix_type_t pix_type, uint32_t caps)
+esp_err_t get_jpeg_size(const jpeg_img_t &jpeg_img, int *width, int *height)
+{
+    const uint8_t *data = (const uint8_t *)jpeg_img.data;
+    size_t len = jpeg_img.data_len;
+    if (len < 4 || data[0] != 0xFF || data[1] != 0xD8) {
+        ESP_LOGE(TAG, "Not a jpeg image.");
+        return ESP_FAIL;
+    }
+    size_t i = 2;
+    while (i + 4 <= len) {
+        if (data[i] != 0xFF) {
+            break;
+        }
+        uint8_t marker = data[i + 1];
+        if (marker == 0xFF) {
+            // fill byte
+            i++;
+            continue;
+        }
+        // SOF0 - SOF15, except DHT, JPG and DAC. [len:2][precision:1][height:2][width:2]
+        if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+            if (i + 9 > len) {
+                break;
+            }
+            *height = (data[i + 5] << 8) | data[i + 6];
+            *width = (data[i + 7] << 8) | data[i + 8];
+            return ESP_OK;
+        }
+        i += 2 + ((data[i + 2] << 8) | data[i + 3]);
+    }
+    ESP_LOGE(TAG, "Failed to find jpeg frame header.");
+    return ESP_FAIL;
+}
+
+int get_sw_decode_jpeg_shift(int width, int height, int min_width, int min_height)
+{
+    if (min_width <= 0 && min_height <= 0) {
+        return 0;
+    }
+    // The decoder scales by 1/2, 1/4 and 1/8 to a size that is a multiple of 8.
+    int shift = 3;
+    for (; shift > 0; shift--) {
+        int mask = (8 << shift) - 1;
+        if (!(width & mask) && !(height & mask) && (width >> shift) >= min_width && (height >> shift) >= min_height) {
+            break;
+        }
+    }
+    return shift;
+}
+
+static esp_err_t try_open_sw_jpeg_decoder(const jpeg_img_t &jpeg_img,
+                                          jpeg_dec_config_t *cfg,
+                                          jpeg_dec_handle_t *jpeg_dec,
+                                          jpeg_dec_io_t *jpeg_io)
+{
+    *jpeg_dec = NULL;
+    if (jpeg_dec_open(cfg, jpeg_dec) != JPEG_ERR_OK) {
+        return ESP_FAIL;
+    }
+    *jpeg_io = {};
+    jpeg_io->inbuf = (uint8_t *)jpeg_img.data;
+    jpeg_io->inbuf_len = jpeg_img.data_len;
+    jpeg_dec_header_info_t out_info = {};
+    if (jpeg_dec_parse_header(*jpeg_dec, jpeg_io, &out_info) != JPEG_ERR_OK) {
+        jpeg_dec_close(*jpeg_dec);
+        *jpeg_dec = NULL;
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Open the decoder with the requested downscaling and block output, drop them if the decoder does not support
+ * them for this image.
+ */
+static esp_err_t open_sw_jpeg_decoder(const jpeg_img_t &jpeg_img,
+                                      pix_type_t pix_type,
+                                      uint32_t caps,
+                                      int width,
+                                      int height,
+                                      int *shift,
+                                      bool *block,
+                                      jpeg_dec_handle_t *jpeg_dec,
+                                      jpeg_dec_io_t *jpeg_io)
 {
-    assert(caps == 0 || caps == DL_IMAGE_CAP_RGB565_BIG_ENDIAN);
-    img_t img;
-    img.pix_type = pix_type;
     jpeg_pixel_format_t output_type;
     switch (pix_type) {
     case DL_IMAGE_PIX_TYPE_RGB888:
@@ -25,32 +105,57 @@ img_t sw_decode_jpeg(const jpeg_img_t &jpeg_img, pix_type_t pix_type, uint32_t c
         break;
     default:
         ESP_LOGE(TAG, "Unsupported img pix format.");
-        return {};
+        return ESP_FAIL;
     }
     jpeg_dec_config_t cfg = {.output_type = output_type,
                              .scale = {.width = 0, .height = 0},
                              .clipper = {.width = 0, .height = 0},
                              .rotate = JPEG_ROTATE_0D,
-                             .block_enable = false};
+                             .block_enable = *block};
+    if (*shift > 0) {
+        cfg.scale = {.width = width >> *shift, .height = height >> *shift};
+    }
+    if (try_open_sw_jpeg_decoder(jpeg_img, &cfg, jpeg_dec, jpeg_io) == ESP_OK) {
+        return ESP_OK;
+    }
+    if (*block) {
+        *block = false;
+        cfg.block_enable = false;
+        if (try_open_sw_jpeg_decoder(jpeg_img, &cfg, jpeg_dec, jpeg_io) == ESP_OK) {
+            return ESP_OK;
+        }
+    }
+    if (*shift > 0) {
+        *shift = 0;
+        cfg.scale = {.width = 0, .height = 0};
+        if (try_open_sw_jpeg_decoder(jpeg_img, &cfg, jpeg_dec, jpeg_io) == ESP_OK) {
+            return ESP_OK;
+        }
+    }
+    ESP_LOGE(TAG, "Failed to open jpeg decoder.");
+    return ESP_FAIL;
+}
 
-    jpeg_dec_handle_t jpeg_dec = NULL;
-    if (jpeg_dec_open(&cfg, &jpeg_dec) != JPEG_ERR_OK) {
-        ESP_LOGE(TAG, "Failed to open jpeg decoder.");
+img_t sw_decode_jpeg(const jpeg_img_t &jpeg_img, pix_type_t pix_type, uint32_t caps, int min_width, int min_height)
+{
+    assert(caps == 0 || caps == DL_IMAGE_CAP_RGB565_BIG_ENDIAN);
+    int width, height;
+    if (get_jpeg_size(jpeg_img, &width, &height) != ESP_OK) {
         return {};
     }
-
-    jpeg_dec_io_t jpeg_io = {};
-    jpeg_io.inbuf = (uint8_t *)jpeg_img.data;
-    jpeg_io.inbuf_len = jpeg_img.data_len;
-    jpeg_dec_header_info_t out_info = {};
-    if (jpeg_dec_parse_header(jpeg_dec, &jpeg_io, &out_info) != JPEG_ERR_OK) {
-        ESP_LOGE(TAG, "Failed to parse jpeg header.");
-        jpeg_dec_close(jpeg_dec);
+    int shift = get_sw_decode_jpeg_shift(width, height, min_width, min_height);
+    bool block = false;
+    jpeg_dec_handle_t jpeg_dec = NULL;
+    jpeg_dec_io_t jpeg_io;
+    if (open_sw_jpeg_decoder(jpeg_img, pix_type, caps, width, height, &shift, &block, &jpeg_dec, &jpeg_io) !=
+        ESP_OK) {
         return {};
     }
 
-    img.width = out_info.width;
-    img.height = out_info.height;
+    img_t img;
+    img.pix_type = pix_type;
+    img.width = width >> shift;
+    img.height = height >> shift;
     size_t out_buf_len = get_img_byte_size(img);
     img.data = heap_caps_aligned_alloc(16, out_buf_len, MALLOC_CAP_DEFAULT);
     if (!img.data) {
@@ -70,8 +175,118 @@ img_t sw_decode_jpeg(const jpeg_img_t &jpeg_img, pix_type_t pix_type, uint32_t c
     return img;
 }
 
+SwJpegDecoder::SwJpegDecoder(pix_type_t pix_type, uint32_t caps) :
+    m_pix_type(pix_type), m_caps(caps), m_buffer(nullptr), m_buffer_size(0), m_width(0), m_height(0), m_shift(0)
+{
+    assert(caps == 0 || caps == DL_IMAGE_CAP_RGB565_BIG_ENDIAN);
+    assert(pix_type == DL_IMAGE_PIX_TYPE_RGB888 || pix_type == DL_IMAGE_PIX_TYPE_RGB565);
+}
+
+SwJpegDecoder::~SwJpegDecoder()
+{
+    if (m_buffer) {
+        heap_caps_free(m_buffer);
+    }
+}
+
+void *SwJpegDecoder::get_buffer(size_t size)
+{
+    if (size > m_buffer_size) {
+        if (m_buffer) {
+            heap_caps_free(m_buffer);
+        }
+        m_buffer = heap_caps_aligned_alloc(16, size, MALLOC_CAP_DEFAULT);
+        m_buffer_size = m_buffer ? size : 0;
+    }
+    return m_buffer;
+}
+
+esp_err_t SwJpegDecoder::decode(const jpeg_img_t &jpeg_img, img_t &img, int min_width, int min_height)
+{
+    return decode_impl(jpeg_img, img, min_width, min_height, nullptr);
+}
+
+esp_err_t SwJpegDecoder::decode_rows(const jpeg_img_t &jpeg_img,
+                                     const RowsCallback &callback,
+                                     int min_width,
+                                     int min_height)
+{
+    img_t img;
+    return decode_impl(jpeg_img, img, min_width, min_height, &callback);
+}
+
+esp_err_t SwJpegDecoder::decode_impl(
+    const jpeg_img_t &jpeg_img, img_t &img, int min_width, int min_height, const RowsCallback *callback)
+{
+    int width, height;
+    ESP_RETURN_ON_ERROR(get_jpeg_size(jpeg_img, &width, &height), TAG, "Failed to get jpeg size.");
+    int shift = get_sw_decode_jpeg_shift(width, height, min_width, min_height);
+    bool block = callback != nullptr;
+    jpeg_dec_handle_t jpeg_dec = NULL;
+    jpeg_dec_io_t jpeg_io;
+    ESP_RETURN_ON_ERROR(
+        open_sw_jpeg_decoder(jpeg_img, m_pix_type, m_caps, width, height, &shift, &block, &jpeg_dec, &jpeg_io),
+        TAG,
+        "Failed to decode jpeg.");
+    m_width = width;
+    m_height = height;
+    m_shift = shift;
+    img.pix_type = m_pix_type;
+    img.width = width >> shift;
+    img.height = height >> shift;
+    img.data = nullptr;
+    img.stride = 0;
+
+    esp_err_t ret = ESP_OK;
+    if (block) {
+        // Each process call outputs the next block row into the same buffer.
+        int outbuf_len = 0, process_count = 0;
+        jpeg_dec_get_outbuf_len(jpeg_dec, &outbuf_len);
+        jpeg_dec_get_process_count(jpeg_dec, &process_count);
+        img_t rows = img;
+        rows.height = 1;
+        int block_height = outbuf_len / get_img_byte_size(rows);
+        rows.data = get_buffer(outbuf_len);
+        if (!rows.data || block_height <= 0) {
+            ESP_LOGE(TAG, "Failed to alloc output buffer.");
+            jpeg_dec_close(jpeg_dec);
+            return ESP_FAIL;
+        }
+        for (int i = 0, y = 0; i < process_count && y < img.height; i++, y += block_height) {
+            jpeg_io.outbuf = (uint8_t *)rows.data;
+            if (jpeg_dec_process(jpeg_dec, &jpeg_io) != JPEG_ERR_OK) {
+                ESP_LOGE(TAG, "Failed to decode jpeg.");
+                ret = ESP_FAIL;
+                break;
+            }
+            rows.height = std::min(block_height, img.height - y);
+            (*callback)(rows, y);
+        }
+    } else {
+        img.data = get_buffer(get_img_byte_size(img));
+        if (!img.data) {
+            ESP_LOGE(TAG, "Failed to alloc output buffer.");
+            jpeg_dec_close(jpeg_dec);
+            return ESP_FAIL;
+        }
+        jpeg_io.outbuf = (uint8_t *)img.data;
+        if (jpeg_dec_process(jpeg_dec, &jpeg_io) != JPEG_ERR_OK) {
+            ESP_LOGE(TAG, "Failed to decode jpeg.");
+            ret = ESP_FAIL;
+        } else if (callback) {
+            (*callback)(img, 0);
+        }
+    }
+    jpeg_dec_close(jpeg_dec);
+    return ret;
+}
+
 jpeg_img_t sw_encode_jpeg_base(const img_t &img, uint8_t quality)
 {
+    if (!is_img_packed(img)) {
+        ESP_LOGE(TAG, "The rows of the img to encode should be packed.");
+        return {};
+    }
     jpeg_img_t jpeg_img;
     jpeg_pixel_format_t src_type;
     switch (img.pix_type) {
@@ -130,8 +345,11 @@ jpeg_img_t sw_encode_jpeg(const img_t &img, uint32_t caps, uint8_t quality)
     img_t img2encode = img;
     bool free = false;
     if (img.pix_type == DL_IMAGE_PIX_TYPE_RGB565 ||
-        (img.pix_type == DL_IMAGE_PIX_TYPE_RGB888 && (caps & DL_IMAGE_CAP_RGB_SWAP))) {
-        img2encode.pix_type = DL_IMAGE_PIX_TYPE_RGB888;
+        (img.pix_type == DL_IMAGE_PIX_TYPE_RGB888 && (caps & DL_IMAGE_CAP_RGB_SWAP)) || !is_img_packed(img)) {
+        if (img.pix_type == DL_IMAGE_PIX_TYPE_RGB565) {
+            img2encode.pix_type = DL_IMAGE_PIX_TYPE_RGB888;
+        }
+        img2encode.stride = 0;
         img2encode.data = heap_caps_malloc(get_img_byte_size(img2encode), MALLOC_CAP_DEFAULT);
         convert_img(img, img2encode, caps);
         free = true;
@@ -246,6 +464,10 @@ jpeg_img_t hw_encode_jpeg_base(const img_t &img,
                                int timeout_ms,
                                jpeg_down_sampling_type_t rgb_sub_sample_method)
 {
+    if (!is_img_packed(img)) {
+        ESP_LOGE(TAG, "The rows of the img to encode should be packed.");
+        return {};
+    }
     jpeg_img_t jpeg_img;
     jpeg_enc_input_format_t src_type;
     switch (img.pix_type) {
@@ -321,21 +543,27 @@ jpeg_img_t hw_encode_jpeg(
     const img_t &img, uint32_t caps, uint8_t quality, int timeout_ms, jpeg_down_sampling_type_t rgb_sub_sample_method)
 {
     img_t img2encode = img;
-    bool free = false;
+    // Images with padded rows are packed by the conversion.
+    bool free = !is_img_packed(img);
     if (img.pix_type == DL_IMAGE_PIX_TYPE_RGB565 &&
         ((caps & DL_IMAGE_CAP_RGB_SWAP) || (caps & DL_IMAGE_CAP_RGB565_BIG_ENDIAN))) {
         if (caps & DL_IMAGE_CAP_RGB565_BIG_ENDIAN) {
             caps |= DL_IMAGE_CAP_RGB565_BYTE_SWAP;
         }
-        img2encode.data = heap_caps_malloc(get_img_byte_size(img2encode), MALLOC_CAP_DEFAULT);
-        convert_img(img, img2encode, caps);
         free = true;
     };
-    if (img.pix_type == DL_IMAGE_PIX_TYPE_RGB888 && !(caps & DL_IMAGE_CAP_RGB_SWAP)) {
-        caps |= DL_IMAGE_CAP_RGB_SWAP;
+    if (img.pix_type == DL_IMAGE_PIX_TYPE_RGB888) {
+        if (caps & DL_IMAGE_CAP_RGB_SWAP) {
+            caps &= ~DL_IMAGE_CAP_RGB_SWAP;
+        } else {
+            caps |= DL_IMAGE_CAP_RGB_SWAP;
+            free = true;
+        }
+    }
+    if (free) {
+        img2encode.stride = 0;
         img2encode.data = heap_caps_malloc(get_img_byte_size(img2encode), MALLOC_CAP_DEFAULT);
         convert_img(img, img2encode, caps);
-        free = true;
     }
     jpeg_img_t ret = hw_encode_jpeg_base(img2encode, quality, timeout_ms, rgb_sub_sample_method);
     if (free) {
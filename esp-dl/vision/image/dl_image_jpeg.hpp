@@ -4,6 +4,7 @@
 #include "esp_heap_caps.h"
 #include "esp_log.h"
 #include "sdkconfig.h"
+#include <functional>
 #if CONFIG_SOC_JPEG_CODEC_SUPPORTED
 #include "driver/jpeg_decode.h"
 #include "driver/jpeg_encode.h"
@@ -11,6 +12,28 @@
 
 namespace dl {
 namespace image {
+/**
+ * @brief Get the size of a jpeg image from its frame header, without decoding it.
+ *
+ * @param jpeg_img The jpeg image.
+ * @param width Output, width of the image.
+ * @param height Output, height of the image.
+ * @return esp_err_t
+ */
+esp_err_t get_jpeg_size(const jpeg_img_t &jpeg_img, int *width, int *height);
+
+/**
+ * @brief Get the downscaling of the software jpeg decoder, which drops the high frequency DCT coefficients instead of
+ * resizing the decoded image.
+ *
+ * @param width Width of the jpeg image.
+ * @param height Height of the jpeg image.
+ * @param min_width The decoded image is at least min_width wide.
+ * @param min_height The decoded image is at least min_height high. If both are 0, the image is not downscaled.
+ * @return The image is decoded at 1 / (1 << shift) of its size, shift is 0 to 3.
+ */
+int get_sw_decode_jpeg_shift(int width, int height, int min_width, int min_height);
+
 /**
  * @brief Softawre jpeg decode.
  * @note Support decoding color image into RGB888/RGB565. Do not support Gray image.
@@ -19,9 +42,87 @@ namespace image {
  * @param pix_type The pixel type of the decoded image.
  * @param caps Default to 0, decode to RGB565 in little endian RGB/ RGB888 in RGB. Set caps to
  * DL_IMAGE_CAP_RGB565_BIG_ENDIAN to get a big endian image.
+ * @param min_width Default to 0. Decode at 1/2, 1/4 or 1/8 of the size if the image is still at least min_width wide
+ * and min_height high, e.g. the input size of the model.
+ * @param min_height Default to 0, together with min_width = 0 the image is decoded at full size.
  * @return img_t
  */
-img_t sw_decode_jpeg(const jpeg_img_t &jpeg_img, pix_type_t pix_type, uint32_t caps = 0);
+img_t sw_decode_jpeg(
+    const jpeg_img_t &jpeg_img, pix_type_t pix_type, uint32_t caps = 0, int min_width = 0, int min_height = 0);
+
+/**
+ * @brief Softawre jpeg decoder which keeps its output buffer from one image to the next, for image sequences like
+ * MJPEG streams or a folder of images.
+ * @note Support decoding color image into RGB888/RGB565. Do not support Gray image.
+ */
+class SwJpegDecoder {
+public:
+    /**
+     * @brief Function called with each decoded block of rows, rows.data is valid until it returns.
+     *
+     * @param rows The decoded rows, rows.height is the number of rows.
+     * @param y The index of the first row in the decoded image.
+     */
+    using RowsCallback = std::function<void(const img_t &rows, int y)>;
+
+    /**
+     * @brief Construct a new SwJpegDecoder object.
+     *
+     * @param pix_type The pixel type of the decoded images, RGB888 or RGB565.
+     * @param caps Same as sw_decode_jpeg().
+     */
+    SwJpegDecoder(pix_type_t pix_type, uint32_t caps = 0);
+    ~SwJpegDecoder();
+
+    /**
+     * @brief Decode a whole image.
+     *
+     * @param jpeg_img The jpeg image.
+     * @param img Output, the decoded image. Its data belongs to the decoder and is valid until the next decode.
+     * @param min_width Same as sw_decode_jpeg().
+     * @param min_height Same as sw_decode_jpeg().
+     * @return esp_err_t
+     */
+    esp_err_t decode(const jpeg_img_t &jpeg_img, img_t &img, int min_width = 0, int min_height = 0);
+
+    /**
+     * @brief Decode an image block row by block row (8 or 16 rows of the jpeg image), only one block row is kept in
+     * memory. Falls back to decoding the whole image into the buffer if the decoder can not output blocks.
+     *
+     * @param jpeg_img The jpeg image.
+     * @param callback Called with the block rows from top to bottom.
+     * @param min_width Same as sw_decode_jpeg().
+     * @param min_height Same as sw_decode_jpeg().
+     * @return esp_err_t
+     */
+    esp_err_t decode_rows(const jpeg_img_t &jpeg_img,
+                          const RowsCallback &callback,
+                          int min_width = 0,
+                          int min_height = 0);
+
+    /**
+     * @brief Size of the last image before downscaling.
+     */
+    int get_width() { return m_width; }
+    int get_height() { return m_height; }
+    /**
+     * @brief Downscaling of the last image, it was decoded at 1 / (1 << shift) of its size.
+     */
+    int get_shift() { return m_shift; }
+
+private:
+    pix_type_t m_pix_type;
+    uint32_t m_caps;
+    void *m_buffer;       /*!< output buffer, reused if it is large enough */
+    size_t m_buffer_size; /*!< size of m_buffer in bytes */
+    int m_width;
+    int m_height;
+    int m_shift;
+
+    void *get_buffer(size_t size);
+    esp_err_t decode_impl(
+        const jpeg_img_t &jpeg_img, img_t &img, int min_width, int min_height, const RowsCallback *callback);
+};
 
 /**
  * @brief Softawre jpeg encode.
@@ -1,5 +1,7 @@
 #include "dl_image_preprocessor.hpp"
 
+static const char *TAG = "dl_image_preprocessor";
+
 namespace dl {
 namespace image {
 
@@ -8,7 +10,7 @@ ImagePreprocessor::ImagePreprocessor(Model *model,
                                      const std::vector<float> &std,
                                      uint32_t caps,
                                      const std::string &input_name) :
-    m_mean(mean), m_std(std), m_caps(caps)
+    m_mean(mean), m_std(std), m_caps(caps), m_jpeg_decoder(nullptr)
 {
     m_model_input = model->get_input(input_name);
     assert(m_model_input->dtype == DATA_TYPE_INT8 || m_model_input->dtype == DATA_TYPE_INT16);
@@ -42,6 +44,7 @@ ImagePreprocessor::ImagePreprocessor(Model *model,
 ImagePreprocessor::~ImagePreprocessor()
 {
     heap_caps_free(m_norm_lut);
+    delete m_jpeg_decoder;
 #if CONFIG_IDF_TARGET_ESP32P4
     if (m_caps & DL_IMAGE_CAP_PPA) {
         heap_caps_free(m_ppa_buffer);
@@ -70,11 +73,25 @@ template void ImagePreprocessor::create_norm_lut<int16_t>();
 
 void ImagePreprocessor::preprocess(const img_t &img, const std::vector<int> &crop_area)
 {
-    assert(get_img_channel(img) == m_mean.size());
     m_crop_area = crop_area;
+    resize_to(img, m_output, crop_area, &m_resize_scale_x, &m_resize_scale_y);
+}
+
+void ImagePreprocessor::preprocess(
+    const img_t &img, const std::vector<int> &crop_area, void *dst, float *scale_x, float *scale_y)
+{
+    img_t output = m_output;
+    output.data = dst;
+    resize_to(img, output, crop_area, scale_x, scale_y);
+}
+
+void ImagePreprocessor::resize_to(
+    const img_t &img, img_t &output, const std::vector<int> &crop_area, float *scale_x, float *scale_y)
+{
+    assert(get_img_channel(img) == m_mean.size());
 #if CONFIG_IDF_TARGET_ESP32P4
     if (resize_ppa(img,
-                   m_output,
+                   output,
                    m_ppa_srm_handle,
                    m_ppa_buffer,
                    m_ppa_buffer_size,
@@ -83,33 +100,76 @@ void ImagePreprocessor::preprocess(const img_t &img, const std::vector<int> &cro
                    m_caps,
                    m_norm_lut,
                    crop_area,
-                   &m_resize_scale_x,
-                   &m_resize_scale_y) == ESP_FAIL) {
-        resize(img,
-               m_output,
-               DL_IMAGE_INTERPOLATE_NEAREST,
-               m_caps,
-               m_norm_lut,
-               crop_area,
-               &m_resize_scale_x,
-               &m_resize_scale_y);
+                   scale_x,
+                   scale_y) == ESP_FAIL) {
+        resize(img, output, DL_IMAGE_INTERPOLATE_NEAREST, m_caps, m_norm_lut, crop_area, scale_x, scale_y);
     }
 #else
-    resize(img,
-           m_output,
-           DL_IMAGE_INTERPOLATE_NEAREST,
-           m_caps,
-           m_norm_lut,
-           crop_area,
-           &m_resize_scale_x,
-           &m_resize_scale_y);
+    resize(img, output, DL_IMAGE_INTERPOLATE_NEAREST, m_caps, m_norm_lut, crop_area, scale_x, scale_y);
 #endif
 }
 
-void ImagePreprocessor::preprocess(const img_t &img, dl::math::Matrix<float> *M_inv)
+esp_err_t ImagePreprocessor::preprocess(const jpeg_img_t &jpeg_img, int *width, int *height)
+{
+    assert(m_mean.size() == 3);
+    if (!m_jpeg_decoder) {
+        m_jpeg_decoder = new SwJpegDecoder(DL_IMAGE_PIX_TYPE_RGB888);
+    }
+    img_t dst_row = m_output;
+    dst_row.height = 1;
+    size_t dst_row_bytes = get_img_byte_size(dst_row);
+    int dst_y = 0;
+    auto resize_rows = [&](const img_t &rows, int y) {
+        // Resize the output rows whose nearest source row is decoded, same rows as resize() of the whole image.
+        int src_height = m_jpeg_decoder->get_height() >> m_jpeg_decoder->get_shift();
+        float scale_y_inv = 1.f / ((float)m_output.height / (float)src_height);
+        img_t src_row = rows;
+        src_row.height = 1;
+        size_t src_row_bytes = get_img_byte_size(src_row);
+        for (; dst_y < m_output.height; dst_y++) {
+            float src_y = std::max(std::min((dst_y + 0.5f) * scale_y_inv - 0.5f, (float)(src_height - 1)), 0.f);
+            int row = (int)(src_y + 0.5f) - y;
+            if (row >= rows.height) {
+                break;
+            }
+            src_row.data = (uint8_t *)rows.data + row * src_row_bytes;
+            dst_row.data = (uint8_t *)m_output.data + dst_y * dst_row_bytes;
+            resize(src_row, dst_row, DL_IMAGE_INTERPOLATE_NEAREST, m_caps, m_norm_lut);
+        }
+    };
+    ESP_RETURN_ON_ERROR(m_jpeg_decoder->decode_rows(jpeg_img, resize_rows, m_output.width, m_output.height),
+                        TAG,
+                        "Failed to decode jpeg.");
+
+    m_crop_area.clear();
+    m_resize_scale_x = (float)m_output.width / (float)m_jpeg_decoder->get_width();
+    m_resize_scale_y = (float)m_output.height / (float)m_jpeg_decoder->get_height();
+    if (width) {
+        *width = m_jpeg_decoder->get_width();
+    }
+    if (height) {
+        *height = m_jpeg_decoder->get_height();
+    }
+    return ESP_OK;
+}
+
+void ImagePreprocessor::preprocess(const img_t &img,
+                                   dl::math::Matrix<float> *M_inv,
+                                   interpolate_type_t interpolate_type)
+{
+    assert(get_img_channel(img) == m_mean.size());
+    warp_affine(img, m_output, interpolate_type, M_inv, m_caps, m_norm_lut);
+}
+
+void ImagePreprocessor::preprocess(const img_t &img,
+                                   dl::math::Matrix<float> *M_inv,
+                                   void *dst,
+                                   interpolate_type_t interpolate_type)
 {
     assert(get_img_channel(img) == m_mean.size());
-    warp_affine(img, m_output, DL_IMAGE_INTERPOLATE_NEAREST, M_inv, m_caps, m_norm_lut);
+    img_t output = m_output;
+    output.data = dst;
+    warp_affine(img, output, interpolate_type, M_inv, m_caps, m_norm_lut);
 }
 } // namespace image
 } // namespace dl
@@ -27,6 +27,7 @@ private:
     float m_resize_scale_x;
     float m_resize_scale_y;
     img_t m_output;
+    SwJpegDecoder *m_jpeg_decoder;
 #if CONFIG_IDF_TARGET_ESP32P4
     ppa_client_handle_t m_ppa_srm_handle;
     size_t m_ppa_buffer_size;
@@ -34,6 +35,7 @@ private:
 #endif
     template <typename T>
     void create_norm_lut();
+    void resize_to(const img_t &img, img_t &output, const std::vector<int> &crop_area, float *scale_x, float *scale_y);
 
 public:
     ImagePreprocessor(Model *model,
@@ -50,7 +52,46 @@ public:
     float get_top_left_y() { return m_crop_area[1]; };
 
     void preprocess(const img_t &img, const std::vector<int> &crop_area = {});
-    void preprocess(const img_t &img, dl::math::Matrix<float> *M_inv);
+
+    /**
+     * @brief Crop and resize the image into dst instead of the model input. It does not change the resize scales
+     *        and the top left corner returned by the getters, so it can run on another task.
+     *
+     * @param img        input image
+     * @param crop_area  [x1, y1, x2, y2] area of the image to resize
+     * @param dst        buffer of the model input size
+     * @param scale_x    output, resize scale along x
+     * @param scale_y    output, resize scale along y
+     */
+    void preprocess(const img_t &img, const std::vector<int> &crop_area, void *dst, float *scale_x, float *scale_y);
+    void preprocess(const img_t &img,
+                    dl::math::Matrix<float> *M_inv,
+                    interpolate_type_t interpolate_type = DL_IMAGE_INTERPOLATE_NEAREST);
+
+    /**
+     * @brief Decode a jpeg image straight into the model input. The image is decoded at 1/2, 1/4 or 1/8 of its size
+     *        if that is still larger than the model input, and resized block row by block row as it is decoded, so
+     *        the whole image is never in memory. The resize scales are relative to the size of the jpeg image.
+     *
+     * @param jpeg_img  input jpeg image, RGB
+     * @param width     output, width of the jpeg image
+     * @param height    output, height of the jpeg image
+     * @return esp_err_t
+     */
+    esp_err_t preprocess(const jpeg_img_t &jpeg_img, int *width = nullptr, int *height = nullptr);
+
+    /**
+     * @brief Warp the image into dst instead of the model input.
+     *
+     * @param img               input image
+     * @param M_inv             inverse of the affine matrix
+     * @param dst               buffer of the model input size
+     * @param interpolate_type  interpolation of the warp
+     */
+    void preprocess(const img_t &img,
+                    dl::math::Matrix<float> *M_inv,
+                    void *dst,
+                    interpolate_type_t interpolate_type = DL_IMAGE_INTERPOLATE_NEAREST);
 };
 
 } // namespace image
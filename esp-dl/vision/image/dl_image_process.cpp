@@ -20,11 +20,18 @@ void bilinear_interpolate_rgb888(
     int y1 = (int)y;
     int y2 = y1 + 1;
 
-    uint8_t *img_data_ptr = (uint8_t *)img.data;
-    uint8_t *Q1_ptr = img_data_ptr + 3 * x1 + 3 * img.width * y1;
-    uint8_t *Q2_ptr = img_data_ptr + 3 * x2 + 3 * img.width * y1;
-    uint8_t *Q3_ptr = img_data_ptr + 3 * x1 + 3 * img.width * y2;
-    uint8_t *Q4_ptr = img_data_ptr + 3 * x2 + 3 * img.width * y2;
+    // The weights of x2/y2 are 0 on the last column/row, do not read past the image.
+    int last_x = crop_area.empty() ? img.width - 1 : crop_area[2] - 1;
+    int last_y = crop_area.empty() ? img.height - 1 : crop_area[3] - 1;
+    int x2_idx = std::min(x2, last_x);
+    int y2_idx = std::min(y2, last_y);
+
+    uint8_t *row1_ptr = (uint8_t *)get_img_row(img, y1);
+    uint8_t *row2_ptr = (uint8_t *)get_img_row(img, y2_idx);
+    uint8_t *Q1_ptr = row1_ptr + 3 * x1;
+    uint8_t *Q2_ptr = row1_ptr + 3 * x2_idx;
+    uint8_t *Q3_ptr = row2_ptr + 3 * x1;
+    uint8_t *Q4_ptr = row2_ptr + 3 * x2_idx;
 
     float A = (x2 - x) * (y2 - y);
     float B = (x - x1) * (y2 - y);
@@ -69,11 +76,18 @@ void bilinear_interpolate_rgb565(
     int y1 = (int)y;
     int y2 = y1 + 1;
 
-    uint16_t *img_data_ptr = (uint16_t *)img.data;
-    pix_t Q1_rgb565 = {.data = (void *)(img_data_ptr + x1 + img.width * y1), .type = DL_IMAGE_PIX_TYPE_RGB565};
-    pix_t Q2_rgb565 = {.data = (void *)(img_data_ptr + x2 + img.width * y1), .type = DL_IMAGE_PIX_TYPE_RGB565};
-    pix_t Q3_rgb565 = {.data = (void *)(img_data_ptr + x1 + img.width * y2), .type = DL_IMAGE_PIX_TYPE_RGB565};
-    pix_t Q4_rgb565 = {.data = (void *)(img_data_ptr + x2 + img.width * y2), .type = DL_IMAGE_PIX_TYPE_RGB565};
+    // The weights of x2/y2 are 0 on the last column/row, do not read past the image.
+    int last_x = crop_area.empty() ? img.width - 1 : crop_area[2] - 1;
+    int last_y = crop_area.empty() ? img.height - 1 : crop_area[3] - 1;
+    int x2_idx = std::min(x2, last_x);
+    int y2_idx = std::min(y2, last_y);
+
+    uint16_t *row1_ptr = (uint16_t *)get_img_row(img, y1);
+    uint16_t *row2_ptr = (uint16_t *)get_img_row(img, y2_idx);
+    pix_t Q1_rgb565 = {.data = (void *)(row1_ptr + x1), .type = DL_IMAGE_PIX_TYPE_RGB565};
+    pix_t Q2_rgb565 = {.data = (void *)(row1_ptr + x2_idx), .type = DL_IMAGE_PIX_TYPE_RGB565};
+    pix_t Q3_rgb565 = {.data = (void *)(row2_ptr + x1), .type = DL_IMAGE_PIX_TYPE_RGB565};
+    pix_t Q4_rgb565 = {.data = (void *)(row2_ptr + x2_idx), .type = DL_IMAGE_PIX_TYPE_RGB565};
     uint8_t tmp[12];
     uint8_t *Q1_ptr = tmp;
     uint8_t *Q2_ptr = tmp + 3;
@@ -125,11 +139,18 @@ void bilinear_interpolate_gray(
     int y1 = (int)y;
     int y2 = y1 + 1;
 
-    uint8_t *img_data_ptr = (uint8_t *)img.data;
-    uint8_t Q1 = img_data_ptr[x1 + img.width * y1];
-    uint8_t Q2 = img_data_ptr[x2 + img.width * y1];
-    uint8_t Q3 = img_data_ptr[x1 + img.width * y2];
-    uint8_t Q4 = img_data_ptr[x2 + img.width * y2];
+    // The weights of x2/y2 are 0 on the last column/row, do not read past the image.
+    int last_x = crop_area.empty() ? img.width - 1 : crop_area[2] - 1;
+    int last_y = crop_area.empty() ? img.height - 1 : crop_area[3] - 1;
+    int x2_idx = std::min(x2, last_x);
+    int y2_idx = std::min(y2, last_y);
+
+    uint8_t *row1_ptr = (uint8_t *)get_img_row(img, y1);
+    uint8_t *row2_ptr = (uint8_t *)get_img_row(img, y2_idx);
+    uint8_t Q1 = row1_ptr[x1];
+    uint8_t Q2 = row1_ptr[x2_idx];
+    uint8_t Q3 = row2_ptr[x1];
+    uint8_t Q4 = row2_ptr[x2_idx];
 
     float A = (x2 - x) * (y2 - y);
     float B = (x - x1) * (y2 - y);
@@ -158,7 +179,7 @@ void nearest_interpolate_rgb888(
     int x1 = (int)(x + 0.5f);
     int y1 = (int)(y + 0.5f);
 
-    pix_t Q = {.data = (void *)((uint8_t *)img.data + 3 * x1 + 3 * img.width * y1), .type = DL_IMAGE_PIX_TYPE_RGB888};
+    pix_t Q = {.data = (void *)((uint8_t *)get_img_row(img, y1) + 3 * x1), .type = DL_IMAGE_PIX_TYPE_RGB888};
     convert_pixel(Q, pix, caps, norm_lut);
 }
 
@@ -175,7 +196,7 @@ void nearest_interpolate_rgb565(
     int x1 = (int)(x + 0.5f);
     int y1 = (int)(y + 0.5f);
 
-    pix_t Q = {.data = (void *)((uint16_t *)img.data + x1 + img.width * y1), .type = DL_IMAGE_PIX_TYPE_RGB565};
+    pix_t Q = {.data = (void *)((uint16_t *)get_img_row(img, y1) + x1), .type = DL_IMAGE_PIX_TYPE_RGB565};
     convert_pixel(Q, pix, caps, norm_lut);
 }
 
@@ -192,7 +213,7 @@ void nearest_interpolate_gray(
     int x1 = (int)(x + 0.5f);
     int y1 = (int)(y + 0.5f);
 
-    pix_t Q = {.data = (void *)((uint8_t *)img.data + x1 + img.width * y1), .type = DL_IMAGE_PIX_TYPE_GRAY};
+    pix_t Q = {.data = (void *)((uint8_t *)get_img_row(img, y1) + x1), .type = DL_IMAGE_PIX_TYPE_GRAY};
     convert_pixel(Q, pix, 0, norm_lut);
 }
 
@@ -207,7 +228,7 @@ void resize_loop(const img_t &src_img,
                  float scale_y)
 {
     float x, y;
-    T *pix_ptr = (T *)dst_img.data;
+    T *pix_ptr;
     pix_t pix;
     pix.type = dst_img.pix_type;
     int step = DL_IMAGE_IS_PIX_TYPE_RGB888(pix.type) ? 3 : 1;
@@ -219,6 +240,7 @@ void resize_loop(const img_t &src_img,
         if (src_img.pix_type == DL_IMAGE_PIX_TYPE_RGB888) {
             for (int i = 0; i < dst_img.height; i++) {
                 y = (i + 0.5f) * scale_y_inv - 0.5f;
+                pix_ptr = (T *)get_img_row(dst_img, i);
                 for (int j = 0; j < dst_img.width; j++) {
                     x = (j + 0.5f) * scale_x_inv - 0.5f;
                     pix.data = (void *)pix_ptr;
@@ -229,6 +251,7 @@ void resize_loop(const img_t &src_img,
         } else if (src_img.pix_type == DL_IMAGE_PIX_TYPE_RGB565) {
             for (int i = 0; i < dst_img.height; i++) {
                 y = (i + 0.5f) * scale_y_inv - 0.5f;
+                pix_ptr = (T *)get_img_row(dst_img, i);
                 for (int j = 0; j < dst_img.width; j++) {
                     x = (j + 0.5f) * scale_x_inv - 0.5f;
                     pix.data = (void *)pix_ptr;
@@ -239,6 +262,7 @@ void resize_loop(const img_t &src_img,
         } else if (src_img.pix_type == DL_IMAGE_PIX_TYPE_GRAY) {
             for (int i = 0; i < dst_img.height; i++) {
                 y = (i + 0.5f) * scale_y_inv - 0.5f;
+                pix_ptr = (T *)get_img_row(dst_img, i);
                 for (int j = 0; j < dst_img.width; j++) {
                     x = (j + 0.5f) * scale_x_inv - 0.5f;
                     pix.data = (void *)pix_ptr;
@@ -254,6 +278,7 @@ void resize_loop(const img_t &src_img,
         if (src_img.pix_type == DL_IMAGE_PIX_TYPE_RGB888) {
             for (int i = 0; i < dst_img.height; i++) {
                 y = (i + 0.5f) * scale_y_inv - 0.5f;
+                pix_ptr = (T *)get_img_row(dst_img, i);
                 for (int j = 0; j < dst_img.width; j++) {
                     x = (j + 0.5f) * scale_x_inv - 0.5f;
                     pix.data = (void *)pix_ptr;
@@ -264,6 +289,7 @@ void resize_loop(const img_t &src_img,
         } else if (src_img.pix_type == DL_IMAGE_PIX_TYPE_RGB565) {
             for (int i = 0; i < dst_img.height; i++) {
                 y = (i + 0.5f) * scale_y_inv - 0.5f;
+                pix_ptr = (T *)get_img_row(dst_img, i);
                 for (int j = 0; j < dst_img.width; j++) {
                     x = (j + 0.5f) * scale_x_inv - 0.5f;
                     pix.data = (void *)pix_ptr;
@@ -274,6 +300,7 @@ void resize_loop(const img_t &src_img,
         } else if (src_img.pix_type == DL_IMAGE_PIX_TYPE_GRAY) {
             for (int i = 0; i < dst_img.height; i++) {
                 y = (i + 0.5f) * scale_y_inv - 0.5f;
+                pix_ptr = (T *)get_img_row(dst_img, i);
                 for (int j = 0; j < dst_img.width; j++) {
                     x = (j + 0.5f) * scale_x_inv - 0.5f;
                     pix.data = (void *)pix_ptr;
@@ -423,6 +450,10 @@ esp_err_t resize_ppa(const img_t &src_img,
     if (convert_pix_type_to_ppa_srm_fmt(src_img.pix_type, &input_srm_color_mode) == ESP_FAIL) {
         return ESP_FAIL;
     }
+    // ppa reads the rows of the input picture pic_w pixels apart.
+    if (get_img_stride(src_img) % get_pix_byte_size(src_img.pix_type)) {
+        return ESP_FAIL;
+    }
     assert(ppa_handle);
     assert(ppa_buffer);
     assert(src_img.data);
@@ -492,7 +523,7 @@ esp_err_t resize_ppa(const img_t &src_img,
     }
     srm_oper_config.in.buffer = (const void *)src_img.data;
     srm_oper_config.in.pic_h = src_img.height;
-    srm_oper_config.in.pic_w = src_img.width;
+    srm_oper_config.in.pic_w = get_img_stride(src_img) / get_pix_byte_size(src_img.pix_type);
     srm_oper_config.in.srm_cm = input_srm_color_mode;
     srm_oper_config.rgb_swap = caps & DL_IMAGE_CAP_RGB_SWAP;
     srm_oper_config.byte_swap =
@@ -525,14 +556,58 @@ esp_err_t resize_ppa(const img_t &src_img,
         img_t ppa_output_img = {
             .data = ppa_buffer, .width = dst_img.width, .height = dst_img.height, .pix_type = DL_IMAGE_PIX_TYPE_RGB888};
         convert_img(ppa_output_img, dst_img, 0, norm_lut);
-    } else {
+    } else if (is_img_packed(dst_img)) {
         if (dst_img.data != ppa_buffer) {
             tool::copy_memory(dst_img.data, ppa_buffer, get_img_byte_size(dst_img));
         }
+    } else {
+        size_t row_bytes = dst_img.width * get_pix_byte_size(dst_img.pix_type);
+        for (int i = 0; i < dst_img.height; i++) {
+            tool::copy_memory(get_img_row(dst_img, i), (uint8_t *)ppa_buffer + i * row_bytes, row_bytes);
+        }
     }
     return ESP_OK;
 }
 #endif
+/* warp_affine() steps the source coordinates in Q16 and interpolates with Q10 weights. */
+static constexpr int WARP_COORD_BITS = 16;
+static constexpr int WARP_WEIGHT_BITS = 10;
+
+static inline uint8_t bilinear_fixed(int Q1, int Q2, int Q3, int Q4, int fx, int fy)
+{
+    const int one = 1 << WARP_WEIGHT_BITS;
+    int top = Q1 * (one - fx) + Q2 * fx;
+    int bottom = Q3 * (one - fx) + Q4 * fx;
+    return (uint8_t)((top * (one - fy) + bottom * fy + (1 << (2 * WARP_WEIGHT_BITS - 1))) >> (2 * WARP_WEIGHT_BITS));
+}
+
+/**
+ * @brief Walk the destination pixels and call sample() with the clamped Q16 source coordinates. Along a row the
+ *        coordinates only need two additions per pixel, every row starts from its exact position so the rounding of
+ *        the steps does not accumulate. Source coordinates must stay within +-32767 pixels.
+ */
+template <typename T, typename Sampler>
+static void warp_affine_rows(
+    const img_t &src_img, img_t &dst_img, dl::math::Matrix<float> *M_inv, int step, Sampler sample)
+{
+    const float one = (float)(1 << WARP_COORD_BITS);
+    const int32_t max_x = (src_img.width - 1) << WARP_COORD_BITS;
+    const int32_t max_y = (src_img.height - 1) << WARP_COORD_BITS;
+    const int32_t step_x = (int32_t)lroundf(M_inv->array[0][0] * one);
+    const int32_t step_y = (int32_t)lroundf(M_inv->array[1][0] * one);
+    for (int i = 0; i < dst_img.height; i++) {
+        T *pix_ptr = (T *)get_img_row(dst_img, i);
+        int32_t x = (int32_t)lroundf((M_inv->array[0][1] * i + M_inv->array[0][2]) * one);
+        int32_t y = (int32_t)lroundf((M_inv->array[1][1] * i + M_inv->array[1][2]) * one);
+        for (int j = 0; j < dst_img.width; j++) {
+            sample(std::max(std::min(x, max_x), 0), std::max(std::min(y, max_y), 0), pix_ptr);
+            x += step_x;
+            y += step_y;
+            pix_ptr += step;
+        }
+    }
+}
+
 template <typename T>
 void warp_affine_loop(const img_t &src_img,
                       img_t &dst_img,
@@ -541,104 +616,121 @@ void warp_affine_loop(const img_t &src_img,
                       uint32_t caps,
                       void *norm_lut)
 {
-    float x, y;
-    T *pix_ptr = (T *)dst_img.data;
     pix_t pix;
     pix.type = dst_img.pix_type;
     int step = DL_IMAGE_IS_PIX_TYPE_RGB888(pix.type) ? 3 : 1;
 
-    float Ax, Bx, Ay, By;
+    const int stride = get_img_stride(src_img);
+    const int last_x = src_img.width - 1;
+    const int last_y = src_img.height - 1;
+    const int32_t frac_mask = (1 << WARP_COORD_BITS) - 1;
+    const int32_t half = 1 << (WARP_COORD_BITS - 1);
+    const int frac_shift = WARP_COORD_BITS - WARP_WEIGHT_BITS;
+    uint8_t tmp[15];
+
+    // Quantized RGB888 outputs are looked up in norm_lut right here, the other outputs go through convert_pixel().
+    bool direct_quant = (pix.type == DL_IMAGE_PIX_TYPE_RGB888_QINT8 || pix.type == DL_IMAGE_PIX_TYPE_RGB888_QINT16);
+    T *lut = (T *)norm_lut;
+    auto store_rgb888 = [&](uint8_t *rgb, T *dst, uint32_t rgb_caps) {
+        if (direct_quant) {
+            if (rgb_caps & DL_IMAGE_CAP_RGB_SWAP) {
+                dst[0] = lut[rgb[2]];
+                dst[1] = lut[rgb[1]];
+                dst[2] = lut[rgb[0]];
+            } else {
+                dst[0] = lut[rgb[0]];
+                dst[1] = lut[rgb[1]];
+                dst[2] = lut[rgb[2]];
+            }
+        } else {
+            pix_t Q_rgb888 = {.data = (void *)rgb, .type = DL_IMAGE_PIX_TYPE_RGB888};
+            pix.data = (void *)dst;
+            convert_pixel(Q_rgb888, pix, rgb_caps, norm_lut);
+        }
+    };
+    auto store_gray = [&](uint8_t *gray, T *dst) {
+        if (pix.type == DL_IMAGE_PIX_TYPE_GRAY) {
+            *dst = *gray;
+        } else {
+            pix_t Q_gray = {.data = (void *)gray, .type = DL_IMAGE_PIX_TYPE_GRAY};
+            pix.data = (void *)dst;
+            convert_pixel(Q_gray, pix, 0, norm_lut);
+        }
+    };
+
     switch (interpolate_type) {
     case DL_IMAGE_INTERPOLATE_BILINEAR:
         if (src_img.pix_type == DL_IMAGE_PIX_TYPE_RGB888) {
-            for (int i = 0; i < dst_img.height; i++) {
-                Bx = M_inv->array[0][1] * i;
-                By = M_inv->array[1][1] * i;
-                for (int j = 0; j < dst_img.width; j++) {
-                    Ax = M_inv->array[0][0] * j;
-                    Ay = M_inv->array[1][0] * j;
-                    x = Ax + Bx + M_inv->array[0][2];
-                    y = Ay + By + M_inv->array[1][2];
-                    pix.data = (void *)pix_ptr;
-                    bilinear_interpolate_rgb888(src_img, x, y, pix, caps, norm_lut);
-                    pix_ptr += step;
+            warp_affine_rows<T>(src_img, dst_img, M_inv, step, [&](int32_t x, int32_t y, T *dst) {
+                int x1 = x >> WARP_COORD_BITS;
+                int y1 = y >> WARP_COORD_BITS;
+                int fx = (x & frac_mask) >> frac_shift;
+                int fy = (y & frac_mask) >> frac_shift;
+                uint8_t *Q1_ptr = (uint8_t *)src_img.data + stride * y1 + 3 * x1;
+                uint8_t *Q2_ptr = Q1_ptr + (x1 < last_x ? 3 : 0);
+                int dy = y1 < last_y ? stride : 0;
+                for (int c = 0; c < 3; c++) {
+                    tmp[c] = bilinear_fixed(Q1_ptr[c], Q2_ptr[c], Q1_ptr[dy + c], Q2_ptr[dy + c], fx, fy);
                 }
-            }
+                store_rgb888(tmp, dst, caps);
+            });
         } else if (src_img.pix_type == DL_IMAGE_PIX_TYPE_RGB565) {
-            for (int i = 0; i < dst_img.height; i++) {
-                Bx = M_inv->array[0][1] * i;
-                By = M_inv->array[1][1] * i;
-                for (int j = 0; j < dst_img.width; j++) {
-                    Ax = M_inv->array[0][0] * j;
-                    Ay = M_inv->array[1][0] * j;
-                    x = Ax + Bx + M_inv->array[0][2];
-                    y = Ay + By + M_inv->array[1][2];
-                    pix.data = (void *)pix_ptr;
-                    bilinear_interpolate_rgb565(src_img, x, y, pix, caps, norm_lut);
-                    pix_ptr += step;
+            warp_affine_rows<T>(src_img, dst_img, M_inv, step, [&](int32_t x, int32_t y, T *dst) {
+                int x1 = x >> WARP_COORD_BITS;
+                int y1 = y >> WARP_COORD_BITS;
+                int fx = (x & frac_mask) >> frac_shift;
+                int fy = (y & frac_mask) >> frac_shift;
+                uint16_t *Q1_ptr = (uint16_t *)((uint8_t *)src_img.data + stride * y1) + x1;
+                uint16_t *Q2_ptr = Q1_ptr + (x1 < last_x ? 1 : 0);
+                int dy = y1 < last_y ? stride / 2 : 0;
+                // RGB swap is applied when the corners are decoded.
+                convert_pixel_from_rgb565_to_rgb888(Q1_ptr, tmp, caps);
+                convert_pixel_from_rgb565_to_rgb888(Q2_ptr, tmp + 3, caps);
+                convert_pixel_from_rgb565_to_rgb888(Q1_ptr + dy, tmp + 6, caps);
+                convert_pixel_from_rgb565_to_rgb888(Q2_ptr + dy, tmp + 9, caps);
+                for (int c = 0; c < 3; c++) {
+                    tmp[12 + c] = bilinear_fixed(tmp[c], tmp[3 + c], tmp[6 + c], tmp[9 + c], fx, fy);
                 }
-            }
+                store_rgb888(tmp + 12, dst, 0);
+            });
         } else if (src_img.pix_type == DL_IMAGE_PIX_TYPE_GRAY) {
-            for (int i = 0; i < dst_img.height; i++) {
-                Bx = M_inv->array[0][1] * i;
-                By = M_inv->array[1][1] * i;
-                for (int j = 0; j < dst_img.width; j++) {
-                    Ax = M_inv->array[0][0] * j;
-                    Ay = M_inv->array[1][0] * j;
-                    x = Ax + Bx + M_inv->array[0][2];
-                    y = Ay + By + M_inv->array[1][2];
-                    pix.data = (void *)pix_ptr;
-                    bilinear_interpolate_gray(src_img, x, y, pix, norm_lut);
-                    pix_ptr += step;
-                }
-            }
+            warp_affine_rows<T>(src_img, dst_img, M_inv, step, [&](int32_t x, int32_t y, T *dst) {
+                int x1 = x >> WARP_COORD_BITS;
+                int y1 = y >> WARP_COORD_BITS;
+                int fx = (x & frac_mask) >> frac_shift;
+                int fy = (y & frac_mask) >> frac_shift;
+                uint8_t *Q1_ptr = (uint8_t *)src_img.data + stride * y1 + x1;
+                uint8_t *Q2_ptr = Q1_ptr + (x1 < last_x ? 1 : 0);
+                int dy = y1 < last_y ? stride : 0;
+                tmp[0] = bilinear_fixed(*Q1_ptr, *Q2_ptr, Q1_ptr[dy], Q2_ptr[dy], fx, fy);
+                store_gray(tmp, dst);
+            });
         } else {
             ESP_LOGE(TAG, "Do not support quant img type.");
         }
         break;
     case DL_IMAGE_INTERPOLATE_NEAREST:
         if (src_img.pix_type == DL_IMAGE_PIX_TYPE_RGB888) {
-            for (int i = 0; i < dst_img.height; i++) {
-                Bx = M_inv->array[0][1] * i;
-                By = M_inv->array[1][1] * i;
-                for (int j = 0; j < dst_img.width; j++) {
-                    Ax = M_inv->array[0][0] * j;
-                    Ay = M_inv->array[1][0] * j;
-                    x = Ax + Bx + M_inv->array[0][2];
-                    y = Ay + By + M_inv->array[1][2];
-                    pix.data = (void *)pix_ptr;
-                    nearest_interpolate_rgb888(src_img, x, y, pix, caps, norm_lut);
-                    pix_ptr += step;
-                }
-            }
+            warp_affine_rows<T>(src_img, dst_img, M_inv, step, [&](int32_t x, int32_t y, T *dst) {
+                int x1 = (x + half) >> WARP_COORD_BITS;
+                int y1 = (y + half) >> WARP_COORD_BITS;
+                store_rgb888((uint8_t *)src_img.data + stride * y1 + 3 * x1, dst, caps);
+            });
         } else if (src_img.pix_type == DL_IMAGE_PIX_TYPE_RGB565) {
-            for (int i = 0; i < dst_img.height; i++) {
-                Bx = M_inv->array[0][1] * i;
-                By = M_inv->array[1][1] * i;
-                for (int j = 0; j < dst_img.width; j++) {
-                    Ax = M_inv->array[0][0] * j;
-                    Ay = M_inv->array[1][0] * j;
-                    x = Ax + Bx + M_inv->array[0][2];
-                    y = Ay + By + M_inv->array[1][2];
-                    pix.data = (void *)pix_ptr;
-                    nearest_interpolate_rgb565(src_img, x, y, pix, caps, norm_lut);
-                    pix_ptr += step;
-                }
-            }
+            warp_affine_rows<T>(src_img, dst_img, M_inv, step, [&](int32_t x, int32_t y, T *dst) {
+                int x1 = (x + half) >> WARP_COORD_BITS;
+                int y1 = (y + half) >> WARP_COORD_BITS;
+                pix_t Q = {.data = (void *)((uint16_t *)((uint8_t *)src_img.data + stride * y1) + x1),
+                           .type = DL_IMAGE_PIX_TYPE_RGB565};
+                pix.data = (void *)dst;
+                convert_pixel(Q, pix, caps, norm_lut);
+            });
         } else if (src_img.pix_type == DL_IMAGE_PIX_TYPE_GRAY) {
-            for (int i = 0; i < dst_img.height; i++) {
-                Bx = M_inv->array[0][1] * i;
-                By = M_inv->array[1][1] * i;
-                for (int j = 0; j < dst_img.width; j++) {
-                    Ax = M_inv->array[0][0] * j;
-                    Ay = M_inv->array[1][0] * j;
-                    x = Ax + Bx + M_inv->array[0][2];
-                    y = Ay + By + M_inv->array[1][2];
-                    pix.data = (void *)pix_ptr;
-                    nearest_interpolate_gray(src_img, x, y, pix, norm_lut);
-                    pix_ptr += step;
-                }
-            }
+            warp_affine_rows<T>(src_img, dst_img, M_inv, step, [&](int32_t x, int32_t y, T *dst) {
+                int x1 = (x + half) >> WARP_COORD_BITS;
+                int y1 = (y + half) >> WARP_COORD_BITS;
+                store_gray((uint8_t *)src_img.data + stride * y1 + x1, dst);
+            });
         } else {
             ESP_LOGE(TAG, "Do not support quant img type");
         }
@@ -0,0 +1,191 @@
+#include "dl_image_sequence.hpp"
+#include "dl_image_color.hpp"
+#include <algorithm>
+#include <dirent.h>
+#include <string.h>
+#include <strings.h>
+
+static const char *TAG = "dl_image_sequence";
+
+namespace dl {
+namespace image {
+static bool has_suffix(const char *name, const char *suffix)
+{
+    size_t len = strlen(name), suffix_len = strlen(suffix);
+    return len >= suffix_len && !strcasecmp(name + len - suffix_len, suffix);
+}
+
+static bool is_bmp(const std::string &file)
+{
+    return has_suffix(file.c_str(), ".bmp");
+}
+
+ImageSequence::ImageSequence(const char *path, pix_type_t pix_type, uint32_t caps) :
+    m_pix_type(pix_type),
+    m_caps(caps),
+    m_decoder(pix_type, caps),
+    m_jpeg({.data = nullptr, .data_len = 0}),
+    m_jpeg_size(0),
+    m_bmp({.data = nullptr, .width = 0, .height = 0, .pix_type = DL_IMAGE_PIX_TYPE_RGB888}),
+    m_bmp_converted(nullptr),
+    m_bmp_converted_size(0)
+{
+    if (has_suffix(path, ".mjpeg") || has_suffix(path, ".mjpg")) {
+        list_mjpeg(path);
+    } else {
+        list_dir(path);
+    }
+    if (m_frames.empty()) {
+        ESP_LOGW(TAG, "No frames in %s.", path);
+    }
+}
+
+ImageSequence::~ImageSequence()
+{
+    if (m_jpeg.data) {
+        heap_caps_free(m_jpeg.data);
+    }
+    if (m_bmp.data) {
+        heap_caps_free(m_bmp.data);
+    }
+    if (m_bmp_converted) {
+        heap_caps_free(m_bmp_converted);
+    }
+}
+
+void ImageSequence::list_dir(const char *path)
+{
+    DIR *dir = opendir(path);
+    if (!dir) {
+        ESP_LOGE(TAG, "Failed to open %s.", path);
+        return;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(dir))) {
+        const char *name = entry->d_name;
+        if (has_suffix(name, ".jpg") || has_suffix(name, ".jpeg") || has_suffix(name, ".bmp")) {
+            m_frames.push_back({std::string(path) + "/" + name, 0, 0});
+        }
+    }
+    closedir(dir);
+    std::sort(m_frames.begin(), m_frames.end(), [](const frame_t &a, const frame_t &b) { return a.file < b.file; });
+}
+
+void ImageSequence::list_mjpeg(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        ESP_LOGE(TAG, "Failed to open %s.", path);
+        return;
+    }
+    // A frame starts at a SOI marker and ends after the next EOI marker, the entropy coded data never contains
+    // markers. Jpeg images with a thumbnail are not supported.
+    uint8_t buf[1024];
+    long offset = 0, start = -1;
+    int prev = -1;
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        for (size_t i = 0; i < n; i++, offset++) {
+            if (prev == 0xFF) {
+                if (buf[i] == 0xD8 && start < 0) {
+                    start = offset - 1;
+                } else if (buf[i] == 0xD9 && start >= 0) {
+                    m_frames.push_back({path, start, (size_t)(offset + 1 - start)});
+                    start = -1;
+                }
+            }
+            prev = buf[i];
+        }
+    }
+    fclose(f);
+}
+
+void *ImageSequence::reserve_jpeg(size_t size)
+{
+    if (size > m_jpeg_size) {
+        if (m_jpeg.data) {
+            heap_caps_free(m_jpeg.data);
+        }
+        m_jpeg.data = heap_caps_malloc(size, MALLOC_CAP_DEFAULT);
+        m_jpeg_size = m_jpeg.data ? size : 0;
+    }
+    return m_jpeg.data;
+}
+
+esp_err_t ImageSequence::load(int index)
+{
+    if (index < 0 || index >= m_frames.size()) {
+        ESP_LOGE(TAG, "Frame %d out of range [0, %d).", index, (int)m_frames.size());
+        return ESP_FAIL;
+    }
+    const frame_t &frame = m_frames[index];
+    m_jpeg.data_len = 0;
+    if (m_bmp.data) {
+        heap_caps_free(m_bmp.data);
+        m_bmp.data = nullptr;
+    }
+    if (is_bmp(frame.file)) {
+        m_bmp = read_bmp(frame.file.c_str());
+        return m_bmp.data ? ESP_OK : ESP_FAIL;
+    }
+
+    FILE *f = fopen(frame.file.c_str(), "rb");
+    if (!f) {
+        ESP_LOGE(TAG, "Failed to open %s.", frame.file.c_str());
+        return ESP_FAIL;
+    }
+    size_t size = frame.size;
+    if (!size) {
+        fseek(f, 0, SEEK_END);
+        size = ftell(f);
+    }
+    fseek(f, frame.offset, SEEK_SET);
+    if (!reserve_jpeg(size)) {
+        ESP_LOGE(TAG, "Failed to alloc jpeg buffer.");
+        fclose(f);
+        return ESP_FAIL;
+    }
+    if (fread(m_jpeg.data, size, 1, f) != 1) {
+        ESP_LOGE(TAG, "Failed to read %s.", frame.file.c_str());
+        fclose(f);
+        return ESP_FAIL;
+    }
+    fclose(f);
+    m_jpeg.data_len = size;
+    return ESP_OK;
+}
+
+esp_err_t ImageSequence::decode(img_t &img, int min_width, int min_height)
+{
+    if (is_jpeg()) {
+        return m_decoder.decode(m_jpeg, img, min_width, min_height);
+    }
+    if (!m_bmp.data) {
+        ESP_LOGE(TAG, "No frame is loaded.");
+        return ESP_FAIL;
+    }
+    if (m_bmp.pix_type == DL_IMAGE_PIX_TYPE_GRAY) {
+        img = m_bmp;
+        return ESP_OK;
+    }
+    // bmp is BGR
+    img = m_bmp;
+    img.pix_type = m_pix_type;
+    size_t size = get_img_byte_size(img);
+    if (size > m_bmp_converted_size) {
+        if (m_bmp_converted) {
+            heap_caps_free(m_bmp_converted);
+        }
+        m_bmp_converted = heap_caps_malloc(size, MALLOC_CAP_DEFAULT);
+        m_bmp_converted_size = m_bmp_converted ? size : 0;
+    }
+    if (!m_bmp_converted) {
+        ESP_LOGE(TAG, "Failed to alloc output buffer.");
+        return ESP_FAIL;
+    }
+    img.data = m_bmp_converted;
+    convert_img(m_bmp, img, m_caps | DL_IMAGE_CAP_RGB_SWAP);
+    return ESP_OK;
+}
+} // namespace image
+} // namespace dl
@@ -0,0 +1,85 @@
+#pragma once
+#include "dl_image_bmp.hpp"
+#include "dl_image_define.hpp"
+#include "dl_image_jpeg.hpp"
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+namespace dl {
+namespace image {
+/**
+ * @brief The frames of a directory of jpeg/bmp images in file name order, or of a MJPEG file, i.e. jpeg images one
+ * after another. Used to replay the same frames through a pipeline, e.g. to benchmark it.
+ * @note Reading a frame and decoding it are separate steps, so they can be timed separately. The buffers are reused
+ * from one frame to the next.
+ */
+class ImageSequence {
+public:
+    /**
+     * @brief Construct a new ImageSequence object.
+     *
+     * @param path A directory of .jpg/.jpeg/.bmp files, or a .mjpeg/.mjpg file.
+     * @param pix_type The pixel type of the decoded frames, RGB888 or RGB565.
+     * @param caps Default to 0, decode to RGB565 in little endian RGB/ RGB888 in RGB. Set caps to
+     * DL_IMAGE_CAP_RGB565_BIG_ENDIAN to get big endian frames.
+     */
+    ImageSequence(const char *path, pix_type_t pix_type = DL_IMAGE_PIX_TYPE_RGB888, uint32_t caps = 0);
+    ~ImageSequence();
+
+    /**
+     * @brief Number of frames, 0 if the path can not be read.
+     */
+    int size() { return m_frames.size(); }
+
+    /**
+     * @brief Read a frame from the file system, without decoding it.
+     *
+     * @param index Index of the frame.
+     * @return esp_err_t
+     */
+    esp_err_t load(int index);
+
+    /**
+     * @brief Whether the loaded frame is a jpeg image, see get_jpeg().
+     */
+    bool is_jpeg() { return m_jpeg.data_len > 0; }
+
+    /**
+     * @brief The loaded jpeg frame, e.g. for Detect::run(jpeg_img). Valid until the next load().
+     */
+    const jpeg_img_t &get_jpeg() { return m_jpeg; }
+
+    /**
+     * @brief Decode the loaded frame.
+     *
+     * @param img Output, the decoded frame, valid until the next load() or decode().
+     * @param min_width Same as sw_decode_jpeg(), ignored by bmp frames.
+     * @param min_height Same as sw_decode_jpeg(), ignored by bmp frames.
+     * @return esp_err_t
+     */
+    esp_err_t decode(img_t &img, int min_width = 0, int min_height = 0);
+
+private:
+    typedef struct {
+        std::string file; /*!< file of the frame */
+        long offset;      /*!< offset of a MJPEG frame in the file */
+        size_t size;      /*!< size of a MJPEG frame, 0 for a whole file */
+    } frame_t;
+
+    pix_type_t m_pix_type;
+    uint32_t m_caps;
+    std::vector<frame_t> m_frames;
+    SwJpegDecoder m_decoder;
+    jpeg_img_t m_jpeg;     /*!< loaded jpeg frame, data_len is 0 for a bmp frame */
+    size_t m_jpeg_size;    /*!< size of the buffer of m_jpeg */
+    img_t m_bmp;           /*!< loaded bmp frame */
+    void *m_bmp_converted; /*!< bmp frame in m_pix_type */
+    size_t m_bmp_converted_size;
+
+    void list_dir(const char *path);
+    void list_mjpeg(const char *path);
+    void *reserve_jpeg(size_t size);
+};
+} // namespace image
+} // namespace dl
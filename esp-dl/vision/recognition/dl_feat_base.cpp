@@ -1,13 +1,46 @@
 #include "dl_feat_base.hpp"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
 
 namespace dl {
 namespace feat {
+#if portNUM_PROCESSORS > 1
+static const char *TAG = "dl_feat_base";
+
+typedef struct {
+    dl::image::FeatImagePreprocessor *preprocessor;
+    const dl::image::img_t *img;
+    const std::vector<std::vector<int>> *landmarks;
+    void *dst;
+    SemaphoreHandle_t free; /*!< given when dst may be overwritten */
+    SemaphoreHandle_t done; /*!< given when the next face is in dst */
+} align_task_data_t;
+
+/**
+ * @brief Align faces 1..n-1 into dst one at a time, while the caller runs the model on the previous face.
+ */
+static void align_task(void *args)
+{
+    align_task_data_t *task = (align_task_data_t *)args;
+    for (int i = 1; i < task->landmarks->size(); i++) {
+        xSemaphoreTake(task->free, portMAX_DELAY);
+        task->preprocessor->preprocess(*task->img, (*task->landmarks)[i], task->dst);
+        xSemaphoreGive(task->done);
+    }
+    vTaskSuspend(NULL);
+}
+#endif
 
 FeatImpl::~FeatImpl()
 {
     delete m_model;
     delete m_image_preprocessor;
     delete m_postprocessor;
+    delete m_feats;
+    if (m_next_input) {
+        heap_caps_free(m_next_input);
+    }
 }
 
 TensorBase *FeatImpl::run(const dl::image::img_t &img, const std::vector<int> &landmarks)
@@ -28,5 +61,97 @@ TensorBase *FeatImpl::run(const dl::image::img_t &img, const std::vector<int> &l
     return feat;
 }
 
+TensorBase *FeatImpl::run(const dl::image::img_t &img,
+                          const std::vector<std::vector<int>> &landmarks,
+                          runtime_mode_t mode)
+{
+    int num = landmarks.size();
+    if (num == 0) {
+        return nullptr;
+    }
+    if (num > m_feats_capacity) {
+        delete m_feats;
+        m_feats = new TensorBase({num, m_feat_len}, nullptr, 0, DATA_TYPE_FLOAT);
+        m_feats_capacity = num;
+    }
+    m_feats->set_shape({num, m_feat_len});
+
+    DL_LOG_INFER_LATENCY_ARRAY_INIT_WITH_SIZE(2, num);
+    DL_LOG_INFER_LATENCY_ARRAY_START(1);
+    m_image_preprocessor->preprocess(img, landmarks[0]);
+
+    // A single core model run leaves the other core free to align the next face.
+#if portNUM_PROCESSORS > 1
+    TensorBase *input = m_image_preprocessor->get_model_input();
+    bool overlap = false;
+    align_task_data_t task_data;
+    TaskHandle_t task_handle = nullptr;
+    if (num > 1 && mode == RUNTIME_MODE_SINGLE_CORE) {
+        if (!m_next_input) {
+            m_next_input = heap_caps_aligned_alloc(16, input->get_bytes(), MALLOC_CAP_DEFAULT);
+        }
+        if (m_next_input) {
+            task_data = {
+                .preprocessor = m_image_preprocessor,
+                .img = &img,
+                .landmarks = &landmarks,
+                .dst = m_next_input,
+                .free = xSemaphoreCreateBinary(),
+                .done = xSemaphoreCreateBinary(),
+            };
+            if (task_data.free && task_data.done) {
+                xSemaphoreGive(task_data.free);
+                BaseType_t core_id = xPortGetCoreID();
+                UBaseType_t priority = uxTaskPriorityGet(xTaskGetCurrentTaskHandle());
+                overlap = xTaskCreatePinnedToCore(
+                              align_task, NULL, 4096, &task_data, priority, &task_handle, (core_id + 1) % 2) == pdPASS;
+            }
+            if (!overlap) {
+                if (task_data.free) {
+                    vSemaphoreDelete(task_data.free);
+                }
+                if (task_data.done) {
+                    vSemaphoreDelete(task_data.done);
+                }
+            }
+        }
+        if (!overlap) {
+            ESP_LOGW(TAG, "Failed to create the align task on the other core, align the faces one after the other");
+        }
+    }
+#endif
+
+    float *feat = (float *)m_feats->data;
+    for (int i = 0; i < num; i++, feat += m_feat_len) {
+        DL_LOG_INFER_LATENCY_ARRAY_START(0);
+        if (i > 0) {
+#if portNUM_PROCESSORS > 1
+            if (overlap) {
+                xSemaphoreTake(task_data.done, portMAX_DELAY);
+                tool::copy_memory(input->data, m_next_input, input->get_bytes());
+                xSemaphoreGive(task_data.free);
+            } else
+#endif
+            {
+                m_image_preprocessor->preprocess(img, landmarks[i]);
+            }
+        }
+        m_model->run(mode);
+        memcpy(feat, m_postprocessor->postprocess()->data, m_feat_len * sizeof(float));
+        DL_LOG_INFER_LATENCY_ARRAY_END(0);
+    }
+
+#if portNUM_PROCESSORS > 1
+    if (overlap) {
+        vTaskDelete(task_handle);
+        vSemaphoreDelete(task_data.free);
+        vSemaphoreDelete(task_data.done);
+    }
+#endif
+    DL_LOG_INFER_LATENCY_ARRAY_END(1);
+    DL_LOG_INFER_LATENCY_ARRAY_PRINT(0, "feat", "per face");
+    DL_LOG_INFER_LATENCY_ARRAY_PRINT(1, "feat", "batch");
+    return m_feats;
+}
 } // namespace feat
 } // namespace dl
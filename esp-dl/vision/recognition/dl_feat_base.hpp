@@ -10,6 +10,18 @@ class Feat {
 public:
     virtual ~Feat() {};
     virtual TensorBase *run(const dl::image::img_t &img, const std::vector<int> &landmarks) = 0;
+
+    /**
+     * @brief Extract the features of several faces of one image.
+     *
+     * @param img        input image
+     * @param landmarks  5 landmarks of each face
+     * @param mode       runtime mode of the model
+     * @return [num_faces, feat_len] L2 normalized features, valid until the next run
+     */
+    virtual TensorBase *run(const dl::image::img_t &img,
+                            const std::vector<std::vector<int>> &landmarks,
+                            runtime_mode_t mode = RUNTIME_MODE_SINGLE_CORE) = 0;
     int m_feat_len;
 };
 
@@ -23,6 +35,12 @@ public:
     {
         return m_model->run(img, landmarks);
     }
+    TensorBase *run(const dl::image::img_t &img,
+                    const std::vector<std::vector<int>> &landmarks,
+                    runtime_mode_t mode = RUNTIME_MODE_SINGLE_CORE)
+    {
+        return m_model->run(img, landmarks, mode);
+    }
 };
 
 class FeatImpl : public Feat {
@@ -30,10 +48,16 @@ protected:
     dl::Model *m_model;
     dl::image::FeatImagePreprocessor *m_image_preprocessor;
     dl::feat::FeatPostprocessor *m_postprocessor;
+    TensorBase *m_feats = nullptr; /*!< features of the last batch */
+    int m_feats_capacity = 0;      /*!< number of features m_feats can hold */
+    void *m_next_input = nullptr;  /*!< model input of the next face, aligned on the other core */
 
 public:
     ~FeatImpl();
     TensorBase *run(const dl::image::img_t &img, const std::vector<int> &landmarks) override;
+    TensorBase *run(const dl::image::img_t &img,
+                    const std::vector<std::vector<int>> &landmarks,
+                    runtime_mode_t mode = RUNTIME_MODE_SINGLE_CORE) override;
 };
 } // namespace feat
 } // namespace dl
@@ -10,7 +10,7 @@ FeatImagePreprocessor::~FeatImagePreprocessor()
     delete m_image_preprocessor;
 }
 
-void FeatImagePreprocessor::preprocess(const dl::image::img_t &img, const std::vector<int> &landmarks)
+void FeatImagePreprocessor::preprocess(const dl::image::img_t &img, const std::vector<int> &landmarks, void *dst)
 {
     assert(landmarks.size() == 10);
     // align face
@@ -24,7 +24,11 @@ void FeatImagePreprocessor::preprocess(const dl::image::img_t &img, const std::v
         source_coord.array[i][1] = h_scale * s_std_ldks_112[2 * i + 1];
     }
     dl::math::Matrix<float> M_inv = dl::math::get_similarity_transform(source_coord, dest_coord);
-    m_image_preprocessor->preprocess(img, &M_inv);
+    if (dst) {
+        m_image_preprocessor->preprocess(img, &M_inv, dst, m_interpolate_type);
+    } else {
+        m_image_preprocessor->preprocess(img, &M_inv, m_interpolate_type);
+    }
 }
 } // namespace image
 } // namespace dl
@@ -10,16 +10,27 @@ public:
                           const std::vector<float> &mean,
                           const std::vector<float> &std,
                           uint32_t caps = 0,
-                          const std::string &input_name = "") :
-        m_image_preprocessor(new dl::image::ImagePreprocessor(model, mean, std, caps, input_name)) {};
+                          const std::string &input_name = "",
+                          interpolate_type_t interpolate_type = DL_IMAGE_INTERPOLATE_NEAREST) :
+        m_image_preprocessor(new dl::image::ImagePreprocessor(model, mean, std, caps, input_name)),
+        m_interpolate_type(interpolate_type) {};
 
     ~FeatImagePreprocessor();
 
-    void preprocess(const dl::image::img_t &img, const std::vector<int> &landmarks);
+    /**
+     * @brief Align the face into the model input, or into dst if given.
+     *
+     * @param img        input image
+     * @param landmarks  5 face landmarks [x0, y0, ..., x4, y4]
+     * @param dst        buffer of the model input size
+     */
+    void preprocess(const dl::image::img_t &img, const std::vector<int> &landmarks, void *dst = nullptr);
+    TensorBase *get_model_input() { return m_image_preprocessor->m_model_input; }
 
 private:
     static std::vector<float> s_std_ldks_112;
     dl::image::ImagePreprocessor *m_image_preprocessor;
+    interpolate_type_t m_interpolate_type; /*!< interpolation of the alignment, bilinear is smoother and slower */
 };
 } // namespace image
 } // namespace dl
@@ -1,17 +1,111 @@
 #include "dl_recognition_database.hpp"
+#include "esp_rom_crc.h"
+#include <limits>
+#include <math.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 static const char *TAG = "dl::recognition::DataBase";
 
 namespace dl {
 namespace recognition {
-DataBase::DataBase(const char *db_path, int feat_len)
+static const uint32_t s_db_magic = 0x42444c45; /*!< "ELDB" */
+static const uint16_t s_db_version = 2;
+static const int s_db_io_buffer_size = 32 * 1024;
+static const int s_min_dead_records_to_compact = 64;
+
+static uint32_t cal_header_crc(const database_header &header)
+{
+    return esp_rom_crc32_le(0, (const uint8_t *)&header, offsetof(database_header, crc));
+}
+
+static uint32_t cal_record_crc(const database_record &record, const float *feat, int feat_len)
+{
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t *)&record, offsetof(database_record, crc));
+    if (record.type == DATABASE_RECORD_ENROLL) {
+        crc = esp_rom_crc32_le(crc, (const uint8_t *)feat, feat_len * sizeof(float));
+    }
+    return crc;
+}
+
+static esp_err_t write_header(FILE *f, int feat_len, uint16_t num_feats_total)
 {
-    assert(db_path);
+    database_header header = {s_db_magic, s_db_version, (uint16_t)feat_len, num_feats_total, 0, 0};
+    header.crc = cal_header_crc(header);
+    if (fwrite(&header, sizeof(database_header), 1, f) != 1) {
+        ESP_LOGE(TAG, "Failed to write db header.");
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t write_record(FILE *f, uint16_t type, uint16_t id, const float *feat, int feat_len)
+{
+    database_record record = {type, id, 0};
+    record.crc = cal_record_crc(record, feat, feat_len);
+    if (fwrite(&record, sizeof(database_record), 1, f) != 1 ||
+        (type == DATABASE_RECORD_ENROLL && fwrite(feat, sizeof(float), feat_len, f) != (size_t)feat_len)) {
+        ESP_LOGE(TAG, "Failed to write db record.");
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Read the next record, false at the end of the file or at a torn or corrupted record.
+ */
+static bool read_record(FILE *f, database_record &record, float *feat, int feat_len)
+{
+    if (fread(&record, sizeof(database_record), 1, f) != 1) {
+        return false;
+    }
+    if (record.type == DATABASE_RECORD_ENROLL) {
+        if (fread(feat, sizeof(float), feat_len, f) != (size_t)feat_len) {
+            return false;
+        }
+    } else if (record.type != DATABASE_RECORD_DELETE) {
+        return false;
+    }
+    return record.id != 0 && record.crc == cal_record_crc(record, feat, feat_len);
+}
+
+static esp_err_t sync_file(FILE *f)
+{
+    if (fflush(f) != 0 || fsync(fileno(f)) != 0) {
+        ESP_LOGE(TAG, "Failed to sync db file.");
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+DataBase::DataBase(const char *db_path, int feat_len, dtype_t feat_dtype) :
+    m_db_file(nullptr),
+    m_num_dead_records(0),
+    m_corrupted(false),
+    m_feat_dtype(feat_dtype),
+    m_capacity(0),
+    m_feat_matrix(nullptr),
+    m_index(nullptr)
+{
+    assert(feat_dtype == DATA_TYPE_FLOAT || feat_dtype == DATA_TYPE_INT16 || feat_dtype == DATA_TYPE_INT8);
+    m_feat_bytes = feat_len * dtype_sizeof(feat_dtype);
+    m_meta.num_feats_total = 0;
+    m_meta.num_feats_valid = 0;
+    m_meta.feat_len = feat_len;
+    if (!db_path) {
+        m_db_path = nullptr;
+        return;
+    }
     int length = strlen(db_path) + 1;
     m_db_path = (char *)malloc(sizeof(char) * length);
     memcpy(m_db_path, db_path, length);
+    m_tmp_path = std::string(db_path) + ".tmp";
+    m_index_path = std::string(db_path) + ".ivf";
     struct stat st;
+    if (stat(db_path, &st) != 0 && stat(m_tmp_path.c_str(), &st) == 0) {
+        // Power was lost between removing the old file and renaming the compacted one.
+        rename(m_tmp_path.c_str(), m_db_path);
+    }
     if (stat(db_path, &st) == 0) {
         load_database_from_storage(feat_len);
     } else {
@@ -21,228 +115,587 @@ DataBase::DataBase(const char *db_path, int feat_len)
 
 DataBase::~DataBase()
 {
+    close_database_file();
     clear_all_feats_in_memory();
+    if (m_feat_matrix) {
+        heap_caps_free(m_feat_matrix);
+    }
+    delete m_index;
     free(m_db_path);
 }
 
-esp_err_t DataBase::create_empty_database_in_storage(int feat_len)
+esp_err_t DataBase::open_database_file()
 {
-    FILE *f = fopen(m_db_path, "wb");
-    size_t size = 0;
-    if (!f) {
-        ESP_LOGE(TAG, "Failed to open db.");
-        return ESP_FAIL;
+    if (!m_db_file) {
+        m_db_file = fopen(m_db_path, "ab");
+        if (!m_db_file) {
+            ESP_LOGE(TAG, "Failed to open db.");
+            return ESP_FAIL;
+        }
     }
+    return ESP_OK;
+}
+
+void DataBase::close_database_file()
+{
+    if (m_db_file) {
+        fclose(m_db_file);
+        m_db_file = nullptr;
+    }
+}
+
+esp_err_t DataBase::create_empty_database_in_storage(int feat_len)
+{
     m_meta.num_feats_total = 0;
     m_meta.num_feats_valid = 0;
     m_meta.feat_len = feat_len;
-    size = fwrite(&m_meta, sizeof(database_meta), 1, f);
-    if (size != 1) {
-        ESP_LOGE(TAG, "Failed to write db meta data.");
-        fclose(f);
+    close_database_file();
+    remove(m_db_path);
+    return compact();
+}
+
+esp_err_t DataBase::compact()
+{
+    if (!m_db_path) {
+        return ESP_OK;
+    }
+    if (m_corrupted) {
+        ESP_LOGE(TAG, "Db file is corrupted, compacting it would drop the records after the corrupted one.");
         return ESP_FAIL;
     }
-    fclose(f);
+    close_database_file();
+    FILE *dst = fopen(m_tmp_path.c_str(), "wb");
+    if (!dst) {
+        ESP_LOGE(TAG, "Failed to open tmp db.");
+        return ESP_FAIL;
+    }
+    if (write_header(dst, m_meta.feat_len, m_meta.num_feats_total) != ESP_OK) {
+        fclose(dst);
+        return ESP_FAIL;
+    }
+    // Copy the live records from the old file, the features in memory may be quantized.
+    FILE *src = fopen(m_db_path, "rb");
+    if (src) {
+        database_record record;
+        std::vector<float> feat(m_meta.feat_len);
+        fseek(src, sizeof(database_header), SEEK_SET);
+        while (read_record(src, record, feat.data(), m_meta.feat_len)) {
+            if (record.type == DATABASE_RECORD_ENROLL &&
+                std::binary_search(m_feat_id.begin(), m_feat_id.end(), record.id) &&
+                write_record(dst, DATABASE_RECORD_ENROLL, record.id, feat.data(), m_meta.feat_len) != ESP_OK) {
+                fclose(src);
+                fclose(dst);
+                return ESP_FAIL;
+            }
+        }
+        fclose(src);
+    }
+    if (sync_file(dst) != ESP_OK) {
+        fclose(dst);
+        return ESP_FAIL;
+    }
+    fclose(dst);
+    // rename() does not replace an existing file on FAT, the constructor finishes an interrupted swap.
+    remove(m_db_path);
+    if (rename(m_tmp_path.c_str(), m_db_path) != 0) {
+        ESP_LOGE(TAG, "Failed to rename tmp db.");
+        return ESP_FAIL;
+    }
+    m_num_dead_records = 0;
     return ESP_OK;
 }
 
 esp_err_t DataBase::clear_all_feats()
 {
-    if (remove(m_db_path) == -1) {
-        ESP_LOGE(TAG, "Failed to remove db.");
+    clear_all_feats_in_memory();
+    m_corrupted = false;
+    if (m_db_path) {
+        ESP_RETURN_ON_ERROR(
+            create_empty_database_in_storage(m_meta.feat_len), TAG, "Failed to create empty db in storage.");
+    }
+    if (m_index) {
+        m_index->clear();
+        if (m_db_path) {
+            remove(m_index_path.c_str());
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t DataBase::enable_index(int nlist, int nprobe)
+{
+    if (nlist < 1 || nlist >= UINT16_MAX) {
+        ESP_LOGE(TAG, "Invalid nlist.");
         return ESP_FAIL;
     }
-    ESP_RETURN_ON_ERROR(
-        create_empty_database_in_storage(m_meta.feat_len), TAG, "Failed to create empty db in storage.");
-    clear_all_feats_in_memory();
+    delete m_index;
+    m_index = new IVFIndex(m_meta.feat_len, nlist, nprobe);
+    if (m_db_path && m_index->load(m_index_path.c_str(), m_feat_id, m_meta.num_feats_total) == ESP_OK) {
+        return ESP_OK;
+    }
+    if (m_index->need_train(m_feat_id.size())) {
+        return train_index();
+    }
+    // Not enough features yet, a stale index file must not be appended to.
+    if (m_db_path) {
+        remove(m_index_path.c_str());
+    }
     return ESP_OK;
 }
 
-void DataBase::clear_all_feats_in_memory()
+void DataBase::set_index_nprobe(int nprobe)
 {
-    for (auto it = m_feats.begin(); it != m_feats.end(); it++) {
-        heap_caps_free(it->feat);
+    if (m_index) {
+        m_index->set_nprobe(nprobe);
     }
-    m_feats.clear();
+}
+
+esp_err_t DataBase::train_index()
+{
+    m_index->train([this](int row, float *dst) { dequantize_feat(row, dst); }, m_feat_id.size());
+    if (!m_index->is_trained()) {
+        return ESP_FAIL;
+    }
+    if (!m_db_path) {
+        return ESP_OK;
+    }
+    return m_index->save(m_index_path.c_str(), m_feat_id, m_meta.num_feats_total);
+}
+
+void DataBase::clear_all_feats_in_memory()
+{
+    // Keep m_feat_matrix, it is reused by the next enrollments.
+    m_feat_scale.clear();
+    m_feat_id.clear();
     m_meta.num_feats_total = 0;
     m_meta.num_feats_valid = 0;
 }
 
+esp_err_t DataBase::reserve_feats_in_memory(int num)
+{
+    if (num <= m_capacity) {
+        return ESP_OK;
+    }
+    void *matrix = heap_caps_realloc(m_feat_matrix, (size_t)num * m_feat_bytes, MALLOC_CAP_SPIRAM);
+    if (!matrix) {
+        ESP_LOGE(TAG, "Failed to alloc feature matrix.");
+        return ESP_ERR_NO_MEM;
+    }
+    m_feat_matrix = matrix;
+    m_capacity = num;
+    return ESP_OK;
+}
+
+esp_err_t DataBase::add_feat_in_memory(uint16_t id, const float *feat)
+{
+    int num = m_feat_id.size();
+    if (num == m_capacity) {
+        ESP_RETURN_ON_ERROR(reserve_feats_in_memory(DL_MAX(m_capacity * 2, 16)), TAG, "Failed to add feature.");
+    }
+    uint8_t *row = (uint8_t *)m_feat_matrix + (size_t)num * m_feat_bytes;
+    // A float feature read from storage is already in place.
+    float scale = (const void *)feat == row ? 1.f : quantize_feat(feat, row);
+    m_feat_scale.push_back(scale);
+    m_feat_id.push_back(id);
+    m_meta.num_feats_valid = m_feat_id.size();
+    return ESP_OK;
+}
+
+void DataBase::delete_feat_in_memory(int index)
+{
+    int num = m_feat_id.size();
+    uint8_t *row = (uint8_t *)m_feat_matrix + (size_t)index * m_feat_bytes;
+    // Keep the enrollment order, query_feat() reports the position of the feature.
+    memmove(row, row + m_feat_bytes, (size_t)(num - index - 1) * m_feat_bytes);
+    m_feat_scale.erase(m_feat_scale.begin() + index);
+    m_feat_id.erase(m_feat_id.begin() + index);
+    m_meta.num_feats_valid = m_feat_id.size();
+    if (m_index && m_index->is_trained()) {
+        m_index->remove(index);
+    }
+}
+
+int DataBase::find_feat(uint16_t id)
+{
+    // Ids grow with enrollment and deletion keeps the order.
+    auto it = std::lower_bound(m_feat_id.begin(), m_feat_id.end(), id);
+    if (it == m_feat_id.end() || *it != id) {
+        return -1;
+    }
+    return it - m_feat_id.begin();
+}
+
+template <typename T>
+static float quantize_feat_template(const float *feat, int len, T *dst)
+{
+    float max_abs = 0;
+    for (int i = 0; i < len; i++) {
+        max_abs = DL_MAX(max_abs, fabsf(feat[i]));
+    }
+    const float qmax = std::numeric_limits<T>::max();
+    float scale = max_abs > 0 ? max_abs / qmax : 1.f;
+    float inv_scale = 1.f / scale;
+    for (int i = 0; i < len; i++) {
+        float value = roundf(feat[i] * inv_scale);
+        dst[i] = (T)DL_CLIP(value, -qmax, qmax);
+    }
+    return scale;
+}
+
+float DataBase::quantize_feat(const float *feat, void *dst)
+{
+    if (m_feat_dtype == DATA_TYPE_INT8) {
+        return quantize_feat_template(feat, m_meta.feat_len, (int8_t *)dst);
+    } else if (m_feat_dtype == DATA_TYPE_INT16) {
+        return quantize_feat_template(feat, m_meta.feat_len, (int16_t *)dst);
+    }
+    memcpy(dst, feat, m_feat_bytes);
+    return 1.f;
+}
+
+void DataBase::dequantize_feat(int index, float *dst)
+{
+    const void *row = (const uint8_t *)m_feat_matrix + (size_t)index * m_feat_bytes;
+    float scale = m_feat_scale[index];
+    if (m_feat_dtype == DATA_TYPE_INT8) {
+        for (int i = 0; i < m_meta.feat_len; i++) {
+            dst[i] = ((const int8_t *)row)[i] * scale;
+        }
+    } else if (m_feat_dtype == DATA_TYPE_INT16) {
+        for (int i = 0; i < m_meta.feat_len; i++) {
+            dst[i] = ((const int16_t *)row)[i] * scale;
+        }
+    } else {
+        memcpy(dst, row, m_feat_bytes);
+    }
+}
+
 esp_err_t DataBase::load_database_from_storage(int feat_len)
 {
     clear_all_feats_in_memory();
+    m_num_dead_records = 0;
+    m_corrupted = false;
     FILE *f = fopen(m_db_path, "rb");
-    size_t size = 0;
     if (!f) {
         ESP_LOGE(TAG, "Failed to open db.");
         return ESP_FAIL;
     }
-    size = fread(&m_meta, sizeof(database_meta), 1, f);
-    if (size != 1) {
-        ESP_LOGE(TAG, "Failed to read database meta.");
+    database_header header;
+    if (fread(&header, sizeof(database_header), 1, f) != 1 || header.magic != s_db_magic) {
+        fclose(f);
+        ESP_LOGW(TAG, "Converting db of the previous format.");
+        ESP_RETURN_ON_ERROR(convert_legacy_database(feat_len), TAG, "Failed to convert db.");
+        return load_database_from_storage(feat_len);
+    }
+    if (header.version != s_db_version || header.crc != cal_header_crc(header)) {
+        ESP_LOGE(TAG, "Unsupported or corrupted db header.");
         fclose(f);
         return ESP_FAIL;
     }
-    if (feat_len != m_meta.feat_len) {
+    if (feat_len != header.feat_len) {
         ESP_LOGE(TAG, "Feature len in storage does not match feature len in db.");
         fclose(f);
         return ESP_FAIL;
     }
-    uint16_t id;
-    for (int i = 0; i < m_meta.num_feats_total; i++) {
-        size = fread(&id, sizeof(uint16_t), 1, f);
-        if (size != 1) {
-            ESP_LOGE(TAG, "Failed to read feature id.");
+    m_meta.num_feats_total = header.num_feats_total;
+
+    // Size the matrix for every record once, then stream the file in large blocks.
+    long file_size = 0;
+    struct stat st;
+    if (stat(m_db_path, &st) == 0) {
+        file_size = st.st_size;
+        int num_records = (file_size - sizeof(database_header)) / (sizeof(database_record) + feat_len * sizeof(float));
+        reserve_feats_in_memory(num_records);
+    }
+    setvbuf(f, nullptr, _IOFBF, s_db_io_buffer_size);
+    std::vector<float> buffer(m_feat_dtype == DATA_TYPE_FLOAT ? 0 : feat_len);
+    database_record record;
+    long offset = 0;
+    bool torn = false;
+    while (true) {
+        int num = m_feat_id.size();
+        if (num == m_capacity && reserve_feats_in_memory(DL_MAX(m_capacity * 2, 16)) != ESP_OK) {
             fclose(f);
-            return ESP_FAIL;
+            return ESP_ERR_NO_MEM;
         }
-        if (id == 0) {
-            if (fseek(f, sizeof(float) * m_meta.feat_len, SEEK_CUR) != 0) {
-                ESP_LOGE(TAG, "Failed to seek db file.");
-                fclose(f);
-                return ESP_FAIL;
+        // Float features are read straight into the matrix.
+        float *feat = buffer.empty() ? (float *)((uint8_t *)m_feat_matrix + (size_t)num * m_feat_bytes)
+                                     : buffer.data();
+        offset = ftell(f);
+        if (!read_record(f, record, feat, feat_len)) {
+            // Only a failed record that runs to the end of the file is the one a power loss left half written.
+            if (offset < file_size) {
+                torn = feof(f) || ftell(f) >= file_size;
+                m_corrupted = !torn;
             }
+            break;
+        }
+        m_meta.num_feats_total = DL_MAX(m_meta.num_feats_total, record.id);
+        if (record.type == DATABASE_RECORD_ENROLL) {
+            add_feat_in_memory(record.id, feat);
             continue;
         }
-        float *feat = (float *)heap_caps_malloc(m_meta.feat_len * sizeof(float), MALLOC_CAP_SPIRAM);
-        size = fread(feat, sizeof(float), m_meta.feat_len, f);
-        if (size != m_meta.feat_len) {
-            ESP_LOGE(TAG, "Failed to read feature data.");
-            fclose(f);
-            return ESP_FAIL;
+        int index = find_feat(record.id);
+        if (index >= 0) {
+            delete_feat_in_memory(index);
+            m_num_dead_records++;
         }
-        m_feats.emplace_back(id, feat);
+        m_num_dead_records++;
     }
-    if (m_feats.size() != m_meta.num_feats_valid) {
-        ESP_LOGE(TAG, "Incorrect valid feature num.");
-        fclose(f);
+    fclose(f);
+    if (m_corrupted) {
+        // Keep the records after the corrupted one in the file, they may still be recovered.
+        ESP_LOGE(TAG,
+                 "Corrupted record at offset %ld of db, the records after it are not loaded and db is not written "
+                 "until clear_all_feats().",
+                 offset);
         return ESP_FAIL;
     }
-    fclose(f);
+    if (torn) {
+        // Drop the record a power loss left half written, later appends must follow a valid record.
+        ESP_LOGW(TAG, "Dropped a corrupted record at the end of db.");
+        return compact();
+    }
     return ESP_OK;
 }
 
-esp_err_t DataBase::enroll_feat(TensorBase *feat)
+esp_err_t DataBase::convert_legacy_database(int feat_len)
 {
-    if (feat->dtype != DATA_TYPE_FLOAT) {
-        ESP_LOGE(TAG, "Only support float feature.");
+    // The previous format is the database_meta followed by [uint16_t id, float feature] records, deleted ones have
+    // id 0. The id of a record is its position + 1.
+    FILE *src = fopen(m_db_path, "rb");
+    if (!src) {
+        ESP_LOGE(TAG, "Failed to open db.");
         return ESP_FAIL;
     }
-    if (feat->size != m_meta.feat_len) {
-        ESP_LOGE(TAG, "Feature len to enroll does not match feature len in db.");
+    database_meta meta;
+    if (fread(&meta, sizeof(database_meta), 1, src) != 1 || meta.feat_len != feat_len) {
+        ESP_LOGE(TAG, "Failed to read database meta.");
+        fclose(src);
         return ESP_FAIL;
     }
-    float *feat_copy = (float *)heap_caps_malloc(m_meta.feat_len * sizeof(float), MALLOC_CAP_SPIRAM);
-    memcpy(feat_copy, feat->data, feat->get_bytes());
-
-    m_feats.emplace_back(m_meta.num_feats_total + 1, feat_copy);
-    m_meta.num_feats_total++;
-    m_meta.num_feats_valid++;
-
-    size_t size = 0;
-    FILE *f = fopen(m_db_path, "rb+");
-    if (!f) {
-        ESP_LOGE(TAG, "Failed to open db.");
+    FILE *dst = fopen(m_tmp_path.c_str(), "wb");
+    if (!dst) {
+        ESP_LOGE(TAG, "Failed to open tmp db.");
+        fclose(src);
         return ESP_FAIL;
     }
-    size = fwrite(&m_meta, sizeof(database_meta), 1, f);
-    if (size != 1) {
-        ESP_LOGE(TAG, "Failed to write database meta.");
-        fclose(f);
-        return ESP_FAIL;
+    esp_err_t ret = write_header(dst, feat_len, meta.num_feats_total);
+    std::vector<float> feat(feat_len);
+    uint16_t id;
+    for (int i = 0; i < meta.num_feats_total && ret == ESP_OK; i++) {
+        if (fread(&id, sizeof(uint16_t), 1, src) != 1 ||
+            fread(feat.data(), sizeof(float), feat_len, src) != (size_t)feat_len) {
+            ESP_LOGE(TAG, "Failed to read feature.");
+            ret = ESP_FAIL;
+        } else if (id != 0) {
+            ret = write_record(dst, DATABASE_RECORD_ENROLL, id, feat.data(), feat_len);
+        }
     }
-    if (fseek(f, 0, SEEK_END) != 0) {
-        ESP_LOGE(TAG, "Failed to seek db file.");
-        fclose(f);
-        return ESP_FAIL;
+    fclose(src);
+    if (ret == ESP_OK) {
+        ret = sync_file(dst);
     }
-    size = fwrite(&m_feats.back().id, sizeof(uint16_t), 1, f);
-    if (size != 1) {
-        ESP_LOGE(TAG, "Failed to write feature id.");
-        fclose(f);
-        return ESP_FAIL;
+    fclose(dst);
+    if (ret != ESP_OK) {
+        remove(m_tmp_path.c_str());
+        return ret;
     }
-    size = fwrite(m_feats.back().feat, sizeof(float), m_meta.feat_len, f);
-    if (size != m_meta.feat_len) {
-        ESP_LOGE(TAG, "Failed to write feature.");
-        fclose(f);
+    remove(m_db_path);
+    if (rename(m_tmp_path.c_str(), m_db_path) != 0) {
+        ESP_LOGE(TAG, "Failed to rename tmp db.");
         return ESP_FAIL;
     }
-    fclose(f);
     return ESP_OK;
 }
 
-esp_err_t DataBase::delete_feat(uint16_t id)
+esp_err_t DataBase::enroll_feat(TensorBase *feat)
 {
-    bool invalid_id = true;
-    for (auto it = m_feats.begin(); it != m_feats.end();) {
-        if (it->id != id) {
-            it++;
-        } else {
-            heap_caps_free(it->feat);
-            it = m_feats.erase(it);
-            m_meta.num_feats_valid--;
-            invalid_id = false;
-            break;
-        }
+    if (feat->size != m_meta.feat_len) {
+        ESP_LOGE(TAG, "Feature len to enroll does not match feature len in db.");
+        return ESP_FAIL;
     }
-    if (invalid_id) {
-        ESP_LOGW(TAG, "Invalid id to delete.");
+    return enroll_feats(feat);
+}
+
+esp_err_t DataBase::enroll_feats(TensorBase *feats)
+{
+    if (feats->dtype != DATA_TYPE_FLOAT) {
+        ESP_LOGE(TAG, "Only support float feature.");
         return ESP_FAIL;
     }
-    size_t size = 0;
-    FILE *f = fopen(m_db_path, "rb+");
-    if (!f) {
-        ESP_LOGE(TAG, "Failed to open db.");
+    if (feats->size == 0 || feats->size % m_meta.feat_len != 0) {
+        ESP_LOGE(TAG, "Feature len to enroll does not match feature len in db.");
         return ESP_FAIL;
     }
-    long int offset = sizeof(database_meta) + (sizeof(uint16_t) + sizeof(float) * m_meta.feat_len) * (id - 1);
-    uint16_t id_invalid = 0;
-    if (fseek(f, offset, SEEK_SET) != 0) {
-        ESP_LOGE(TAG, "Failed to seek db file.");
-        fclose(f);
+    if (m_corrupted) {
+        ESP_LOGE(TAG, "Db file is corrupted, clear_all_feats() starts a new one.");
         return ESP_FAIL;
     }
-    size = fwrite(&id_invalid, sizeof(uint16_t), 1, f);
-    if (size != 1) {
-        ESP_LOGE(TAG, "Failed to write feature id.");
-        fclose(f);
+    int num = feats->size / m_meta.feat_len;
+    if (m_meta.num_feats_total + num > UINT16_MAX) {
+        ESP_LOGE(TAG, "No id left to enroll.");
         return ESP_FAIL;
     }
+    if (m_db_path) {
+        ESP_RETURN_ON_ERROR(open_database_file(), TAG, "Failed to open db.");
+    }
+    // Grow by half at least, many small batches must not copy the whole matrix every time.
+    int needed = m_feat_id.size() + num;
+    if (needed > m_capacity) {
+        ESP_RETURN_ON_ERROR(reserve_feats_in_memory(DL_MAX(needed, m_capacity + m_capacity / 2)),
+                            TAG,
+                            "Failed to enroll features.");
+    }
+    const float *feat = (const float *)feats->data;
+    for (int i = 0; i < num; i++, feat += m_meta.feat_len) {
+        uint16_t id = m_meta.num_feats_total + 1;
+        ESP_RETURN_ON_ERROR(add_feat_in_memory(id, feat), TAG, "Failed to enroll feature in memory.");
+        m_meta.num_feats_total++;
+        if (m_db_file) {
+            ESP_RETURN_ON_ERROR(write_record(m_db_file, DATABASE_RECORD_ENROLL, id, feat, m_meta.feat_len),
+                                TAG,
+                                "Failed to write feature.");
+        }
+    }
+    // One sync for the whole batch, a torn tail is dropped by the next load.
+    if (m_db_file) {
+        ESP_RETURN_ON_ERROR(sync_file(m_db_file), TAG, "Failed to sync db.");
+    }
 
-    offset = sizeof(uint16_t);
-    if (fseek(f, offset, SEEK_SET) != 0) {
-        ESP_LOGE(TAG, "Failed to seek db file.");
-        fclose(f);
+    if (m_index) {
+        if (m_index->is_trained()) {
+            std::vector<int> lists(num);
+            feat = (const float *)feats->data;
+            for (int i = 0; i < num; i++, feat += m_meta.feat_len) {
+                lists[i] = m_index->add(feat);
+            }
+            if (m_db_path) {
+                ESP_RETURN_ON_ERROR(
+                    m_index->append(m_index_path.c_str(), lists), TAG, "Failed to add features to index.");
+            }
+        }
+        if (m_index->need_train(m_feat_id.size())) {
+            ESP_RETURN_ON_ERROR(train_index(), TAG, "Failed to train index.");
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t DataBase::delete_feat(uint16_t id)
+{
+    if (m_corrupted) {
+        ESP_LOGE(TAG, "Db file is corrupted, clear_all_feats() starts a new one.");
         return ESP_FAIL;
     }
-    size = fwrite(&m_meta.num_feats_valid, sizeof(uint16_t), 1, f);
-    if (size != 1) {
-        ESP_LOGE(TAG, "Failed to write valid feature num.");
-        fclose(f);
+    int index = find_feat(id);
+    if (index < 0) {
+        ESP_LOGW(TAG, "Invalid id to delete.");
         return ESP_FAIL;
     }
-    fclose(f);
+    delete_feat_in_memory(index);
+    if (!m_db_path) {
+        return ESP_OK;
+    }
+    ESP_RETURN_ON_ERROR(open_database_file(), TAG, "Failed to open db.");
+    ESP_RETURN_ON_ERROR(
+        write_record(m_db_file, DATABASE_RECORD_DELETE, id, nullptr, m_meta.feat_len), TAG, "Failed to delete.");
+    ESP_RETURN_ON_ERROR(sync_file(m_db_file), TAG, "Failed to sync db.");
+    // The enroll record and the delete record are dead now.
+    m_num_dead_records += 2;
+    if (m_num_dead_records >= DL_MAX(s_min_dead_records_to_compact, (int)m_meta.num_feats_valid)) {
+        ESP_RETURN_ON_ERROR(compact(), TAG, "Failed to compact db.");
+    }
     return ESP_OK;
 }
 
 esp_err_t DataBase::delete_last_feat()
 {
-    if (m_feats.empty()) {
+    if (m_feat_id.empty()) {
         ESP_LOGW(TAG, "Empty db, nothing to delete");
         return ESP_FAIL;
     }
-    uint16_t id = m_feats.back().id;
+    uint16_t id = m_feat_id.back();
     return delete_feat(id);
 }
 
-float DataBase::cal_similarity(float *feat1, float *feat2)
+/**
+ * @brief Dot products of the query with rows of the feature matrix, all rows or the ones in index. Four rows share
+ *        every load of the query, quantized rows are accumulated in integer and scaled once per row.
+ */
+template <typename T, typename AccT>
+static void dot_rows(const T *matrix,
+                     const T *query,
+                     const int *index,
+                     int rows,
+                     int len,
+                     const float *row_scale,
+                     float query_scale,
+                     float *sim)
+{
+    int i = 0;
+    for (; i + 4 <= rows; i += 4) {
+        const T *row0 = matrix + (size_t)(index ? index[i] : i) * len;
+        const T *row1 = matrix + (size_t)(index ? index[i + 1] : i + 1) * len;
+        const T *row2 = matrix + (size_t)(index ? index[i + 2] : i + 2) * len;
+        const T *row3 = matrix + (size_t)(index ? index[i + 3] : i + 3) * len;
+        AccT acc0 = 0, acc1 = 0, acc2 = 0, acc3 = 0;
+        for (int j = 0; j < len; j++) {
+            AccT q = query[j];
+            acc0 += (AccT)row0[j] * q;
+            acc1 += (AccT)row1[j] * q;
+            acc2 += (AccT)row2[j] * q;
+            acc3 += (AccT)row3[j] * q;
+        }
+        sim[i] = acc0;
+        sim[i + 1] = acc1;
+        sim[i + 2] = acc2;
+        sim[i + 3] = acc3;
+    }
+    for (; i < rows; i++) {
+        const T *row = matrix + (size_t)(index ? index[i] : i) * len;
+        AccT acc = 0;
+        for (int j = 0; j < len; j++) {
+            acc += (AccT)row[j] * query[j];
+        }
+        sim[i] = acc;
+    }
+    if (row_scale) {
+        for (i = 0; i < rows; i++) {
+            sim[i] *= row_scale[index ? index[i] : i] * query_scale;
+        }
+    }
+}
+
+void DataBase::cal_similarity(const float *feat, const int *rows, int num_rows)
 {
-    float sum = 0;
-    for (int i = 0; i < m_meta.feat_len; i++) {
-        sum += feat1[i] * feat2[i];
+    int len = m_meta.feat_len;
+    m_sim.resize(num_rows);
+    if (m_feat_dtype == DATA_TYPE_FLOAT) {
+        dot_rows<float, float>((const float *)m_feat_matrix, feat, rows, num_rows, len, nullptr, 1.f, m_sim.data());
+        return;
+    }
+    m_query.resize(m_feat_bytes);
+    float query_scale = quantize_feat(feat, m_query.data());
+    if (m_feat_dtype == DATA_TYPE_INT8) {
+        dot_rows<int8_t, int32_t>((const int8_t *)m_feat_matrix,
+                                  (const int8_t *)m_query.data(),
+                                  rows,
+                                  num_rows,
+                                  len,
+                                  m_feat_scale.data(),
+                                  query_scale,
+                                  m_sim.data());
+    } else {
+        dot_rows<int16_t, int64_t>((const int16_t *)m_feat_matrix,
+                                   (const int16_t *)m_query.data(),
+                                   rows,
+                                   num_rows,
+                                   len,
+                                   m_feat_scale.data(),
+                                   query_scale,
+                                   m_sim.data());
     }
-    return sum;
 }
 
 std::vector<result_t> DataBase::query_feat(TensorBase *feat, float thr, int top_k)
@@ -251,23 +704,41 @@ std::vector<result_t> DataBase::query_feat(TensorBase *feat, float thr, int top_
         ESP_LOGW(TAG, "Top_k should be greater than 0.");
         return {};
     }
+    if (feat->dtype != DATA_TYPE_FLOAT || feat->size != m_meta.feat_len) {
+        ESP_LOGE(TAG, "Query feature should be float with the same len as the features in db.");
+        return {};
+    }
+    const int *rows = nullptr;
+    int num_rows = m_feat_id.size();
+    if (m_index && m_index->is_trained() && m_index->get_nprobe() < m_index->get_nlist()) {
+        const std::vector<int> &candidates = m_index->search((const float *)feat->data);
+        rows = candidates.data();
+        num_rows = candidates.size();
+    }
+    cal_similarity((const float *)feat->data, rows, num_rows);
+
+    // Bounded heap keeps the top_k results, its front is the worst kept one.
+    auto better = [](const result_t &a, const result_t &b) -> bool {
+        return a.similarity > b.similarity || (a.similarity == b.similarity && a.id < b.id);
+    };
     std::vector<result_t> results;
-    float sim;
-    int i = 1;
-    for (auto it = m_feats.begin(); it != m_feats.end(); it++, i++) {
-        sim = cal_similarity(it->feat, (float *)feat->data);
+    results.reserve(DL_MIN(top_k, (int)m_sim.size()));
+    for (int i = 0; i < (int)m_sim.size(); i++) {
+        float sim = m_sim[i];
         if (sim <= thr) {
             continue;
         }
-        // results.emplace_back(it->id, sim);
-        results.emplace_back(i, sim);
-    }
-    std::sort(results.begin(), results.end(), [](const result_t &a, const result_t &b) -> bool {
-        return a.similarity > b.similarity;
-    });
-    if (results.size() > top_k) {
-        results.resize(top_k);
+        result_t result = {(uint16_t)((rows ? rows[i] : i) + 1), sim};
+        if ((int)results.size() < top_k) {
+            results.push_back(result);
+            std::push_heap(results.begin(), results.end(), better);
+        } else if (better(result, results.front())) {
+            std::pop_heap(results.begin(), results.end(), better);
+            results.back() = result;
+            std::push_heap(results.begin(), results.end(), better);
+        }
     }
+    std::sort_heap(results.begin(), results.end(), better);
     return results;
 }
 
@@ -279,10 +750,12 @@ void DataBase::print()
            m_meta.num_feats_valid,
            m_meta.feat_len);
     printf("[feats]\n");
-    for (auto it : m_feats) {
-        printf("id: %d feat: ", it.id);
-        for (int i = 0; i < m_meta.feat_len; i++) {
-            printf("%f, ", it.feat[i]);
+    std::vector<float> feat(m_meta.feat_len);
+    for (int i = 0; i < (int)m_feat_id.size(); i++) {
+        dequantize_feat(i, feat.data());
+        printf("id: %d feat: ", m_feat_id[i]);
+        for (int j = 0; j < m_meta.feat_len; j++) {
+            printf("%f, ", feat[j]);
         }
         printf("\n");
     }
@@ -1,34 +1,112 @@
 #pragma once
 #include "dl_recognition_define.hpp"
+#include "dl_recognition_ivf.hpp"
 #include "dl_tensor_base.hpp"
 #include "esp_check.h"
 #include "esp_system.h"
 #include <algorithm>
-#include <list>
+#include <string>
+#include <vector>
 
 namespace dl {
 namespace recognition {
+/**
+ * @brief Feature database kept in memory as one contiguous matrix and persisted in an append-only file.
+ *
+ * The file is a versioned header followed by enroll and delete records, each with a crc32. Enrolling and deleting
+ * only append records, a record torn by power loss at the end of the file is dropped on the next load. A corrupted
+ * record before the end stops the load, the file is then kept as it is and the database refuses to write it until
+ * clear_all_feats(). Dead records are removed by compact(), which runs automatically once they outnumber the valid
+ * features, and writes a new file before replacing the old one. Files of the previous format are converted on load.
+ * Without a path the features are only kept in memory.
+ */
 class DataBase {
 public:
-    DataBase(const char *db_path, int feat_len);
+    /**
+     * @brief Construct a new DataBase object.
+     *
+     * @param db_path     path of the database file, nullptr keeps the features only in memory
+     * @param feat_len    length of the features
+     * @param feat_dtype  type of the features kept in memory. DATA_TYPE_INT8 and DATA_TYPE_INT16 quantize each feature
+     *                    with its own scale, which cuts memory and speeds up query_feat() for large databases. The
+     *                    database file always stores float features.
+     */
+    DataBase(const char *db_path, int feat_len, dtype_t feat_dtype = DATA_TYPE_FLOAT);
     virtual ~DataBase();
     esp_err_t clear_all_feats();
     esp_err_t enroll_feat(TensorBase *feat);
+
+    /**
+     * @brief Enroll several features with one write to storage.
+     *
+     * @param feats float features of shape [num, feat_len], their ids are consecutive
+     * @return esp_err_t
+     */
+    esp_err_t enroll_feats(TensorBase *feats);
     esp_err_t delete_feat(uint16_t id);
     esp_err_t delete_last_feat();
     std::vector<result_t> query_feat(TensorBase *feat, float thr, int top_k);
     void print();
     int get_num_feats() { return m_meta.num_feats_valid; }
 
+    /**
+     * @brief Rewrite the database file with only the valid features.
+     *
+     * @return esp_err_t
+     */
+    esp_err_t compact();
+
+    /**
+     * @brief Enable the IVF index. It is kept in db_path + ".ivf", loaded if it matches the database and trained
+     *        otherwise. An index of a database without a path is only kept in memory. Until nlist * 8 features are
+     *        enrolled, query_feat() still scores every feature. Training runs inside enroll_feat() and takes a while
+     *        for big databases.
+     *
+     * @param nlist   number of lists, about sqrt(number of features) is a good start
+     * @param nprobe  number of lists scored by a query
+     * @return esp_err_t
+     */
+    esp_err_t enable_index(int nlist, int nprobe = 8);
+
+    /**
+     * @brief Change the number of lists scored by a query, more lists give higher recall and slower query.
+     *
+     * @param nprobe number of lists scored by a query
+     */
+    void set_index_nprobe(int nprobe);
+
 private:
     char *m_db_path;
-    std::list<database_feat> m_feats;
     database_meta m_meta;
+    FILE *m_db_file;                 /*!< database file opened for appending records */
+    std::string m_tmp_path;          /*!< path of the file compact() writes */
+    int m_num_dead_records;          /*!< records in the database file that compact() would drop */
+    bool m_corrupted;                /*!< a record before the end of the database file is corrupted */
+    dtype_t m_feat_dtype;            /*!< type of the features in m_feat_matrix */
+    int m_feat_bytes;                /*!< bytes of one feature in m_feat_matrix */
+    int m_capacity;                  /*!< number of features m_feat_matrix can hold */
+    void *m_feat_matrix;             /*!< num_feats_valid x feat_len features, contiguous */
+    std::vector<float> m_feat_scale; /*!< scale of each quantized feature */
+    std::vector<uint16_t> m_feat_id; /*!< id of each feature */
+    std::vector<float> m_sim;        /*!< similarity of each feature to the query */
+    std::vector<uint8_t> m_query;    /*!< query feature converted to m_feat_dtype */
+    IVFIndex *m_index;               /*!< optional IVF index, nullptr if disabled */
+    std::string m_index_path;        /*!< path of the index file */
 
     esp_err_t create_empty_database_in_storage(int feat_len);
     esp_err_t load_database_from_storage(int feat_len);
+    esp_err_t convert_legacy_database(int feat_len);
+    esp_err_t open_database_file();
+    void close_database_file();
     void clear_all_feats_in_memory();
-    float cal_similarity(float *feat1, float *feat2);
+    esp_err_t reserve_feats_in_memory(int num);
+    int find_feat(uint16_t id);
+    esp_err_t add_feat_in_memory(uint16_t id, const float *feat);
+    void delete_feat_in_memory(int index);
+    float quantize_feat(const float *feat, void *dst);
+    void dequantize_feat(int index, float *dst);
+    esp_err_t train_index();
+    void cal_similarity(const float *feat, const int *rows, int num_rows);
 };
 } // namespace recognition
 } // namespace dl
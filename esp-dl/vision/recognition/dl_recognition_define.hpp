@@ -3,6 +3,26 @@
 
 namespace dl {
 namespace recognition {
+typedef enum {
+    DATABASE_RECORD_ENROLL = 1, /*!< record followed by feat_len float feature */
+    DATABASE_RECORD_DELETE = 2, /*!< record deleting the feature with its id */
+} database_record_type_t;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t feat_len;
+    uint16_t num_feats_total; /*!< ids up to it are taken, records after the header may take more */
+    uint16_t reserved;
+    uint32_t crc; /*!< crc32 of the fields above */
+} database_header;
+
+typedef struct {
+    uint16_t type;
+    uint16_t id;
+    uint32_t crc; /*!< crc32 of type, id and the feature */
+} database_record;
+
 typedef struct {
     uint16_t num_feats_total;
     uint16_t num_feats_valid;
@@ -19,5 +39,11 @@ typedef struct {
     float similarity;
 } result_t;
 
+typedef struct {
+    uint16_t nlist;
+    uint16_t feat_len;
+    uint16_t num_trained;
+} ivf_meta;
+
 } // namespace recognition
 } // namespace dl
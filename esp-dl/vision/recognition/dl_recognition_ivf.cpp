@@ -0,0 +1,246 @@
+#include "dl_recognition_ivf.hpp"
+#include "dl_define.hpp"
+#include "esp_log.h"
+#include <algorithm>
+#include <math.h>
+#include <numeric>
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "dl::recognition::IVFIndex";
+
+namespace dl {
+namespace recognition {
+static const int s_kmeans_iters = 10;
+static const int s_max_train_rows_per_list = 32;
+
+static void normalize(float *feat, int len)
+{
+    float sum = 0;
+    for (int i = 0; i < len; i++) {
+        sum += feat[i] * feat[i];
+    }
+    if (sum > 0) {
+        float inv_norm = 1.f / sqrtf(sum);
+        for (int i = 0; i < len; i++) {
+            feat[i] *= inv_norm;
+        }
+    }
+}
+
+IVFIndex::IVFIndex(int feat_len, int nlist, int nprobe) :
+    m_feat_len(feat_len), m_nlist(DL_MAX(nlist, 1)), m_num_trained(0)
+{
+    set_nprobe(nprobe);
+}
+
+void IVFIndex::set_nprobe(int nprobe)
+{
+    m_nprobe = DL_CLIP(nprobe, 1, m_nlist);
+}
+
+bool IVFIndex::need_train(int num_rows)
+{
+    if (!is_trained()) {
+        return num_rows >= get_min_train_rows();
+    }
+    return m_num_trained < m_nlist * s_max_train_rows_per_list && num_rows >= m_num_trained * 4;
+}
+
+void IVFIndex::cal_centroid_sim(const float *feat)
+{
+    m_centroid_sim.resize(m_nlist);
+    const float *centroid = m_centroids.data();
+    for (int i = 0; i < m_nlist; i++, centroid += m_feat_len) {
+        float sum = 0;
+        for (int j = 0; j < m_feat_len; j++) {
+            sum += centroid[j] * feat[j];
+        }
+        m_centroid_sim[i] = sum;
+    }
+}
+
+int IVFIndex::nearest_list(const float *feat)
+{
+    cal_centroid_sim(feat);
+    return std::max_element(m_centroid_sim.begin(), m_centroid_sim.end()) - m_centroid_sim.begin();
+}
+
+void IVFIndex::train(const std::function<void(int row, float *dst)> &get_row, int num_rows)
+{
+    clear();
+    if (num_rows < m_nlist) {
+        ESP_LOGW(TAG, "Too few features to train the index.");
+        return;
+    }
+    // Spherical k-means on an evenly spaced sample of the rows.
+    int num_samples = DL_MIN(num_rows, m_nlist * s_max_train_rows_per_list);
+    std::vector<float> feat(m_feat_len);
+    std::vector<float> sums(m_nlist * m_feat_len);
+    std::vector<int> counts(m_nlist);
+    m_centroids.resize(m_nlist * m_feat_len);
+    for (int i = 0; i < m_nlist; i++) {
+        float *centroid = m_centroids.data() + i * m_feat_len;
+        get_row((int)((int64_t)i * num_rows / m_nlist), centroid);
+        normalize(centroid, m_feat_len);
+    }
+    for (int iter = 0; iter < s_kmeans_iters; iter++) {
+        std::fill(sums.begin(), sums.end(), 0.f);
+        std::fill(counts.begin(), counts.end(), 0);
+        for (int i = 0; i < num_samples; i++) {
+            get_row((int)((int64_t)i * num_rows / num_samples), feat.data());
+            int list = nearest_list(feat.data());
+            float *sum = sums.data() + list * m_feat_len;
+            for (int j = 0; j < m_feat_len; j++) {
+                sum[j] += feat[j];
+            }
+            counts[list]++;
+        }
+        for (int i = 0; i < m_nlist; i++) {
+            // An empty list keeps its centroid.
+            if (counts[i] > 0) {
+                float *centroid = m_centroids.data() + i * m_feat_len;
+                memcpy(centroid, sums.data() + i * m_feat_len, m_feat_len * sizeof(float));
+                normalize(centroid, m_feat_len);
+            }
+        }
+    }
+
+    m_lists.resize(m_nlist);
+    m_row_list.reserve(num_rows);
+    for (int i = 0; i < num_rows; i++) {
+        get_row(i, feat.data());
+        add(feat.data());
+    }
+    m_num_trained = num_rows;
+}
+
+void IVFIndex::clear()
+{
+    m_num_trained = 0;
+    m_centroids.clear();
+    m_lists.clear();
+    m_row_list.clear();
+}
+
+int IVFIndex::add(const float *feat)
+{
+    int list = nearest_list(feat);
+    m_lists[list].push_back(m_row_list.size());
+    m_row_list.push_back(list);
+    return list;
+}
+
+void IVFIndex::remove(int row)
+{
+    std::vector<int> &rows = m_lists[m_row_list[row]];
+    rows.erase(std::lower_bound(rows.begin(), rows.end(), row));
+    m_row_list.erase(m_row_list.begin() + row);
+    for (auto &list : m_lists) {
+        for (auto it = std::upper_bound(list.begin(), list.end(), row); it != list.end(); it++) {
+            (*it)--;
+        }
+    }
+}
+
+const std::vector<int> &IVFIndex::search(const float *feat)
+{
+    cal_centroid_sim(feat);
+    m_probe.resize(m_nlist);
+    std::iota(m_probe.begin(), m_probe.end(), 0);
+    std::partial_sort(m_probe.begin(), m_probe.begin() + m_nprobe, m_probe.end(), [this](int a, int b) -> bool {
+        return m_centroid_sim[a] > m_centroid_sim[b] || (m_centroid_sim[a] == m_centroid_sim[b] && a < b);
+    });
+    m_candidates.clear();
+    for (int i = 0; i < m_nprobe; i++) {
+        const std::vector<int> &rows = m_lists[m_probe[i]];
+        m_candidates.insert(m_candidates.end(), rows.begin(), rows.end());
+    }
+    // Score the rows in memory order.
+    std::sort(m_candidates.begin(), m_candidates.end());
+    return m_candidates;
+}
+
+esp_err_t IVFIndex::save(const char *path, const std::vector<uint16_t> &ids, int num_records)
+{
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        ESP_LOGE(TAG, "Failed to open index file.");
+        return ESP_FAIL;
+    }
+    ivf_meta meta = {(uint16_t)m_nlist, (uint16_t)m_feat_len, (uint16_t)m_num_trained};
+    std::vector<uint16_t> record_list(num_records, UINT16_MAX);
+    for (int i = 0; i < (int)ids.size(); i++) {
+        record_list[ids[i] - 1] = m_row_list[i];
+    }
+    if (fwrite(&meta, sizeof(ivf_meta), 1, f) != 1 ||
+        fwrite(m_centroids.data(), sizeof(float), m_centroids.size(), f) != m_centroids.size() ||
+        fwrite(record_list.data(), sizeof(uint16_t), num_records, f) != (size_t)num_records) {
+        ESP_LOGE(TAG, "Failed to write index file.");
+        fclose(f);
+        return ESP_FAIL;
+    }
+    fclose(f);
+    return ESP_OK;
+}
+
+esp_err_t IVFIndex::append(const char *path, const std::vector<int> &lists)
+{
+    FILE *f = fopen(path, "ab");
+    if (!f) {
+        ESP_LOGE(TAG, "Failed to open index file.");
+        return ESP_FAIL;
+    }
+    std::vector<uint16_t> record_list(lists.begin(), lists.end());
+    if (fwrite(record_list.data(), sizeof(uint16_t), record_list.size(), f) != record_list.size()) {
+        ESP_LOGE(TAG, "Failed to write index file.");
+        fclose(f);
+        return ESP_FAIL;
+    }
+    fclose(f);
+    return ESP_OK;
+}
+
+esp_err_t IVFIndex::load(const char *path, const std::vector<uint16_t> &ids, int num_records)
+{
+    clear();
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return ESP_FAIL;
+    }
+    ivf_meta meta;
+    if (fread(&meta, sizeof(ivf_meta), 1, f) != 1 || meta.nlist != m_nlist || meta.feat_len != m_feat_len ||
+        meta.num_trained == 0) {
+        ESP_LOGW(TAG, "Index file does not match the index.");
+        fclose(f);
+        return ESP_FAIL;
+    }
+    m_centroids.resize(m_nlist * m_feat_len);
+    std::vector<uint16_t> record_list(num_records + 1);
+    // The file must hold exactly one list per record.
+    if (fread(m_centroids.data(), sizeof(float), m_centroids.size(), f) != m_centroids.size() ||
+        fread(record_list.data(), sizeof(uint16_t), num_records + 1, f) != (size_t)num_records) {
+        ESP_LOGW(TAG, "Index file does not match the database.");
+        fclose(f);
+        clear();
+        return ESP_FAIL;
+    }
+    fclose(f);
+
+    m_lists.resize(m_nlist);
+    m_row_list.reserve(ids.size());
+    for (int i = 0; i < (int)ids.size(); i++) {
+        int list = record_list[ids[i] - 1];
+        if (list >= m_nlist) {
+            ESP_LOGW(TAG, "Index file does not match the database.");
+            clear();
+            return ESP_FAIL;
+        }
+        m_lists[list].push_back(i);
+        m_row_list.push_back(list);
+    }
+    m_num_trained = meta.num_trained;
+    return ESP_OK;
+}
+} // namespace recognition
+} // namespace dl
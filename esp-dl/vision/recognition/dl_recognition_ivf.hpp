@@ -0,0 +1,133 @@
+#pragma once
+#include "dl_recognition_define.hpp"
+#include "esp_err.h"
+#include <functional>
+#include <vector>
+
+namespace dl {
+namespace recognition {
+/**
+ * @brief Inverted file index over the rows of the DataBase feature matrix.
+ *
+ * Features are clustered by spherical k-means into nlist lists. A query only scores the rows of the nprobe lists whose
+ * centroids are closest to it, nprobe trades recall for speed. The index is trained once enough features are enrolled,
+ * later features are added to their closest list without moving the centroids.
+ */
+class IVFIndex {
+private:
+    int m_feat_len;                        /*!< length of the features */
+    int m_nlist;                           /*!< number of lists */
+    int m_nprobe;                          /*!< number of lists scored by a query */
+    int m_num_trained;                     /*!< number of rows the centroids were trained with, 0 if not trained */
+    std::vector<float> m_centroids;        /*!< nlist x feat_len normalized centroids */
+    std::vector<std::vector<int>> m_lists; /*!< rows of each list in ascending order */
+    std::vector<uint16_t> m_row_list;      /*!< list of each row */
+    std::vector<float> m_centroid_sim;     /*!< similarity of the query to each centroid */
+    std::vector<int> m_probe;              /*!< lists scored by the query */
+    std::vector<int> m_candidates;         /*!< rows scored by the query */
+
+    void cal_centroid_sim(const float *feat);
+    int nearest_list(const float *feat);
+
+public:
+    /**
+     * @brief Construct a new IVFIndex object.
+     *
+     * @param feat_len  length of the features
+     * @param nlist     number of lists, about sqrt(number of features) is a good start
+     * @param nprobe    number of lists scored by a query
+     */
+    IVFIndex(int feat_len, int nlist, int nprobe);
+
+    /**
+     * @brief Change the number of lists scored by a query.
+     *
+     * @param nprobe number of lists scored by a query, nlist gives the same results as brute force.
+     */
+    void set_nprobe(int nprobe);
+
+    int get_nlist() { return m_nlist; }
+    int get_nprobe() { return m_nprobe; }
+    int get_num_trained() { return m_num_trained; }
+    bool is_trained() { return m_num_trained > 0; }
+
+    /**
+     * @brief Number of rows needed to train the centroids.
+     */
+    int get_min_train_rows() { return m_nlist * 8; }
+
+    /**
+     * @brief Whether the centroids should be trained again. The centroids are trained again when the number of rows
+     *        reaches four times the number of rows they were trained with, until the training sample is full.
+     *
+     * @param num_rows number of rows in the database
+     */
+    bool need_train(int num_rows);
+
+    /**
+     * @brief Train the centroids with a sample of the rows and assign every row to a list.
+     *
+     * @param get_row   writes the float feature of a row to dst
+     * @param num_rows  number of rows in the database
+     */
+    void train(const std::function<void(int row, float *dst)> &get_row, int num_rows);
+
+    /**
+     * @brief Reset to the untrained state.
+     */
+    void clear();
+
+    /**
+     * @brief Add a row after the last row.
+     *
+     * @param feat feature of the row
+     * @return list of the row
+     */
+    int add(const float *feat);
+
+    /**
+     * @brief Remove a row, the rows after it move up by one.
+     *
+     * @param row row to remove
+     */
+    void remove(int row);
+
+    /**
+     * @brief Find the rows the query should be scored against.
+     *
+     * @param feat feature of the query
+     * @return rows of the nprobe closest lists in ascending order
+     */
+    const std::vector<int> &search(const float *feat);
+
+    /**
+     * @brief Write the centroids and the list of every record to the index file.
+     *
+     * @param path         path of the index file
+     * @param ids          id of each row, the record of a row is its id - 1
+     * @param num_records  number of records in the database file, deleted ones included
+     * @return esp_err_t
+     */
+    esp_err_t save(const char *path, const std::vector<uint16_t> &ids, int num_records);
+
+    /**
+     * @brief Append the lists of new records to the index file with one write.
+     *
+     * @param path   path of the index file
+     * @param lists  list of each record
+     * @return esp_err_t
+     */
+    esp_err_t append(const char *path, const std::vector<int> &lists);
+
+    /**
+     * @brief Load the centroids and the lists from the index file.
+     *
+     * @param path         path of the index file
+     * @param ids          id of each row, the record of a row is its id - 1
+     * @param num_records  number of records in the database file, deleted ones included
+     * @return ESP_FAIL if the index file is missing or does not match the database.
+     */
+    esp_err_t load(const char *path, const std::vector<uint16_t> &ids, int num_records);
+};
+} // namespace recognition
+} // namespace dl
@@ -0,0 +1,178 @@
+#include "bsp/esp-bsp.h"
+#include "coco_pose.hpp"
+#include "dl_image_sequence.hpp"
+#include "dl_tool_bench.hpp"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "human_face_detect.hpp"
+#include "human_face_recognition.hpp"
+#include "imagenet_cls.hpp"
+#include "pedestrian_detect.hpp"
+#include <atomic>
+#include <functional>
+
+extern const uint8_t human_face_jpg_start[] asm("_binary_human_face_jpg_start");
+extern const uint8_t human_face_jpg_end[] asm("_binary_human_face_jpg_end");
+const char *TAG = "pipeline_benchmark";
+
+static std::atomic<uint32_t> s_num_allocs(0);
+
+// Called by the heap component for every allocation, see CONFIG_HEAP_USE_HOOKS.
+extern "C" void esp_heap_trace_alloc_hook(void *ptr, size_t size, uint32_t caps)
+{
+    s_num_allocs.fetch_add(1, std::memory_order_relaxed);
+}
+
+extern "C" void esp_heap_trace_free_hook(void *ptr) {}
+
+static uint32_t get_num_allocs()
+{
+    return s_num_allocs.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief The frames to replay, from the image sequence or the embedded image if it has no frames.
+ */
+class Frames {
+public:
+    Frames(dl::image::ImageSequence *sequence) :
+        m_sequence(sequence), m_decoder(dl::image::DL_IMAGE_PIX_TYPE_RGB888), m_index(0)
+    {
+    }
+
+    int size() { return m_sequence->size() ? m_sequence->size() : 1; }
+
+    esp_err_t load()
+    {
+        int index = m_index++ % size();
+        return m_sequence->size() ? m_sequence->load(index) : ESP_OK;
+    }
+
+    esp_err_t decode(dl::image::img_t &img)
+    {
+        if (m_sequence->size()) {
+            return m_sequence->decode(img);
+        }
+        dl::image::jpeg_img_t jpeg_img = {.data = (void *)human_face_jpg_start,
+                                          .data_len = (size_t)(human_face_jpg_end - human_face_jpg_start)};
+        return m_decoder.decode(jpeg_img, img);
+    }
+
+private:
+    dl::image::ImageSequence *m_sequence;
+    dl::image::SwJpegDecoder m_decoder;
+    int m_index;
+};
+
+/**
+ * @brief Run the pipeline on the warm-up frames, then on the measured frames, and print the results.
+ *
+ * @param bench The benchmark of the pipeline.
+ * @param frames The frames to replay.
+ * @param pipeline Runs the models on a decoded frame, timing each of them as a stage of bench.
+ */
+static void run_benchmark(dl::tool::Benchmark &bench,
+                          Frames &frames,
+                          const std::function<void(const dl::image::img_t &)> &pipeline)
+{
+    dl::image::img_t img;
+    int num_warmup = CONFIG_BENCHMARK_NUM_WARMUP_FRAMES;
+    for (int i = 0; i < num_warmup + CONFIG_BENCHMARK_NUM_FRAMES; i++) {
+        if (i == num_warmup) {
+            bench.reset();
+        }
+        bench.start("load");
+        esp_err_t ret = frames.load();
+        bench.end();
+        if (ret != ESP_OK) {
+            continue;
+        }
+        bench.start("decode");
+        ret = frames.decode(img);
+        bench.end();
+        if (ret != ESP_OK) {
+            continue;
+        }
+        pipeline(img);
+        bench.end_frame();
+    }
+    bench.print_json();
+    bench.print();
+}
+
+extern "C" void app_main(void)
+{
+    if (bsp_sdcard_mount() != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to mount sdcard, benchmark with the embedded image.");
+    }
+    dl::image::ImageSequence *sequence = new dl::image::ImageSequence(CONFIG_BENCHMARK_IMAGE_PATH);
+    Frames frames(sequence);
+    ESP_LOGI(TAG, "Benchmark on %d frames.", frames.size());
+
+#if CONFIG_BENCHMARK_HUMAN_FACE
+    {
+        HumanFaceDetect *detect = new HumanFaceDetect();
+        HumanFaceFeat *feat = new HumanFaceFeat();
+        dl::tool::Benchmark bench("human_face", MALLOC_CAP_8BIT, get_num_allocs);
+        std::vector<std::vector<int>> landmarks;
+        run_benchmark(bench, frames, [&](const dl::image::img_t &img) {
+            bench.start("detect");
+            auto &detect_results = detect->run(img);
+            bench.end();
+            landmarks.clear();
+            for (const auto &res : detect_results) {
+                landmarks.emplace_back(res.keypoint);
+            }
+            if (!landmarks.empty()) {
+                bench.start("feat");
+                feat->run(img, landmarks);
+                bench.end();
+            }
+        });
+        delete detect;
+        delete feat;
+    }
+#endif
+
+#if CONFIG_BENCHMARK_PEDESTRIAN_DETECT
+    {
+        PedestrianDetect *detect = new PedestrianDetect();
+        dl::tool::Benchmark bench("pedestrian_detect", MALLOC_CAP_8BIT, get_num_allocs);
+        run_benchmark(bench, frames, [&](const dl::image::img_t &img) {
+            bench.start("detect");
+            detect->run(img);
+            bench.end();
+        });
+        delete detect;
+    }
+#endif
+
+#if CONFIG_BENCHMARK_COCO_POSE
+    {
+        COCOPose *pose = new COCOPose();
+        dl::tool::Benchmark bench("coco_pose", MALLOC_CAP_8BIT, get_num_allocs);
+        run_benchmark(bench, frames, [&](const dl::image::img_t &img) {
+            bench.start("pose");
+            pose->run(img);
+            bench.end();
+        });
+        delete pose;
+    }
+#endif
+
+#if CONFIG_BENCHMARK_IMAGENET_CLS
+    {
+        ImageNetCls *cls = new ImageNetCls();
+        dl::tool::Benchmark bench("imagenet_cls", MALLOC_CAP_8BIT, get_num_allocs);
+        run_benchmark(bench, frames, [&](const dl::image::img_t &img) {
+            bench.start("classify");
+            cls->run(img);
+            bench.end();
+        });
+        delete cls;
+    }
+#endif
+
+    delete sequence;
+    bsp_sdcard_unmount();
+}
@@ -35,6 +35,8 @@ extern "C" void app_main(void)
                                                       nullptr /*element*/,
                                                       p_model_0->get_inputs()->get_exponent(),
                                                       p_model_0->get_inputs()->get_dtype());
+    // A push writes the new frame twice into a ring buffer instead of moving the whole window.
+    input_tensor->enable_ring_buffer(1);
 
     // Because the first layer of model_0 in the example is conv, so the data layout follows NWC format.
     dl::TensorBase *one_step_input_tensor =
@@ -10,10 +10,10 @@ class StreamingModel {
 private:
     dl::Model *m_p_model = nullptr;
     dl::TensorBase *m_p_input = nullptr;
-    // The characteristic of initializing the buffer to zero will be utilized directly.
-    dl::TensorBase *m_p_input_cache = nullptr;
+    std::string m_input_name;
+    // The window bound to the model input, read by every run without a copy when possible.
+    mutable dl::TensorBase *m_p_window = nullptr;
     dl::TensorBase *m_p_output = nullptr;
-    dl::TensorBase *m_p_output_cache = nullptr;
 
 public:
     StreamingModel(std::string model_name,
@@ -25,12 +25,11 @@ public:
     {
         m_p_model = new dl::Model((const char *)model_espdl, model_name.c_str(), location);
         m_p_input = m_p_model->get_input(input_name);
-        if (!input_cache_name.empty()) {
-            m_p_input_cache = m_p_model->get_input(input_cache_name);
-        }
+        m_input_name = input_name;
         m_p_output = m_p_model->get_output(output_name);
-        if (!output_cache_name.empty()) {
-            m_p_output_cache = m_p_model->get_output(output_cache_name);
+        // The cache starts with zeros and is updated in place by every run.
+        if (!input_cache_name.empty() && !output_cache_name.empty()) {
+            m_p_model->bind_streaming_cache(input_cache_name, output_cache_name);
         }
     }
 
@@ -43,11 +42,11 @@ public:
             return nullptr;
         }
 
-        m_p_input->assign(input_p);
-        m_p_model->run();
-        if (m_p_input_cache && m_p_output_cache) {
-            m_p_input_cache->assign(m_p_output_cache);
+        if (input_p != m_p_window) {
+            m_p_model->bind_streaming_input(m_input_name, input_p);
+            m_p_window = input_p;
         }
+        m_p_model->run();
         return m_p_output;
     }
 
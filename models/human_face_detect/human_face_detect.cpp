@@ -85,7 +85,8 @@ std::list<dl::detect::result_t> &MNP::run(const dl::image::img_t &img, std::list
         candidate.limit_box(img.width, img.height);
 
         DL_LOG_INFER_LATENCY_ARRAY_START(0);
-        m_image_preprocessor->preprocess(img, candidate.box);
+        m_image_preprocessor->preprocess(
+            img, {candidate.box[0], candidate.box[1], candidate.box[2], candidate.box[3]});
         DL_LOG_INFER_LATENCY_ARRAY_END(0);
 
         DL_LOG_INFER_LATENCY_ARRAY_START(1);
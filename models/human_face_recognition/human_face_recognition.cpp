@@ -91,6 +91,28 @@ std::vector<dl::recognition::result_t> HumanFaceRecognizer::recognize(const dl::
     }
 }
 
+std::vector<std::vector<dl::recognition::result_t>> HumanFaceRecognizer::recognize_all(
+    const dl::image::img_t &img, std::list<dl::detect::result_t> &detect_res)
+{
+    if (detect_res.empty()) {
+        ESP_LOGW("HumanFaceRecognizer", "Failed to recognize. No face detected.");
+        return {};
+    }
+    std::vector<std::vector<int>> landmarks;
+    landmarks.reserve(detect_res.size());
+    for (const auto &res : detect_res) {
+        landmarks.emplace_back(res.keypoint);
+    }
+    dl::TensorBase *feats = m_feat.run(img, landmarks);
+    std::vector<std::vector<dl::recognition::result_t>> res(landmarks.size());
+    for (int i = 0; i < landmarks.size(); i++) {
+        float *feat_ptr = (float *)feats->data + i * m_feat.m_feat_len;
+        dl::TensorBase feat({m_feat.m_feat_len}, feat_ptr, 0, dl::DATA_TYPE_FLOAT, false);
+        res[i] = m_db.query_feat(&feat, m_thr, m_top_k);
+    }
+    return res;
+}
+
 esp_err_t HumanFaceRecognizer::enroll(const dl::image::img_t &img, std::list<dl::detect::result_t> &detect_res)
 {
     if (detect_res.empty()) {
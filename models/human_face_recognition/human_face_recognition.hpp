@@ -38,6 +38,15 @@ public:
 
     std::vector<dl::recognition::result_t> recognize(const dl::image::img_t &img,
                                                      std::list<dl::detect::result_t> &detect_res);
+    /**
+     * @brief Recognize every detected face, the features are extracted in one batch.
+     *
+     * @param img         input image
+     * @param detect_res  detected faces
+     * @return results of each face, in the order of detect_res
+     */
+    std::vector<std::vector<dl::recognition::result_t>> recognize_all(const dl::image::img_t &img,
+                                                                      std::list<dl::detect::result_t> &detect_res);
     esp_err_t enroll(const dl::image::img_t &img, std::list<dl::detect::result_t> &detect_res);
     esp_err_t clear_all_feats();
     esp_err_t delete_feat(uint16_t id);
@@ -0,0 +1,199 @@
+#include "dl_fbank.h"
+#include "test_fft.h"
+#include <math.h>
+
+static const char *TAG = "TEST DL FBANK";
+static int LOOP = 10;
+
+// chirp from 100 Hz to 6 kHz, a 1 kHz tone and noise, the second half 40 dB quieter
+static int16_t *gen_test_pcm(int len, int sample_rate)
+{
+    int16_t *pcm = (int16_t *)malloc(len * sizeof(int16_t));
+    uint32_t seed = 1;
+    for (int i = 0; i < len; i++) {
+        float t = (float)i / sample_rate;
+        float duration = (float)len / sample_rate;
+        float phase = 2 * M_PI * (100 * t + (6000 - 100) * t * t / (2 * duration));
+        seed = seed * 1664525 + 1013904223;
+        float noise = ((int32_t)seed >> 16) / 32768.0f;
+        float x = 0.4f * sinf(phase) + 0.2f * sinf(2 * M_PI * 1000 * t) + 0.02f * noise;
+        if (i >= len / 2) {
+            x *= 0.01f;
+        }
+        pcm[i] = (int16_t)lroundf(x * 32767);
+    }
+    return pcm;
+}
+
+/**
+ * Straightforward log-mel filterbank with a dft, the same definition as dl_fbank.
+ */
+static void ref_fbank(const int16_t *pcm, int num_frames, const dl_fbank_config_t *config, int fft_point, float *out)
+{
+    int len = config->frame_length;
+    int num_bins = fft_point / 2 + 1;
+    float high_freq = config->high_freq > 0 ? config->high_freq : config->sample_rate * 0.5f;
+    double low_mel = 1127.0 * log(1.0 + config->low_freq / 700.0);
+    double delta = (1127.0 * log(1.0 + high_freq / 700.0) - low_mel) / (config->num_mels + 1);
+    double *x = (double *)malloc(len * sizeof(double));
+    double *power = (double *)malloc(num_bins * sizeof(double));
+    double *cos_table = (double *)malloc(fft_point * sizeof(double));
+    for (int i = 0; i < fft_point; i++) {
+        cos_table[i] = cos(2 * M_PI * i / fft_point);
+    }
+
+    for (int f = 0; f < num_frames; f++) {
+        const int16_t *frame = pcm + f * config->frame_shift;
+        for (int i = 0; i < len; i++) {
+            x[i] = frame[i] / 32768.0 - config->preemphasis * frame[i > 0 ? i - 1 : 0] / 32768.0;
+            double w = 0.5 - 0.5 * cos(2 * M_PI * i / (len - 1));
+            x[i] *= pow(w, 0.85);
+        }
+        for (int k = 0; k < num_bins; k++) {
+            double re = 0, im = 0;
+            for (int i = 0; i < len; i++) {
+                int idx = (int)(((int64_t)k * i) % fft_point);
+                re += x[i] * cos_table[idx];
+                im -= x[i] * cos_table[(idx + fft_point * 3 / 4) % fft_point];
+            }
+            power[k] = re * re + im * im;
+        }
+        for (int m = 0; m < config->num_mels; m++) {
+            double left = low_mel + m * delta, center = left + delta, right = center + delta;
+            double energy = 0;
+            for (int k = 0; k < num_bins; k++) {
+                double mel = 1127.0 * log(1.0 + (double)k * config->sample_rate / fft_point / 700.0);
+                if (mel > left && mel < right) {
+                    energy += power[k] * (mel <= center ? (mel - left) / delta : (right - mel) / delta);
+                }
+            }
+            out[f * config->num_mels + m] = log(energy > config->energy_floor ? energy : config->energy_floor);
+        }
+    }
+    free(x);
+    free(power);
+    free(cos_table);
+}
+
+TEST_CASE("Test dl fbank f32 and s16 vs reference", "[dl_fbank]")
+{
+    dl_fbank_config_t config = DL_FBANK_DEFAULT_CONFIG();
+    int len = config.sample_rate / 2;
+    int num_frames = (len - config.frame_length) / config.frame_shift + 1;
+    int num_mels = config.num_mels;
+    int16_t *pcm = gen_test_pcm(len, config.sample_rate);
+    float *gt = (float *)malloc(num_frames * num_mels * sizeof(float));
+    float *y = (float *)malloc(num_frames * num_mels * sizeof(float));
+    ref_fbank(pcm, num_frames, &config, 512, gt);
+    int ram_size_before = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+
+    for (int s16 = 0; s16 < 2; s16++) {
+        config.use_s16 = s16;
+        dl_fbank_t *fbank = dl_fbank_init(&config, MALLOC_CAP_8BIT);
+        TEST_ASSERT_NOT_NULL(fbank);
+        TEST_ASSERT_EQUAL(ESP_OK, dl_fbank_set_output(fbank, y, DL_FBANK_OUTPUT_F32, 0, num_frames));
+        TEST_ASSERT_EQUAL(num_frames, dl_fbank_push(fbank, pcm, len));
+
+        // the loud half and the quiet half of the signal. The max error of the int16 path is checked on the bands
+        // within 60 dB of the loudest band of the frame, the noise floor of the int16 fft is lower.
+        float range = logf(1e6f);
+        for (int half = 0; half < 2; half++) {
+            float max_err = 0, sum_err = 0;
+            int begin = half * num_frames / 2, end = (half + 1) * num_frames / 2;
+            for (int f = begin; f < end; f++) {
+                float frame_max = gt[f * num_mels];
+                for (int m = 1; m < num_mels; m++) {
+                    frame_max = gt[f * num_mels + m] > frame_max ? gt[f * num_mels + m] : frame_max;
+                }
+                for (int m = 0; m < num_mels; m++) {
+                    float err = fabsf(y[f * num_mels + m] - gt[f * num_mels + m]);
+                    if (!s16 || gt[f * num_mels + m] > frame_max - range) {
+                        max_err = err > max_err ? err : max_err;
+                    }
+                    sum_err += err;
+                }
+            }
+            float mean_err = sum_err / ((end - begin) * num_mels);
+            printf("fbank %s, %s half: mean abs error %f, max abs error %f\n",
+                   s16 ? "s16" : "f32",
+                   half ? "quiet" : "loud",
+                   mean_err,
+                   max_err);
+            TEST_ASSERT_LESS_THAN_FLOAT(s16 ? 0.05 : 1e-3, mean_err);
+            TEST_ASSERT_LESS_THAN_FLOAT(s16 ? 0.2 : 1e-2, max_err);
+        }
+        dl_fbank_deinit(fbank);
+    }
+
+    free(pcm);
+    free(gt);
+    free(y);
+    int ram_size_end = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    ESP_LOGI(TAG, "ram size before: %d, end:%d", ram_size_before, ram_size_end);
+    TEST_ASSERT_EQUAL(true, ram_size_before - ram_size_end < 300);
+}
+
+TEST_CASE("Test dl fbank streaming into int8 input", "[dl_fbank]")
+{
+    dl_fbank_config_t config = DL_FBANK_DEFAULT_CONFIG();
+    int len = config.sample_rate;
+    int num_mels = config.num_mels;
+    int window = 49; // frames of a [1, 49, 40] model input
+    int exponent = -3;
+    int16_t *pcm = gen_test_pcm(len, config.sample_rate);
+    int8_t *once = (int8_t *)heap_caps_aligned_calloc(16, window * num_mels, 1, MALLOC_CAP_8BIT);
+    int8_t *chunks = (int8_t *)heap_caps_aligned_calloc(16, window * num_mels, 1, MALLOC_CAP_8BIT);
+    float *frames = (float *)malloc(window * num_mels * sizeof(float));
+
+    for (int s16 = 0; s16 < 2; s16++) {
+        config.use_s16 = s16;
+        dl_fbank_t *fbank = dl_fbank_init(&config, MALLOC_CAP_8BIT);
+        dl_fbank_set_output(fbank, once, DL_FBANK_OUTPUT_S8, exponent, window);
+        int num_frames = dl_fbank_push(fbank, pcm, len);
+        TEST_ASSERT_EQUAL((len - config.frame_length) / config.frame_shift + 1, num_frames);
+
+        // the same frames pushed in chunks of 1 to 700 samples
+        dl_fbank_reset(fbank);
+        dl_fbank_set_output(fbank, chunks, DL_FBANK_OUTPUT_S8, exponent, window);
+        int count = 0;
+        uint32_t seed = 7;
+        for (int i = 0; i < len;) {
+            seed = seed * 1664525 + 1013904223;
+            int n = 1 + (seed >> 8) % 700;
+            n = n < len - i ? n : len - i;
+            count += dl_fbank_push(fbank, pcm + i, n);
+            i += n;
+        }
+        TEST_ASSERT_EQUAL(num_frames, count);
+        TEST_ASSERT_EQUAL_INT8_ARRAY(once, chunks, window * num_mels);
+
+        // the int8 frames are the float frames quantized with the exponent
+        dl_fbank_reset(fbank);
+        dl_fbank_set_output(fbank, frames, DL_FBANK_OUTPUT_F32, 0, window);
+        dl_fbank_push(fbank, pcm, len);
+        for (int i = 0; i < window * num_mels; i++) {
+            int q = lroundf(frames[i] * (1 << -exponent));
+            q = q < INT8_MIN ? INT8_MIN : (q > INT8_MAX ? INT8_MAX : q);
+            TEST_ASSERT_INT_WITHIN(1, q, once[i]);
+        }
+
+        dl_fbank_reset(fbank);
+        dl_fbank_set_output(fbank, once, DL_FBANK_OUTPUT_S8, exponent, window);
+        num_frames = 0;
+        uint32_t start = esp_timer_get_time();
+        for (int k = 0; k < LOOP; k++) {
+            num_frames += dl_fbank_push(fbank, pcm, len);
+        }
+        uint32_t end = esp_timer_get_time();
+        printf("fbank %s: %ld us per frame, %ld us per second of audio\n",
+               s16 ? "s16" : "f32",
+               (long)(end - start) / num_frames,
+               (long)(end - start) / LOOP);
+        dl_fbank_deinit(fbank);
+    }
+
+    free(pcm);
+    free(frames);
+    heap_caps_free(once);
+    heap_caps_free(chunks);
+}
@@ -503,3 +503,316 @@ TEST_CASE("12. test dl irfft hp s16", "[dl_fft]")
     ESP_LOGI(TAG, "ram size before: %d, end:%d", ram_size_before, ram_size_end);
     TEST_ASSERT_EQUAL(true, ram_size_before == ram_size_end);
 }
+
+static void dft_f64(const float *x, float *y, int nfft, bool real_input)
+{
+    for (int k = 0; k < nfft; k++) {
+        double re = 0, im = 0;
+        for (int n = 0; n < nfft; n++) {
+            double angle = -2 * M_PI * (double)((int64_t)n * k % nfft) / nfft;
+            double x_re = real_input ? x[n] : x[2 * n];
+            double x_im = real_input ? 0 : x[2 * n + 1];
+            re += x_re * cos(angle) - x_im * sin(angle);
+            im += x_re * sin(angle) + x_im * cos(angle);
+        }
+        y[2 * k] = re;
+        y[2 * k + 1] = im;
+    }
+}
+
+TEST_CASE("13. test dl fft not power of two", "[dl_fft]")
+{
+    // 400, 480 and 1000 are mixed-radix, 97 and 462 = 2 * 3 * 7 * 11 use Bluestein
+    int test_nfft[5] = {400, 480, 1000, 97, 462};
+    float target_db = 90;
+    int ram_size_before = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    uint32_t start = 0, end = 0;
+
+    srand(1234);
+    for (int i = 0; i < 5; i++) {
+        int nfft = test_nfft[i];
+        printf("test fft(%d) float: ", nfft);
+        float *input = (float *)malloc(nfft * sizeof(float) * 2);
+        float *gt = (float *)malloc(nfft * sizeof(float) * 2);
+        float *x = (float *)heap_caps_aligned_alloc(16, nfft * sizeof(float) * 2, MALLOC_CAP_8BIT);
+        for (int j = 0; j < nfft * 2; j++) {
+            input[j] = (float)rand() / RAND_MAX - 0.5f;
+        }
+        dft_f64(input, gt, nfft, false);
+        memcpy(x, input, nfft * 2 * sizeof(float));
+
+        dl_fft_f32_t *fft_handle = dl_fft_f32_init(nfft, MALLOC_CAP_8BIT);
+        TEST_ASSERT_NOT_NULL(fft_handle);
+        dl_fft_f32_run(fft_handle, x);
+        TEST_ASSERT_EQUAL(true, check_fft_results(x, gt, nfft * 2, target_db, 1e-3));
+        printf("test ifft(%d) float: ", nfft);
+        dl_ifft_f32_run(fft_handle, x);
+        TEST_ASSERT_EQUAL(true, check_fft_results(x, input, nfft * 2, 80, 1e-3));
+
+        start = esp_timer_get_time();
+        for (int k = 0; k < LOOP; k++) {
+            dl_fft_f32_run(fft_handle, x);
+        }
+        end = esp_timer_get_time();
+        printf("time:%ld us\n", (end - start) / LOOP);
+        dl_fft_f32_deinit(fft_handle);
+
+        // real fft of an even length runs a complex fft of nfft / 2 points
+        if (nfft % 2 == 0) {
+            printf("test rfft(%d) float: ", nfft);
+            dft_f64(input, gt, nfft, true);
+            gt[1] = gt[nfft];
+            memcpy(x, input, nfft * sizeof(float));
+            fft_handle = dl_rfft_f32_init(nfft, MALLOC_CAP_8BIT);
+            TEST_ASSERT_NOT_NULL(fft_handle);
+            dl_rfft_f32_run(fft_handle, x);
+            TEST_ASSERT_EQUAL(true, check_fft_results(x, gt, nfft, target_db, 1e-3));
+            printf("test irfft(%d) float: ", nfft);
+            dl_irfft_f32_run(fft_handle, x);
+            TEST_ASSERT_EQUAL(true, check_fft_results(x, input, nfft, 80, 1e-3));
+            dl_rfft_f32_deinit(fft_handle);
+        }
+        heap_caps_free(x);
+        free(input);
+        free(gt);
+    }
+
+    int ram_size_end = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    ESP_LOGI(TAG, "ram size before: %d, end:%d", ram_size_before, ram_size_end);
+    TEST_ASSERT_EQUAL(true, ram_size_before == ram_size_end);
+}
+
+// planar signals <-> interleaved signals, elem_size values per element
+template <typename T>
+static void interleave(const T *planar, T *interleaved, int len, int batch, int elem_size, bool inverse)
+{
+    for (int c = 0; c < batch; c++) {
+        for (int i = 0; i < len; i++) {
+            for (int k = 0; k < elem_size; k++) {
+                T *p = (T *)planar + (c * len + i) * elem_size + k;
+                T *q = interleaved + (i * batch + c) * elem_size + k;
+                if (inverse) {
+                    *p = *q;
+                } else {
+                    *q = *p;
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("14. test dl fft batch", "[dl_fft]")
+{
+    int test_nfft[3] = {128, 512, 2048};
+    uint32_t test_flags[4] = {
+        0, DL_FFT_BATCH_INTERLEAVED, DL_FFT_BATCH_DUAL_CORE, DL_FFT_BATCH_INTERLEAVED | DL_FFT_BATCH_DUAL_CORE};
+    const int batch = 6;
+    int ram_size_before = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    int exponent[batch * 2], batch_exponent[batch * 2];
+
+    srand(4321);
+    for (int i = 0; i < 3; i++) {
+        int nfft = test_nfft[i];
+        int size = nfft * 2 * batch;
+        int16_t *input = (int16_t *)malloc(size * sizeof(int16_t));
+        int16_t *gt = (int16_t *)heap_caps_aligned_alloc(16, size * sizeof(int16_t), MALLOC_CAP_8BIT);
+        int16_t *x = (int16_t *)heap_caps_aligned_alloc(16, size * sizeof(int16_t), MALLOC_CAP_8BIT);
+        int16_t *y = (int16_t *)malloc(size * sizeof(int16_t));
+        float *input_f32 = (float *)malloc(size * sizeof(float));
+        float *gt_f32 = (float *)heap_caps_aligned_alloc(16, size * sizeof(float), MALLOC_CAP_8BIT);
+        float *x_f32 = (float *)heap_caps_aligned_alloc(16, size * sizeof(float), MALLOC_CAP_8BIT);
+        float *y_f32 = (float *)malloc(size * sizeof(float));
+        // every signal has its own level, so the hp kernels scale them differently
+        for (int j = 0; j < size; j++) {
+            int c = j / (nfft * 2);
+            input[j] = (rand() % 65536 - 32768) >> (c * 2);
+            input_f32[j] = input[j] / 32768.0f;
+        }
+
+        for (int hp = 0; hp < 2; hp++) {
+            // complex int16 fft, the results of the batch are the same as the single signal fft
+            dl_fft_s16_t *fft_handle = dl_fft_s16_init(nfft, MALLOC_CAP_8BIT);
+            memcpy(gt, input, size * sizeof(int16_t));
+            for (int c = 0; c < batch; c++) {
+                int16_t *signal = gt + c * nfft * 2;
+                hp ? dl_fft_s16_hp_run(fft_handle, signal, -15, &exponent[c])
+                   : dl_fft_s16_run(fft_handle, signal, -15, &exponent[c]);
+            }
+            for (int f = 0; f < 4; f++) {
+                bool interleaved = test_flags[f] & DL_FFT_BATCH_INTERLEAVED;
+                interleaved ? interleave(input, x, nfft, batch, 2, false) : (void)memcpy(x, input, size * 2);
+                esp_err_t ret = hp ? dl_fft_s16_hp_batch_run(fft_handle, x, batch, test_flags[f], -15, batch_exponent)
+                                   : dl_fft_s16_batch_run(fft_handle, x, batch, test_flags[f], -15, batch_exponent);
+                TEST_ASSERT_EQUAL(ESP_OK, ret);
+                interleaved ? interleave(y, x, nfft, batch, 2, true) : (void)memcpy(y, x, size * 2);
+                TEST_ASSERT_EQUAL_INT16_ARRAY(gt, y, size);
+                TEST_ASSERT_EQUAL_INT32_ARRAY(exponent, batch_exponent, batch);
+            }
+
+            uint32_t start = esp_timer_get_time();
+            for (int k = 0; k < LOOP; k++) {
+                for (int c = 0; c < batch; c++) {
+                    int16_t *signal = x + c * nfft * 2;
+                    hp ? dl_fft_s16_hp_run(fft_handle, signal, -15, &exponent[c])
+                       : dl_fft_s16_run(fft_handle, signal, -15, &exponent[c]);
+                }
+            }
+            uint32_t end = esp_timer_get_time();
+            uint32_t batch_start = esp_timer_get_time();
+            for (int k = 0; k < LOOP; k++) {
+                hp ? dl_fft_s16_hp_batch_run(fft_handle, x, batch, 0, -15, batch_exponent)
+                   : dl_fft_s16_batch_run(fft_handle, x, batch, 0, -15, batch_exponent);
+            }
+            uint32_t batch_end = esp_timer_get_time();
+            printf("fft%s(%d) s16 x %d: single %ld us, batch %ld us\n",
+                   hp ? " hp" : "",
+                   nfft,
+                   batch,
+                   (long)(end - start) / LOOP,
+                   (long)(batch_end - batch_start) / LOOP);
+            dl_fft_s16_deinit(fft_handle);
+
+            // real int16 fft of planar signals, the same buffer holds twice as many real signals
+            fft_handle = dl_rfft_s16_init(nfft, MALLOC_CAP_8BIT);
+            memcpy(gt, input, size * sizeof(int16_t));
+            for (int c = 0; c < batch * 2; c++) {
+                int16_t *signal = gt + c * nfft;
+                hp ? dl_rfft_s16_hp_run(fft_handle, signal, -15, &exponent[c])
+                   : dl_rfft_s16_run(fft_handle, signal, -15, &exponent[c]);
+            }
+            for (int f = 0; f < 4; f += 2) {
+                memcpy(x, input, size * sizeof(int16_t));
+                int num = batch * 2;
+                esp_err_t ret = hp ? dl_rfft_s16_hp_batch_run(fft_handle, x, num, test_flags[f], -15, batch_exponent)
+                                   : dl_rfft_s16_batch_run(fft_handle, x, num, test_flags[f], -15, batch_exponent);
+                TEST_ASSERT_EQUAL(ESP_OK, ret);
+                TEST_ASSERT_EQUAL_INT16_ARRAY(gt, x, size);
+                TEST_ASSERT_EQUAL_INT32_ARRAY(exponent, batch_exponent, batch * 2);
+            }
+            TEST_ASSERT_EQUAL(ESP_ERR_NOT_SUPPORTED,
+                              dl_rfft_s16_batch_run(fft_handle, x, batch, DL_FFT_BATCH_INTERLEAVED, -15, exponent));
+            dl_rfft_s16_deinit(fft_handle);
+        }
+
+        // float fft and rfft run the single signal kernels
+        dl_fft_f32_t *fft_handle = dl_fft_f32_init(nfft, MALLOC_CAP_8BIT);
+        memcpy(gt_f32, input_f32, size * sizeof(float));
+        for (int c = 0; c < batch; c++) {
+            dl_fft_f32_run(fft_handle, gt_f32 + c * nfft * 2);
+        }
+        for (int f = 0; f < 4; f++) {
+            bool interleaved = test_flags[f] & DL_FFT_BATCH_INTERLEAVED;
+            interleaved ? interleave(input_f32, x_f32, nfft, batch, 2, false)
+                        : (void)memcpy(x_f32, input_f32, size * sizeof(float));
+            TEST_ASSERT_EQUAL(ESP_OK, dl_fft_f32_batch_run(fft_handle, x_f32, batch, test_flags[f]));
+            interleaved ? interleave(y_f32, x_f32, nfft, batch, 2, true)
+                        : (void)memcpy(y_f32, x_f32, size * sizeof(float));
+            TEST_ASSERT_EQUAL(0, memcmp(gt_f32, y_f32, size * sizeof(float)));
+        }
+        // the interleaved runs share the gather buffer, freed by deinit
+        TEST_ASSERT_NOT_NULL(fft_handle->batch_buf);
+        dl_fft_f32_deinit(fft_handle);
+
+        fft_handle = dl_rfft_f32_init(nfft, MALLOC_CAP_8BIT);
+        memcpy(gt_f32, input_f32, size * sizeof(float));
+        for (int c = 0; c < batch * 2; c++) {
+            dl_rfft_f32_run(fft_handle, gt_f32 + c * nfft);
+        }
+        memcpy(x_f32, input_f32, size * sizeof(float));
+        TEST_ASSERT_EQUAL(ESP_OK, dl_rfft_f32_batch_run(fft_handle, x_f32, batch * 2, DL_FFT_BATCH_DUAL_CORE));
+        TEST_ASSERT_EQUAL(0, memcmp(gt_f32, x_f32, size * sizeof(float)));
+        dl_rfft_f32_deinit(fft_handle);
+
+        free(input);
+        free(y);
+        free(input_f32);
+        free(y_f32);
+        heap_caps_free(gt);
+        heap_caps_free(x);
+        heap_caps_free(gt_f32);
+        heap_caps_free(x_f32);
+    }
+
+    int ram_size_end = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    ESP_LOGI(TAG, "ram size before: %d, end:%d", ram_size_before, ram_size_end);
+    TEST_ASSERT_EQUAL(true, ram_size_before - ram_size_end < 300);
+}
+
+TEST_CASE("15. test dl fft oop s16", "[dl_fft]")
+{
+    int test_nfft[8] = {2, 4, 32, 128, 256, 512, 1024, 2048};
+    int ram_size_before = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+
+    srand(1234);
+    for (int i = 0; i < 8; i++) {
+        int nfft = test_nfft[i];
+        int16_t *input = (int16_t *)malloc(nfft * 2 * sizeof(int16_t));
+        int16_t *gt = (int16_t *)heap_caps_aligned_alloc(16, nfft * 2 * sizeof(int16_t), MALLOC_CAP_8BIT);
+        int16_t *x = (int16_t *)heap_caps_aligned_alloc(16, nfft * 2 * sizeof(int16_t), MALLOC_CAP_8BIT);
+        int16_t *y = (int16_t *)heap_caps_aligned_alloc(16, nfft * 2 * sizeof(int16_t), MALLOC_CAP_8BIT);
+        for (int j = 0; j < nfft * 2; j++) {
+            input[j] = (rand() % 65536 - 32768) >> 2;
+        }
+        dl_fft_s16_t *fft_handle = dl_fft_s16_init(nfft, MALLOC_CAP_8BIT);
+
+        // fft, ifft, fft hp and ifft hp, the out-of-place results are the same as the in-place results
+        for (int k = 0; k < 4; k++) {
+            int exponent, oop_exponent;
+            memcpy(gt, input, nfft * 2 * sizeof(int16_t));
+            memcpy(x, input, nfft * 2 * sizeof(int16_t));
+            switch (k) {
+            case 0:
+                dl_fft_s16_run(fft_handle, gt, -15, &exponent);
+                dl_fft_s16_oop_run(fft_handle, x, y, -15, &oop_exponent);
+                break;
+            case 1:
+                dl_ifft_s16_run(fft_handle, gt, -15, &exponent);
+                dl_ifft_s16_oop_run(fft_handle, x, y, -15, &oop_exponent);
+                break;
+            case 2:
+                dl_fft_s16_hp_run(fft_handle, gt, -15, &exponent);
+                dl_fft_s16_hp_oop_run(fft_handle, x, y, -15, &oop_exponent);
+                break;
+            default:
+                dl_ifft_s16_hp_run(fft_handle, gt, -15, &exponent);
+                dl_ifft_s16_hp_oop_run(fft_handle, x, y, -15, &oop_exponent);
+                break;
+            }
+            TEST_ASSERT_EQUAL_INT16_ARRAY(gt, y, nfft * 2);
+            TEST_ASSERT_EQUAL(exponent, oop_exponent);
+        }
+
+        // out == data runs the in-place fft
+        int exponent;
+        memcpy(x, input, nfft * 2 * sizeof(int16_t));
+        TEST_ASSERT_EQUAL(ESP_OK, dl_ifft_s16_hp_oop_run(fft_handle, x, x, -15, &exponent));
+        TEST_ASSERT_EQUAL_INT16_ARRAY(gt, x, nfft * 2);
+
+        if (nfft >= 256) {
+            uint32_t start = esp_timer_get_time();
+            for (int k = 0; k < LOOP; k++) {
+                dl_fft_s16_hp_run(fft_handle, x, -15, &exponent);
+            }
+            uint32_t end = esp_timer_get_time();
+            uint32_t oop_start = esp_timer_get_time();
+            for (int k = 0; k < LOOP; k++) {
+                dl_fft_s16_hp_oop_run(fft_handle, x, y, -15, &exponent);
+            }
+            uint32_t oop_end = esp_timer_get_time();
+            printf("fft hp(%d) s16: in-place %ld us, out-of-place %ld us\n",
+                   nfft,
+                   (long)(end - start) / LOOP,
+                   (long)(oop_end - oop_start) / LOOP);
+        }
+
+        dl_fft_s16_deinit(fft_handle);
+        free(input);
+        heap_caps_free(gt);
+        heap_caps_free(x);
+        heap_caps_free(y);
+    }
+
+    int ram_size_end = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    ESP_LOGI(TAG, "ram size before: %d, end:%d", ram_size_before, ram_size_end);
+    TEST_ASSERT_EQUAL(true, ram_size_before - ram_size_end < 300);
+}
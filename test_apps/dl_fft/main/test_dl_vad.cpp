@@ -0,0 +1,107 @@
+#include "dl_fbank.h"
+#include "test_fft.h"
+#include <math.h>
+
+static const char *TAG = "TEST DL VAD";
+
+// 1 s of quiet noise, 1 s of a 150 Hz harmonic tone over the noise, 1 s of 20 dB louder noise
+static int16_t *gen_vad_pcm(int len, int sample_rate)
+{
+    int16_t *pcm = (int16_t *)malloc(len * sizeof(int16_t));
+    uint32_t seed = 1;
+    for (int i = 0; i < len; i++) {
+        float t = (float)i / sample_rate;
+        seed = seed * 1664525 + 1013904223;
+        float noise = ((int32_t)seed >> 16) / 32768.0f;
+        float x = 0.003f * noise;
+        if (i >= len / 3 && i < 2 * len / 3) {
+            for (int h = 1; h * 150 < 3500; h++) {
+                x += 0.2f / h * sinf(2 * M_PI * 150 * h * t);
+            }
+        } else if (i >= 2 * len / 3) {
+            x *= 10;
+        }
+        pcm[i] = (int16_t)lroundf(x * 32767);
+    }
+    return pcm;
+}
+
+TEST_CASE("Test dl vad gating a streaming model", "[dl_vad]")
+{
+    dl_fbank_config_t fbank_config = DL_FBANK_DEFAULT_CONFIG();
+    dl_vad_config_t vad_config = DL_VAD_DEFAULT_CONFIG();
+    int sample_rate = fbank_config.sample_rate;
+    int len = sample_rate * 3;
+    int hop = 4; // frames per step of the model
+    int step_len = hop * fbank_config.frame_shift;
+    int num_steps = len / step_len;
+    int16_t *pcm = gen_vad_pcm(len, sample_rate);
+    bool *gate[2];
+    int ram_size_before = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+
+    for (int s16 = 0; s16 < 2; s16++) {
+        fbank_config.use_s16 = s16;
+        dl_fbank_t *fbank = dl_fbank_init(&fbank_config, MALLOC_CAP_8BIT);
+        dl_vad_t *vad = dl_vad_init(&vad_config, MALLOC_CAP_8BIT);
+        TEST_ASSERT_NOT_NULL(fbank);
+        TEST_ASSERT_NOT_NULL(vad);
+        TEST_ASSERT_EQUAL(ESP_OK, dl_fbank_set_vad(fbank, vad));
+
+        // one step of the model every hop frames, skipped if the gate was closed over the new frames
+        gate[s16] = (bool *)calloc(num_steps, sizeof(bool));
+        int frames = 0, runs = 0;
+        for (int step = 0; step < num_steps; step++) {
+            frames += dl_fbank_push(fbank, pcm + step * step_len, step_len);
+            gate[s16][step] = dl_vad_check(vad);
+            runs += gate[s16][step];
+        }
+
+        dl_vad_stats_t stats;
+        dl_vad_get_stats(vad, &stats);
+        printf("vad %s: %ld frames, %ld active, %ld segments, %ld of %ld runs skipped, noise floor %.1f dB\n",
+               s16 ? "s16" : "f32",
+               (long)stats.frames,
+               (long)stats.active_frames,
+               (long)stats.segments,
+               (long)stats.skipped_checks,
+               (long)stats.checks,
+               stats.noise_floor_db);
+        TEST_ASSERT_EQUAL(frames, stats.frames);
+        TEST_ASSERT_EQUAL(num_steps, stats.checks);
+        TEST_ASSERT_EQUAL(num_steps - runs, stats.skipped_checks);
+        TEST_ASSERT_EQUAL(1, stats.segments);
+
+        // the tone runs the model from its second step to the end of the hangover, the noise never does
+        int begin = num_steps / 3 + 1, end = 2 * num_steps / 3;
+        int hangover_steps = (vad_config.hangover_frames + hop - 1) / hop + 1;
+        for (int step = 0; step < num_steps; step++) {
+            if (step >= begin && step < end) {
+                TEST_ASSERT_TRUE(gate[s16][step]);
+            } else if (step < begin - 1 || step > end + hangover_steps) {
+                TEST_ASSERT_FALSE(gate[s16][step]);
+            }
+        }
+        TEST_ASSERT_INT_WITHIN(2 * hangover_steps, num_steps / 3, runs);
+
+        // a reset forgets the noise floor and closes the gate, the statistics are kept
+        dl_vad_reset(vad);
+        TEST_ASSERT_FALSE(dl_vad_check(vad));
+        dl_vad_get_stats(vad, &stats);
+        TEST_ASSERT_EQUAL(frames, stats.frames);
+        dl_vad_reset_stats(vad);
+        dl_vad_get_stats(vad, &stats);
+        TEST_ASSERT_EQUAL(0, stats.frames);
+
+        dl_fbank_deinit(fbank);
+        dl_vad_deinit(vad);
+    }
+    // the float and the int16 path gate the same steps
+    TEST_ASSERT_EQUAL_INT8_ARRAY(gate[0], gate[1], num_steps);
+
+    free(gate[0]);
+    free(gate[1]);
+    free(pcm);
+    int ram_size_end = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    ESP_LOGI(TAG, "ram size before: %d, end:%d", ram_size_before, ram_size_end);
+    TEST_ASSERT_EQUAL(true, ram_size_before - ram_size_end < 300);
+}
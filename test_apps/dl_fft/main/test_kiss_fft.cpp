@@ -116,3 +116,93 @@ TEST_CASE("Test dl kiss ifft s16", "[kiss_fft]")
     ESP_LOGI(TAG, "ram size before: %d, end:%d", ram_size_before, ram_size_end);
     TEST_ASSERT_EQUAL(true, ram_size_before == ram_size_end);
 }
+
+typedef esp_err_t (*test_fft_s16_func_t)(int16_t *data, int N, int16_t *table, int *shift);
+
+static esp_err_t test_fft2r_sc16(int16_t *data, int N, int16_t *table, int *shift)
+{
+    shift[0] = dl_power_of_two(N);
+    return dl_fft2r_sc16_ansi(data, N, table);
+}
+
+static esp_err_t test_fft4r_sc16(int16_t *data, int N, int16_t *table, int *shift)
+{
+    shift[0] = dl_power_of_two(N);
+    return dl_fft4r_sc16_ansi(data, N, table);
+}
+
+TEST_CASE("Test dl fft4r s16 vs fft2r s16 and kiss fft", "[kiss_fft]")
+{
+    const int16_t *input[5] = {
+        fft_input_s16_128, fft_input_s16_256, fft_input_s16_512, fft_input_s16_1024, fft_input_s16_2048};
+    const float *output[5] = {fft_output_128, fft_output_256, fft_output_512, fft_output_1024, fft_output_2048};
+    int test_nfft[5] = {128, 256, 512, 1024, 2048};
+    const char *names[4] = {"fft2r", "fft4r", "fft2r hp", "fft4r hp"};
+    test_fft_s16_func_t funcs[4] = {test_fft2r_sc16, test_fft4r_sc16, dl_fft2r_sc16_hp_ansi, dl_fft4r_sc16_hp_ansi};
+    int ram_size_before = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    uint32_t start = 0, end = 0;
+
+    printf("| Size | Kernel | SNR (dB) | RMSE | Time (us) |\n");
+    for (int i = 0; i < 5; i++) {
+        int nfft = test_nfft[i];
+        int16_t *x = (int16_t *)heap_caps_aligned_alloc(16, nfft * sizeof(int16_t) * 2, MALLOC_CAP_8BIT);
+        float *y = (float *)heap_caps_aligned_alloc(16, nfft * sizeof(float) * 2, MALLOC_CAP_8BIT);
+        // the radix-4 table starts with the radix-2 table
+        int16_t *table = dl_gen_fft4r_table_sc16(nfft, MALLOC_CAP_8BIT);
+        float snr[4];
+
+        for (int f = 0; f < 4; f++) {
+            int shift = 0;
+            memcpy(x, input[i], nfft * 2 * sizeof(int16_t));
+            funcs[f](x, nfft, table, &shift);
+            dl_bitrev2r_sc16_ansi(x, nfft);
+            dl_short_to_float(x, nfft * 2, -15 + shift, y);
+            snr[f] = get_snr(y, output[i], nfft);
+
+            start = esp_timer_get_time();
+            for (int k = 0; k < LOOP; k++) {
+                funcs[f](x, nfft, table, &shift);
+                dl_bitrev2r_sc16_ansi(x, nfft);
+            }
+            end = esp_timer_get_time();
+            printf("| %d | %s | %f | %f | %ld |\n",
+                   nfft,
+                   names[f],
+                   snr[f],
+                   get_rmse(y, output[i], nfft),
+                   (end - start) / LOOP);
+        }
+
+        // kiss fft scales the output by 1 / nfft
+        kiss_fft_cfg kiss_handle = kiss_fft_alloc(nfft, 0, 0, 0);
+        memcpy(x, input[i], nfft * 2 * sizeof(int16_t));
+        int16_t *x2 = (int16_t *)heap_caps_aligned_alloc(16, nfft * sizeof(int16_t) * 2, MALLOC_CAP_8BIT);
+        kiss_fft(kiss_handle, (kiss_fft_cpx *)x, (kiss_fft_cpx *)x2);
+        dl_short_to_float(x2, nfft * 2, -15 + dl_power_of_two(nfft), y);
+        float kiss_snr = get_snr(y, output[i], nfft);
+        start = esp_timer_get_time();
+        for (int k = 0; k < LOOP; k++) {
+            kiss_fft(kiss_handle, (kiss_fft_cpx *)x, (kiss_fft_cpx *)x2);
+        }
+        end = esp_timer_get_time();
+        printf("| %d | kiss fft | %f | %f | %ld |\n",
+               nfft,
+               kiss_snr,
+               get_rmse(y, output[i], nfft),
+               (end - start) / LOOP);
+
+        // radix-4 rounds once per two radix-2 stages, it should never be less precise
+        TEST_ASSERT_EQUAL(true, snr[1] > snr[0] - 0.5);
+        TEST_ASSERT_EQUAL(true, snr[3] > snr[2] - 0.5);
+        TEST_ASSERT_EQUAL(true, snr[3] > kiss_snr);
+        free(kiss_handle);
+        heap_caps_free(table);
+        heap_caps_free(x);
+        heap_caps_free(x2);
+        heap_caps_free(y);
+    }
+
+    int ram_size_end = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    ESP_LOGI(TAG, "ram size before: %d, end:%d", ram_size_before, ram_size_end);
+    TEST_ASSERT_EQUAL(true, ram_size_before == ram_size_end);
+}
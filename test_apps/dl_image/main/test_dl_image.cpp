@@ -251,3 +251,269 @@ TEST_CASE("Test BMP", "[dl_image][ignore]")
 
     ESP_ERROR_CHECK(bsp_sdcard_unmount());
 }
+
+static void check_warp_affine(const img_t &src_img, interpolate_type_t interpolate_type, uint32_t caps)
+{
+    // Rotated and scaled crop, like the similarity transform of a face, kept inside the source image.
+    dl::math::Matrix<float> M_inv(2, 3);
+    float theta = 0.3f, s = 1.7f;
+    M_inv.array[0][0] = s * cosf(theta);
+    M_inv.array[0][1] = -s * sinf(theta);
+    M_inv.array[0][2] = 120.f;
+    M_inv.array[1][0] = s * sinf(theta);
+    M_inv.array[1][1] = s * cosf(theta);
+    M_inv.array[1][2] = 80.f;
+
+    img_t dst_img = {.data = heap_caps_malloc(112 * 112 * 3, MALLOC_CAP_DEFAULT),
+                     .width = 112,
+                     .height = 112,
+                     .pix_type = DL_IMAGE_PIX_TYPE_RGB888};
+    int64_t start = esp_timer_get_time();
+    warp_affine(src_img, dst_img, interpolate_type, &M_inv, caps);
+    int64_t end = esp_timer_get_time();
+    printf("warp_affine %s %s 112x112: %.2fms\n",
+           pix_type_to_str(src_img.pix_type).c_str(),
+           interpolate_type == DL_IMAGE_INTERPOLATE_BILINEAR ? "bilinear" : "nearest",
+           (end - start) / 1000.f);
+
+    // Compare with the float interpolation.
+    uint8_t ref[3];
+    pix_t pix = {.data = ref, .type = DL_IMAGE_PIX_TYPE_RGB888};
+    uint8_t *dst_ptr = (uint8_t *)dst_img.data;
+    int max_diff = 0, mismatch = 0;
+    for (int i = 0; i < dst_img.height; i++) {
+        for (int j = 0; j < dst_img.width; j++) {
+            float x = M_inv.array[0][0] * j + M_inv.array[0][1] * i + M_inv.array[0][2];
+            float y = M_inv.array[1][0] * j + M_inv.array[1][1] * i + M_inv.array[1][2];
+            if (interpolate_type == DL_IMAGE_INTERPOLATE_BILINEAR) {
+                if (src_img.pix_type == DL_IMAGE_PIX_TYPE_RGB888) {
+                    bilinear_interpolate_rgb888(src_img, x, y, pix, caps, nullptr);
+                } else {
+                    bilinear_interpolate_rgb565(src_img, x, y, pix, caps, nullptr);
+                }
+            } else {
+                if (src_img.pix_type == DL_IMAGE_PIX_TYPE_RGB888) {
+                    nearest_interpolate_rgb888(src_img, x, y, pix, caps, nullptr);
+                } else {
+                    nearest_interpolate_rgb565(src_img, x, y, pix, caps, nullptr);
+                }
+            }
+            for (int c = 0; c < 3; c++) {
+                int diff = abs(ref[c] - dst_ptr[c]);
+                max_diff = std::max(max_diff, diff);
+                mismatch += (diff > 0);
+            }
+            dst_ptr += 3;
+        }
+    }
+    if (interpolate_type == DL_IMAGE_INTERPOLATE_BILINEAR) {
+        TEST_ASSERT_LESS_OR_EQUAL(1, max_diff);
+    } else {
+        // Only coordinates right at the middle of two pixels may round to the other one.
+        TEST_ASSERT_LESS_OR_EQUAL(112 * 112 * 3 / 100, mismatch);
+    }
+    heap_caps_free(dst_img.data);
+}
+
+TEST_CASE("Test warp_affine", "[dl_image]")
+{
+    jpeg_img_t jpeg_img = {.data = (void *)color_405x540_jpg_start,
+                           .data_len = (size_t)(color_405x540_jpg_end - color_405x540_jpg_start)};
+    img_t img = sw_decode_jpeg(jpeg_img, DL_IMAGE_PIX_TYPE_RGB888);
+    check_warp_affine(img, DL_IMAGE_INTERPOLATE_BILINEAR, DL_IMAGE_CAP_RGB_SWAP);
+    check_warp_affine(img, DL_IMAGE_INTERPOLATE_NEAREST, DL_IMAGE_CAP_RGB_SWAP);
+    heap_caps_free(img.data);
+
+    img = sw_decode_jpeg(jpeg_img, DL_IMAGE_PIX_TYPE_RGB565);
+    check_warp_affine(img, DL_IMAGE_INTERPOLATE_BILINEAR, DL_IMAGE_CAP_RGB_SWAP);
+    check_warp_affine(img, DL_IMAGE_INTERPOLATE_NEAREST, DL_IMAGE_CAP_RGB_SWAP);
+    heap_caps_free(img.data);
+}
+
+TEST_CASE("Test sw decode downscale", "[dl_image]")
+{
+    jpeg_img_t jpeg_img = {.data = (void *)color_320x240_jpg_start,
+                           .data_len = (size_t)(color_320x240_jpg_end - color_320x240_jpg_start)};
+    int width, height;
+    TEST_ASSERT_EQUAL(ESP_OK, get_jpeg_size(jpeg_img, &width, &height));
+    TEST_ASSERT_EQUAL(320, width);
+    TEST_ASSERT_EQUAL(240, height);
+    TEST_ASSERT_EQUAL(0, get_sw_decode_jpeg_shift(width, height, 0, 0));
+    TEST_ASSERT_EQUAL(1, get_sw_decode_jpeg_shift(width, height, 1, 1));
+    TEST_ASSERT_EQUAL(1, get_sw_decode_jpeg_shift(width, height, 100, 100));
+    TEST_ASSERT_EQUAL(0, get_sw_decode_jpeg_shift(width, height, 200, 100));
+
+    int64_t start, end;
+    start = esp_timer_get_time();
+    img_t img = sw_decode_jpeg(jpeg_img, DL_IMAGE_PIX_TYPE_RGB888);
+    end = esp_timer_get_time();
+    printf("sw_decode_rgb888_color_320x240: %.2fms\n", (end - start) / 1000.f);
+    start = esp_timer_get_time();
+    img_t half_img = sw_decode_jpeg(jpeg_img, DL_IMAGE_PIX_TYPE_RGB888, 0, 100, 100);
+    end = esp_timer_get_time();
+    printf("sw_decode_rgb888_color_320x240 at 1/2: %.2fms\n", (end - start) / 1000.f);
+    TEST_ASSERT_EQUAL(160, half_img.width);
+    TEST_ASSERT_EQUAL(120, half_img.height);
+
+    // The downscaled image is close to the 2x2 mean of the full size one.
+    uint8_t *ptr = (uint8_t *)img.data;
+    uint8_t *half_ptr = (uint8_t *)half_img.data;
+    int64_t error = 0;
+    for (int y = 0; y < half_img.height; y++) {
+        for (int x = 0; x < half_img.width; x++) {
+            for (int c = 0; c < 3; c++) {
+                int sum = ptr[(2 * y * width + 2 * x) * 3 + c] + ptr[(2 * y * width + 2 * x + 1) * 3 + c] +
+                    ptr[((2 * y + 1) * width + 2 * x) * 3 + c] + ptr[((2 * y + 1) * width + 2 * x + 1) * 3 + c];
+                error += abs(sum / 4 - half_ptr[(y * half_img.width + x) * 3 + c]);
+            }
+        }
+    }
+    TEST_ASSERT_LESS_OR_EQUAL(8, error / (half_img.width * half_img.height * 3));
+    heap_caps_free(img.data);
+
+    // Block rows put together are the same as the whole image.
+    SwJpegDecoder decoder(DL_IMAGE_PIX_TYPE_RGB888);
+    int next_y = 0, mismatch = 0;
+    TEST_ASSERT_EQUAL(ESP_OK,
+                      decoder.decode_rows(
+                          jpeg_img,
+                          [&](const img_t &rows, int y) {
+                              TEST_ASSERT_EQUAL(next_y, y);
+                              TEST_ASSERT_EQUAL(half_img.width, rows.width);
+                              size_t offset = y * half_img.width * 3;
+                              mismatch += memcmp(rows.data, half_ptr + offset, get_img_byte_size(rows)) != 0;
+                              next_y += rows.height;
+                          },
+                          100,
+                          100));
+    TEST_ASSERT_EQUAL(half_img.height, next_y);
+    TEST_ASSERT_EQUAL(0, mismatch);
+    TEST_ASSERT_EQUAL(width, decoder.get_width());
+    TEST_ASSERT_EQUAL(1, decoder.get_shift());
+
+    img_t decoded;
+    TEST_ASSERT_EQUAL(ESP_OK, decoder.decode(jpeg_img, decoded, 100, 100));
+    TEST_ASSERT_EQUAL(0, memcmp(decoded.data, half_img.data, get_img_byte_size(half_img)));
+    heap_caps_free(half_img.data);
+}
+
+static bool img_equal(const img_t &img1, const img_t &img2)
+{
+    size_t row_bytes = img1.width * get_pix_byte_size(img1.pix_type);
+    for (int i = 0; i < img1.height; i++) {
+        if (memcmp(get_img_row(img1, i), get_img_row(img2, i), row_bytes)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Count the bytes of the buffer of img which are outside area and not equal to value.
+ */
+static int count_changed_outside(const img_t &img, const std::vector<int> &area, uint8_t value)
+{
+    int pix_bytes = get_pix_byte_size(img.pix_type);
+    int changed = 0;
+    for (int i = 0; i < img.height; i++) {
+        uint8_t *row = (uint8_t *)get_img_row(img, i);
+        for (int j = 0; j < (int)get_img_stride(img); j++) {
+            bool inside = i >= area[1] && i < area[3] && j >= area[0] * pix_bytes && j < area[2] * pix_bytes;
+            changed += !inside && row[j] != value;
+        }
+    }
+    return changed;
+}
+
+TEST_CASE("Test img stride", "[dl_image]")
+{
+    // The same pixels, packed and as a sub image of a bigger buffer with padded rows.
+    const int width = 96, height = 64, x0 = 8, y0 = 4;
+    img_t img = {.data = heap_caps_malloc(width * height * 3, MALLOC_CAP_DEFAULT),
+                 .width = width,
+                 .height = height,
+                 .pix_type = DL_IMAGE_PIX_TYPE_RGB888};
+    for (int i = 0; i < width * height * 3; i++) {
+        ((uint8_t *)img.data)[i] = (i * 7 + i / 300) & 0xff;
+    }
+    img_t canvas = {.data = nullptr,
+                    .width = width + 16,
+                    .height = height + 8,
+                    .pix_type = DL_IMAGE_PIX_TYPE_RGB888,
+                    .stride = (width + 16) * 3 + 4};
+    size_t canvas_size = canvas.stride * canvas.height;
+    canvas.data = heap_caps_malloc(canvas_size, MALLOC_CAP_DEFAULT);
+    memset(canvas.data, 0xa5, canvas_size);
+    img_t sub_img = get_sub_img(canvas, {x0, y0, x0 + width, y0 + height});
+    TEST_ASSERT_FALSE(is_img_packed(sub_img));
+    for (int i = 0; i < height; i++) {
+        memcpy(get_img_row(sub_img, i), get_img_row(img, i), width * 3);
+    }
+
+    img_t dst = {.data = heap_caps_malloc(40 * 30 * 3, MALLOC_CAP_DEFAULT),
+                 .width = 40,
+                 .height = 30,
+                 .pix_type = DL_IMAGE_PIX_TYPE_RGB888};
+    img_t ref = dst;
+    ref.data = heap_caps_malloc(40 * 30 * 3, MALLOC_CAP_DEFAULT);
+    for (auto interpolate_type : {DL_IMAGE_INTERPOLATE_BILINEAR, DL_IMAGE_INTERPOLATE_NEAREST}) {
+        resize(img, ref, interpolate_type, DL_IMAGE_CAP_RGB_SWAP);
+        resize(sub_img, dst, interpolate_type, DL_IMAGE_CAP_RGB_SWAP);
+        TEST_ASSERT_TRUE(img_equal(ref, dst));
+        resize(img, ref, interpolate_type, 0, nullptr, {10, 6, 70, 50});
+        resize(sub_img, dst, interpolate_type, 0, nullptr, {10, 6, 70, 50});
+        TEST_ASSERT_TRUE(img_equal(ref, dst));
+    }
+
+    // Resize into a rectangle of a bigger image, the pixels around it are left untouched.
+    uint8_t *out_buf = (uint8_t *)heap_caps_malloc(64 * 40 * 3, MALLOC_CAP_DEFAULT);
+    memset(out_buf, 0x5a, 64 * 40 * 3);
+    img_t out = {.data = out_buf, .width = 64, .height = 40, .pix_type = DL_IMAGE_PIX_TYPE_RGB888};
+    img_t out_sub = get_sub_img(out, {12, 5, 52, 35});
+    resize(img, ref, DL_IMAGE_INTERPOLATE_BILINEAR);
+    resize(sub_img, out_sub, DL_IMAGE_INTERPOLATE_BILINEAR);
+    TEST_ASSERT_TRUE(img_equal(ref, out_sub));
+    TEST_ASSERT_EQUAL(0, count_changed_outside(out, {12, 5, 52, 35}, 0x5a));
+
+    img_t rgb565 = {.data = heap_caps_malloc(width * height * 2, MALLOC_CAP_DEFAULT),
+                    .width = width,
+                    .height = height,
+                    .pix_type = DL_IMAGE_PIX_TYPE_RGB565};
+    img_t ref_rgb565 = rgb565;
+    ref_rgb565.data = heap_caps_malloc(width * height * 2, MALLOC_CAP_DEFAULT);
+    convert_img(img, ref_rgb565);
+    convert_img(sub_img, rgb565);
+    TEST_ASSERT_TRUE(img_equal(ref_rgb565, rgb565));
+    convert_img(img, ref_rgb565, 0, nullptr, {3, 5, 50, 60});
+    convert_img(sub_img, rgb565, 0, nullptr, {3, 5, 50, 60});
+    TEST_ASSERT_TRUE(img_equal(ref_rgb565, rgb565));
+
+    dl::math::Matrix<float> M_inv(2, 3);
+    M_inv.array[0][0] = 1.3f;
+    M_inv.array[0][1] = -0.4f;
+    M_inv.array[0][2] = 30.f;
+    M_inv.array[1][0] = 0.4f;
+    M_inv.array[1][1] = 1.3f;
+    M_inv.array[1][2] = 5.f;
+    for (auto interpolate_type : {DL_IMAGE_INTERPOLATE_BILINEAR, DL_IMAGE_INTERPOLATE_NEAREST}) {
+        warp_affine(img, ref, interpolate_type, &M_inv);
+        warp_affine(sub_img, dst, interpolate_type, &M_inv);
+        TEST_ASSERT_TRUE(img_equal(ref, dst));
+    }
+
+    // Drawing does not touch the padding.
+    draw_hollow_rectangle(img, 5, 5, 60, 40, {255, 0, 0}, 3);
+    draw_hollow_rectangle(sub_img, 5, 5, 60, 40, {255, 0, 0}, 3);
+    draw_point(img, 90, 60, {0, 255, 0}, 5);
+    draw_point(sub_img, 90, 60, {0, 255, 0}, 5);
+    TEST_ASSERT_TRUE(img_equal(img, sub_img));
+    TEST_ASSERT_EQUAL(0, count_changed_outside(canvas, {x0, y0, x0 + width, y0 + height}, 0xa5));
+
+    heap_caps_free(img.data);
+    heap_caps_free(canvas.data);
+    heap_caps_free(dst.data);
+    heap_caps_free(ref.data);
+    heap_caps_free(out_buf);
+    heap_caps_free(rgb565.data);
+    heap_caps_free(ref_rgb565.data);
+}
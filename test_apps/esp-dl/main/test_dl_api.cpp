@@ -1,10 +1,18 @@
 #include "dl_model_base.hpp"
 #include "dl_module_add.hpp"
+#include "dl_module_anchor_box_decode.hpp"
+#include "dl_module_anchor_point_decode.hpp"
+#include "dl_module_conv.hpp"
 #include "dl_module_creator.hpp"
+#include "dl_module_dfl.hpp"
+#include "dl_module_gru.hpp"
+#include "dl_module_lstm.hpp"
+#include "dl_module_non_max_suppression.hpp"
 #include "dl_module_relu.hpp"
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "unity.h"
+#include <functional>
 #include <type_traits>
 static const char *TAG = "TEST DL MODEL";
 
@@ -127,3 +135,750 @@ TEST_CASE("Test dl module API: run()", "[api]")
     int total_ram_size_end = heap_caps_get_free_size(MALLOC_CAP_8BIT);
     TEST_ASSERT_EQUAL(true, total_ram_size_before == total_ram_size_end);
 }
+
+TEST_CASE("Test dl module API: detection postprocess", "[api]")
+{
+    ESP_LOGI(TAG, "Test dl module API: detection postprocess");
+    int total_ram_size_before = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+
+    // Anchor-free decoding of a 1x2 stage with stride 8.
+    float distance[8] = {1, 1, 1, 1, 0.5, 1, 2, 0};
+    TensorBase *distance_tensor = new TensorBase({1, 1, 2, 4}, distance, 0, DATA_TYPE_FLOAT, false);
+    TensorBase *box_tensor = new TensorBase({1, 2, 4}, nullptr, 0, DATA_TYPE_FLOAT);
+    module::Module *decode_op =
+        new module::AnchorPointDecode("decode", 8, 8, 4, 4, MODULE_NON_INPLACE, QUANT_TYPE_FLOAT32);
+    decode_op->run(distance_tensor, box_tensor);
+    float box_ref[8] = {-4, -4, 12, 12, 8, -4, 28, 4};
+    for (int i = 0; i < 8; i++) {
+        TEST_ASSERT_EQUAL_FLOAT(box_ref[i], box_tensor->get_element<float>(i));
+    }
+
+    // DFL of an int8 graph writes float distances, the decoding of the quantized node reads them as float
+    int reg_max = 4;
+    int bins[8] = {1, 1, 1, 1, 0, 1, 2, 3};
+    TensorBase *logits_tensor = new TensorBase({1, 1, 2, 4 * reg_max}, nullptr, -4, DATA_TYPE_INT8);
+    for (int i = 0; i < 8; i++) {
+        for (int j = 0; j < reg_max; j++) {
+            ((int8_t *)logits_tensor->data)[i * reg_max + j] = j == bins[i] ? 127 : -128;
+        }
+    }
+    TensorBase *bins_tensor = new TensorBase({1, 1, 2, 4}, nullptr, 0, DATA_TYPE_FLOAT);
+    module::Module *dfl_op = new module::DFL("dfl", reg_max, MODULE_NON_INPLACE, QUANT_TYPE_SYMM_8BIT);
+    module::Module *decode_int8_op =
+        new module::AnchorPointDecode("decode", 8, 8, 4, 4, MODULE_NON_INPLACE, QUANT_TYPE_SYMM_8BIT);
+    dfl_op->run(logits_tensor, bins_tensor);
+    decode_int8_op->run(bins_tensor, box_tensor);
+    float bins_box_ref[8] = {-4, -4, 12, 12, 12, -4, 28, 28};
+    for (int i = 0; i < 8; i++) {
+        TEST_ASSERT_FLOAT_WITHIN(0.01, bins_box_ref[i], box_tensor->get_element<float>(i));
+    }
+
+    // anchor boxes [h, w] of 16x8 and 32x32 on a cell of stride 16, from int8 and from float offsets
+    float offset[8] = {1, -1, 0, 2, 0, 0, 0, 0};
+    TensorBase *offset_tensor = new TensorBase({1, 1, 1, 8}, offset, 0, DATA_TYPE_FLOAT, false);
+    TensorBase *offset_int8_tensor = new TensorBase({1, 1, 1, 8}, nullptr, -2, DATA_TYPE_INT8);
+    for (int i = 0; i < 8; i++) {
+        ((int8_t *)offset_int8_tensor->data)[i] = offset[i] * 4;
+    }
+    TensorBase *anchor_box_tensor = new TensorBase({1, 2, 4}, nullptr, 0, DATA_TYPE_FLOAT);
+    module::Module *anchor_op =
+        new module::AnchorBoxDecode("anchor", 16, 16, 8, 8, {16, 8, 32, 32}, MODULE_NON_INPLACE, QUANT_TYPE_SYMM_8BIT);
+    float anchor_box_ref[8] = {12, -16, 12, 48, -8, -8, 24, 24};
+    for (TensorBase *input : {offset_tensor, offset_int8_tensor}) {
+        anchor_op->run(input, anchor_box_tensor);
+        for (int i = 0; i < 8; i++) {
+            TEST_ASSERT_EQUAL_FLOAT(anchor_box_ref[i], anchor_box_tensor->get_element<float>(i));
+        }
+    }
+
+    // onnx nonmaxsuppression_suppress_by_IOU
+    float boxes[24] = {0, 0, 1, 1, 0, 0.1, 1, 1.1, 0, -0.1, 1, 0.9, 0, 10, 1, 11, 0, 10.1, 1, 11.1, 0, 100, 1, 101};
+    float scores[6] = {0.9, 0.75, 0.6, 0.95, 0.5, 0.3};
+    TensorBase *boxes_tensor = new TensorBase({1, 6, 4}, boxes, 0, DATA_TYPE_FLOAT, false);
+    TensorBase *scores_tensor = new TensorBase({1, 1, 6}, scores, 0, DATA_TYPE_FLOAT, false);
+    TensorBase *selected_tensor = new TensorBase({4, 3}, nullptr, 0, DATA_TYPE_INT64);
+    module::Module *nms_op = new module::NonMaxSuppression("nms", 4, 0.5, 0, true, 0, QUANT_TYPE_FLOAT32);
+    nms_op->run({boxes_tensor, scores_tensor}, {selected_tensor});
+    int64_t selected_ref[12] = {0, 0, 3, 0, 0, 0, 0, 0, 5, -1, -1, -1};
+    for (int i = 0; i < 12; i++) {
+        TEST_ASSERT_EQUAL(selected_ref[i], selected_tensor->get_element<int64_t>(i));
+    }
+
+    delete distance_tensor;
+    delete box_tensor;
+    delete boxes_tensor;
+    delete scores_tensor;
+    delete selected_tensor;
+    delete logits_tensor;
+    delete bins_tensor;
+    delete offset_tensor;
+    delete offset_int8_tensor;
+    delete anchor_box_tensor;
+    delete decode_op;
+    delete dfl_op;
+    delete decode_int8_op;
+    delete anchor_op;
+    delete nms_op;
+
+    int total_ram_size_end = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    TEST_ASSERT_EQUAL(true, total_ram_size_before == total_ram_size_end);
+}
+
+TEST_CASE("Test dl tensor API: ring buffer push", "[api]")
+{
+    ESP_LOGI(TAG, "Test dl tensor API: ring buffer push");
+    int total_ram_size_before = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+
+    // int8 frames of 16 bytes keep the window aligned, int16 frames of 10 bytes don't
+    std::vector<std::vector<int>> shapes = {{1, 10, 16}, {1, 7, 5}};
+    std::vector<dtype_t> dtypes = {DATA_TYPE_INT8, DATA_TYPE_INT16};
+    for (int t = 0; t < 2; t++) {
+        std::vector<int> shape = shapes[t];
+        TensorBase *window = new TensorBase(shape, nullptr, 0, dtypes[t]);
+        TensorBase *ring = new TensorBase(shape, nullptr, 0, dtypes[t]);
+        TEST_ASSERT_EQUAL(false, ring->enable_ring_buffer(2));
+        TEST_ASSERT_EQUAL(true, ring->enable_ring_buffer(1));
+
+        int frame_size = shape[2] * window->get_dtype_bytes();
+        std::vector<uint8_t> frames(shape[1] * frame_size);
+        for (int step = 0; step < 50; step++) {
+            int num = 1 + step % 3;
+            if (step % 10 == 9) {
+                num = shape[1];
+            }
+            for (int i = 0; i < num * frame_size; i++) {
+                frames[i] = rand();
+            }
+            TensorBase *new_frames = new TensorBase({1, num, shape[2]}, frames.data(), 0, dtypes[t], false);
+            window->push(new_frames, 1);
+            ring->push(new_frames, 1);
+            TEST_ASSERT_EQUAL(0, memcmp(window->data, ring->data, window->get_bytes()));
+            if (t == 0) {
+                TEST_ASSERT_EQUAL(0, (uintptr_t)ring->data & 0xf);
+            }
+            delete new_frames;
+        }
+        delete window;
+        delete ring;
+    }
+
+    int total_ram_size_end = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    TEST_ASSERT_EQUAL(true, total_ram_size_before == total_ram_size_end);
+}
+
+static std::vector<int> get_coordinates(int index, const std::vector<int> &shape)
+{
+    std::vector<int> coords(shape.size());
+    for (int i = shape.size() - 1; i >= 0; i--) {
+        coords[i] = index % shape[i];
+        index /= shape[i];
+    }
+    return coords;
+}
+
+static int get_index(const std::vector<int> &coords, const std::vector<int> &shape)
+{
+    int index = 0;
+    for (int i = 0; i < shape.size(); i++) {
+        index = index * shape[i] + coords[i];
+    }
+    return index;
+}
+
+TEST_CASE("Test dl tensor API: transpose, slice, pad and flip", "[api]")
+{
+    ESP_LOGI(TAG, "Test dl tensor API: transpose, slice, pad and flip");
+    int total_ram_size_before = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+
+    const int repeat = 10;
+    std::vector<int> shape = {1, 24, 20, 32};
+    TensorBase *input = new TensorBase(shape, nullptr, 0, DATA_TYPE_INT8);
+    for (int i = 0; i < input->get_size(); i++) {
+        input->get_element_ptr<int8_t>()[i] = rand();
+    }
+    int8_t *input_element = input->get_element_ptr<int8_t>();
+    // compares the output with an element-wise gather of a precomputed index table, -1 for the pad value, and logs
+    // the time of both on the target. The gather doesn't compute the indices, so it is faster than the element-wise
+    // loops the fast paths replaced, not a measure of them.
+    auto check = [&](const char *name, TensorBase *output, std::function<void()> run, std::function<int(int)> index) {
+        int size = output->get_size();
+        std::vector<int> table(size);
+        for (int o = 0; o < size; o++) {
+            table[o] = index(o);
+        }
+        std::vector<int8_t> ref(size);
+        int64_t start = esp_timer_get_time();
+        for (int i = 0; i < repeat; i++) {
+            for (int o = 0; o < size; o++) {
+                ref[o] = table[o] < 0 ? 7 : input_element[table[o]];
+            }
+        }
+        int64_t ref_time = esp_timer_get_time() - start;
+        start = esp_timer_get_time();
+        for (int i = 0; i < repeat; i++) {
+            run();
+        }
+        int64_t time = esp_timer_get_time() - start;
+        ESP_LOGI(TAG, "%s: %lld us, element-wise %lld us", name, time / repeat, ref_time / repeat);
+        TEST_ASSERT_EQUAL(0, memcmp(ref.data(), output->data, size));
+    };
+
+    // NCHW->NHWC, NHWC->NCHW, last two axes, inner axis in place, generic and reversed axes
+    std::vector<std::vector<int>> perms = {{0, 2, 3, 1}, {0, 3, 1, 2}, {0, 1, 3, 2}, {2, 0, 1, 3}, {1, 3, 0, 2}, {}};
+    for (std::vector<int> perm : perms) {
+        if (perm.empty()) {
+            perm = {3, 2, 1, 0};
+        }
+        std::vector<int> output_shape = {shape[perm[0]], shape[perm[1]], shape[perm[2]], shape[perm[3]]};
+        TensorBase *output = new TensorBase(output_shape, nullptr, 0, DATA_TYPE_INT8);
+        auto run = [&]() { output->transpose(input, perm); };
+        auto index = [&](int o) {
+            std::vector<int> coords = get_coordinates(o, output_shape), input_coords(4);
+            for (int i = 0; i < 4; i++) {
+                input_coords[perm[i]] = coords[i];
+            }
+            return get_index(input_coords, shape);
+        };
+        char name[40];
+        snprintf(name, sizeof(name), "transpose {%d, %d, %d, %d}", perm[0], perm[1], perm[2], perm[3]);
+        check(name, output, run, index);
+        delete output;
+    }
+
+    // channels in the middle given with all axes, every other column
+    TensorBase *output = new TensorBase({1, 16, 20, 32}, nullptr, 0, DATA_TYPE_INT8);
+    auto slice_channels = [&]() { TensorBase::slice(input, output, {0, 4, 0, 0}, {1, 20, 20, 32}, {0, 1, 2, 3}); };
+    auto channels_index = [&](int o) {
+        std::vector<int> coords = get_coordinates(o, output->shape);
+        coords[1] += 4;
+        return get_index(coords, shape);
+    };
+    check("slice channels", output, slice_channels, channels_index);
+    delete output;
+
+    output = new TensorBase({1, 24, 20, 16}, nullptr, 0, DATA_TYPE_INT8);
+    auto slice_columns = [&]() { TensorBase::slice(input, output, {1}, {32}, {3}, {2}); };
+    auto columns_index = [&](int o) {
+        std::vector<int> coords = get_coordinates(o, output->shape);
+        coords[3] = coords[3] * 2 + 1;
+        return get_index(coords, shape);
+    };
+    check("slice columns", output, slice_columns, columns_index);
+    delete output;
+
+    // constant border of a conv input
+    int8_t pad_value = 7;
+    TensorBase *const_value = new TensorBase({1}, &pad_value, 0, DATA_TYPE_INT8);
+    output = new TensorBase({1, 24, 22, 34}, nullptr, 0, DATA_TYPE_INT8);
+    auto pad = [&]() { output->pad(input, {0, 0, 1, 1, 0, 0, 1, 1}, PADDING_CONSTANT, const_value); };
+    auto pad_index = [&](int o) {
+        std::vector<int> coords = get_coordinates(o, output->shape);
+        coords[2] -= 1;
+        coords[3] -= 1;
+        if (coords[2] < 0 || coords[2] >= shape[2] || coords[3] < 0 || coords[3] >= shape[3]) {
+            return -1;
+        }
+        return get_index(coords, shape);
+    };
+    check("pad constant", output, pad, pad_index);
+    delete output;
+    delete const_value;
+
+    // flip twice to time it on the same data, and a slice with negative steps
+    output = new TensorBase(shape, input_element, 0, DATA_TYPE_INT8);
+    auto flip = [&]() { output->flip<int8_t>({1, 3})->flip<int8_t>({1, 3}); };
+    check("flip", output, flip, [](int o) { return o; });
+    auto slice_reversed = [&]() { TensorBase::slice(input, output, {-1, -1}, {-100, -100}, {1, 3}, {-1, -1}); };
+    auto reversed_index = [&](int o) {
+        std::vector<int> coords = get_coordinates(o, shape);
+        coords[1] = shape[1] - 1 - coords[1];
+        coords[3] = shape[3] - 1 - coords[3];
+        return get_index(coords, shape);
+    };
+    check("slice reversed", output, slice_reversed, reversed_index);
+    delete output;
+    delete input;
+
+    int total_ram_size_end = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    TEST_ASSERT_EQUAL(true, total_ram_size_before == total_ram_size_end);
+}
+
+TEST_CASE("Test dl module API: streaming conv", "[api]")
+{
+    ESP_LOGI(TAG, "Test dl module API: streaming conv");
+    int total_ram_size_before = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+
+    // causal dilated conv, strided conv with padding on both sides and causal depthwise conv
+    std::vector<std::vector<int>> input_shapes = {{1, 16, 16}, {1, 20, 8}, {1, 12, 16}};
+    std::vector<std::vector<int>> filter_shapes = {{3, 16, 16}, {3, 8, 8}, {5, 1, 16}};
+    std::vector<std::vector<int>> pads = {{4, 0}, {1, 1}, {4, 0}};
+    std::vector<int> dilations = {2, 1, 1};
+    std::vector<int> strides = {1, 2, 1};
+    std::vector<int> groups = {1, 1, 16};
+    std::vector<int> hops = {2, 4, 1};
+    std::vector<quant_type_t> quant_types = {QUANT_TYPE_SYMM_8BIT, QUANT_TYPE_SYMM_16BIT, QUANT_TYPE_SYMM_8BIT};
+    for (int t = 0; t < input_shapes.size(); t++) {
+        dtype_t dtype = quant_types[t] == QUANT_TYPE_SYMM_8BIT ? DATA_TYPE_INT8 : DATA_TYPE_INT16;
+        TensorBase *input = new TensorBase(input_shapes[t], nullptr, 0, dtype);
+        TensorBase *filter = new TensorBase(filter_shapes[t], nullptr, 0, dtype);
+        for (int i = 0; i < filter->get_bytes(); i++) {
+            ((int8_t *)filter->data)[i] = rand() % 7 - 3;
+        }
+
+        // the streaming conv and the conv over the whole window, both without bias
+        ModelContext context;
+        std::vector<module::Conv *> convs;
+        std::vector<TensorBase *> outputs;
+        for (int i = 0; i < 2; i++) {
+            module::Conv *conv = new module::Conv(
+                Linear, pads[t], {dilations[t]}, {strides[t]}, "conv", groups[t], quant_types[t]);
+            std::vector<std::vector<int>> shapes = {input_shapes[t], filter_shapes[t]};
+            TensorBase *output = new TensorBase(conv->get_output_shape(shapes)[0], nullptr, 2, dtype);
+            conv->m_inputs_index = {context.push_back_tensor(input), context.push_back_tensor(filter)};
+            conv->m_outputs_index = {context.push_back_tensor(output)};
+            convs.push_back(conv);
+            outputs.push_back(output);
+        }
+        TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, convs[0]->set_streaming(&context, input_shapes[t][1]));
+        TEST_ASSERT_EQUAL(ESP_OK, convs[0]->set_streaming(&context, hops[t]));
+
+        std::vector<int> frame_shape = {1, hops[t], input_shapes[t][2]};
+        TensorBase *frames = new TensorBase(frame_shape, nullptr, 0, dtype);
+        for (int step = 0; step < 30; step++) {
+            if (step == 20) {
+                // a window which doesn't move by hop frames needs a reset
+                for (int i = 0; i < input->get_bytes(); i++) {
+                    ((int8_t *)input->data)[i] = rand();
+                }
+                convs[0]->reset_streaming();
+            } else {
+                for (int i = 0; i < frames->get_bytes(); i++) {
+                    ((int8_t *)frames->data)[i] = rand();
+                }
+                input->push(frames, 1);
+            }
+            if (step >= 10 && step < 13) {
+                // skipped runs, the next run after Model::skip_run() drops the state and computes the whole window
+                continue;
+            } else if (step == 13) {
+                convs[0]->reset_streaming();
+            }
+            convs[0]->forward(&context);
+            convs[1]->forward(&context);
+            TEST_ASSERT_EQUAL(0, memcmp(outputs[0]->data, outputs[1]->data, outputs[0]->get_bytes()));
+        }
+
+        for (int i = 0; i < 2; i++) {
+            delete convs[i];
+            delete outputs[i];
+        }
+        delete frames;
+        delete input;
+        delete filter;
+    }
+
+    int total_ram_size_end = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    TEST_ASSERT_EQUAL(true, total_ram_size_before == total_ram_size_end);
+}
+
+/**
+ * @brief Reads the fused weights of an RNN through its Gemm. The Gemm kernels read the filters output channel first
+ * for the ansi kernels and in blocks of output channels for esp32s3 and esp32p4, so the float reference takes the
+ * weights the kernels actually use.
+ */
+class TestRNNWeights : public module::GRU {
+public:
+    TestRNNWeights(quant_type_t quant_type) : module::GRU("gru", 1, 0, quant_type) {}
+
+    /**
+     * @brief Filter [1, 1, rows, columns] as [rows, columns] floats, the Gemm of an identity matrix.
+     */
+    template <typename T>
+    std::vector<float> read(TensorBase *filter)
+    {
+        int rows = filter->shape[2], columns = filter->shape[3];
+        TensorBase *eye = new TensorBase({1, 1, rows, rows}, nullptr, 0, filter->dtype);
+        for (int i = 0; i < rows; i++) {
+            ((T *)eye->data)[i * rows + i] = 1;
+        }
+        TensorBase *output = new TensorBase({1, 1, rows, columns}, nullptr, filter->exponent, filter->dtype);
+        gemm<T>(eye, filter, nullptr, output, RUNTIME_MODE_SINGLE_CORE);
+        std::vector<float> values(rows * columns);
+        for (int i = 0; i < rows * columns; i++) {
+            values[i] = ((T *)output->data)[i] * DL_SCALE(filter->exponent);
+        }
+        delete eye;
+        delete output;
+        return values;
+    }
+};
+
+// float GRU (linear_before_reset = 1) or LSTM over the dequantized tensors, y [seq_length, batch_size, hidden_size].
+// w [input_size, columns] and r [hidden_size, columns] are the weights read by TestRNNWeights.
+static void ref_rnn(bool lstm,
+                    TensorBase *x,
+                    const std::vector<float> &w,
+                    const std::vector<float> &r,
+                    TensorBase *b,
+                    int hidden_size,
+                    float *y)
+{
+    int seq_length = x->shape[0], batch_size = x->shape[1], input_size = x->shape[2];
+    int gates = lstm ? 4 : 3;
+    int columns = gates * hidden_size;
+    std::vector<float> h(batch_size * hidden_size, 0), c(batch_size * hidden_size, 0);
+    std::vector<float> gx(columns), gh(columns);
+    auto value = [](TensorBase *t, int i) {
+        switch (t->dtype) {
+        case DATA_TYPE_INT8:
+            return ldexpf(((int8_t *)t->data)[i], t->exponent);
+        case DATA_TYPE_INT16:
+            return ldexpf(((int16_t *)t->data)[i], t->exponent);
+        case DATA_TYPE_INT32:
+            return ldexpf(((int32_t *)t->data)[i], t->exponent);
+        default:
+            return ldexpf(((int64_t *)t->data)[i], t->exponent);
+        }
+    };
+    auto sigmoid = [](float v) { return 1.f / (1.f + expf(-v)); };
+    for (int t = 0; t < seq_length; t++) {
+        for (int n = 0; n < batch_size; n++) {
+            for (int k = 0; k < columns; k++) {
+                gx[k] = value(b, k);
+                gh[k] = value(b, columns + k);
+                for (int i = 0; i < input_size; i++) {
+                    gx[k] += value(x, (t * batch_size + n) * input_size + i) * w[i * columns + k];
+                }
+                for (int i = 0; i < hidden_size; i++) {
+                    gh[k] += h[n * hidden_size + i] * r[i * columns + k];
+                }
+            }
+            for (int j = 0; j < hidden_size; j++) {
+                float &hj = h[n * hidden_size + j];
+                if (lstm) {
+                    float i_gate = sigmoid(gx[j] + gh[j]);
+                    float o_gate = sigmoid(gx[hidden_size + j] + gh[hidden_size + j]);
+                    float f_gate = sigmoid(gx[2 * hidden_size + j] + gh[2 * hidden_size + j]);
+                    float c_gate = tanhf(gx[3 * hidden_size + j] + gh[3 * hidden_size + j]);
+                    float &cj = c[n * hidden_size + j];
+                    cj = f_gate * cj + i_gate * c_gate;
+                    hj = o_gate * tanhf(cj);
+                } else {
+                    float z = sigmoid(gx[j] + gh[j]);
+                    float rg = sigmoid(gx[hidden_size + j] + gh[hidden_size + j]);
+                    float nt = tanhf(gx[2 * hidden_size + j] + rg * gh[2 * hidden_size + j]);
+                    hj = (1 - z) * nt + z * hj;
+                }
+            }
+        }
+        memcpy(y + t * batch_size * hidden_size, h.data(), batch_size * hidden_size * sizeof(float));
+    }
+}
+
+TEST_CASE("Test dl module API: streaming GRU and LSTM", "[api]")
+{
+    ESP_LOGI(TAG, "Test dl module API: streaming GRU and LSTM");
+    int total_ram_size_before = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+
+    int input_size = 8, hidden_size = 8, batch_size = 2;
+    int seq_length = 6, hop = 2, runs = 8;
+    int total_length = seq_length + hop * (runs - 1);
+    for (int lstm = 0; lstm < 2; lstm++) {
+        for (int bits = 8; bits <= 16; bits += 8) {
+            quant_type_t quant_type = bits == 8 ? QUANT_TYPE_SYMM_8BIT : QUANT_TYPE_SYMM_16BIT;
+            dtype_t dtype = bits == 8 ? DATA_TYPE_INT8 : DATA_TYPE_INT16;
+            int columns = (lstm ? 4 : 3) * hidden_size;
+            int num_outputs = lstm ? 3 : 2;
+            int gate_exponent = bits == 8 ? -4 : -11;
+            // x in [-4, 4), weights in [-0.3, 0.3], biases in [-0.5, 0.5]
+            int x_exponent = 4 - bits, w_exponent = 2 - bits;
+            TensorBase *stream = new TensorBase({total_length, batch_size, input_size}, nullptr, x_exponent, dtype);
+            TensorBase *w = new TensorBase({1, 1, input_size, columns}, nullptr, w_exponent, dtype);
+            TensorBase *r = new TensorBase({1, 1, hidden_size, columns}, nullptr, w_exponent, dtype);
+            TensorBase *b = new TensorBase(
+                {1, 2 * columns}, nullptr, -2 * bits, bits == 8 ? DATA_TYPE_INT32 : DATA_TYPE_INT64);
+            // random values in [-range / 2, range / 2) scaled by num / den
+            auto fill = [](TensorBase *t, int range, int num, int den) {
+                for (int i = 0; i < t->get_size(); i++) {
+                    int64_t value = (int64_t)(rand() % range - range / 2) * num / den;
+                    if (t->dtype == DATA_TYPE_INT8) {
+                        ((int8_t *)t->data)[i] = value;
+                    } else if (t->dtype == DATA_TYPE_INT16) {
+                        ((int16_t *)t->data)[i] = value;
+                    } else if (t->dtype == DATA_TYPE_INT32) {
+                        ((int32_t *)t->data)[i] = value;
+                    } else {
+                        ((int64_t *)t->data)[i] = value;
+                    }
+                }
+            };
+            int range = 1 << (bits - 1);
+            fill(stream, range, 1, 1);
+            fill(w, range, 3, 10);
+            fill(r, range, 3, 10);
+            fill(b, range, 1 << (bits + 1), 1);
+
+            // the streaming module over a window moving by hop frames, a module over the whole stream and a module
+            // over the window
+            ModelContext context;
+            TensorBase *window = new TensorBase({seq_length, batch_size, input_size}, nullptr, x_exponent, dtype);
+            std::vector<TensorBase *> inputs = {window, stream, window};
+            std::vector<module::RNN *> rnns;
+            std::vector<std::vector<TensorBase *>> outputs(3);
+            for (int i = 0; i < 3; i++) {
+                module::RNN *rnn = nullptr;
+                if (lstm) {
+                    rnn = new module::LSTM("lstm", hidden_size, gate_exponent, quant_type);
+                } else {
+                    rnn = new module::GRU("gru", hidden_size, gate_exponent, quant_type);
+                }
+                std::vector<std::vector<int>> shapes = {inputs[i]->shape};
+                std::vector<std::vector<int>> output_shapes = rnn->get_output_shape(shapes);
+                rnn->m_inputs_index = {context.push_back_tensor(inputs[i]),
+                                       context.push_back_tensor(w),
+                                       context.push_back_tensor(r),
+                                       context.push_back_tensor(b)};
+                for (int j = 0; j < num_outputs; j++) {
+                    // Y and Y_h in [-1, 1), Y_c in [-4, 4)
+                    int exponent = (j == 2 ? 3 : 1) - bits;
+                    TensorBase *output = new TensorBase(output_shapes[j], nullptr, exponent, dtype);
+                    rnn->m_outputs_index.push_back(context.push_back_tensor(output));
+                    outputs[i].push_back(output);
+                }
+                rnns.push_back(rnn);
+            }
+            TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, rnns[0]->set_streaming(&context, seq_length + 1));
+            TEST_ASSERT_EQUAL(ESP_OK, rnns[0]->set_streaming(&context, hop));
+
+            size_t frame_bytes = batch_size * input_size * stream->get_dtype_bytes();
+            for (int k = 0; k < runs; k++) {
+                memcpy(window->data, (int8_t *)stream->data + k * hop * frame_bytes, seq_length * frame_bytes);
+                rnns[0]->forward(&context);
+            }
+            rnns[1]->forward(&context);
+            size_t y_bytes = outputs[0][0]->get_bytes();
+            int8_t *y_last = (int8_t *)outputs[1][0]->data + outputs[1][0]->get_bytes() - y_bytes;
+            TEST_ASSERT_EQUAL(0, memcmp(outputs[0][0]->data, y_last, y_bytes));
+            for (int j = 1; j < num_outputs; j++) {
+                TEST_ASSERT_EQUAL(0, memcmp(outputs[0][j]->data, outputs[1][j]->data, outputs[0][j]->get_bytes()));
+            }
+
+            // after a reset the window starts from zero states like the first frames of the stream
+            rnns[0]->reset_streaming();
+            memcpy(window->data, stream->data, seq_length * frame_bytes);
+            rnns[0]->forward(&context);
+            TEST_ASSERT_EQUAL(0, memcmp(outputs[0][0]->data, outputs[1][0]->data, y_bytes));
+
+            // the runs of the windows 2 and 3 are skipped, after Model::skip_run() the window 4 runs from zero states
+            // like the module over the window alone
+            memcpy(window->data, (int8_t *)stream->data + hop * frame_bytes, seq_length * frame_bytes);
+            rnns[0]->forward(&context);
+            memcpy(window->data, (int8_t *)stream->data + 4 * hop * frame_bytes, seq_length * frame_bytes);
+            rnns[0]->reset_streaming();
+            rnns[0]->forward(&context);
+            rnns[2]->forward(&context);
+            for (int j = 0; j < num_outputs; j++) {
+                TEST_ASSERT_EQUAL(0, memcmp(outputs[0][j]->data, outputs[2][j]->data, outputs[0][j]->get_bytes()));
+            }
+
+            // Y of the whole stream against the float reference
+            TestRNNWeights weights(quant_type);
+            std::vector<float> w_ref = bits == 8 ? weights.read<int8_t>(w) : weights.read<int16_t>(w);
+            std::vector<float> r_ref = bits == 8 ? weights.read<int8_t>(r) : weights.read<int16_t>(r);
+#if !CONFIG_TIE728_BOOST && !CONFIG_ESP32P4_BOOST
+            // the ansi kernels read the filters output channel first
+            for (int i = 0; i < input_size * columns; i++) {
+                int value = bits == 8 ? w->get_element<int8_t>(i) : w->get_element<int16_t>(i);
+                TEST_ASSERT_EQUAL_FLOAT(value * DL_SCALE(w->exponent),
+                                        w_ref[(i % input_size) * columns + i / input_size]);
+            }
+#endif
+            TensorBase *y = outputs[1][0];
+            std::vector<float> ref(y->get_size());
+            ref_rnn(lstm, stream, w_ref, r_ref, b, hidden_size, ref.data());
+            float max_err = 0;
+            for (int i = 0; i < y->get_size(); i++) {
+                int value = bits == 8 ? y->get_element<int8_t>(i) : y->get_element<int16_t>(i);
+                float err = fabsf(value * DL_SCALE(y->exponent) - ref[i]);
+                max_err = err > max_err ? err : max_err;
+            }
+            ESP_LOGI(TAG, "%s int%d: max abs error %f", lstm ? "LSTM" : "GRU", bits, max_err);
+            TEST_ASSERT_LESS_THAN_FLOAT(bits == 8 ? 0.1 : 0.01, max_err);
+
+            for (int i = 0; i < 3; i++) {
+                delete rnns[i];
+                for (int j = 0; j < num_outputs; j++) {
+                    delete outputs[i][j];
+                }
+            }
+            delete window;
+            delete stream;
+            delete w;
+            delete r;
+            delete b;
+        }
+    }
+
+    // only the fused layout of the weights is supported, not the ONNX one, and no sequence_lens
+    std::vector<int> x_shape = {seq_length, batch_size, input_size};
+    std::vector<int> w_shape = {1, 1, input_size, 3 * hidden_size};
+    std::vector<int> r_shape = {1, 1, hidden_size, 3 * hidden_size};
+    std::vector<int> b_shape = {1, 6 * hidden_size};
+    TEST_ASSERT_EQUAL(ESP_OK, module::RNN::check_inputs("gru", 3, hidden_size, {x_shape, w_shape, r_shape, b_shape}));
+    TEST_ASSERT_EQUAL(ESP_OK, module::RNN::check_inputs("gru", 3, hidden_size, {x_shape, w_shape, r_shape, {}, {}}));
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_SUPPORTED,
+                      module::RNN::check_inputs("lstm", 4, hidden_size, {x_shape, w_shape, r_shape, b_shape}));
+    TEST_ASSERT_EQUAL(
+        ESP_ERR_NOT_SUPPORTED,
+        module::RNN::check_inputs("gru", 3, hidden_size, {x_shape, {1, 3 * hidden_size, input_size}, r_shape}));
+    TEST_ASSERT_EQUAL(
+        ESP_ERR_NOT_SUPPORTED,
+        module::RNN::check_inputs("gru", 3, hidden_size, {x_shape, w_shape, {1, 3 * hidden_size, hidden_size}}));
+    TEST_ASSERT_EQUAL(
+        ESP_ERR_NOT_SUPPORTED,
+        module::RNN::check_inputs("gru", 3, hidden_size, {x_shape, w_shape, r_shape, {1, 3 * hidden_size}}));
+    TEST_ASSERT_EQUAL(ESP_ERR_NOT_SUPPORTED,
+                      module::RNN::check_inputs("gru", 3, hidden_size, {x_shape, w_shape, r_shape, b_shape, {2}}));
+
+    // a module with weights in the ONNX layout doesn't run
+    ModelContext context;
+    TensorBase *x = new TensorBase(x_shape, nullptr, 0, DATA_TYPE_INT8);
+    TensorBase *w = new TensorBase({1, 3 * hidden_size, input_size}, nullptr, 0, DATA_TYPE_INT8);
+    TensorBase *r = new TensorBase(r_shape, nullptr, 0, DATA_TYPE_INT8);
+    module::GRU *gru = new module::GRU("gru", hidden_size, -4, QUANT_TYPE_SYMM_8BIT);
+    std::vector<std::vector<int>> shapes = {x_shape};
+    TensorBase *y = new TensorBase(gru->get_output_shape(shapes)[0], nullptr, -7, DATA_TYPE_INT8);
+    memset(y->data, 0x55, y->get_bytes());
+    gru->m_inputs_index = {context.push_back_tensor(x), context.push_back_tensor(w), context.push_back_tensor(r)};
+    gru->m_outputs_index = {context.push_back_tensor(y)};
+    gru->forward(&context);
+    for (int i = 0; i < y->get_bytes(); i++) {
+        TEST_ASSERT_EQUAL(0x55, ((uint8_t *)y->data)[i]);
+    }
+    delete gru;
+    delete x;
+    delete w;
+    delete r;
+    delete y;
+
+    int total_ram_size_end = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    TEST_ASSERT_EQUAL(true, total_ram_size_before == total_ram_size_end);
+}
+
+#if CONFIG_IDF_TARGET_ESP32S3 || CONFIG_IDF_TARGET_ESP32P4
+extern const uint8_t api_models_espdl[] asm("_binary_api_models_espdl_start");
+
+typedef struct {
+    const char *name;
+    const char *input;
+    const char *output;
+    const char *input_cache;
+    const char *output_cache;
+} test_streaming_model_t;
+
+// The streaming models of examples/tutorial/how_to_run_streaming_model
+static const test_streaming_model_t test_streaming_models[2] = {
+    {"model_0_ishap_1_64_36_kshap_3_s8_streaming.espdl", "input.1", "42", "cache", "31"},
+    {"model_2_ishap_1_64_36_kshap_3_s8_streaming.espdl", "input.1", "32", "cache", "27"},
+};
+
+/**
+ * @brief A streaming model fed by bind_streaming_input() and bind_streaming_cache(), and the same model whose input
+ * and cache are assigned by hand before each run.
+ */
+class TestStreamingModel {
+public:
+    const test_streaming_model_t &m_cfg;
+    Model *m_bound;
+    Model *m_manual;
+    TensorBase *m_window; /*!< ring buffer window bound to the input of m_bound */
+    TensorBase *m_cache;  /*!< cache of m_manual, copied from its output cache after each run */
+    TensorBase *m_frame;  /*!< new frame pushed into m_window */
+
+    TestStreamingModel(const test_streaming_model_t &cfg, bool share_buffer) : m_cfg(cfg)
+    {
+        m_bound = new Model((const char *)api_models_espdl, cfg.name);
+        m_manual = new Model((const char *)api_models_espdl, cfg.name);
+        TensorBase *input = m_bound->get_inputs()[cfg.input];
+        m_window = new TensorBase(input->get_shape(), nullptr, input->get_exponent(), input->get_dtype());
+        TEST_ASSERT_EQUAL(true, m_window->enable_ring_buffer(1));
+        m_frame = new TensorBase({1, 1, input->get_shape()[2]}, nullptr, input->get_exponent(), input->get_dtype());
+        TensorBase *cache = m_manual->get_inputs()[cfg.input_cache];
+        m_cache = new TensorBase(cache->get_shape(), nullptr, cache->get_exponent(), cache->get_dtype());
+        TEST_ASSERT_EQUAL(ESP_OK, m_bound->bind_streaming_input(cfg.input, m_window));
+        TEST_ASSERT_EQUAL(ESP_OK, m_bound->bind_streaming_cache(cfg.input_cache, cfg.output_cache, share_buffer));
+    }
+
+    ~TestStreamingModel()
+    {
+        delete m_bound;
+        delete m_manual;
+        delete m_window;
+        delete m_cache;
+        delete m_frame;
+    }
+
+    void push()
+    {
+        for (int i = 0; i < m_frame->get_bytes(); i++) {
+            ((uint8_t *)m_frame->data)[i] = rand();
+        }
+        m_window->push(m_frame, 1);
+    }
+
+    // Run both models on the window, their outputs and caches must be the same.
+    void run_and_check()
+    {
+        m_bound->run();
+        std::map<std::string, TensorBase *> inputs = {{m_cfg.input, m_window}, {m_cfg.input_cache, m_cache}};
+        m_manual->run(inputs);
+        m_cache->assign(m_manual->get_outputs()[m_cfg.output_cache]);
+
+        TensorBase *output = m_bound->get_outputs()[m_cfg.output];
+        TensorBase *ref = m_manual->get_outputs()[m_cfg.output];
+        TEST_ASSERT_EQUAL(0, memcmp(ref->data, output->data, ref->get_bytes()));
+        TensorBase *cache = m_bound->get_inputs()[m_cfg.input_cache];
+        TEST_ASSERT_EQUAL(0, memcmp(m_cache->data, cache->data, m_cache->get_bytes()));
+    }
+};
+
+TEST_CASE("Test dl model API: streaming input and cache bindings", "[api]")
+{
+    ESP_LOGI(TAG, "Test dl model API: streaming input and cache bindings");
+    srand(46);
+    // the cache readers of both models run before the writer, share_buffer false forces the copy after each run
+    for (const test_streaming_model_t &cfg : test_streaming_models) {
+        for (bool share_buffer : {true, false}) {
+            TestStreamingModel *model = new TestStreamingModel(cfg, share_buffer);
+            for (int step = 0; step < 40; step++) {
+                model->push();
+                model->run_and_check();
+            }
+            delete model;
+        }
+    }
+}
+
+TEST_CASE("Test dl model API: skip_run of a streaming model", "[api]")
+{
+    ESP_LOGI(TAG, "Test dl model API: skip_run of a streaming model");
+    srand(49);
+    for (const test_streaming_model_t &cfg : test_streaming_models) {
+        for (bool share_buffer : {true, false}) {
+            TestStreamingModel *model = new TestStreamingModel(cfg, share_buffer);
+            TensorBase *cache = model->m_bound->get_inputs()[cfg.input_cache];
+            for (int step = 0; step < 40; step++) {
+                model->push();
+                if (step % 10 < 5) {
+                    model->run_and_check();
+                    continue;
+                }
+                // neither model runs, the cache keeps the value of the last run and the window the new frames
+                model->m_bound->skip_run();
+                TEST_ASSERT_EQUAL(0, memcmp(model->m_cache->data, cache->data, cache->get_bytes()));
+            }
+            delete model;
+        }
+    }
+}
+#endif
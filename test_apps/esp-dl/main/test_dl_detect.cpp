@@ -0,0 +1,503 @@
+#include "dl_math_dfl.hpp"
+#include "dl_detect_cascade.hpp"
+#include "dl_detect_msr_postprocessor.hpp"
+#include "dl_detect_nms.hpp"
+#include "dl_detect_postprocessor.hpp"
+#include "dl_detect_tracker.hpp"
+#include "dl_math.hpp"
+#include "esp_log.h"
+#include "unity.h"
+#include <algorithm>
+#include <list>
+
+static const char *TAG = "TEST DL DETECT";
+
+using namespace dl;
+using namespace dl::detect;
+
+typedef struct {
+    int category;
+    float score;
+    int box[4];
+} test_box_t;
+
+static uint32_t test_rand(uint32_t &seed)
+{
+    seed = seed * 1664525 + 1013904223;
+    return seed >> 8;
+}
+
+static std::vector<test_box_t> gen_test_boxes(int num, int num_classes, uint32_t seed)
+{
+    std::vector<test_box_t> boxes(num);
+    for (int i = 0; i < num; i++) {
+        int x = test_rand(seed) % 600;
+        int y = test_rand(seed) % 600;
+        int w = 10 + test_rand(seed) % 100;
+        int h = 10 + test_rand(seed) % 100;
+        boxes[i] = {(int)(test_rand(seed) % num_classes), (test_rand(seed) % 100000) / 100000.f, {x, y, x + w, y + h}};
+    }
+    return boxes;
+}
+
+static float test_iou(const test_box_t &a, const test_box_t &b)
+{
+    int inter_w = DL_MIN(a.box[2], b.box[2]) - DL_MAX(a.box[0], b.box[0]) + 1;
+    int inter_h = DL_MIN(a.box[3], b.box[3]) - DL_MAX(a.box[1], b.box[1]) + 1;
+    if (inter_w <= 0 || inter_h <= 0) {
+        return 0;
+    }
+    int area_a = (a.box[2] - a.box[0] + 1) * (a.box[3] - a.box[1] + 1);
+    int area_b = (b.box[2] - b.box[0] + 1) * (b.box[3] - b.box[1] + 1);
+    int inter = inter_w * inter_h;
+    return (float)inter / (area_a + area_b - inter);
+}
+
+// Reference greedy NMS over a sorted std::list, same as the original postprocessor implementation.
+static std::list<test_box_t> ref_nms(const std::vector<test_box_t> &boxes, float iou_thr, int top_k, bool class_aware)
+{
+    std::list<test_box_t> box_list;
+    for (const test_box_t &box : boxes) {
+        box_list.insert(std::upper_bound(box_list.begin(),
+                                         box_list.end(),
+                                         box,
+                                         [](const test_box_t &a, const test_box_t &b) { return a.score > b.score; }),
+                        box);
+    }
+    std::list<test_box_t> kept;
+    while (!box_list.empty() && (int)kept.size() < top_k) {
+        test_box_t cur = box_list.front();
+        box_list.pop_front();
+        kept.push_back(cur);
+        for (auto it = box_list.begin(); it != box_list.end();) {
+            if ((!class_aware || it->category == cur.category) && test_iou(cur, *it) > iou_thr) {
+                it = box_list.erase(it);
+            } else {
+                it++;
+            }
+        }
+    }
+    return kept;
+}
+
+static void check_nms(const std::vector<test_box_t> &boxes, int top_k, bool class_aware)
+{
+    float iou_thr = 0.5;
+    DetectCandidates candidates(boxes.size());
+    dl::tool::Latency latency;
+    latency.start();
+    for (const test_box_t &box : boxes) {
+        candidates.push(box.category, box.score, box.box[0], box.box[1], box.box[2], box.box[3]);
+    }
+    candidates.nms(iou_thr, top_k, NMS_TYPE_HARD, class_aware);
+    latency.end();
+    ESP_LOGI(TAG,
+             "candidates: %d, class_aware: %d, kept: %d, latency: %ld us",
+             (int)boxes.size(),
+             class_aware,
+             (int)candidates.get_keep().size(),
+             latency.get_period());
+
+    std::list<test_box_t> ref = ref_nms(boxes, iou_thr, top_k, class_aware);
+    TEST_ASSERT_EQUAL(ref.size(), candidates.get_keep().size());
+    auto it = ref.begin();
+    for (int slot : candidates.get_keep()) {
+        TEST_ASSERT_EQUAL_FLOAT(it->score, candidates.get_score(slot));
+        TEST_ASSERT_EQUAL(it->category, candidates.get_category(slot));
+        TEST_ASSERT_EQUAL_INT32_ARRAY(it->box, candidates.get_box(slot), 4);
+        it++;
+    }
+}
+
+TEST_CASE("Test dl detect API: nms()", "[api]")
+{
+    for (int num : {100, 1000, 3000}) {
+        std::vector<test_box_t> boxes = gen_test_boxes(num, 3, num);
+        check_nms(boxes, 50, false);
+        check_nms(boxes, 50, true);
+    }
+
+    // Bounded candidate buffer keeps the highest scoring boxes.
+    std::vector<test_box_t> boxes = gen_test_boxes(2000, 1, 7);
+    DetectCandidates candidates(100);
+    for (const test_box_t &box : boxes) {
+        if (candidates.accept(box.score)) {
+            candidates.push(box.category, box.score, box.box[0], box.box[1], box.box[2], box.box[3]);
+        }
+    }
+    TEST_ASSERT_EQUAL(100, candidates.size());
+    std::sort(boxes.begin(), boxes.end(), [](const test_box_t &a, const test_box_t &b) { return a.score > b.score; });
+    candidates.nms(1.f, 100);
+    for (int i = 0; i < 100; i++) {
+        TEST_ASSERT_EQUAL_FLOAT(boxes[i].score, candidates.get_score(candidates.get_keep()[i]));
+    }
+
+    // Fast NMS never keeps more boxes than greedy NMS.
+    candidates.set_capacity(boxes.size());
+    for (const test_box_t &box : boxes) {
+        candidates.push(box.category, box.score, box.box[0], box.box[1], box.box[2], box.box[3]);
+    }
+    int hard_num = candidates.nms(0.5, boxes.size(), NMS_TYPE_HARD);
+    int fast_num = candidates.nms(0.5, boxes.size(), NMS_TYPE_FAST);
+    ESP_LOGI(TAG, "hard nms kept: %d, fast nms kept: %d", hard_num, fast_num);
+    TEST_ASSERT_EQUAL(true, fast_num <= hard_num);
+}
+
+// Feeds synthetic boxes with eagerly stored keypoints, like MNPPostprocessor does.
+class TestDetectPostprocessor : public DetectPostprocessor {
+public:
+    const std::vector<test_box_t> *m_boxes;
+
+    TestDetectPostprocessor(const float nms_thr, const int top_k) :
+        DetectPostprocessor(nullptr, 0, nms_thr, top_k), m_boxes(nullptr)
+    {
+        set_resize_scale_x(1);
+        set_resize_scale_y(1);
+    }
+
+    template <typename T>
+    const std::vector<int> &get_cells(const T *score, int cell_num, int channel_num, int score_thr_quant)
+    {
+        filter_cells(score, cell_num, channel_num, score_thr_quant);
+        return m_cells;
+    }
+
+    void postprocess() override
+    {
+        set_keypoint_num(4);
+        m_candidates.set_keypoint_num(4);
+        for (const test_box_t &box : *m_boxes) {
+            if (m_candidates.accept(box.score)) {
+                int slot = m_candidates.push(box.category, box.score, box.box[0], box.box[1], box.box[2], box.box[3]);
+                int *keypoint = m_candidates.get_keypoint(slot);
+                keypoint[0] = box.box[0];
+                keypoint[1] = box.box[1];
+                keypoint[2] = box.box[2];
+                keypoint[3] = box.box[3];
+            }
+        }
+        nms();
+    }
+};
+
+TEST_CASE("Test dl detect API: result reuse", "[api]")
+{
+    TestDetectPostprocessor postprocessor(0.5, 20);
+    std::vector<const result_t *> nodes;
+    for (int frame = 0; frame < 4; frame++) {
+        std::vector<test_box_t> boxes = gen_test_boxes(500, 2, frame + 1);
+        postprocessor.m_boxes = &boxes;
+        postprocessor.clear_result();
+        postprocessor.postprocess();
+        std::list<result_t> &result = postprocessor.get_result(1000, 1000);
+        std::list<test_box_t> ref = ref_nms(boxes, 0.5, 20, false);
+        TEST_ASSERT_EQUAL(ref.size(), result.size());
+
+        auto it = ref.begin();
+        int i = 0;
+        for (const result_t &res : result) {
+            TEST_ASSERT_EQUAL_FLOAT(it->score, res.score);
+            TEST_ASSERT_EQUAL(4, res.keypoint.size());
+            for (int j = 0; j < 4; j++) {
+                TEST_ASSERT_EQUAL(DL_CLIP(it->box[j], 0, 999), res.box[j]);
+                TEST_ASSERT_EQUAL(DL_CLIP(it->box[j], 0, 999), res.keypoint[j]);
+            }
+            // Result nodes and their keypoint storage are recycled across frames.
+            if (frame == 0) {
+                nodes.push_back(&res);
+            } else if (i < (int)nodes.size()) {
+                TEST_ASSERT_EQUAL(true, std::find(nodes.begin(), nodes.end(), &res) != nodes.end());
+            }
+            it++;
+            i++;
+        }
+    }
+}
+
+template <typename T>
+static void check_dfl(int exponent, int logit_range, float max_error)
+{
+    const int reg_max = 16;
+    const int num = 200;
+    uint32_t seed = exponent + logit_range;
+    std::vector<T> logits(num * 4 * reg_max);
+    for (int i = 0; i < (int)logits.size(); i++) {
+        logits[i] = (T)((int)(test_rand(seed) % (2 * logit_range + 1)) - logit_range);
+    }
+
+    dl::math::DFLDecoder decoder(reg_max);
+    decoder.set_exponent<T>(exponent);
+    std::vector<float> distance(num * 4);
+    dl::tool::Latency latency;
+    latency.start();
+    for (int i = 0; i < num; i++) {
+        decoder.decode(logits.data() + i * 4 * reg_max, distance.data() + i * 4);
+    }
+    latency.end();
+    long quant_period = latency.get_period();
+
+    std::vector<float> ref(num * 4);
+    float box_data[4 * reg_max];
+    latency.start();
+    for (int i = 0; i < num; i++) {
+        for (int j = 0; j < 4 * reg_max; j++) {
+            box_data[j] = dequantize(logits[i * 4 * reg_max + j], DL_SCALE(exponent));
+        }
+        for (int j = 0; j < 4; j++) {
+            ref[i * 4 + j] = dl::math::dfl_integral(box_data + j * reg_max, reg_max - 1);
+        }
+    }
+    latency.end();
+
+    float error = 0;
+    for (int i = 0; i < num * 4; i++) {
+        error = DL_MAX(error, fabsf(distance[i] - ref[i]));
+    }
+    ESP_LOGI(TAG,
+             "dfl %d bit, exponent: %d, max error: %f bins, quant: %ld us, float: %ld us",
+             (int)sizeof(T) * 8,
+             exponent,
+             error,
+             quant_period,
+             latency.get_period());
+    TEST_ASSERT_EQUAL(true, error < max_error);
+}
+
+TEST_CASE("Test dl detect API: dfl decode", "[api]")
+{
+    check_dfl<int8_t>(-2, 128, 0.01);
+    check_dfl<int8_t>(-4, 128, 0.01);
+    check_dfl<int16_t>(-10, 8192, 0.01);
+    check_dfl<int16_t>(-12, 32767, 0.01);
+}
+
+TEST_CASE("Test dl detect API: merge regions", "[api]")
+{
+    TestDetectPostprocessor postprocessor(0.5, 20);
+    std::vector<test_box_t> merged;
+    postprocessor.clear_merged_result();
+    for (int region = 0; region < 3; region++) {
+        std::vector<test_box_t> boxes = gen_test_boxes(200, 2, region + 10);
+        postprocessor.m_boxes = &boxes;
+        postprocessor.clear_result();
+        postprocessor.postprocess();
+        postprocessor.merge_result();
+        std::list<test_box_t> kept = ref_nms(boxes, 0.5, 20, false);
+        merged.insert(merged.end(), kept.begin(), kept.end());
+    }
+    postprocessor.nms_merged_result();
+    std::list<result_t> &result = postprocessor.get_result(1000, 1000);
+    std::list<test_box_t> ref = ref_nms(merged, 0.5, 20, false);
+    TEST_ASSERT_EQUAL(ref.size(), result.size());
+    auto it = ref.begin();
+    for (const result_t &res : result) {
+        TEST_ASSERT_EQUAL_FLOAT(it->score, res.score);
+        for (int j = 0; j < 4; j++) {
+            TEST_ASSERT_EQUAL(DL_CLIP(it->box[j], 0, 999), res.box[j]);
+            // The keypoints of each region are kept through the merge.
+            TEST_ASSERT_EQUAL(DL_CLIP(it->box[j], 0, 999), res.keypoint[j]);
+        }
+        it++;
+    }
+
+    int box[4] = {100, 200, 140, 300};
+    std::vector<int> roi = get_roi(box, 640, 480);
+    TEST_ASSERT_EQUAL_INT32_ARRAY(box, roi.data(), 4);
+    int square[4] = {70, 200, 170, 300};
+    roi = get_roi(box, 640, 480, 0, true);
+    TEST_ASSERT_EQUAL_INT32_ARRAY(square, roi.data(), 4);
+    int expanded[4] = {60, 190, 180, 310};
+    roi = get_roi(box, 640, 480, 0.2, true);
+    TEST_ASSERT_EQUAL_INT32_ARRAY(expanded, roi.data(), 4);
+    int clipped[4] = {600, 450, 640, 480};
+    int border[4] = {600, 450, 660, 500};
+    roi = get_roi(border, 640, 480);
+    TEST_ASSERT_EQUAL_INT32_ARRAY(clipped, roi.data(), 4);
+    int outside[4] = {700, 500, 720, 520};
+    TEST_ASSERT_EQUAL(true, get_roi(outside, 640, 480).empty());
+}
+
+template <typename T>
+static void check_filter_cells(int channel_num)
+{
+    TestDetectPostprocessor postprocessor(0.5, 20);
+    const int cell_num = 400;
+    uint32_t seed = channel_num;
+    std::vector<T> score(cell_num * channel_num);
+    for (int i = 0; i < (int)score.size(); i++) {
+        // Mostly low scores with a few peaks, like the class scores of a detection head.
+        int value = test_rand(seed) % 100 < 2 ? test_rand(seed) % 256 - 128 : test_rand(seed) % 64 - 128;
+        score[i] = sizeof(T) == 1 ? value : value * 100;
+    }
+
+    for (int thr : {-200, -129, -128, -100, -65, -64, 0, 100, 126, 127}) {
+        int score_thr_quant = sizeof(T) == 1 ? thr : thr * 100;
+        std::vector<int> ref;
+        for (int i = 0; i < cell_num; i++) {
+            for (int c = 0; c < channel_num; c++) {
+                if (score[i * channel_num + c] > score_thr_quant) {
+                    ref.push_back(i);
+                    break;
+                }
+            }
+        }
+        const std::vector<int> &cells = postprocessor.get_cells(score.data(), cell_num, channel_num, score_thr_quant);
+        TEST_ASSERT_EQUAL(ref.size(), cells.size());
+        TEST_ASSERT_EQUAL_INT32_ARRAY(ref.data(), cells.data(), ref.size());
+    }
+}
+
+TEST_CASE("Test dl detect API: filter_cells()", "[api]")
+{
+    for (int channel_num : {1, 3, 4, 80}) {
+        check_filter_cells<int8_t>(channel_num);
+        check_filter_cells<int16_t>(channel_num);
+    }
+}
+
+// Detector of a synthetic sequence of moving boxes, returns the ground truth boxes of the current frame.
+class TestSequenceDetect : public Detect {
+public:
+    int m_frame = 0;
+    std::vector<int> m_keypoint;
+    std::list<result_t> m_result;
+
+    static void get_box(int object, int frame, int *box)
+    {
+        // Two objects moving at constant speed and one accelerating.
+        float x = object == 2 ? 300 + 0.05f * frame * frame : 100 + 40 * object + (object ? -2.f : 4.f) * frame;
+        float y = 200 + 150 * object + 2.f * frame;
+        box[0] = (int)x;
+        box[1] = (int)y;
+        box[2] = (int)x + 80;
+        box[3] = (int)y + 100;
+    }
+
+    std::list<result_t> &run(const dl::image::img_t &img)
+    {
+        m_result.clear();
+        m_keypoint.resize(3 * 2);
+        for (int object = 0; object < 3; object++) {
+            result_t res;
+            res.category = 0;
+            res.score = 0.9f - 0.1f * object;
+            get_box(object, m_frame, res.box);
+            m_keypoint[2 * object] = res.box[0] + 40;
+            m_keypoint[2 * object + 1] = res.box[1] + 50;
+            res.keypoint = {m_keypoint.data() + 2 * object, 2};
+            m_result.push_back(res);
+        }
+        return m_result;
+    }
+};
+
+static float track_sequence(int detect_interval, float motion_thr, int &num_detections)
+{
+    TestSequenceDetect detect;
+    DetectTracker tracker(&detect, detect_interval, motion_thr);
+    dl::image::img_t img = {
+        .data = nullptr, .width = 1000, .height = 1000, .pix_type = dl::image::DL_IMAGE_PIX_TYPE_RGB888};
+    float iou_sum = 0;
+    int num_boxes = 0;
+    for (detect.m_frame = 0; detect.m_frame < 60; detect.m_frame++) {
+        std::list<result_t> &result = tracker.run(img);
+        TEST_ASSERT_EQUAL(3, result.size());
+        for (const result_t &res : result) {
+            // The objects are reported in the order of their scores.
+            int object = num_boxes % 3;
+            test_box_t ref = {0, 0, {}}, box = {0, 0, {res.box[0], res.box[1], res.box[2], res.box[3]}};
+            TestSequenceDetect::get_box(object, detect.m_frame, ref.box);
+            iou_sum += test_iou(ref, box);
+            TEST_ASSERT_INT_WITHIN(8, ref.box[0] + 40, res.keypoint[0]);
+            num_boxes++;
+        }
+    }
+    num_detections = tracker.get_num_detections();
+    TEST_ASSERT_EQUAL(60, tracker.get_num_frames());
+    return iou_sum / num_boxes;
+}
+
+TEST_CASE("Test dl detect API: tracker", "[api]")
+{
+    int num_detections;
+    float iou = track_sequence(1, 0, num_detections);
+    TEST_ASSERT_EQUAL(60, num_detections);
+    TEST_ASSERT_EQUAL_FLOAT(1.f, iou);
+
+    for (int detect_interval : {2, 3, 5}) {
+        iou = track_sequence(detect_interval, 0, num_detections);
+        ESP_LOGI(TAG, "detect every %d frames: %d detections, mean IoU: %f", detect_interval, num_detections, iou);
+        // One more run on the second frame measures the velocities.
+        TEST_ASSERT_EQUAL(true, num_detections <= (60 + detect_interval - 1) / detect_interval + 1);
+        TEST_ASSERT_EQUAL(true, iou > 0.85f);
+    }
+
+    // Fast objects trigger the detector earlier.
+    iou = track_sequence(10, 0.1f, num_detections);
+    ESP_LOGI(TAG, "detect on motion: %d detections, mean IoU: %f", num_detections, iou);
+    TEST_ASSERT_EQUAL(true, num_detections > 6 && num_detections < 60);
+    TEST_ASSERT_EQUAL(true, iou > 0.85f);
+
+    // The other run() overloads of Detect stay reachable on the tracker.
+    TestSequenceDetect detect;
+    DetectTracker tracker(&detect);
+    dl::image::img_t img = {
+        .data = nullptr, .width = 1000, .height = 1000, .pix_type = dl::image::DL_IMAGE_PIX_TYPE_RGB888};
+    std::vector<std::vector<int>> rois = {{0, 0, 1000, 1000}};
+    TEST_ASSERT_EQUAL(3, tracker.run(img, rois).size());
+    TEST_ASSERT_EQUAL(1, tracker.get_num_frames());
+}
+
+#if CONFIG_IDF_TARGET_ESP32S3 || CONFIG_IDF_TARGET_ESP32P4
+extern const uint8_t api_models_espdl[] asm("_binary_api_models_espdl_start");
+
+// A low score threshold keeps some boxes on the synthetic image.
+class TestRegionDetect : public DetectImpl {
+public:
+    TestRegionDetect()
+    {
+        m_model = new dl::Model((const char *)api_models_espdl, "human_face_detect_msr_s8_v1.espdl");
+        m_model->minimize();
+        m_image_preprocessor = new dl::image::ImagePreprocessor(m_model, {0, 0, 0}, {1, 1, 1});
+        m_postprocessor = new MSRPostprocessor(
+            m_model, 0.05, 0.5, 10, {{8, 8, 9, 9, {{16, 16}, {32, 32}}}, {16, 16, 9, 9, {{64, 64}, {128, 128}}}});
+    }
+};
+
+TEST_CASE("Test dl detect API: regions on the other core", "[api]")
+{
+    ESP_LOGI(TAG, "Test dl detect API: regions on the other core");
+    const int width = 320;
+    const int height = 240;
+    std::vector<uint8_t> pixels(width * height * 3);
+    uint32_t seed = 7;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            uint8_t *pixel = pixels.data() + (y * width + x) * 3;
+            pixel[0] = x * 255 / width;
+            pixel[1] = y * 255 / height;
+            pixel[2] = test_rand(seed);
+        }
+    }
+    dl::image::img_t img = {pixels.data(), width, height, dl::image::DL_IMAGE_PIX_TYPE_RGB888};
+    std::vector<std::vector<int>> rois = {{0, 0, 160, 120}, {100, 40, 300, 240}, {0, 0, 320, 240}, {200, 0, 320, 90}};
+
+    // multi core runs crop the regions in turn, single core runs crop the next region on the other core
+    TestRegionDetect *detect = new TestRegionDetect();
+    std::list<result_t> &ref_result = detect->run(img, rois, RUNTIME_MODE_MULTI_CORE);
+    std::vector<result_t> ref(ref_result.begin(), ref_result.end());
+    ESP_LOGI(TAG, "%d boxes in %d regions", (int)ref.size(), (int)rois.size());
+    std::list<result_t> &result = detect->run(img, rois, RUNTIME_MODE_SINGLE_CORE);
+    TEST_ASSERT_EQUAL(ref.size(), result.size());
+    auto it = ref.begin();
+    for (const result_t &res : result) {
+        TEST_ASSERT_EQUAL(it->category, res.category);
+        TEST_ASSERT_EQUAL_FLOAT(it->score, res.score);
+        for (int j = 0; j < 4; j++) {
+            TEST_ASSERT_EQUAL(it->box[j], res.box[j]);
+        }
+        it++;
+    }
+    delete detect;
+}
+#endif
@@ -0,0 +1,678 @@
+#include "dl_feat_base.hpp"
+#include "dl_recognition_database.hpp"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "esp_timer.h"
+#include "esp_vfs_fat.h"
+#include "unity.h"
+#include <math.h>
+
+static const char *TAG = "TEST DL RECOGNITION";
+
+using namespace dl;
+using namespace dl::recognition;
+
+#define TEST_STORAGE_PATH "/storage"
+#define TEST_DB_PATH TEST_STORAGE_PATH "/test.db"
+
+static wl_handle_t s_wl_handle = WL_INVALID_HANDLE;
+
+static void remove_db_files()
+{
+    remove(TEST_DB_PATH);
+    remove(TEST_DB_PATH ".tmp");
+    remove(TEST_DB_PATH ".ivf");
+}
+
+static void mount_storage()
+{
+    esp_vfs_fat_mount_config_t mount_config;
+    memset(&mount_config, 0, sizeof(esp_vfs_fat_mount_config_t));
+    mount_config.max_files = 4;
+    mount_config.format_if_mount_failed = true;
+    TEST_ASSERT_EQUAL(ESP_OK,
+                      esp_vfs_fat_spiflash_mount_rw_wl(TEST_STORAGE_PATH, "storage", &mount_config, &s_wl_handle));
+    remove_db_files();
+}
+
+static void unmount_storage()
+{
+    remove_db_files();
+    TEST_ASSERT_EQUAL(ESP_OK, esp_vfs_fat_spiflash_unmount_rw_wl(TEST_STORAGE_PATH, s_wl_handle));
+}
+
+static uint32_t test_rand(uint32_t &seed)
+{
+    seed = seed * 1664525 + 1013904223;
+    return seed >> 8;
+}
+
+static float test_randf(uint32_t &seed)
+{
+    return (test_rand(seed) % 20001) / 10000.f - 1.f;
+}
+
+static void test_normalize(float *feat, int len)
+{
+    float sum = 0;
+    for (int i = 0; i < len; i++) {
+        sum += feat[i] * feat[i];
+    }
+    float inv_norm = 1.f / sqrtf(sum);
+    for (int i = 0; i < len; i++) {
+        feat[i] *= inv_norm;
+    }
+}
+
+/**
+ * Unit features around num_clusters random centers, like the features of several photos of each person.
+ */
+static std::vector<float> gen_test_feats(int num, int feat_len, int num_clusters, float noise, uint32_t seed)
+{
+    std::vector<float> centers(num_clusters * feat_len);
+    for (float &value : centers) {
+        value = test_randf(seed);
+    }
+    std::vector<float> feats((size_t)num * feat_len);
+    for (int i = 0; i < num; i++) {
+        const float *center = centers.data() + (i % num_clusters) * feat_len;
+        float *feat = feats.data() + (size_t)i * feat_len;
+        for (int j = 0; j < feat_len; j++) {
+            feat[j] = center[j] + noise * test_randf(seed);
+        }
+        test_normalize(feat, feat_len);
+    }
+    return feats;
+}
+
+static std::vector<float> gen_test_query(const float *feat, int feat_len, float noise, uint32_t seed)
+{
+    std::vector<float> query(feat, feat + feat_len);
+    for (float &value : query) {
+        value += noise * test_randf(seed);
+    }
+    test_normalize(query.data(), feat_len);
+    return query;
+}
+
+static float test_dot(const float *a, const float *b, int len)
+{
+    float sum = 0;
+    for (int i = 0; i < len; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+/**
+ * Brute force float query over the features of the enrolled ids, in enrollment order like DataBase::query_feat().
+ */
+static std::vector<result_t> ref_query(const std::vector<float> &feats,
+                                       const std::vector<uint16_t> &ids,
+                                       const float *query,
+                                       int feat_len,
+                                       int top_k)
+{
+    std::vector<result_t> results;
+    for (int i = 0; i < ids.size(); i++) {
+        results.push_back({(uint16_t)(i + 1), test_dot(feats.data() + (ids[i] - 1) * feat_len, query, feat_len)});
+    }
+    std::stable_sort(results.begin(), results.end(), [](const result_t &a, const result_t &b) -> bool {
+        return a.similarity > b.similarity;
+    });
+    results.resize(DL_MIN(top_k, (int)results.size()));
+    return results;
+}
+
+/**
+ * Query features close to the enrolled ones and to the deleted ones, the float database must match the brute force
+ * results, a quantized one the best match and the similarities within tol.
+ */
+static void check_queries(DataBase *db,
+                          const std::vector<float> &feats,
+                          const std::vector<uint16_t> &ids,
+                          int feat_len,
+                          dtype_t dtype,
+                          float tol)
+{
+    const int top_k = 5;
+    int num = feats.size() / feat_len;
+    TEST_ASSERT_EQUAL((int)ids.size(), db->get_num_feats());
+    for (int i = 0; i < num; i += 3) {
+        std::vector<float> query = gen_test_query(feats.data() + i * feat_len, feat_len, 0.05, i);
+        TensorBase query_tensor({feat_len}, query.data(), 0, DATA_TYPE_FLOAT, false);
+        std::vector<result_t> ref = ref_query(feats, ids, query.data(), feat_len, top_k);
+        std::vector<result_t> results = db->query_feat(&query_tensor, -2.f, top_k);
+        TEST_ASSERT_EQUAL(ref.size(), results.size());
+        TEST_ASSERT_EQUAL(ref[0].id, results[0].id);
+        for (int k = 0; k < results.size(); k++) {
+            float sim = test_dot(feats.data() + (ids[results[k].id - 1] - 1) * feat_len, query.data(), feat_len);
+            TEST_ASSERT_FLOAT_WITHIN(tol, sim, results[k].similarity);
+            if (k > 0) {
+                TEST_ASSERT_TRUE(results[k - 1].similarity >= results[k].similarity);
+            }
+            if (dtype == DATA_TYPE_FLOAT) {
+                TEST_ASSERT_EQUAL(ref[k].id, results[k].id);
+            }
+        }
+
+        // only the feature the query was made from is above a high threshold
+        results = db->query_feat(&query_tensor, 0.8f, top_k);
+        bool enrolled = std::find(ids.begin(), ids.end(), i + 1) != ids.end();
+        TEST_ASSERT_EQUAL(enrolled ? 1 : 0, results.size());
+        if (enrolled) {
+            TEST_ASSERT_EQUAL(ids[results[0].id - 1], i + 1);
+        }
+    }
+}
+
+TEST_CASE("Test dl recognition API: database enroll, query and delete", "[api]")
+{
+    ESP_LOGI(TAG, "Test dl recognition API: database enroll, query and delete");
+    mount_storage();
+    const int feat_len = 64;
+    const int num = 60;
+    std::vector<float> feats = gen_test_feats(num, feat_len, num, 0, 1);
+    dtype_t dtypes[3] = {DATA_TYPE_FLOAT, DATA_TYPE_INT16, DATA_TYPE_INT8};
+    float tols[3] = {1e-5, 1e-3, 2e-2};
+
+    for (int d = 0; d < 3; d++) {
+        for (int persist = 0; persist < 2; persist++) {
+            remove_db_files();
+            DataBase *db = new DataBase(persist ? TEST_DB_PATH : nullptr, feat_len, dtypes[d]);
+            std::vector<uint16_t> ids;
+            // one at a time, then the rest in one batch
+            for (int i = 0; i < 10; i++) {
+                TensorBase feat({feat_len}, feats.data() + i * feat_len, 0, DATA_TYPE_FLOAT, false);
+                TEST_ASSERT_EQUAL(ESP_OK, db->enroll_feat(&feat));
+                ids.push_back(i + 1);
+            }
+            TensorBase batch({num - 10, feat_len}, feats.data() + 10 * feat_len, 0, DATA_TYPE_FLOAT, false);
+            TEST_ASSERT_EQUAL(ESP_OK, db->enroll_feats(&batch));
+            for (int i = 10; i < num; i++) {
+                ids.push_back(i + 1);
+            }
+            check_queries(db, feats, ids, feat_len, dtypes[d], tols[d]);
+
+            TEST_ASSERT_EQUAL(ESP_OK, db->delete_feat(4));
+            TEST_ASSERT_EQUAL(ESP_OK, db->delete_feat(31));
+            TEST_ASSERT_EQUAL(ESP_OK, db->delete_last_feat());
+            TEST_ASSERT_EQUAL(ESP_FAIL, db->delete_feat(4));
+            ids.erase(std::find(ids.begin(), ids.end(), 4));
+            ids.erase(std::find(ids.begin(), ids.end(), 31));
+            ids.pop_back();
+            check_queries(db, feats, ids, feat_len, dtypes[d], tols[d]);
+
+            if (persist) {
+                // the same features after a reload
+                delete db;
+                db = new DataBase(TEST_DB_PATH, feat_len, dtypes[d]);
+                check_queries(db, feats, ids, feat_len, dtypes[d], tols[d]);
+            }
+
+            TEST_ASSERT_EQUAL(ESP_OK, db->clear_all_feats());
+            TEST_ASSERT_EQUAL(0, db->get_num_feats());
+            delete db;
+        }
+    }
+    unmount_storage();
+}
+
+TEST_CASE("Test dl recognition API: database query benchmark", "[recognition_benchmark]")
+{
+    ESP_LOGI(TAG, "Test dl recognition API: database query benchmark");
+    const int feat_len = 512;
+    const int batch = 1000;
+    const int num_queries = 20;
+    int nums[3] = {1000, 10000, 50000};
+    dtype_t dtypes[3] = {DATA_TYPE_FLOAT, DATA_TYPE_INT16, DATA_TYPE_INT8};
+
+    printf("| dtype | features | enroll (ms) | query top 5 (ms) |\n");
+    printf("|-------|----------|-------------|------------------|\n");
+    for (int d = 0; d < 3; d++) {
+        for (int n = 0; n < 3; n++) {
+            size_t bytes = (size_t)nums[n] * feat_len * dtype_sizeof(dtypes[d]);
+            // the matrix plus one batch of float features
+            if (heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM) < bytes + batch * feat_len * sizeof(float)) {
+                printf("| %s | %d | skipped, %d KB of PSRAM needed | |\n",
+                       dtype_to_string(dtypes[d]),
+                       nums[n],
+                       (int)(bytes / 1024));
+                continue;
+            }
+            DataBase *db = new DataBase(nullptr, feat_len, dtypes[d]);
+            int64_t enroll_time = 0;
+            esp_err_t ret = ESP_OK;
+            for (int i = 0; i < nums[n] && ret == ESP_OK; i += batch) {
+                // 5 photos of each person
+                std::vector<float> feats = gen_test_feats(batch, feat_len, batch / 5, 0.3, i + 1);
+                TensorBase feats_tensor({batch, feat_len}, feats.data(), 0, DATA_TYPE_FLOAT, false);
+                int64_t start = esp_timer_get_time();
+                ret = db->enroll_feats(&feats_tensor);
+                enroll_time += esp_timer_get_time() - start;
+            }
+            if (ret != ESP_OK) {
+                // growing the matrix may need a second block of its size
+                printf("| %s | %d | skipped, out of PSRAM | |\n", dtype_to_string(dtypes[d]), nums[n]);
+                delete db;
+                continue;
+            }
+
+            std::vector<float> queries = gen_test_feats(num_queries, feat_len, num_queries, 0, 7);
+            int64_t query_time = 0;
+            for (int i = 0; i < num_queries; i++) {
+                TensorBase query({feat_len}, queries.data() + i * feat_len, 0, DATA_TYPE_FLOAT, false);
+                int64_t start = esp_timer_get_time();
+                std::vector<result_t> results = db->query_feat(&query, -2.f, 5);
+                query_time += esp_timer_get_time() - start;
+                TEST_ASSERT_EQUAL(5, results.size());
+            }
+            printf("| %s | %d | %.2f | %.2f |\n",
+                   dtype_to_string(dtypes[d]),
+                   nums[n],
+                   enroll_time / 1000.f,
+                   query_time / 1000.f / num_queries);
+            delete db;
+        }
+    }
+}
+
+TEST_CASE("Test dl recognition API: IVF index", "[api]")
+{
+    ESP_LOGI(TAG, "Test dl recognition API: IVF index");
+    mount_storage();
+    const int feat_len = 32;
+    const int nlist = 8;
+    const int num = 200;
+    std::vector<float> feats = gen_test_feats(num, feat_len, 10, 1.5, 2);
+
+    IVFIndex *index = new IVFIndex(feat_len, nlist, 1);
+    TEST_ASSERT_FALSE(index->need_train(nlist * 8 - 1));
+    TEST_ASSERT_TRUE(index->need_train(nlist * 8));
+    index->train([&](int row, float *dst) { memcpy(dst, feats.data() + row * feat_len, feat_len * sizeof(float)); },
+                 num - 10);
+    TEST_ASSERT_TRUE(index->is_trained());
+    std::vector<int> lists;
+    for (int i = num - 10; i < num; i++) {
+        lists.push_back(index->add(feats.data() + i * feat_len));
+    }
+    for (int i = 0; i < num; i++) {
+        // a row is in the list closest to its own feature
+        const std::vector<int> &rows = index->search(feats.data() + i * feat_len);
+        TEST_ASSERT_TRUE(std::is_sorted(rows.begin(), rows.end()));
+        TEST_ASSERT_TRUE(std::binary_search(rows.begin(), rows.end(), i));
+    }
+    index->set_nprobe(nlist);
+    TEST_ASSERT_EQUAL(num, index->search(feats.data()).size());
+
+    // save the first rows, append the others in one write, then load the index with some rows deleted
+    std::vector<uint16_t> ids(num - 10);
+    for (int i = 0; i < num - 10; i++) {
+        ids[i] = i + 1;
+    }
+    IVFIndex *trained = new IVFIndex(feat_len, nlist, 1);
+    trained->train([&](int row, float *dst) { memcpy(dst, feats.data() + row * feat_len, feat_len * sizeof(float)); },
+                   num - 10);
+    TEST_ASSERT_EQUAL(ESP_OK, trained->save(TEST_DB_PATH ".ivf", ids, num - 10));
+    TEST_ASSERT_EQUAL(ESP_OK, trained->append(TEST_DB_PATH ".ivf", lists));
+    delete trained;
+    for (int i = num - 10; i < num; i++) {
+        ids.push_back(i + 1);
+    }
+    index->set_nprobe(2);
+    index->remove(150);
+    index->remove(7);
+    ids.erase(ids.begin() + 150);
+    ids.erase(ids.begin() + 7);
+    IVFIndex *loaded = new IVFIndex(feat_len, nlist, 2);
+    TEST_ASSERT_EQUAL(ESP_FAIL, loaded->load(TEST_DB_PATH ".ivf", ids, num - 1));
+    TEST_ASSERT_EQUAL(ESP_OK, loaded->load(TEST_DB_PATH ".ivf", ids, num));
+    for (int i = 0; i < num; i += 7) {
+        std::vector<int> expected = index->search(feats.data() + i * feat_len);
+        const std::vector<int> &rows = loaded->search(feats.data() + i * feat_len);
+        TEST_ASSERT_EQUAL(expected.size(), rows.size());
+        TEST_ASSERT_EQUAL_INT32_ARRAY(expected.data(), rows.data(), rows.size());
+    }
+    delete index;
+    delete loaded;
+
+    // an index of the database, all lists give the brute force results
+    remove_db_files();
+    DataBase *db = new DataBase(TEST_DB_PATH, feat_len);
+    TEST_ASSERT_EQUAL(ESP_OK, db->enable_index(nlist, nlist));
+    for (int i = 0; i < num; i += 20) {
+        TensorBase batch({20, feat_len}, feats.data() + i * feat_len, 0, DATA_TYPE_FLOAT, false);
+        TEST_ASSERT_EQUAL(ESP_OK, db->enroll_feats(&batch));
+    }
+    TEST_ASSERT_EQUAL(ESP_OK, db->delete_feat(3));
+    ids.resize(num);
+    for (int i = 0; i < num; i++) {
+        ids[i] = i + 1;
+    }
+    ids.erase(ids.begin() + 2);
+    check_queries(db, feats, ids, feat_len, DATA_TYPE_FLOAT, 1e-5);
+
+    // the index loaded with the database finds the same features
+    std::vector<std::vector<result_t>> expected;
+    db->set_index_nprobe(2);
+    for (int i = 0; i < num; i += 7) {
+        TensorBase query({feat_len}, feats.data() + i * feat_len, 0, DATA_TYPE_FLOAT, false);
+        expected.push_back(db->query_feat(&query, 0.f, 3));
+    }
+    delete db;
+    db = new DataBase(TEST_DB_PATH, feat_len);
+    TEST_ASSERT_EQUAL(ESP_OK, db->enable_index(nlist, 2));
+    for (int i = 0; i < num; i += 7) {
+        TensorBase query({feat_len}, feats.data() + i * feat_len, 0, DATA_TYPE_FLOAT, false);
+        std::vector<result_t> results = db->query_feat(&query, 0.f, 3);
+        TEST_ASSERT_EQUAL(expected[i / 7].size(), results.size());
+        for (int k = 0; k < results.size(); k++) {
+            TEST_ASSERT_EQUAL(expected[i / 7][k].id, results[k].id);
+            TEST_ASSERT_EQUAL_FLOAT(expected[i / 7][k].similarity, results[k].similarity);
+        }
+    }
+    delete db;
+    unmount_storage();
+}
+
+TEST_CASE("Test dl recognition API: IVF recall benchmark", "[recognition_benchmark]")
+{
+    ESP_LOGI(TAG, "Test dl recognition API: IVF recall benchmark");
+    const int feat_len = 512;
+    const int batch = 1000;
+    const int num_queries = 100;
+    const int top_k = 5;
+    int nums[2] = {10000, 50000};
+    int nprobes[5] = {1, 2, 4, 8, 16};
+
+    printf("| features | nlist | nprobe | recall@1 | recall@%d | query (ms) |\n", top_k);
+    printf("|----------|-------|--------|----------|-----------|------------|\n");
+    for (int n = 0; n < 2; n++) {
+        int nlist = sqrtf(nums[n]);
+        if (heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM) < (size_t)nums[n] * feat_len * 3 / 2) {
+            printf("| %d | %d | skipped, out of PSRAM | | | |\n", nums[n], nlist);
+            continue;
+        }
+        DataBase *db = new DataBase(nullptr, feat_len, DATA_TYPE_INT8);
+        TEST_ASSERT_EQUAL(ESP_OK, db->enable_index(nlist));
+        esp_err_t ret = ESP_OK;
+        std::vector<float> queries;
+        for (int i = 0; i < nums[n] && ret == ESP_OK; i += batch) {
+            // 5 photos of each person, the queries are other photos of some of them
+            std::vector<float> feats = gen_test_feats(batch, feat_len, batch / 5, 0.3, i + 1);
+            TensorBase feats_tensor({batch, feat_len}, feats.data(), 0, DATA_TYPE_FLOAT, false);
+            ret = db->enroll_feats(&feats_tensor);
+            for (int j = 0; j < num_queries * batch / nums[n]; j++) {
+                std::vector<float> query = gen_test_query(feats.data() + j * 5 * feat_len, feat_len, 0.02, i + j);
+                queries.insert(queries.end(), query.begin(), query.end());
+            }
+        }
+        if (ret != ESP_OK) {
+            printf("| %d | %d | skipped, out of PSRAM | | | |\n", nums[n], nlist);
+            delete db;
+            continue;
+        }
+
+        // all lists are scored like brute force
+        std::vector<std::vector<result_t>> ref;
+        db->set_index_nprobe(nlist);
+        for (int i = 0; i < num_queries; i++) {
+            TensorBase query({feat_len}, queries.data() + i * feat_len, 0, DATA_TYPE_FLOAT, false);
+            ref.push_back(db->query_feat(&query, -2.f, top_k));
+        }
+        for (int p = 0; p < 5; p++) {
+            db->set_index_nprobe(nprobes[p]);
+            int hits_1 = 0;
+            int hits_k = 0;
+            int64_t query_time = 0;
+            for (int i = 0; i < num_queries; i++) {
+                TensorBase query({feat_len}, queries.data() + i * feat_len, 0, DATA_TYPE_FLOAT, false);
+                int64_t start = esp_timer_get_time();
+                std::vector<result_t> results = db->query_feat(&query, -2.f, top_k);
+                query_time += esp_timer_get_time() - start;
+                hits_1 += !results.empty() && results[0].id == ref[i][0].id;
+                for (const result_t &result : results) {
+                    for (const result_t &expected : ref[i]) {
+                        hits_k += result.id == expected.id;
+                    }
+                }
+            }
+            printf("| %d | %d | %d | %.3f | %.3f | %.2f |\n",
+                   nums[n],
+                   nlist,
+                   nprobes[p],
+                   (float)hits_1 / num_queries,
+                   (float)hits_k / (num_queries * top_k),
+                   query_time / 1000.f / num_queries);
+        }
+        delete db;
+    }
+}
+
+static std::vector<uint8_t> read_test_file(const char *path)
+{
+    std::vector<uint8_t> data;
+    FILE *f = fopen(path, "rb");
+    TEST_ASSERT_NOT_NULL(f);
+    uint8_t buffer[256];
+    size_t size;
+    while ((size = fread(buffer, 1, sizeof(buffer), f)) > 0) {
+        data.insert(data.end(), buffer, buffer + size);
+    }
+    fclose(f);
+    return data;
+}
+
+static void write_test_file(const char *path, const std::vector<uint8_t> &data)
+{
+    FILE *f = fopen(path, "wb");
+    TEST_ASSERT_NOT_NULL(f);
+    TEST_ASSERT_EQUAL(data.size(), fwrite(data.data(), 1, data.size(), f));
+    fclose(f);
+}
+
+/**
+ * Check the header and the records of the database file against the expected (type, id) of each record.
+ */
+static void check_db_file(const std::vector<float> &feats,
+                          int feat_len,
+                          int num_feats_total,
+                          const std::vector<std::pair<uint16_t, uint16_t>> &records)
+{
+    std::vector<uint8_t> data = read_test_file(TEST_DB_PATH);
+    size_t record_bytes = sizeof(database_record) + feat_len * sizeof(float);
+    size_t size = sizeof(database_header);
+    for (auto &record : records) {
+        size += record.first == DATABASE_RECORD_ENROLL ? record_bytes : sizeof(database_record);
+    }
+    TEST_ASSERT_EQUAL(size, data.size());
+
+    database_header header;
+    memcpy(&header, data.data(), sizeof(database_header));
+    TEST_ASSERT_EQUAL(0x42444c45, header.magic);
+    TEST_ASSERT_EQUAL(2, header.version);
+    TEST_ASSERT_EQUAL(feat_len, header.feat_len);
+    TEST_ASSERT_EQUAL(num_feats_total, header.num_feats_total);
+    TEST_ASSERT_EQUAL(esp_rom_crc32_le(0, data.data(), offsetof(database_header, crc)), header.crc);
+
+    const uint8_t *ptr = data.data() + sizeof(database_header);
+    for (auto &expected : records) {
+        database_record record;
+        memcpy(&record, ptr, sizeof(database_record));
+        TEST_ASSERT_EQUAL(expected.first, record.type);
+        TEST_ASSERT_EQUAL(expected.second, record.id);
+        uint32_t crc = esp_rom_crc32_le(0, ptr, offsetof(database_record, crc));
+        ptr += sizeof(database_record);
+        if (record.type == DATABASE_RECORD_ENROLL) {
+            // the float feature as enrolled
+            TEST_ASSERT_EQUAL(0, memcmp(ptr, feats.data() + (record.id - 1) * feat_len, feat_len * sizeof(float)));
+            crc = esp_rom_crc32_le(crc, ptr, feat_len * sizeof(float));
+            ptr += feat_len * sizeof(float);
+        }
+        TEST_ASSERT_EQUAL(crc, record.crc);
+    }
+}
+
+TEST_CASE("Test dl recognition API: database file format", "[api]")
+{
+    ESP_LOGI(TAG, "Test dl recognition API: database file format");
+    mount_storage();
+    const int feat_len = 16;
+    const int num = 80;
+    const size_t record_bytes = sizeof(database_record) + feat_len * sizeof(float);
+    std::vector<float> feats = gen_test_feats(num, feat_len, num, 0, 3);
+    std::vector<std::pair<uint16_t, uint16_t>> records;
+
+    // enroll and delete append records after the header
+    DataBase *db = new DataBase(TEST_DB_PATH, feat_len, DATA_TYPE_INT8);
+    check_db_file(feats, feat_len, 0, records);
+    TensorBase batch({3, feat_len}, feats.data(), 0, DATA_TYPE_FLOAT, false);
+    TEST_ASSERT_EQUAL(ESP_OK, db->enroll_feats(&batch));
+    TEST_ASSERT_EQUAL(ESP_OK, db->delete_feat(2));
+    records = {{DATABASE_RECORD_ENROLL, 1},
+               {DATABASE_RECORD_ENROLL, 2},
+               {DATABASE_RECORD_ENROLL, 3},
+               {DATABASE_RECORD_DELETE, 2}};
+    check_db_file(feats, feat_len, 0, records);
+
+    // compaction keeps the valid features and the ids
+    TEST_ASSERT_EQUAL(ESP_OK, db->compact());
+    records = {{DATABASE_RECORD_ENROLL, 1}, {DATABASE_RECORD_ENROLL, 3}};
+    check_db_file(feats, feat_len, 3, records);
+    delete db;
+    db = new DataBase(TEST_DB_PATH, feat_len);
+    check_queries(
+        db, std::vector<float>(feats.begin(), feats.begin() + 3 * feat_len), {1, 3}, feat_len, DATA_TYPE_FLOAT, 1e-5);
+    TensorBase feat({feat_len}, feats.data() + 3 * feat_len, 0, DATA_TYPE_FLOAT, false);
+    TEST_ASSERT_EQUAL(ESP_OK, db->enroll_feat(&feat));
+    records.push_back({DATABASE_RECORD_ENROLL, 4});
+    check_db_file(feats, feat_len, 3, records);
+
+    // deleting compacts the file once the dead records reach the valid ones
+    TensorBase rest({num - 4, feat_len}, feats.data() + 4 * feat_len, 0, DATA_TYPE_FLOAT, false);
+    TEST_ASSERT_EQUAL(ESP_OK, db->enroll_feats(&rest));
+    std::vector<uint16_t> ids = {1, 3};
+    for (int i = 4; i <= num; i++) {
+        ids.push_back(i);
+    }
+    int num_deleted = 0;
+    while (true) {
+        TEST_ASSERT_EQUAL(ESP_OK, db->delete_feat(ids.back()));
+        ids.pop_back();
+        num_deleted++;
+        if (read_test_file(TEST_DB_PATH).size() == sizeof(database_header) + ids.size() * record_bytes) {
+            break;
+        }
+        TEST_ASSERT_TRUE(num_deleted < num / 2);
+    }
+    TEST_ASSERT_EQUAL(64, num_deleted * 2);
+    records.clear();
+    for (uint16_t id : ids) {
+        records.push_back({DATABASE_RECORD_ENROLL, id});
+    }
+    check_db_file(feats, feat_len, num, records);
+    delete db;
+
+    // a record torn at the end of the file is dropped, by a short write or by a full one with a wrong crc
+    for (int torn = 0; torn < 2; torn++) {
+        std::vector<uint8_t> data = read_test_file(TEST_DB_PATH);
+        if (torn == 0) {
+            data.resize(data.size() - 10);
+        } else {
+            data.back() ^= 1;
+        }
+        write_test_file(TEST_DB_PATH, data);
+        db = new DataBase(TEST_DB_PATH, feat_len);
+        ids.pop_back();
+        records.pop_back();
+        check_db_file(feats, feat_len, num, records);
+        check_queries(db, feats, ids, feat_len, DATA_TYPE_FLOAT, 1e-5);
+        delete db;
+    }
+
+    // a corrupted record before the end stops the load, the file is kept and not written
+    std::vector<uint8_t> data = read_test_file(TEST_DB_PATH);
+    data[sizeof(database_header) + 2 * record_bytes + sizeof(database_record)] ^= 1;
+    write_test_file(TEST_DB_PATH, data);
+    db = new DataBase(TEST_DB_PATH, feat_len);
+    TEST_ASSERT_EQUAL(2, db->get_num_feats());
+    TEST_ASSERT_EQUAL(ESP_FAIL, db->enroll_feat(&feat));
+    TEST_ASSERT_EQUAL(ESP_FAIL, db->delete_feat(1));
+    TEST_ASSERT_EQUAL(ESP_FAIL, db->compact());
+    delete db;
+    std::vector<uint8_t> kept = read_test_file(TEST_DB_PATH);
+    TEST_ASSERT_EQUAL(data.size(), kept.size());
+    TEST_ASSERT_EQUAL(0, memcmp(data.data(), kept.data(), data.size()));
+
+    // until the database is cleared
+    db = new DataBase(TEST_DB_PATH, feat_len);
+    TEST_ASSERT_EQUAL(ESP_OK, db->clear_all_feats());
+    TEST_ASSERT_EQUAL(ESP_OK, db->enroll_feat(&feat));
+    TEST_ASSERT_EQUAL(1, db->get_num_feats());
+    delete db;
+    unmount_storage();
+}
+
+#if CONFIG_IDF_TARGET_ESP32S3 || CONFIG_IDF_TARGET_ESP32P4
+extern const uint8_t api_models_espdl[] asm("_binary_api_models_espdl_start");
+
+class TestFeat : public dl::feat::FeatImpl {
+public:
+    TestFeat()
+    {
+        m_model = new dl::Model((const char *)api_models_espdl, "human_face_feat_mfn_s8_v1.espdl");
+        m_model->minimize();
+        m_image_preprocessor =
+            new dl::image::FeatImagePreprocessor(m_model, {127.5, 127.5, 127.5}, {127.5, 127.5, 127.5});
+        m_postprocessor = new dl::feat::FeatPostprocessor(m_model);
+        m_feat_len = m_model->get_output()->get_size();
+    }
+};
+
+TEST_CASE("Test dl recognition API: batched feature extraction", "[api]")
+{
+    ESP_LOGI(TAG, "Test dl recognition API: batched feature extraction");
+    const int width = 320;
+    const int height = 240;
+    std::vector<uint8_t> pixels(width * height * 3);
+    uint32_t seed = 5;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            uint8_t *pixel = pixels.data() + (y * width + x) * 3;
+            pixel[0] = x * 255 / width;
+            pixel[1] = y * 255 / height;
+            pixel[2] = test_rand(seed);
+        }
+    }
+    dl::image::img_t img = {pixels.data(), width, height, dl::image::DL_IMAGE_PIX_TYPE_RGB888};
+
+    // left eye, left mouth corner, nose, right eye, right mouth corner of faces of different sizes
+    std::vector<std::vector<int>> landmarks;
+    for (int i = 0; i < 5; i++) {
+        int x = 50 + i * 55;
+        int y = 70 + (i % 2) * 90;
+        int s = 20 + i * 4;
+        landmarks.push_back({x - s, y - s, x - s + 2, y + s, x, y, x + s, y - s - i, x + s - 2, y + s});
+    }
+
+    TestFeat *feat = new TestFeat();
+    std::vector<float> ref(landmarks.size() * feat->m_feat_len);
+    for (int i = 0; i < landmarks.size(); i++) {
+        TensorBase *out = feat->run(img, landmarks[i]);
+        memcpy(ref.data() + i * feat->m_feat_len, out->data, feat->m_feat_len * sizeof(float));
+    }
+
+    // single core model runs align the next face on the other core, multi core runs align in turn
+    runtime_mode_t modes[2] = {RUNTIME_MODE_SINGLE_CORE, RUNTIME_MODE_MULTI_CORE};
+    for (int m = 0; m < 2; m++) {
+        for (int n = 1; n <= landmarks.size(); n += 3) {
+            std::vector<std::vector<int>> batch(landmarks.begin(), landmarks.begin() + n);
+            TensorBase *feats = feat->run(img, batch, modes[m]);
+            TEST_ASSERT_EQUAL(n, feats->shape[0]);
+            TEST_ASSERT_EQUAL(feat->m_feat_len, feats->shape[1]);
+            TEST_ASSERT_EQUAL(0, memcmp(ref.data(), feats->data, n * feat->m_feat_len * sizeof(float)));
+        }
+    }
+    delete feat;
+}
+#endif
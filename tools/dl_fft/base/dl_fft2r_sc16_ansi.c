@@ -391,6 +391,32 @@ esp_err_t dl_bitrev2r_sc16_ansi(int16_t *data, int N)
     return result;
 }
 
+esp_err_t dl_bitrev2r_sc16_batch_ansi(int16_t *data, int N, int batch, int istride, int cstride)
+{
+    int j, k;
+    uint32_t temp;
+    uint32_t *in_data = (uint32_t *)data;
+    j = 0;
+    for (int i = 1; i < (N - 1); i++) {
+        k = N >> 1;
+        while (k <= j) {
+            j -= k;
+            k >>= 1;
+        }
+        j += k;
+        if (i < j) {
+            // the index pair is computed once for all signals
+            for (int c = 0; c < batch; c++) {
+                uint32_t *x = in_data + c * cstride;
+                temp = x[j * istride];
+                x[j * istride] = x[i * istride];
+                x[i * istride] = temp;
+            }
+        }
+    }
+    return ESP_OK;
+}
+
 esp_err_t dl_cplx2reC_sc16(int16_t *data, int N)
 {
     esp_err_t result = ESP_OK;
@@ -0,0 +1,497 @@
+#include "dl_fft_base.h"
+
+/*
+ * Radix-4 int16 fft. A radix-4 stage does the work of two consecutive radix-2 stages of dl_fft2r_sc16_ansi() on the
+ * same data layout: group j uses U = w[2j], U^2 = w[j] and U^3 from the tail of the table, where w is the bit reversed
+ * radix-2 twiddle table. The output is left in the same bit reversed order, so dl_bitrev2r_sc16_ansi() and the rfft
+ * pre/post processing are shared with the radix-2 path. If log2(N) is odd, a radix-2 stage finishes the transform.
+ *
+ * Butterflies are accumulated in int32 and rounded once per stage: 3 complex multiplications instead of 4 and half of
+ * the rounding steps compared with two radix-2 stages.
+ */
+
+// Number of bits of the largest magnitude, tracked by or-ing |x| (or |x| - 1 for negative x) of the outputs.
+static inline int dl_bits_u32(uint32_t x)
+{
+    return x ? 32 - __builtin_clz(x) : 0;
+}
+
+static inline uint32_t dl_abs_bits_s32(int32_t x)
+{
+    return (uint32_t)(x ^ (x >> 31));
+}
+
+static uint32_t dl_abs_bits_sc16(const int16_t *data, int N)
+{
+    uint32_t bits = 0;
+    for (int i = 0; i < N * 2; i++) {
+        bits |= dl_abs_bits_s32(data[i]);
+    }
+    return bits;
+}
+
+/**
+ * @brief One radix-4 butterfly from x into y, which may be the same. The result is (sum + round) >> shift, sum is
+ * scaled by 2^13.
+ * @return Magnitude bits of the outputs if track is true, otherwise 0.
+ */
+static inline uint32_t dl_fft4r_bfly_sc16(const dl_sc16_t *x0,
+                                          const dl_sc16_t *x1,
+                                          const dl_sc16_t *x2,
+                                          const dl_sc16_t *x3,
+                                          dl_sc16_t *y0,
+                                          dl_sc16_t *y1,
+                                          dl_sc16_t *y2,
+                                          dl_sc16_t *y3,
+                                          dl_sc16_t u1,
+                                          dl_sc16_t u2,
+                                          dl_sc16_t u3,
+                                          int shift,
+                                          bool inverse,
+                                          bool track)
+{
+    int32_t round = 1 << (shift - 1);
+    dl_sc16_t a0 = *x0;
+    dl_sc16_t a1 = *x1;
+    dl_sc16_t a2 = *x2;
+    dl_sc16_t a3 = *x3;
+
+    // conj(U^k) * a_k in Q13
+    int32_t b1_re = ((int32_t)u1.re * a1.re + (int32_t)u1.im * a1.im + 2) >> 2;
+    int32_t b1_im = ((int32_t)u1.re * a1.im - (int32_t)u1.im * a1.re + 2) >> 2;
+    int32_t b2_re = ((int32_t)u2.re * a2.re + (int32_t)u2.im * a2.im + 2) >> 2;
+    int32_t b2_im = ((int32_t)u2.re * a2.im - (int32_t)u2.im * a2.re + 2) >> 2;
+    int32_t b3_re = ((int32_t)u3.re * a3.re + (int32_t)u3.im * a3.im + 2) >> 2;
+    int32_t b3_im = ((int32_t)u3.re * a3.im - (int32_t)u3.im * a3.re + 2) >> 2;
+
+    int32_t a0_re = (int32_t)a0.re << 13;
+    int32_t a0_im = (int32_t)a0.im << 13;
+    int32_t c0_re = a0_re + b2_re;
+    int32_t c0_im = a0_im + b2_im;
+    int32_t c2_re = a0_re - b2_re;
+    int32_t c2_im = a0_im - b2_im;
+    int32_t d0_re = b1_re + b3_re;
+    int32_t d0_im = b1_im + b3_im;
+    int32_t d1_re = b1_re - b3_re;
+    int32_t d1_im = b1_im - b3_im;
+    if (inverse) { // y2 = c2 + i * d1, y3 = c2 - i * d1
+        d1_re = -d1_re;
+        d1_im = -d1_im;
+    }
+
+    int32_t y0_re = (c0_re + d0_re + round) >> shift;
+    int32_t y0_im = (c0_im + d0_im + round) >> shift;
+    int32_t y1_re = (c0_re - d0_re + round) >> shift;
+    int32_t y1_im = (c0_im - d0_im + round) >> shift;
+    int32_t y2_re = (c2_re + d1_im + round) >> shift;
+    int32_t y2_im = (c2_im - d1_re + round) >> shift;
+    int32_t y3_re = (c2_re - d1_im + round) >> shift;
+    int32_t y3_im = (c2_im + d1_re + round) >> shift;
+
+    y0->re = y0_re;
+    y0->im = y0_im;
+    y1->re = y1_re;
+    y1->im = y1_im;
+    y2->re = y2_re;
+    y2->im = y2_im;
+    y3->re = y3_re;
+    y3->im = y3_im;
+    if (track) {
+        return dl_abs_bits_s32(y0_re) | dl_abs_bits_s32(y0_im) | dl_abs_bits_s32(y1_re) | dl_abs_bits_s32(y1_im) |
+            dl_abs_bits_s32(y2_re) | dl_abs_bits_s32(y2_im) | dl_abs_bits_s32(y3_re) | dl_abs_bits_s32(y3_im);
+    }
+    return 0;
+}
+
+/**
+ * @brief The twiddles of radix-4 group j, conjugated for the inverse transform.
+ */
+static inline void dl_fft4r_twiddle_sc16(
+    const uint32_t *w, const uint32_t *w3, int j, bool inverse, dl_sc16_t *u1, dl_sc16_t *u2, dl_sc16_t *u3)
+{
+    u1->data = w[2 * j];
+    u2->data = w[j];
+    u3->data = w3[j];
+    if (inverse) {
+        u1->im = -u1->im;
+        u2->im = -u2->im;
+        u3->im = -u3->im;
+    }
+}
+
+/**
+ * @brief One radix-4 stage, the result is (sum + round) >> shift, sum is scaled by 2^13.
+ * @return Magnitude bits of the outputs if track is true, otherwise 0.
+ */
+static inline uint32_t dl_fft4r_stage_sc16(
+    dl_sc16_t *data, int N4, int ie, const uint32_t *w, const uint32_t *w3, int shift, bool inverse, bool track)
+{
+    uint32_t bits = 0;
+
+    for (int j = 0; j < ie; j++) {
+        dl_sc16_t u1, u2, u3;
+        dl_fft4r_twiddle_sc16(w, w3, j, inverse, &u1, &u2, &u3);
+
+        dl_sc16_t *x0 = data + j * 4 * N4;
+        dl_sc16_t *x1 = x0 + N4;
+        dl_sc16_t *x2 = x1 + N4;
+        dl_sc16_t *x3 = x2 + N4;
+        for (int i = 0; i < N4; i++) {
+            bits |= dl_fft4r_bfly_sc16(
+                x0 + i, x1 + i, x2 + i, x3 + i, x0 + i, x1 + i, x2 + i, x3 + i, u1, u2, u3, shift, inverse, track);
+        }
+    }
+    return bits;
+}
+
+/**
+ * @brief The radix-2 butterfly of the last stage from x into y, which may be the same. The result is
+ * (sum + round) >> shift, sum is scaled by 2^14.
+ */
+static inline void dl_fft2r_bfly_sc16(
+    const dl_sc16_t *x0, const dl_sc16_t *x1, dl_sc16_t *y0, dl_sc16_t *y1, dl_sc16_t cs, int shift)
+{
+    int32_t round = 1 << (shift - 1);
+    dl_sc16_t a = *x0;
+    dl_sc16_t m = *x1;
+    int32_t t_re = ((int32_t)cs.re * m.re + (int32_t)cs.im * m.im + 1) >> 1;
+    int32_t t_im = ((int32_t)cs.re * m.im - (int32_t)cs.im * m.re + 1) >> 1;
+    int32_t a_re = (int32_t)a.re << 14;
+    int32_t a_im = (int32_t)a.im << 14;
+
+    y0->re = (a_re + t_re + round) >> shift;
+    y0->im = (a_im + t_im + round) >> shift;
+    y1->re = (a_re - t_re + round) >> shift;
+    y1->im = (a_im - t_im + round) >> shift;
+}
+
+/**
+ * @brief The last radix-2 stage (N2 = 1) for odd log2(N), the result is (sum + round) >> shift, sum is scaled by 2^14.
+ */
+static inline void dl_fft2r_last_stage_sc16(dl_sc16_t *data, int N, const uint32_t *w, int shift, bool inverse)
+{
+    for (int j = 0; j < N / 2; j++) {
+        dl_sc16_t cs;
+        cs.data = w[j];
+        if (inverse) {
+            cs.im = -cs.im;
+        }
+        dl_fft2r_bfly_sc16(data + 2 * j, data + 2 * j + 1, data + 2 * j, data + 2 * j + 1, cs, shift);
+    }
+}
+
+static inline void dl_fft4r_sc16_impl(int16_t *data, int N, int16_t *table, bool inverse)
+{
+    dl_sc16_t *x = (dl_sc16_t *)data;
+    const uint32_t *w = (const uint32_t *)table;
+    const uint32_t *w3 = (const uint32_t *)(table + N);
+    int ie = 1;
+    int N4 = N >> 2;
+
+    for (; N4 > 0; N4 >>= 2) {
+        dl_fft4r_stage_sc16(x, N4, ie, w, w3, 15, inverse, false); // sum / 4
+        ie <<= 2;
+    }
+    if (ie < N) {
+        dl_fft2r_last_stage_sc16(x, N, w, 15, inverse); // sum / 2
+    }
+}
+
+static inline void dl_fft4r_sc16_hp_impl(int16_t *data, int N, int16_t *table, int *shift, bool inverse)
+{
+    dl_sc16_t *x = (dl_sc16_t *)data;
+    const uint32_t *w = (const uint32_t *)table;
+    const uint32_t *w3 = (const uint32_t *)(table + N);
+    int ie = 1;
+    int N4 = N >> 2;
+    int bits = dl_bits_u32(dl_abs_bits_sc16(data, N));
+
+    // |y| < 5.25 * 2^bits after a radix-4 butterfly, scale it by 2^(12 - bits) to stay below 2^15.
+    shift[0] = 0;
+    for (; N4 > 0; N4 >>= 2) {
+        shift[0] += bits - 12;
+        bits = dl_bits_u32(dl_fft4r_stage_sc16(x, N4, ie, w, w3, bits + 1, inverse, true));
+        ie <<= 2;
+    }
+    // |y| < 2.42 * 2^bits after a radix-2 butterfly, scale it by 2^(13 - bits).
+    if (ie < N) {
+        shift[0] += bits - 13;
+        dl_fft2r_last_stage_sc16(x, N, w, bits + 1, inverse);
+    }
+}
+
+esp_err_t dl_fft4r_sc16_ansi(int16_t *data, int N, int16_t *table)
+{
+    dl_fft4r_sc16_impl(data, N, table, false);
+    return ESP_OK;
+}
+
+esp_err_t dl_ifft4r_sc16_ansi(int16_t *data, int N, int16_t *table)
+{
+    dl_fft4r_sc16_impl(data, N, table, true);
+    return ESP_OK;
+}
+
+esp_err_t dl_fft4r_sc16_hp_ansi(int16_t *data, int N, int16_t *table, int *shift)
+{
+    dl_fft4r_sc16_hp_impl(data, N, table, shift, false);
+    return ESP_OK;
+}
+
+esp_err_t dl_ifft4r_sc16_hp_ansi(int16_t *data, int N, int16_t *table, int *shift)
+{
+    dl_fft4r_sc16_hp_impl(data, N, table, shift, true);
+    return ESP_OK;
+}
+
+/**
+ * @brief Step the bit reversed value r of a counter to the bit reversed value of the next count, msb is the highest
+ * bit of the counter. Amortized it flips two bits, so no bit reversal table is needed.
+ */
+static inline int dl_bitrev_next(int r, int msb)
+{
+    while (r & msb) {
+        r ^= msb;
+        msb >>= 1;
+    }
+    return r | msb;
+}
+
+/**
+ * @brief Radix-4 fft whose last stage writes the outputs in natural order into out, so there is no bit reversal pass.
+ * The other stages run in place on data. Group j of the last radix-4 stage holds the natural order outputs
+ * r + {0, N / 2, N / 4, 3N / 4}, group j of the last radix-2 stage r + {0, N / 2}, with r the bit reversed j.
+ * If shift is not NULL, the stages are scaled like dl_fft4r_sc16_hp_impl().
+ */
+static inline void dl_fft4r_sc16_oop_impl(int16_t *data, int16_t *out, int N, int16_t *table, int *shift, bool inverse)
+{
+    dl_sc16_t *x = (dl_sc16_t *)data;
+    dl_sc16_t *y = (dl_sc16_t *)out;
+    const uint32_t *w = (const uint32_t *)table;
+    const uint32_t *w3 = (const uint32_t *)(table + N);
+    bool track = shift != NULL;
+    uint32_t bits = track ? dl_abs_bits_sc16(data, N) : 0;
+    int stage_shift = 15;
+    int ie = 1;
+    int N4 = N >> 2;
+
+    if (track) {
+        shift[0] = 0;
+    }
+    for (; N4 > 1; N4 >>= 2) {
+        if (track) {
+            shift[0] += dl_bits_u32(bits) - 12;
+            stage_shift = dl_bits_u32(bits) + 1;
+        }
+        bits = dl_fft4r_stage_sc16(x, N4, ie, w, w3, stage_shift, inverse, track);
+        ie <<= 2;
+    }
+
+    if (N4 == 1) {
+        if (track) {
+            shift[0] += dl_bits_u32(bits) - 12;
+            stage_shift = dl_bits_u32(bits) + 1;
+        }
+        int r = 0;
+        for (int j = 0; j < ie; j++) {
+            dl_sc16_t u1, u2, u3;
+            dl_fft4r_twiddle_sc16(w, w3, j, inverse, &u1, &u2, &u3);
+            dl_sc16_t *x0 = x + 4 * j;
+            dl_fft4r_bfly_sc16(x0,
+                               x0 + 1,
+                               x0 + 2,
+                               x0 + 3,
+                               y + r,
+                               y + r + 2 * ie,
+                               y + r + ie,
+                               y + r + 3 * ie,
+                               u1,
+                               u2,
+                               u3,
+                               stage_shift,
+                               inverse,
+                               false);
+            r = dl_bitrev_next(r, ie >> 1);
+        }
+    } else if (ie < N) {
+        if (track) {
+            shift[0] += dl_bits_u32(bits) - 13;
+            stage_shift = dl_bits_u32(bits) + 1;
+        }
+        int r = 0;
+        for (int j = 0; j < N / 2; j++) {
+            dl_sc16_t cs;
+            cs.data = w[j];
+            if (inverse) {
+                cs.im = -cs.im;
+            }
+            dl_fft2r_bfly_sc16(x + 2 * j, x + 2 * j + 1, y + r, y + r + N / 2, cs, stage_shift);
+            r = dl_bitrev_next(r, N >> 2);
+        }
+    } else {
+        y[0] = x[0];
+    }
+}
+
+esp_err_t dl_fft4r_sc16_oop_ansi(int16_t *data, int16_t *out, int N, int16_t *table)
+{
+    dl_fft4r_sc16_oop_impl(data, out, N, table, NULL, false);
+    return ESP_OK;
+}
+
+esp_err_t dl_ifft4r_sc16_oop_ansi(int16_t *data, int16_t *out, int N, int16_t *table)
+{
+    dl_fft4r_sc16_oop_impl(data, out, N, table, NULL, true);
+    return ESP_OK;
+}
+
+esp_err_t dl_fft4r_sc16_hp_oop_ansi(int16_t *data, int16_t *out, int N, int16_t *table, int *shift)
+{
+    dl_fft4r_sc16_oop_impl(data, out, N, table, shift, false);
+    return ESP_OK;
+}
+
+esp_err_t dl_ifft4r_sc16_hp_oop_ansi(int16_t *data, int16_t *out, int N, int16_t *table, int *shift)
+{
+    dl_fft4r_sc16_oop_impl(data, out, N, table, shift, true);
+    return ESP_OK;
+}
+
+// Signals of a batch are transformed in groups of at most DL_FFT_BATCH_GROUP, which keep their shifts on the stack.
+#define DL_FFT_BATCH_GROUP 16
+
+/**
+ * @brief Radix-4 fft of batch signals, element i of signal c is data[i * istride + c * cstride]. The twiddles of a
+ * group are loaded once for all signals. If shift is not NULL, every signal is scaled like dl_fft4r_sc16_hp_impl()
+ * and gets its own shift, so the results are the same as transforming the signals one by one.
+ */
+static inline void dl_fft4r_sc16_batch_impl(
+    int16_t *data, int N, int16_t *table, int batch, int istride, int cstride, int *shift)
+{
+    const uint32_t *w = (const uint32_t *)table;
+    const uint32_t *w3 = (const uint32_t *)(table + N);
+    bool track = shift != NULL;
+    uint32_t bits[DL_FFT_BATCH_GROUP]; // or of the magnitudes of each signal
+    int stage_shift[DL_FFT_BATCH_GROUP];
+
+    for (int c0 = 0; c0 < batch; c0 += DL_FFT_BATCH_GROUP) {
+        int count = batch - c0 < DL_FFT_BATCH_GROUP ? batch - c0 : DL_FFT_BATCH_GROUP;
+        dl_sc16_t *x = (dl_sc16_t *)data + c0 * cstride;
+        for (int c = 0; c < count; c++) {
+            stage_shift[c] = 15;
+            if (track) {
+                uint32_t b = 0;
+                for (int i = 0; i < N; i++) {
+                    dl_sc16_t v = x[c * cstride + i * istride];
+                    b |= dl_abs_bits_s32(v.re) | dl_abs_bits_s32(v.im);
+                }
+                bits[c] = b;
+                shift[c0 + c] = 0;
+            }
+        }
+
+        int ie = 1;
+        for (int N4 = N >> 2; N4 > 0; N4 >>= 2) {
+            if (track) {
+                for (int c = 0; c < count; c++) {
+                    shift[c0 + c] += dl_bits_u32(bits[c]) - 12;
+                    stage_shift[c] = dl_bits_u32(bits[c]) + 1;
+                    bits[c] = 0;
+                }
+            }
+            for (int j = 0; j < ie; j++) {
+                dl_sc16_t u1, u2, u3;
+                dl_fft4r_twiddle_sc16(w, w3, j, false, &u1, &u2, &u3);
+                for (int c = 0; c < count; c++) {
+                    dl_sc16_t *x0 = x + c * cstride + j * 4 * N4 * istride;
+                    dl_sc16_t *x1 = x0 + N4 * istride;
+                    dl_sc16_t *x2 = x1 + N4 * istride;
+                    dl_sc16_t *x3 = x2 + N4 * istride;
+                    uint32_t b = 0;
+                    for (int i = 0; i < N4 * istride; i += istride) {
+                        b |= dl_fft4r_bfly_sc16(x0 + i,
+                                                x1 + i,
+                                                x2 + i,
+                                                x3 + i,
+                                                x0 + i,
+                                                x1 + i,
+                                                x2 + i,
+                                                x3 + i,
+                                                u1,
+                                                u2,
+                                                u3,
+                                                stage_shift[c],
+                                                false,
+                                                track);
+                    }
+                    bits[c] |= b;
+                }
+            }
+            ie <<= 2;
+        }
+
+        if (ie < N) {
+            if (track) {
+                for (int c = 0; c < count; c++) {
+                    shift[c0 + c] += dl_bits_u32(bits[c]) - 13;
+                    stage_shift[c] = dl_bits_u32(bits[c]) + 1;
+                }
+            }
+            for (int j = 0; j < N / 2; j++) {
+                dl_sc16_t cs;
+                cs.data = w[j];
+                for (int c = 0; c < count; c++) {
+                    dl_sc16_t *x0 = x + c * cstride + 2 * j * istride;
+                    dl_fft2r_bfly_sc16(x0, x0 + istride, x0, x0 + istride, cs, stage_shift[c]);
+                }
+            }
+        }
+    }
+}
+
+esp_err_t dl_fft4r_sc16_batch_ansi(int16_t *data, int N, int16_t *table, int batch, int istride, int cstride)
+{
+    dl_fft4r_sc16_batch_impl(data, N, table, batch, istride, cstride, NULL);
+    return ESP_OK;
+}
+
+esp_err_t dl_fft4r_sc16_hp_batch_ansi(
+    int16_t *data, int N, int16_t *table, int batch, int istride, int cstride, int *shift)
+{
+    dl_fft4r_sc16_batch_impl(data, N, table, batch, istride, cstride, shift);
+    return ESP_OK;
+}
+
+static inline int dl_reverse_bits(int x, int bits)
+{
+    int y = 0;
+    for (int i = 0; i < bits; i++) {
+        y = (y << 1) | ((x >> i) & 1);
+    }
+    return y;
+}
+
+int16_t *dl_gen_fft4r_table_sc16(int fft_point, uint32_t caps)
+{
+    // fft_point / 2 radix-2 twiddles in bit reversed order, followed by U^3 of the fft_point / 4 radix-4 groups
+    int16_t *fft_table = (int16_t *)heap_caps_aligned_alloc(16, (fft_point + fft_point / 2) * sizeof(int16_t), caps);
+
+    if (fft_table) {
+        float e = M_PI * 2.0 / fft_point;
+        for (int i = 0; i < (fft_point >> 1); i++) {
+            fft_table[2 * i] = (int16_t)roundf(INT16_MAX * cosf(i * e));
+            fft_table[2 * i + 1] = (int16_t)roundf(INT16_MAX * sinf(i * e));
+        }
+        dl_bitrev2r_sc16_ansi(fft_table, fft_point >> 1);
+
+        int16_t *w3 = fft_table + fft_point;
+        int log2n = dl_power_of_two(fft_point >> 1);
+        for (int j = 0; j < (fft_point >> 2); j++) {
+            int k = 3 * dl_reverse_bits(2 * j, log2n);
+            w3[2 * j] = (int16_t)roundf(INT16_MAX * cosf(k * e));
+            w3[2 * j + 1] = (int16_t)roundf(INT16_MAX * sinf(k * e));
+        }
+    }
+
+    return fft_table;
+}
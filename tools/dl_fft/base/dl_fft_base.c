@@ -90,3 +90,21 @@ int dl_float_to_short(const float *x, int len, int16_t *y, int out_exponent)
 
     return -exponent;
 }
+
+// round(2^16 * log2(1 + i / 32))
+static const int32_t dl_log2_table_q16[33] = {
+    0,     2909,  5732,  8473,  11136, 13727, 16248, 18704, 21098, 23433, 25711,
+    27936, 30109, 32234, 34312, 36346, 38336, 40286, 42196, 44068, 45904, 47705,
+    49472, 51207, 52911, 54584, 56229, 57845, 59434, 60997, 62534, 64047, 65536,
+};
+
+int32_t dl_log2_u64_q16(uint64_t x)
+{
+    int n = 63 - __builtin_clzll(x);
+    uint32_t m = n >= 16 ? (uint32_t)(x >> (n - 16)) : (uint32_t)(x << (16 - n)); // [2^16, 2^17)
+    uint32_t frac = m - (1 << 16);
+    uint32_t idx = frac >> 11;
+    int32_t r = frac & 0x7ff;
+    int32_t y = dl_log2_table_q16[idx] + (((dl_log2_table_q16[idx + 1] - dl_log2_table_q16[idx]) * r) >> 11);
+    return n * 65536 + y;
+}
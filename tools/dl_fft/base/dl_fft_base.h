@@ -20,6 +20,8 @@ int dl_power_of_two(uint32_t n);
 float *dl_short_to_float(const int16_t *x, int len, int exponent, float *y);
 int16_t dl_array_max_q_s16(const int16_t *x, int size);
 int dl_float_to_short(const float *x, int len, int16_t *y, int out_exponent);
+// log2(x) in Q16 for x > 0, the mantissa is interpolated in a 33 entry table, error < 2e-4
+int32_t dl_log2_u64_q16(uint64_t x);
 
 // float fftr2
 float *dl_gen_fftr2_table_f32(int fft_point, uint32_t caps);
@@ -41,6 +43,15 @@ esp_err_t dl_bitrev4r_fc32_ansi(float *data, int N, uint16_t *reverse_tab, int b
 esp_err_t dl_rfft_post_proc_fc32_ansi(float *data, int N, float *table);
 esp_err_t dl_rfft_pre_proc_fc32_ansi(float *data, int N, float *table);
 
+// float fft of a length which is not a power of two, mixed-radix (2, 3, 4, 5) or Bluestein
+typedef struct dl_fft_plan_fc32_s dl_fft_plan_fc32_t;
+
+dl_fft_plan_fc32_t *dl_gen_fft_plan_fc32(int fft_point, uint32_t caps);
+void dl_free_fft_plan_fc32(dl_fft_plan_fc32_t *plan);
+
+esp_err_t dl_fft_plan_fc32_ansi(dl_fft_plan_fc32_t *plan, float *data);
+esp_err_t dl_ifft_plan_fc32_ansi(dl_fft_plan_fc32_t *plan, float *data);
+
 // int16 fft and rfft
 int16_t *dl_gen_fft_table_sc16(int fft_point, uint32_t caps);
 int16_t *dl_gen_rfft_table_s16(int fft_point, uint32_t caps);
@@ -56,6 +67,27 @@ esp_err_t dl_rfft_post_proc_sc16_ansi(int16_t *data, int N, int16_t *table);
 esp_err_t dl_rfft_pre_proc_sc16_ansi(int16_t *data, int N, int16_t *table);
 esp_err_t dl_cplx2real_sc16_hp_ansi(int16_t *data, int N, int16_t *table, int *shift);
 
+// int16 fftr4, the table is the radix-2 table followed by the radix-4 twiddles, see dl_gen_fft4r_table_sc16()
+int16_t *dl_gen_fft4r_table_sc16(int fft_point, uint32_t caps);
+
+esp_err_t dl_fft4r_sc16_hp_ansi(int16_t *data, int N, int16_t *table, int *shift);
+esp_err_t dl_fft4r_sc16_ansi(int16_t *data, int N, int16_t *table);
+
+esp_err_t dl_ifft4r_sc16_hp_ansi(int16_t *data, int N, int16_t *table, int *shift);
+esp_err_t dl_ifft4r_sc16_ansi(int16_t *data, int N, int16_t *table);
+
+// out-of-place, the last stage writes natural order results into out and data is overwritten by the other stages
+esp_err_t dl_fft4r_sc16_oop_ansi(int16_t *data, int16_t *out, int N, int16_t *table);
+esp_err_t dl_ifft4r_sc16_oop_ansi(int16_t *data, int16_t *out, int N, int16_t *table);
+esp_err_t dl_fft4r_sc16_hp_oop_ansi(int16_t *data, int16_t *out, int N, int16_t *table, int *shift);
+esp_err_t dl_ifft4r_sc16_hp_oop_ansi(int16_t *data, int16_t *out, int N, int16_t *table, int *shift);
+
+// batch: element i of signal c is at complex index i * istride + c * cstride
+esp_err_t dl_fft4r_sc16_batch_ansi(int16_t *data, int N, int16_t *table, int batch, int istride, int cstride);
+esp_err_t dl_fft4r_sc16_hp_batch_ansi(
+    int16_t *data, int N, int16_t *table, int batch, int istride, int cstride, int *shift);
+esp_err_t dl_bitrev2r_sc16_batch_ansi(int16_t *data, int N, int batch, int istride, int cstride);
+
 #if CONFIG_IDF_TARGET_ESP32
 #define dl_fft2r_fc32 dl_fft2r_fc32_ae32_
 #define dl_ifft2r_fc32 dl_ifft2r_fc32_ae32_
@@ -82,6 +114,16 @@ esp_err_t dl_cplx2real_sc16_hp_ansi(int16_t *data, int N, int16_t *table, int *s
 #define dl_fft2r_sc16_hp dl_fft2r_sc16_hp_ansi
 #define dl_ifft2r_sc16 dl_ifft2r_sc16_ansi
 #define dl_ifft2r_sc16_hp dl_ifft2r_sc16_hp_ansi
+#define dl_fft4r_sc16 dl_fft4r_sc16_ansi
+#define dl_fft4r_sc16_hp dl_fft4r_sc16_hp_ansi
+#define dl_ifft4r_sc16 dl_ifft4r_sc16_ansi
+#define dl_ifft4r_sc16_hp dl_ifft4r_sc16_hp_ansi
+#define dl_fft4r_sc16_oop dl_fft4r_sc16_oop_ansi
+#define dl_ifft4r_sc16_oop dl_ifft4r_sc16_oop_ansi
+#define dl_fft4r_sc16_hp_oop dl_fft4r_sc16_hp_oop_ansi
+#define dl_ifft4r_sc16_hp_oop dl_ifft4r_sc16_hp_oop_ansi
+#define dl_fft4r_sc16_batch dl_fft4r_sc16_batch_ansi
+#define dl_fft4r_sc16_hp_batch dl_fft4r_sc16_hp_batch_ansi
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,295 @@
+#include "dl_fft_base.h"
+
+/*
+ * Float fft of a length which is not a power of two.
+ *
+ * Lengths whose only prime factors are 2, 3 and 5 run a mixed-radix (4, 2, 3, 5) Stockham fft: every stage reads one
+ * buffer and writes the other in natural order, so there is no bit reversal. Any other length runs Bluestein's
+ * algorithm, which turns the fft into a circular convolution computed by power of two ffts of length M >= 2N - 1.
+ */
+
+#define DL_FFT_PLAN_MAX_FACTORS 32
+
+struct dl_fft_plan_fc32_s {
+    int N;
+    int factor_num;                       /*!< 0 if the plan is Bluestein */
+    int factors[DL_FFT_PLAN_MAX_FACTORS]; /*!< radix of each stage */
+    dl_fc32_t *table;                     /*!< exp(-2 * pi * i * k / N), k = 0 ... N - 1 */
+    dl_fc32_t *buffer;                    /*!< N complex for mixed-radix, M complex for Bluestein */
+    int M;                                /*!< Bluestein, power of two fft length */
+    dl_fc32_t *chirp;                     /*!< Bluestein, exp(-pi * i * n^2 / N), n = 0 ... N - 1 */
+    dl_fc32_t *chirp_fft;                 /*!< Bluestein, fft of conj(chirp) / M */
+    float *sub_table;                     /*!< Bluestein, radix-2 table of length M */
+    uint16_t *sub_bitrev_table;           /*!< Bluestein, bit reversal table of length M */
+    int sub_bitrev_size;
+};
+
+static int dl_fft_plan_factorize(int N, int *factors)
+{
+    static const int radix[4] = {4, 2, 3, 5};
+    int num = 0;
+    for (int r = 0; r < 4; r++) {
+        // only one radix-2 stage, the others are merged into radix-4 stages
+        while (N % radix[r] == 0 && (radix[r] != 2 || N % 4 != 0)) {
+            factors[num++] = radix[r];
+            N /= radix[r];
+        }
+    }
+    return N == 1 ? num : 0;
+}
+
+static inline dl_fc32_t dl_cmul_fc32(dl_fc32_t a, dl_fc32_t b)
+{
+    dl_fc32_t c;
+    c.re = a.re * b.re - a.im * b.im;
+    c.im = a.re * b.im + a.im * b.re;
+    return c;
+}
+
+static void *dl_fft_plan_alloc(size_t size, uint32_t caps)
+{
+    return heap_caps_aligned_alloc(16, size, caps);
+}
+
+dl_fft_plan_fc32_t *dl_gen_fft_plan_fc32(int fft_point, uint32_t caps)
+{
+    if (fft_point < 2) {
+        return NULL;
+    }
+    dl_fft_plan_fc32_t *plan = (dl_fft_plan_fc32_t *)heap_caps_calloc(1, sizeof(dl_fft_plan_fc32_t), caps);
+    if (!plan) {
+        return NULL;
+    }
+    int N = fft_point;
+    plan->N = N;
+    plan->factor_num = dl_fft_plan_factorize(N, plan->factors);
+
+    if (plan->factor_num > 0) {
+        plan->table = (dl_fc32_t *)dl_fft_plan_alloc(N * sizeof(dl_fc32_t), caps);
+        plan->buffer = (dl_fc32_t *)dl_fft_plan_alloc(N * sizeof(dl_fc32_t), caps);
+        if (!plan->table || !plan->buffer) {
+            dl_free_fft_plan_fc32(plan);
+            return NULL;
+        }
+        for (int k = 0; k < N; k++) {
+            double angle = 2 * M_PI * k / N;
+            plan->table[k].re = cos(angle);
+            plan->table[k].im = -sin(angle);
+        }
+        return plan;
+    }
+
+    // Bluestein: X[k] = chirp[k] * sum(x[n] * chirp[n] * conj(chirp[k - n]))
+    int M = 1;
+    while (M < 2 * N - 1) {
+        M <<= 1;
+    }
+    plan->M = M;
+    plan->chirp = (dl_fc32_t *)dl_fft_plan_alloc(N * sizeof(dl_fc32_t), caps);
+    plan->chirp_fft = (dl_fc32_t *)dl_fft_plan_alloc(M * sizeof(dl_fc32_t), caps);
+    plan->buffer = (dl_fc32_t *)dl_fft_plan_alloc(M * sizeof(dl_fc32_t), caps);
+    plan->sub_table = dl_gen_fftr2_table_f32(M, caps);
+    plan->sub_bitrev_table = dl_gen_bitrev2r_table(M, caps, &plan->sub_bitrev_size);
+    if (!plan->chirp || !plan->chirp_fft || !plan->buffer || !plan->sub_table) {
+        dl_free_fft_plan_fc32(plan);
+        return NULL;
+    }
+
+    for (int n = 0; n < N; n++) {
+        // n^2 mod 2N keeps the angle accurate for large n
+        double angle = M_PI * (double)(((int64_t)n * n) % (2 * N)) / N;
+        plan->chirp[n].re = cos(angle);
+        plan->chirp[n].im = -sin(angle);
+    }
+    dl_fc32_t *b = plan->chirp_fft;
+    float scale = 1.0f / M;
+    memset(b, 0, M * sizeof(dl_fc32_t));
+    for (int n = 0; n < N; n++) {
+        b[n].re = plan->chirp[n].re * scale;
+        b[n].im = -plan->chirp[n].im * scale;
+        if (n > 0) {
+            b[M - n] = b[n];
+        }
+    }
+    dl_fft2r_fc32((float *)b, M, plan->sub_table);
+    dl_bitrev2r_fc32_ansi((float *)b, M, plan->sub_bitrev_table, plan->sub_bitrev_size);
+
+    return plan;
+}
+
+void dl_free_fft_plan_fc32(dl_fft_plan_fc32_t *plan)
+{
+    if (plan) {
+        heap_caps_free(plan->table);
+        heap_caps_free(plan->buffer);
+        heap_caps_free(plan->chirp);
+        heap_caps_free(plan->chirp_fft);
+        heap_caps_free(plan->sub_table);
+        heap_caps_free(plan->sub_bitrev_table);
+        heap_caps_free(plan);
+    }
+}
+
+/**
+ * @brief One Stockham stage of radix p on sub-transforms of length n = p * m, s sub-transforms are interleaved.
+ * dst[r + s * (p * q + j)] = w^(j * q) * sum_k(src[r + s * (q + m * k)] * exp(-2 * pi * i * j * k / p))
+ */
+static void dl_fft_plan_stage_fc32(const dl_fc32_t *src, dl_fc32_t *dst, const dl_fc32_t *table, int p, int m, int s)
+{
+    const float c3 = -0.5f, s3 = 0.866025403784f;             // cos, sin(2 * pi / 3)
+    const float c51 = 0.309016994375f, s51 = 0.951056516295f;  // cos, sin(2 * pi / 5)
+    const float c52 = -0.809016994375f, s52 = 0.587785252292f; // cos, sin(4 * pi / 5)
+
+    for (int q = 0; q < m; q++) {
+        const dl_fc32_t w1 = table[q * s];
+        const dl_fc32_t w2 = table[2 * q * s];
+        const dl_fc32_t w3 = p > 3 ? table[3 * q * s] : w1;
+        const dl_fc32_t w4 = p > 4 ? table[4 * q * s] : w1;
+        const dl_fc32_t *x = src + s * q;
+        dl_fc32_t *y = dst + s * p * q;
+
+        for (int r = 0; r < s; r++) {
+            dl_fc32_t a0 = x[r];
+            dl_fc32_t a1 = x[r + s * m];
+            dl_fc32_t y0, y1, y2, y3, y4;
+
+            if (p == 2) {
+                y0.re = a0.re + a1.re;
+                y0.im = a0.im + a1.im;
+                y1.re = a0.re - a1.re;
+                y1.im = a0.im - a1.im;
+                y[r] = y0;
+                y[r + s] = dl_cmul_fc32(y1, w1);
+            } else if (p == 4) {
+                dl_fc32_t a2 = x[r + 2 * s * m];
+                dl_fc32_t a3 = x[r + 3 * s * m];
+                dl_fc32_t t0 = {{a0.re + a2.re, a0.im + a2.im}};
+                dl_fc32_t t1 = {{a0.re - a2.re, a0.im - a2.im}};
+                dl_fc32_t t2 = {{a1.re + a3.re, a1.im + a3.im}};
+                dl_fc32_t t3 = {{a1.re - a3.re, a1.im - a3.im}};
+                y0.re = t0.re + t2.re;
+                y0.im = t0.im + t2.im;
+                y1.re = t1.re + t3.im; // t1 - i * t3
+                y1.im = t1.im - t3.re;
+                y2.re = t0.re - t2.re;
+                y2.im = t0.im - t2.im;
+                y3.re = t1.re - t3.im; // t1 + i * t3
+                y3.im = t1.im + t3.re;
+                y[r] = y0;
+                y[r + s] = dl_cmul_fc32(y1, w1);
+                y[r + 2 * s] = dl_cmul_fc32(y2, w2);
+                y[r + 3 * s] = dl_cmul_fc32(y3, w3);
+            } else if (p == 3) {
+                dl_fc32_t a2 = x[r + 2 * s * m];
+                dl_fc32_t t1 = {{a1.re + a2.re, a1.im + a2.im}};
+                dl_fc32_t t2 = {{a0.re + c3 * t1.re, a0.im + c3 * t1.im}};
+                dl_fc32_t t3 = {{s3 * (a1.im - a2.im), -s3 * (a1.re - a2.re)}}; // -i * s3 * (a1 - a2)
+                y0.re = a0.re + t1.re;
+                y0.im = a0.im + t1.im;
+                y1.re = t2.re + t3.re;
+                y1.im = t2.im + t3.im;
+                y2.re = t2.re - t3.re;
+                y2.im = t2.im - t3.im;
+                y[r] = y0;
+                y[r + s] = dl_cmul_fc32(y1, w1);
+                y[r + 2 * s] = dl_cmul_fc32(y2, w2);
+            } else { // p == 5
+                dl_fc32_t a2 = x[r + 2 * s * m];
+                dl_fc32_t a3 = x[r + 3 * s * m];
+                dl_fc32_t a4 = x[r + 4 * s * m];
+                dl_fc32_t t1 = {{a1.re + a4.re, a1.im + a4.im}};
+                dl_fc32_t t2 = {{a2.re + a3.re, a2.im + a3.im}};
+                dl_fc32_t t3 = {{a1.re - a4.re, a1.im - a4.im}};
+                dl_fc32_t t4 = {{a2.re - a3.re, a2.im - a3.im}};
+                dl_fc32_t b1 = {{a0.re + c51 * t1.re + c52 * t2.re, a0.im + c51 * t1.im + c52 * t2.im}};
+                dl_fc32_t b2 = {{a0.re + c52 * t1.re + c51 * t2.re, a0.im + c52 * t1.im + c51 * t2.im}};
+                // d1 = -i * (s51 * t3 + s52 * t4), d2 = -i * (s52 * t3 - s51 * t4)
+                dl_fc32_t d1 = {{s51 * t3.im + s52 * t4.im, -s51 * t3.re - s52 * t4.re}};
+                dl_fc32_t d2 = {{s52 * t3.im - s51 * t4.im, -s52 * t3.re + s51 * t4.re}};
+                y0.re = a0.re + t1.re + t2.re;
+                y0.im = a0.im + t1.im + t2.im;
+                y1.re = b1.re + d1.re;
+                y1.im = b1.im + d1.im;
+                y4.re = b1.re - d1.re;
+                y4.im = b1.im - d1.im;
+                y2.re = b2.re + d2.re;
+                y2.im = b2.im + d2.im;
+                y3.re = b2.re - d2.re;
+                y3.im = b2.im - d2.im;
+                y[r] = y0;
+                y[r + s] = dl_cmul_fc32(y1, w1);
+                y[r + 2 * s] = dl_cmul_fc32(y2, w2);
+                y[r + 3 * s] = dl_cmul_fc32(y3, w3);
+                y[r + 4 * s] = dl_cmul_fc32(y4, w4);
+            }
+        }
+    }
+}
+
+static void dl_fft_mixed_fc32(dl_fft_plan_fc32_t *plan, dl_fc32_t *data)
+{
+    dl_fc32_t *src = data;
+    dl_fc32_t *dst = plan->buffer;
+    int n = plan->N;
+    int s = 1;
+
+    for (int i = 0; i < plan->factor_num; i++) {
+        int p = plan->factors[i];
+        n /= p;
+        dl_fft_plan_stage_fc32(src, dst, plan->table, p, n, s);
+        s *= p;
+        dl_fc32_t *tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+    if (src != data) {
+        memcpy(data, src, plan->N * sizeof(dl_fc32_t));
+    }
+}
+
+static void dl_fft_bluestein_fc32(dl_fft_plan_fc32_t *plan, dl_fc32_t *data)
+{
+    int N = plan->N;
+    int M = plan->M;
+    dl_fc32_t *a = plan->buffer;
+
+    for (int n = 0; n < N; n++) {
+        a[n] = dl_cmul_fc32(data[n], plan->chirp[n]);
+    }
+    memset(a + N, 0, (M - N) * sizeof(dl_fc32_t));
+
+    dl_fft2r_fc32((float *)a, M, plan->sub_table);
+    dl_bitrev2r_fc32_ansi((float *)a, M, plan->sub_bitrev_table, plan->sub_bitrev_size);
+    for (int k = 0; k < M; k++) {
+        a[k] = dl_cmul_fc32(a[k], plan->chirp_fft[k]);
+    }
+    dl_ifft2r_fc32((float *)a, M, plan->sub_table);
+    dl_bitrev2r_fc32_ansi((float *)a, M, plan->sub_bitrev_table, plan->sub_bitrev_size);
+
+    for (int k = 0; k < N; k++) {
+        data[k] = dl_cmul_fc32(a[k], plan->chirp[k]);
+    }
+}
+
+esp_err_t dl_fft_plan_fc32_ansi(dl_fft_plan_fc32_t *plan, float *data)
+{
+    if (plan->factor_num > 0) {
+        dl_fft_mixed_fc32(plan, (dl_fc32_t *)data);
+    } else {
+        dl_fft_bluestein_fc32(plan, (dl_fc32_t *)data);
+    }
+    return ESP_OK;
+}
+
+esp_err_t dl_ifft_plan_fc32_ansi(dl_fft_plan_fc32_t *plan, float *data)
+{
+    // ifft(x) = conj(fft(conj(x)))
+    for (int i = 1; i < plan->N * 2; i += 2) {
+        data[i] = -data[i];
+    }
+    dl_fft_plan_fc32_ansi(plan, data);
+    for (int i = 1; i < plan->N * 2; i += 2) {
+        data[i] = -data[i];
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,462 @@
+#include "dl_fbank.h"
+#include "esp_log.h"
+#include <math.h>
+#include <string.h>
+
+static const char *TAG = "dl fbank";
+
+/**
+ * @brief Streaming log-mel filterbank instance structure
+ */
+struct dl_fbank_s {
+    dl_fbank_config_t config;
+    int fft_point;
+    int num_bins;               /*!< fft_point / 2 + 1 power spectrum bins */
+    int16_t *ring;              /*!< the last frame_length samples */
+    int pos;                    /*!< write position in ring, the oldest sample once it is full */
+    int until_next;             /*!< samples to push until the next frame */
+    int16_t *mel_start;         /*!< first bin of each mel filter */
+    int16_t *mel_len;           /*!< number of bins of each mel filter, the weights of all filters are packed */
+    void *out;                  /*!< output buffer of out_frames * num_mels elements */
+    dl_fbank_output_t out_type; /*!< data type of out */
+    int out_exponent;           /*!< exponent of int8 / int16 out */
+    int out_frames;             /*!< number of frames in out */
+    float out_scale;            /*!< 2^-out_exponent */
+    dl_fft_f32_t *fft_f32;      /*!< float path */
+    float *window_f32;          /*!< window divided by 32768 */
+    float *mel_weight_f32;      /*!< packed mel filter weights */
+    float *buf_f32;             /*!< fft_point rfft buffer */
+    float *power_f32;           /*!< num_bins power spectrum */
+    float *mel_f32;             /*!< num_mels log-mel energies */
+    dl_fft_s16_t *fft_s16;      /*!< int16 path */
+    int16_t *window_s16;        /*!< window in Q15 */
+    int16_t *mel_weight_s16;    /*!< packed mel filter weights in Q15 */
+    int32_t *frame_s32;         /*!< frame_length pre-emphasized samples in Q30 */
+    int16_t *buf_s16;           /*!< fft_point rfft buffer */
+    uint32_t *power_s16;        /*!< num_bins power spectrum */
+    int32_t *mel_q16;           /*!< num_mels log-mel energies in Q16 */
+    int32_t floor_q16;          /*!< log(energy_floor) in Q16 */
+    dl_vad_t *vad;              /*!< detector fed with the power spectrum of each frame, NULL if not set */
+};
+
+#define DL_LN2_Q16 45426
+
+static inline float dl_mel_scale(float freq)
+{
+    return 1127.0f * logf(1.0f + freq / 700.0f);
+}
+
+static float dl_fbank_window(dl_fbank_window_t window, int i, int len)
+{
+    float a = 2 * M_PI * i / (len - 1);
+    switch (window) {
+    case DL_FBANK_WINDOW_HANN:
+        return 0.5f - 0.5f * cosf(a);
+    case DL_FBANK_WINDOW_HAMMING:
+        return 0.54f - 0.46f * cosf(a);
+    case DL_FBANK_WINDOW_POVEY:
+        return powf(0.5f - 0.5f * cosf(a), 0.85f);
+    default:
+        return 1.0f;
+    }
+}
+
+/**
+ * @brief Triangular filters on the mel scale, only the non-zero weights are kept.
+ * @return Number of weights. The weights are written if weights is not NULL.
+ */
+static int dl_fbank_gen_mel_filters(dl_fbank_t *handle, float *weights)
+{
+    const dl_fbank_config_t *config = &handle->config;
+    float high_freq = config->high_freq > 0 ? config->high_freq : config->sample_rate * 0.5f;
+    float low_mel = dl_mel_scale(config->low_freq);
+    float delta = (dl_mel_scale(high_freq) - low_mel) / (config->num_mels + 1);
+    float bin_freq = (float)config->sample_rate / handle->fft_point;
+    int num = 0;
+
+    for (int m = 0; m < config->num_mels; m++) {
+        float left = low_mel + m * delta;
+        float center = left + delta;
+        float right = center + delta;
+        handle->mel_start[m] = 0;
+        handle->mel_len[m] = 0;
+        for (int k = 0; k < handle->num_bins; k++) {
+            float mel = dl_mel_scale(k * bin_freq);
+            if (mel <= left || mel >= right) {
+                continue;
+            }
+            if (handle->mel_len[m] == 0) {
+                handle->mel_start[m] = k;
+            }
+            if (weights) {
+                weights[num] = mel <= center ? (mel - left) / delta : (right - mel) / delta;
+            }
+            handle->mel_len[m]++;
+            num++;
+        }
+    }
+    return num;
+}
+
+dl_fbank_t *dl_fbank_init(const dl_fbank_config_t *config, uint32_t caps)
+{
+    int fft_point = config->fft_point;
+    if (fft_point == 0) {
+        fft_point = 1 << dl_power_of_two(config->frame_length);
+        if (fft_point < config->frame_length) {
+            fft_point <<= 1;
+        }
+    }
+    float high_freq = config->high_freq > 0 ? config->high_freq : config->sample_rate * 0.5f;
+    if (config->sample_rate <= 0 || config->frame_length < 2 || config->frame_shift <= 0 ||
+        config->frame_shift > config->frame_length || config->num_mels <= 0 || config->energy_floor <= 0 ||
+        config->low_freq < 0 || high_freq > config->sample_rate * 0.5f || config->low_freq >= high_freq) {
+        ESP_LOGE(TAG, "Invalid filterbank config");
+        return NULL;
+    }
+    if (fft_point < config->frame_length || fft_point % 2 != 0 || (config->use_s16 && !dl_is_power_of_two(fft_point))) {
+        ESP_LOGE(TAG, "FFT point must be an even number >= frame length, and a power of two for int16");
+        return NULL;
+    }
+
+    dl_fbank_t *handle = (dl_fbank_t *)heap_caps_calloc(1, sizeof(dl_fbank_t), caps);
+    if (!handle) {
+        ESP_LOGE(TAG, "Failed to allocate filterbank handle");
+        return NULL;
+    }
+    handle->config = *config;
+    handle->fft_point = fft_point;
+    handle->num_bins = fft_point / 2 + 1;
+    handle->until_next = config->frame_length;
+
+    int num_mels = config->num_mels;
+    int frame_length = config->frame_length;
+    int num_weights;
+    handle->ring = (int16_t *)heap_caps_calloc(frame_length, sizeof(int16_t), caps);
+    handle->mel_start = (int16_t *)heap_caps_malloc(num_mels * sizeof(int16_t), caps);
+    handle->mel_len = (int16_t *)heap_caps_malloc(num_mels * sizeof(int16_t), caps);
+    if (!handle->ring || !handle->mel_start || !handle->mel_len) {
+        goto err;
+    }
+
+    num_weights = dl_fbank_gen_mel_filters(handle, NULL);
+    if (num_weights == 0) {
+        ESP_LOGE(TAG, "No fft bin in the mel filters, increase fft point");
+        dl_fbank_deinit(handle);
+        return NULL;
+    }
+    handle->mel_weight_f32 = (float *)heap_caps_malloc(num_weights * sizeof(float), caps);
+    if (!handle->mel_weight_f32) {
+        goto err;
+    }
+    dl_fbank_gen_mel_filters(handle, handle->mel_weight_f32);
+
+    if (config->use_s16) {
+        handle->fft_s16 = dl_rfft_s16_init(fft_point, caps);
+        handle->window_s16 = (int16_t *)heap_caps_malloc(frame_length * sizeof(int16_t), caps);
+        handle->mel_weight_s16 = (int16_t *)heap_caps_malloc(num_weights * sizeof(int16_t), caps);
+        handle->frame_s32 = (int32_t *)heap_caps_malloc(frame_length * sizeof(int32_t), caps);
+        handle->buf_s16 = (int16_t *)heap_caps_aligned_alloc(16, fft_point * sizeof(int16_t), caps);
+        handle->power_s16 = (uint32_t *)heap_caps_malloc(handle->num_bins * sizeof(uint32_t), caps);
+        handle->mel_q16 = (int32_t *)heap_caps_malloc(num_mels * sizeof(int32_t), caps);
+        if (!handle->fft_s16 || !handle->window_s16 || !handle->mel_weight_s16 || !handle->frame_s32 ||
+            !handle->buf_s16 || !handle->power_s16 || !handle->mel_q16) {
+            goto err;
+        }
+        for (int i = 0; i < frame_length; i++) {
+            handle->window_s16[i] = (int16_t)roundf(INT16_MAX * dl_fbank_window(config->window, i, frame_length));
+        }
+        for (int i = 0; i < num_weights; i++) {
+            handle->mel_weight_s16[i] = (int16_t)roundf(INT16_MAX * handle->mel_weight_f32[i]);
+        }
+        handle->floor_q16 = (int32_t)lroundf(logf(config->energy_floor) * 65536.0f);
+        heap_caps_free(handle->mel_weight_f32);
+        handle->mel_weight_f32 = NULL;
+    } else {
+        handle->fft_f32 = dl_rfft_f32_init(fft_point, caps);
+        handle->window_f32 = (float *)heap_caps_malloc(frame_length * sizeof(float), caps);
+        handle->buf_f32 = (float *)heap_caps_aligned_alloc(16, fft_point * sizeof(float), caps);
+        handle->power_f32 = (float *)heap_caps_malloc(handle->num_bins * sizeof(float), caps);
+        handle->mel_f32 = (float *)heap_caps_malloc(num_mels * sizeof(float), caps);
+        if (!handle->fft_f32 || !handle->window_f32 || !handle->buf_f32 || !handle->power_f32 || !handle->mel_f32) {
+            goto err;
+        }
+        for (int i = 0; i < frame_length; i++) {
+            // samples are scaled to [-1, 1) here
+            handle->window_f32[i] = dl_fbank_window(config->window, i, frame_length) / 32768.0f;
+        }
+    }
+
+    return handle;
+
+err:
+    ESP_LOGE(TAG, "Failed to allocate filterbank buffers");
+    dl_fbank_deinit(handle);
+    return NULL;
+}
+
+void dl_fbank_deinit(dl_fbank_t *handle)
+{
+    if (handle) {
+        dl_rfft_f32_deinit(handle->fft_f32);
+        dl_rfft_s16_deinit(handle->fft_s16);
+        heap_caps_free(handle->ring);
+        heap_caps_free(handle->mel_start);
+        heap_caps_free(handle->mel_len);
+        heap_caps_free(handle->window_f32);
+        heap_caps_free(handle->mel_weight_f32);
+        heap_caps_free(handle->buf_f32);
+        heap_caps_free(handle->power_f32);
+        heap_caps_free(handle->mel_f32);
+        heap_caps_free(handle->window_s16);
+        heap_caps_free(handle->mel_weight_s16);
+        heap_caps_free(handle->frame_s32);
+        heap_caps_free(handle->buf_s16);
+        heap_caps_free(handle->power_s16);
+        heap_caps_free(handle->mel_q16);
+        heap_caps_free(handle);
+    }
+}
+
+esp_err_t dl_fbank_set_output(dl_fbank_t *handle, void *data, dl_fbank_output_t type, int exponent, int num_frames)
+{
+    if (!handle || (data && num_frames <= 0)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    handle->out = data;
+    handle->out_type = type;
+    handle->out_exponent = exponent;
+    handle->out_frames = num_frames;
+    handle->out_scale = ldexpf(1.0f, -exponent);
+    return ESP_OK;
+}
+
+esp_err_t dl_fbank_set_vad(dl_fbank_t *handle, dl_vad_t *vad)
+{
+    if (!handle || (vad && dl_vad_get_num_bins(vad) != handle->num_bins)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    handle->vad = vad;
+    return ESP_OK;
+}
+
+void dl_fbank_reset(dl_fbank_t *handle)
+{
+    if (handle) {
+        handle->pos = 0;
+        handle->until_next = handle->config.frame_length;
+    }
+}
+
+int dl_fbank_get_num_mels(dl_fbank_t *handle)
+{
+    return handle->config.num_mels;
+}
+
+static void dl_fbank_frame_f32(dl_fbank_t *handle)
+{
+    const dl_fbank_config_t *config = &handle->config;
+    int len = config->frame_length;
+    int head = len - handle->pos;
+    float *x = handle->buf_f32;
+
+    // unwrap the ring buffer, oldest sample first
+    for (int i = 0; i < head; i++) {
+        x[i] = handle->ring[handle->pos + i];
+    }
+    for (int i = head; i < len; i++) {
+        x[i] = handle->ring[i - head];
+    }
+    if (config->preemphasis != 0) {
+        for (int i = len - 1; i > 0; i--) {
+            x[i] -= config->preemphasis * x[i - 1];
+        }
+        x[0] -= config->preemphasis * x[0];
+    }
+    for (int i = 0; i < len; i++) {
+        x[i] *= handle->window_f32[i];
+    }
+    memset(x + len, 0, (handle->fft_point - len) * sizeof(float));
+
+    dl_rfft_f32_run(handle->fft_f32, x);
+
+    float *power = handle->power_f32;
+    int nyquist = handle->num_bins - 1;
+    power[0] = x[0] * x[0];
+    power[nyquist] = x[1] * x[1];
+    for (int k = 1; k < nyquist; k++) {
+        power[k] = x[2 * k] * x[2 * k] + x[2 * k + 1] * x[2 * k + 1];
+    }
+    if (handle->vad) {
+        dl_vad_process_f32(handle->vad, power);
+    }
+
+    const float *w = handle->mel_weight_f32;
+    for (int m = 0; m < config->num_mels; m++) {
+        const float *p = power + handle->mel_start[m];
+        float energy = 0;
+        for (int k = 0; k < handle->mel_len[m]; k++) {
+            energy += w[k] * p[k];
+        }
+        w += handle->mel_len[m];
+        handle->mel_f32[m] = logf(energy > config->energy_floor ? energy : config->energy_floor);
+    }
+}
+
+static void dl_fbank_frame_s16(dl_fbank_t *handle)
+{
+    const dl_fbank_config_t *config = &handle->config;
+    int len = config->frame_length;
+    int head = len - handle->pos;
+    int32_t *y = handle->frame_s32;
+
+    for (int i = 0; i < head; i++) {
+        y[i] = handle->ring[handle->pos + i];
+    }
+    for (int i = head; i < len; i++) {
+        y[i] = handle->ring[i - head];
+    }
+    // y = x - c * x[-1] in Q30, |y| < 2^31
+    int32_t coef = (int32_t)lroundf(config->preemphasis * 32768.0f);
+    for (int i = len - 1; i > 0; i--) {
+        y[i] = y[i] * 32768 - coef * y[i - 1];
+    }
+    y[0] = y[0] * 32768 - coef * y[0];
+
+    // block floating point: scale the frame to 15 bits before the window
+    uint32_t bits = 0;
+    for (int i = 0; i < len; i++) {
+        bits |= (uint32_t)(y[i] ^ (y[i] >> 31));
+    }
+    int shift = bits ? 32 - __builtin_clz(bits) - 15 : 0;
+    int16_t *x = handle->buf_s16;
+    if (shift > 0) {
+        int32_t round = 1 << (shift - 1);
+        for (int i = 0; i < len; i++) {
+            x[i] = (((y[i] + round) >> shift) * handle->window_s16[i] + (1 << 14)) >> 15;
+        }
+    } else {
+        for (int i = 0; i < len; i++) {
+            x[i] = (y[i] * (1 << -shift) * handle->window_s16[i] + (1 << 14)) >> 15;
+        }
+    }
+    memset(x + len, 0, (handle->fft_point - len) * sizeof(int16_t));
+
+    int exponent;
+    dl_rfft_s16_hp_run(handle->fft_s16, x, shift - 30, &exponent);
+
+    uint32_t *power = handle->power_s16;
+    int nyquist = handle->num_bins - 1;
+    power[0] = (uint32_t)(x[0] * x[0]);
+    power[nyquist] = (uint32_t)(x[1] * x[1]);
+    for (int k = 1; k < nyquist; k++) {
+        power[k] = (uint32_t)(x[2 * k] * x[2 * k]) + (uint32_t)(x[2 * k + 1] * x[2 * k + 1]);
+    }
+    if (handle->vad) {
+        dl_vad_process_s16(handle->vad, power, 2 * exponent);
+    }
+
+    // energy = sum * 2^(2 * exponent - 15)
+    int32_t log2_scale = (2 * exponent - 15) * 65536;
+    const int16_t *w = handle->mel_weight_s16;
+    for (int m = 0; m < config->num_mels; m++) {
+        const uint32_t *p = power + handle->mel_start[m];
+        uint64_t sum = 0;
+        for (int k = 0; k < handle->mel_len[m]; k++) {
+            sum += (uint64_t)((uint32_t)w[k] * (uint64_t)p[k]);
+        }
+        w += handle->mel_len[m];
+        int32_t log_q16 = handle->floor_q16;
+        if (sum) {
+            log_q16 = ((int64_t)(dl_log2_u64_q16(sum) + log2_scale) * DL_LN2_Q16) >> 16;
+            log_q16 = log_q16 > handle->floor_q16 ? log_q16 : handle->floor_q16;
+        }
+        handle->mel_q16[m] = log_q16;
+    }
+}
+
+static inline int32_t dl_fbank_saturate(int32_t x, int32_t min, int32_t max)
+{
+    return x < min ? min : (x > max ? max : x);
+}
+
+/**
+ * @brief Move the output frames up by one row and write the new frame into the last row.
+ */
+static void dl_fbank_write_frame(dl_fbank_t *handle)
+{
+    int num_mels = handle->config.num_mels;
+    int elem_size = handle->out_type == DL_FBANK_OUTPUT_F32 ? 4 : (handle->out_type == DL_FBANK_OUTPUT_S16 ? 2 : 1);
+    int row_size = num_mels * elem_size;
+    uint8_t *row = (uint8_t *)handle->out + (handle->out_frames - 1) * row_size;
+    memmove(handle->out, (uint8_t *)handle->out + row_size, (handle->out_frames - 1) * row_size);
+
+    int32_t min = handle->out_type == DL_FBANK_OUTPUT_S16 ? INT16_MIN : INT8_MIN;
+    int32_t max = handle->out_type == DL_FBANK_OUTPUT_S16 ? INT16_MAX : INT8_MAX;
+    for (int m = 0; m < num_mels; m++) {
+        int32_t q;
+        if (handle->config.use_s16) {
+            int32_t v = handle->mel_q16[m];
+            if (handle->out_type == DL_FBANK_OUTPUT_F32) {
+                ((float *)row)[m] = v * (1.0f / 65536.0f);
+                continue;
+            }
+            int shift = 16 + handle->out_exponent;
+            if (shift > 0) {
+                q = (v + (1 << (shift - 1))) >> shift;
+            } else {
+                int64_t t = (int64_t)v * (1 << -shift);
+                q = t < INT32_MIN ? INT32_MIN : (t > INT32_MAX ? INT32_MAX : (int32_t)t);
+            }
+        } else {
+            float v = handle->mel_f32[m];
+            if (handle->out_type == DL_FBANK_OUTPUT_F32) {
+                ((float *)row)[m] = v;
+                continue;
+            }
+            float t = roundf(v * handle->out_scale);
+            q = t < INT16_MIN ? INT16_MIN : (t > INT16_MAX ? INT16_MAX : (int32_t)t);
+        }
+        q = dl_fbank_saturate(q, min, max);
+        if (handle->out_type == DL_FBANK_OUTPUT_S16) {
+            ((int16_t *)row)[m] = q;
+        } else {
+            ((int8_t *)row)[m] = q;
+        }
+    }
+}
+
+int dl_fbank_push(dl_fbank_t *handle, const int16_t *pcm, int len)
+{
+    if (!handle || (!pcm && len > 0)) {
+        return -1;
+    }
+
+    int frame_length = handle->config.frame_length;
+    int frames = 0;
+    while (len > 0) {
+        int n = len < handle->until_next ? len : handle->until_next;
+        int first = frame_length - handle->pos;
+        first = n < first ? n : first;
+        memcpy(handle->ring + handle->pos, pcm, first * sizeof(int16_t));
+        memcpy(handle->ring, pcm + first, (n - first) * sizeof(int16_t));
+        handle->pos = (handle->pos + n) % frame_length;
+        handle->until_next -= n;
+        pcm += n;
+        len -= n;
+
+        if (handle->until_next == 0) {
+            if (handle->config.use_s16) {
+                dl_fbank_frame_s16(handle);
+            } else {
+                dl_fbank_frame_f32(handle);
+            }
+            if (handle->out) {
+                dl_fbank_write_frame(handle);
+            }
+            handle->until_next = handle->config.frame_shift;
+            frames++;
+        }
+    }
+    return frames;
+}
@@ -0,0 +1,132 @@
+#pragma once
+#include "dl_rfft.h"
+#include "dl_vad.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Window applied to each frame before the fft
+ */
+typedef enum {
+    DL_FBANK_WINDOW_HANN = 0, /*!< hann window */
+    DL_FBANK_WINDOW_HAMMING,  /*!< hamming window */
+    DL_FBANK_WINDOW_POVEY,    /*!< hann window to the power of 0.85, the default of kaldi */
+    DL_FBANK_WINDOW_RECT,     /*!< no window */
+} dl_fbank_window_t;
+
+/**
+ * @brief Data type of the frames written into the output buffer
+ */
+typedef enum {
+    DL_FBANK_OUTPUT_F32 = 0, /*!< float log-mel energies */
+    DL_FBANK_OUTPUT_S16,     /*!< int16 log-mel energies, value = round(log_mel * 2^-exponent) */
+    DL_FBANK_OUTPUT_S8,      /*!< int8 log-mel energies, value = round(log_mel * 2^-exponent) */
+} dl_fbank_output_t;
+
+/**
+ * @brief Log-mel filterbank configuration
+ */
+typedef struct {
+    int sample_rate;          /*!< sample rate of the input in Hz */
+    int frame_length;         /*!< samples per frame, e.g. 400 for 25 ms at 16 kHz */
+    int frame_shift;          /*!< samples between the starts of two frames, at most frame_length */
+    int fft_point;            /*!< rfft length >= frame_length, 0 selects the next power of two. The int16 path needs
+                                   a power of two, the float path any even length. */
+    int num_mels;             /*!< number of mel filters */
+    float low_freq;           /*!< lower edge of the first mel filter in Hz */
+    float high_freq;          /*!< upper edge of the last mel filter in Hz, 0 selects sample_rate / 2 */
+    float preemphasis;        /*!< pre-emphasis coefficient inside a frame, 0 disables it */
+    float energy_floor;       /*!< mel energies are clamped to this value before the log */
+    dl_fbank_window_t window; /*!< window function */
+    bool use_s16;             /*!< run the int16 rfft and fixed point filterbank, for chips without fpu */
+} dl_fbank_config_t;
+
+#define DL_FBANK_DEFAULT_CONFIG()        \
+    {                                    \
+        .sample_rate = 16000,            \
+        .frame_length = 400,             \
+        .frame_shift = 160,              \
+        .fft_point = 0,                  \
+        .num_mels = 40,                  \
+        .low_freq = 20,                  \
+        .high_freq = 0,                  \
+        .preemphasis = 0.97f,            \
+        .energy_floor = 1e-6f,           \
+        .window = DL_FBANK_WINDOW_POVEY, \
+        .use_s16 = false,                \
+    }
+
+/**
+ * @brief Streaming log-mel filterbank instance
+ */
+typedef struct dl_fbank_s dl_fbank_t;
+
+/**
+ * @brief Initialize a streaming log-mel filterbank. The window, the sparse mel filters and the fft tables are
+ * computed once here.
+ * @param config  Filterbank configuration
+ * @param caps    Configuration flags for memory allocation, same with esp-idf heap_caps_malloc
+ *                (e.g., MALLOC_CAP_8BIT, MALLOC_CAP_INTERNAL, MALLOC_CAP_SPIRAM)
+ * @return dl_fbank_t*  Handle to filterbank instance, NULL if the configuration is invalid or allocation failed
+ */
+dl_fbank_t *dl_fbank_init(const dl_fbank_config_t *config, uint32_t caps);
+
+/**
+ * @brief Deinitialize a streaming log-mel filterbank
+ * @param handle  Filterbank instance handle created by dl_fbank_init()
+ */
+void dl_fbank_deinit(dl_fbank_t *handle);
+
+/**
+ * @brief Set the buffer the frames are written into, e.g. the data of the model input TensorBase.
+ *
+ * The buffer holds the last num_frames frames as [num_frames, num_mels], oldest first. Every new frame moves the
+ * others up by one row and is written into the last row, so the buffer is always laid out like a [1, num_frames,
+ * num_mels] model input. The buffer is not cleared.
+ *
+ * @param handle      Filterbank instance handle
+ * @param data        Output buffer of num_frames * num_mels elements, NULL to stop writing frames
+ * @param type        Data type of the output buffer
+ * @param exponent    Exponent of the int8 / int16 output, e.g. TensorBase::exponent. Ignored for float output.
+ * @param num_frames  Number of frames in the buffer
+ * @return esp_err_t  ESP_OK on success, ESP_ERR_INVALID_ARG otherwise
+ */
+esp_err_t dl_fbank_set_output(dl_fbank_t *handle, void *data, dl_fbank_output_t type, int exponent, int num_frames);
+
+/**
+ * @brief Feed pcm samples. A frame is computed and written into the output buffer every frame_shift samples, once
+ * the first frame_length samples arrived. Samples which do not complete a frame are kept for the next call.
+ * @param handle  Filterbank instance handle
+ * @param pcm     16-bit pcm samples
+ * @param len     Number of samples, any length
+ * @return int    Number of new frames, -1 on error
+ */
+int dl_fbank_push(dl_fbank_t *handle, const int16_t *pcm, int len);
+
+/**
+ * @brief Feed the power spectrum of every new frame to a voice activity detector, e.g. to skip the runs of the
+ * streaming model in silence with dl_vad_check(). The frames are still written into the output buffer.
+ * @param handle  Filterbank instance handle
+ * @param vad     Detector with the same fft_point and sample_rate, NULL to stop feeding it
+ * @return esp_err_t  ESP_OK on success, ESP_ERR_INVALID_ARG if the number of bins differs
+ */
+esp_err_t dl_fbank_set_vad(dl_fbank_t *handle, dl_vad_t *vad);
+
+/**
+ * @brief Drop the buffered samples, the next frame starts with the next pushed sample.
+ * @param handle  Filterbank instance handle
+ */
+void dl_fbank_reset(dl_fbank_t *handle);
+
+/**
+ * @brief Get the number of mel filters
+ * @param handle  Filterbank instance handle
+ * @return int    Number of mel filters
+ */
+int dl_fbank_get_num_mels(dl_fbank_t *handle);
+
+#ifdef __cplusplus
+}
+#endif
@@ -11,6 +11,8 @@ extern "C" {
  * @param log2n      Log base 2 of FFT points
  * @param fft_table  FFT real to complex coefficient table
  * @param rfft_table   FFT complex to real coefficient table
+ * @param plan       Mixed-radix or Bluestein plan if the (complex) FFT length is not a power of two, otherwise NULL
+ * @param batch_buf  Signals gathered by dl_fft_f32_batch_run() from interleaved batches, one per core, or NULL
  */
 typedef struct {
     int fft_point;
@@ -19,6 +21,8 @@ typedef struct {
     float *rfft_table;
     uint16_t *bitrev_table;
     int bitrev_size;
+    dl_fft_plan_fc32_t *plan;
+    float *batch_buf;
 } dl_fft_f32_t;
 
 /**
@@ -37,7 +41,8 @@ typedef struct {
 
 /**
  * @brief Initialize a single-precision floating-point FFT instance
- * @param fft_point  Number of FFT points (must be power of two)
+ * @param fft_point  Number of FFT points. Powers of two are the fastest, lengths like 400 or 480 whose prime
+ *                   factors are 2, 3 and 5 use a mixed-radix FFT, any other length uses Bluestein's algorithm.
  * @param caps       Configuration flags for memory allocation, same with esp-idf heap_caps_malloc
  *                   (e.g., MALLOC_CAP_8BIT, MALLOC_CAP_INTERNAL, MALLOC_CAP_SPIRAM)
  * @return dl_fft_f32_t*  Handle to FFT instance
@@ -121,6 +126,101 @@ esp_err_t dl_fft_s16_hp_run(dl_fft_s16_t *handle, int16_t *data, int in_exponent
  */
 esp_err_t dl_ifft_s16_hp_run(dl_fft_s16_t *handle, int16_t *data, int in_exponent, int *out_exponent);
 
+/**
+ * @brief Execute out-of-place 16-bit fixed-point FFT transform. The last stage writes the results in natural order into
+ * out, there is no bit reversal pass over the data. The results are the same as dl_fft_s16_run().
+ * @param handle        FFT instance handle
+ * @param data          Input buffer, overwritten by the other stages
+ * @param out           Output buffer of fft_point complex values. If it is data, the in-place fft is run.
+ * @param in_exponent   Input data exponent (2^in_exponent scaling factor)
+ * @param out_exponent  Output data exponent (2^out_exponent scaling factor)
+ * @return esp_err_t    ESP_OK on success, error code otherwise
+ */
+esp_err_t dl_fft_s16_oop_run(dl_fft_s16_t *handle, int16_t *data, int16_t *out, int in_exponent, int *out_exponent);
+
+/**
+ * @brief Execute out-of-place 16-bit fixed-point inverse FFT transform. The last stage writes the results in natural
+ * order into out, there is no bit reversal pass over the data. The results are the same as dl_ifft_s16_run().
+ * @param handle        FFT instance handle
+ * @param data          Input buffer, overwritten by the other stages
+ * @param out           Output buffer of fft_point complex values. If it is data, the in-place fft is run.
+ * @param in_exponent   Input data exponent (2^in_exponent scaling factor)
+ * @param out_exponent  Output data exponent (2^out_exponent scaling factor)
+ * @return esp_err_t    ESP_OK on success, error code otherwise
+ */
+esp_err_t dl_ifft_s16_oop_run(dl_fft_s16_t *handle, int16_t *data, int16_t *out, int in_exponent, int *out_exponent);
+
+/**
+ * @brief Execute out-of-place 16-bit fixed-point FFT with high-precision scaling. The last stage writes the results in
+ * natural order into out, there is no bit reversal pass over the data. The results are the same as dl_fft_s16_hp_run().
+ * @param handle        FFT instance handle
+ * @param data          Input buffer, overwritten by the other stages
+ * @param out           Output buffer of fft_point complex values. If it is data, the in-place fft is run.
+ * @param in_exponent   Input data exponent (2^in_exponent scaling factor)
+ * @param out_exponent  Output data exponent (2^out_exponent scaling factor)
+ * @return esp_err_t    ESP_OK on success, error code otherwise
+ */
+esp_err_t dl_fft_s16_hp_oop_run(dl_fft_s16_t *handle, int16_t *data, int16_t *out, int in_exponent, int *out_exponent);
+
+/**
+ * @brief Execute out-of-place 16-bit fixed-point inverse FFT with high-precision scaling. The last stage writes the
+ * results in natural order into out, there is no bit reversal pass over the data. The results are the same as
+ * dl_ifft_s16_hp_run().
+ * @param handle        FFT instance handle
+ * @param data          Input buffer, overwritten by the other stages
+ * @param out           Output buffer of fft_point complex values. If it is data, the in-place fft is run.
+ * @param in_exponent   Input data exponent (2^in_exponent scaling factor)
+ * @param out_exponent  Output data exponent (2^out_exponent scaling factor)
+ * @return esp_err_t    ESP_OK on success, error code otherwise
+ */
+esp_err_t dl_ifft_s16_hp_oop_run(dl_fft_s16_t *handle, int16_t *data, int16_t *out, int in_exponent, int *out_exponent);
+
+/**
+ * Flags of the batched FFTs, which transform a batch of signals of the same length in one call, e.g. the channels of
+ * a microphone array. Without DL_FFT_BATCH_INTERLEAVED the signals are planar, stored one after the other.
+ */
+#define DL_FFT_BATCH_INTERLEAVED (1 << 0) /*!< element i of signal c is element i * batch + c of data */
+#define DL_FFT_BATCH_DUAL_CORE (1 << 1)   /*!< transform the second half of the batch on the other core */
+
+/**
+ * @brief Execute single-precision floating-point FFT transform on a batch of signals
+ * @param handle  FFT instance handle
+ * @param data    Input/output buffer of batch signals, in-place fft calculation
+ * @param batch   Number of signals
+ * @param flags   Bitwise OR of DL_FFT_BATCH_* flags. DL_FFT_BATCH_DUAL_CORE is ignored if fft_point is not a power
+ *                of two.
+ * @return esp_err_t  ESP_OK on success, error code otherwise
+ */
+esp_err_t dl_fft_f32_batch_run(dl_fft_f32_t *handle, float *data, int batch, uint32_t flags);
+
+/**
+ * @brief Execute 16-bit fixed-point FFT transform on a batch of signals. The twiddles are loaded once for all
+ * signals and the bit reversal indices are computed once.
+ * @param handle        FFT instance handle
+ * @param data          Input/output buffer of batch signals, in-place fft calculation
+ * @param batch         Number of signals
+ * @param flags         Bitwise OR of DL_FFT_BATCH_* flags
+ * @param in_exponent   Input data exponent (2^in_exponent scaling factor)
+ * @param out_exponent  Output data exponent of each signal, an array of batch elements
+ * @return esp_err_t    ESP_OK on success, error code otherwise
+ */
+esp_err_t dl_fft_s16_batch_run(
+    dl_fft_s16_t *handle, int16_t *data, int batch, uint32_t flags, int in_exponent, int *out_exponent);
+
+/**
+ * @brief Execute 16-bit fixed-point FFT with high-precision scaling on a batch of signals. Every signal is scaled
+ * on its own, the results are the same as dl_fft_s16_hp_run() on each signal.
+ * @param handle        FFT instance handle
+ * @param data          Input/output buffer of batch signals, in-place fft calculation
+ * @param batch         Number of signals
+ * @param flags         Bitwise OR of DL_FFT_BATCH_* flags
+ * @param in_exponent   Input data exponent (2^in_exponent scaling factor)
+ * @param out_exponent  Output data exponent of each signal, an array of batch elements
+ * @return esp_err_t    ESP_OK on success, error code otherwise
+ */
+esp_err_t dl_fft_s16_hp_batch_run(
+    dl_fft_s16_t *handle, int16_t *data, int batch, uint32_t flags, int in_exponent, int *out_exponent);
+
 #ifdef __cplusplus
 }
 #endif
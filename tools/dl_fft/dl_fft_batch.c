@@ -0,0 +1,269 @@
+#include "dl_fft.h"
+#include "dl_rfft.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+static const char *TAG = "dl fft batch";
+
+// internal flag, select the hp int16 kernels
+#define DL_FFT_BATCH_HP (1u << 31)
+
+/**
+ * @brief Transform the signals [begin, end) of a batch.
+ */
+typedef esp_err_t (*dl_fft_batch_func_t)(
+    void *handle, void *data, int batch, int begin, int end, uint32_t flags, int in_exponent, int *out_exponent);
+
+typedef struct {
+    dl_fft_batch_func_t func;
+    void *handle;
+    void *data;
+    int batch;
+    int begin;
+    int end;
+    uint32_t flags;
+    int in_exponent;
+    int *out_exponent;
+    esp_err_t ret;
+    SemaphoreHandle_t done; /*!< given when the signals of the task are transformed */
+} dl_fft_batch_task_t;
+
+#if portNUM_PROCESSORS > 1
+static void dl_fft_batch_task(void *args)
+{
+    dl_fft_batch_task_t *task = (dl_fft_batch_task_t *)args;
+    task->ret = task->func(task->handle,
+                           task->data,
+                           task->batch,
+                           task->begin,
+                           task->end,
+                           task->flags,
+                           task->in_exponent,
+                           task->out_exponent);
+    xSemaphoreGive(task->done);
+    vTaskDelete(NULL);
+}
+#endif
+
+/**
+ * @brief Run func on the whole batch, or on the first half while a task on the other core runs the second half.
+ */
+static esp_err_t dl_fft_batch_split(dl_fft_batch_func_t func,
+                                    void *handle,
+                                    void *data,
+                                    int batch,
+                                    uint32_t flags,
+                                    int in_exponent,
+                                    int *out_exponent)
+{
+#if portNUM_PROCESSORS > 1
+    if ((flags & DL_FFT_BATCH_DUAL_CORE) && batch > 1) {
+        int half = batch / 2;
+        dl_fft_batch_task_t task = {
+            .func = func,
+            .handle = handle,
+            .data = data,
+            .batch = batch,
+            .begin = half,
+            .end = batch,
+            .flags = flags,
+            .in_exponent = in_exponent,
+            .out_exponent = out_exponent,
+            .ret = ESP_OK,
+            .done = xSemaphoreCreateBinary(),
+        };
+        if (task.done) {
+            BaseType_t core_id = xPortGetCoreID();
+            UBaseType_t priority = uxTaskPriorityGet(NULL);
+            if (xTaskCreatePinnedToCore(
+                    dl_fft_batch_task, "dl_fft_batch", 4096, &task, priority, NULL, (core_id + 1) % 2) == pdPASS) {
+                esp_err_t ret = func(handle, data, batch, 0, half, flags, in_exponent, out_exponent);
+                xSemaphoreTake(task.done, portMAX_DELAY);
+                vSemaphoreDelete(task.done);
+                return ret != ESP_OK ? ret : task.ret;
+            }
+            vSemaphoreDelete(task.done);
+        }
+        ESP_LOGW(TAG, "Failed to create the task on the other core, run the batch on one core");
+    }
+#endif
+    return func(handle, data, batch, 0, batch, flags, in_exponent, out_exponent);
+}
+
+static esp_err_t dl_fft_f32_batch_func(
+    void *handle, void *data, int batch, int begin, int end, uint32_t flags, int in_exponent, int *out_exponent)
+{
+    dl_fft_f32_t *fft = (dl_fft_f32_t *)handle;
+    int fft_point = fft->fft_point;
+    float *x = (float *)data;
+
+    esp_err_t ret = ESP_OK;
+
+    if (!(flags & DL_FFT_BATCH_INTERLEAVED)) {
+        for (int c = begin; c < end && ret == ESP_OK; c++) {
+            ret = dl_fft_f32_run(fft, x + c * fft_point * 2);
+        }
+        return ret;
+    }
+
+    // gather each signal for the optimized single signal kernels, the second half of a batch has its own buffer
+    float *buf = fft->batch_buf + (begin > 0 ? fft_point * 2 : 0);
+    for (int c = begin; c < end && ret == ESP_OK; c++) {
+        for (int i = 0; i < fft_point; i++) {
+            buf[2 * i] = x[2 * (i * batch + c)];
+            buf[2 * i + 1] = x[2 * (i * batch + c) + 1];
+        }
+        ret = dl_fft_f32_run(fft, buf);
+        for (int i = 0; i < fft_point; i++) {
+            x[2 * (i * batch + c)] = buf[2 * i];
+            x[2 * (i * batch + c) + 1] = buf[2 * i + 1];
+        }
+    }
+    return ret;
+}
+
+static esp_err_t dl_rfft_f32_batch_func(
+    void *handle, void *data, int batch, int begin, int end, uint32_t flags, int in_exponent, int *out_exponent)
+{
+    dl_fft_f32_t *fft = (dl_fft_f32_t *)handle;
+    esp_err_t ret = ESP_OK;
+    for (int c = begin; c < end && ret == ESP_OK; c++) {
+        ret = dl_rfft_f32_run(fft, (float *)data + c * fft->fft_point);
+    }
+    return ret;
+}
+
+static esp_err_t dl_fft_s16_batch_func(
+    void *handle, void *data, int batch, int begin, int end, uint32_t flags, int in_exponent, int *out_exponent)
+{
+    dl_fft_s16_t *fft = (dl_fft_s16_t *)handle;
+    int fft_point = fft->fft_point;
+    int istride = (flags & DL_FFT_BATCH_INTERLEAVED) ? batch : 1;
+    int cstride = (flags & DL_FFT_BATCH_INTERLEAVED) ? 1 : fft_point;
+    int16_t *x = (int16_t *)data + begin * cstride * 2;
+
+    if (flags & DL_FFT_BATCH_HP) {
+        dl_fft4r_sc16_hp_batch(x, fft_point, fft->fft_table, end - begin, istride, cstride, out_exponent + begin);
+        for (int c = begin; c < end; c++) {
+            out_exponent[c] += in_exponent;
+        }
+    } else {
+        dl_fft4r_sc16_batch(x, fft_point, fft->fft_table, end - begin, istride, cstride);
+        for (int c = begin; c < end; c++) {
+            out_exponent[c] = in_exponent + fft->log2n;
+        }
+    }
+    dl_bitrev2r_sc16_batch_ansi(x, fft_point, end - begin, istride, cstride);
+    return ESP_OK;
+}
+
+static esp_err_t dl_rfft_s16_batch_func(
+    void *handle, void *data, int batch, int begin, int end, uint32_t flags, int in_exponent, int *out_exponent)
+{
+    dl_fft_s16_t *fft = (dl_fft_s16_t *)handle;
+    int fft_point = fft->fft_point;
+    int cpx_point = fft_point >> 1;
+    int16_t *x = (int16_t *)data + begin * fft_point;
+
+    if (flags & DL_FFT_BATCH_HP) {
+        dl_fft4r_sc16_hp_batch(x, cpx_point, fft->fft_table, end - begin, 1, cpx_point, out_exponent + begin);
+        for (int c = begin; c < end; c++) {
+            out_exponent[c] += in_exponent + 1;
+        }
+    } else {
+        dl_fft4r_sc16_batch(x, cpx_point, fft->fft_table, end - begin, 1, cpx_point);
+        for (int c = begin; c < end; c++) {
+            out_exponent[c] = in_exponent + fft->log2n;
+        }
+    }
+    dl_bitrev2r_sc16_batch_ansi(x, cpx_point, end - begin, 1, cpx_point);
+    for (int c = 0; c < end - begin; c++) {
+        dl_rfft_post_proc_sc16_ansi(x + c * fft_point, cpx_point, fft->rfft_table);
+    }
+    return ESP_OK;
+}
+
+esp_err_t dl_fft_f32_batch_run(dl_fft_f32_t *handle, float *data, int batch, uint32_t flags)
+{
+    if (!handle || !data || batch <= 0) {
+        return ESP_FAIL;
+    }
+    if (handle->plan) {
+        // the mixed-radix and Bluestein plans share one work buffer
+        flags &= ~DL_FFT_BATCH_DUAL_CORE;
+    }
+    if ((flags & DL_FFT_BATCH_INTERLEAVED) && !handle->batch_buf) {
+        handle->batch_buf =
+            (float *)heap_caps_aligned_alloc(16, handle->fft_point * 4 * sizeof(float), MALLOC_CAP_DEFAULT);
+        if (!handle->batch_buf) {
+            ESP_LOGE(TAG, "Failed to allocate FFT buffer");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    return dl_fft_batch_split(dl_fft_f32_batch_func, handle, data, batch, flags, 0, NULL);
+}
+
+esp_err_t dl_rfft_f32_batch_run(dl_fft_f32_t *handle, float *data, int batch, uint32_t flags)
+{
+    if (!handle || !data || batch <= 0) {
+        return ESP_FAIL;
+    }
+    if (flags & DL_FFT_BATCH_INTERLEAVED) {
+        ESP_LOGE(TAG, "Interleaved real signals are not supported");
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (handle->plan) {
+        flags &= ~DL_FFT_BATCH_DUAL_CORE;
+    }
+    return dl_fft_batch_split(dl_rfft_f32_batch_func, handle, data, batch, flags, 0, NULL);
+}
+
+esp_err_t dl_fft_s16_batch_run(
+    dl_fft_s16_t *handle, int16_t *data, int batch, uint32_t flags, int in_exponent, int *out_exponent)
+{
+    if (!handle || !data || !out_exponent || batch <= 0) {
+        return ESP_FAIL;
+    }
+    flags &= ~DL_FFT_BATCH_HP;
+    return dl_fft_batch_split(dl_fft_s16_batch_func, handle, data, batch, flags, in_exponent, out_exponent);
+}
+
+esp_err_t dl_fft_s16_hp_batch_run(
+    dl_fft_s16_t *handle, int16_t *data, int batch, uint32_t flags, int in_exponent, int *out_exponent)
+{
+    if (!handle || !data || !out_exponent || batch <= 0) {
+        return ESP_FAIL;
+    }
+    flags |= DL_FFT_BATCH_HP;
+    return dl_fft_batch_split(dl_fft_s16_batch_func, handle, data, batch, flags, in_exponent, out_exponent);
+}
+
+esp_err_t dl_rfft_s16_batch_run(
+    dl_fft_s16_t *handle, int16_t *data, int batch, uint32_t flags, int in_exponent, int *out_exponent)
+{
+    if (!handle || !data || !out_exponent || batch <= 0) {
+        return ESP_FAIL;
+    }
+    if (flags & DL_FFT_BATCH_INTERLEAVED) {
+        ESP_LOGE(TAG, "Interleaved real signals are not supported");
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    flags &= ~DL_FFT_BATCH_HP;
+    return dl_fft_batch_split(dl_rfft_s16_batch_func, handle, data, batch, flags, in_exponent, out_exponent);
+}
+
+esp_err_t dl_rfft_s16_hp_batch_run(
+    dl_fft_s16_t *handle, int16_t *data, int batch, uint32_t flags, int in_exponent, int *out_exponent)
+{
+    if (!handle || !data || !out_exponent || batch <= 0) {
+        return ESP_FAIL;
+    }
+    if (flags & DL_FFT_BATCH_INTERLEAVED) {
+        ESP_LOGE(TAG, "Interleaved real signals are not supported");
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    flags |= DL_FFT_BATCH_HP;
+    return dl_fft_batch_split(dl_rfft_s16_batch_func, handle, data, batch, flags, in_exponent, out_exponent);
+}
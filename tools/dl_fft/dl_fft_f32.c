@@ -8,8 +8,8 @@ static const char *TAG = "dl fft";
 // Create a new FFT handle
 dl_fft_f32_t *dl_fft_f32_init(int fft_point, uint32_t caps)
 {
-    if (!dl_is_power_of_two(fft_point)) {
-        ESP_LOGE(TAG, "FFT point must be power of two");
+    if (fft_point < 2) {
+        ESP_LOGE(TAG, "FFT point must be at least 2");
         return NULL;
     }
 
@@ -21,9 +21,21 @@ dl_fft_f32_t *dl_fft_f32_init(int fft_point, uint32_t caps)
     handle->fft_table = NULL;
     handle->rfft_table = NULL;
     handle->bitrev_table = NULL;
+    handle->plan = NULL;
+    handle->batch_buf = NULL;
     handle->fft_point = fft_point;
     handle->log2n = dl_power_of_two(fft_point);
 
+    if (!dl_is_power_of_two(fft_point)) {
+        handle->plan = dl_gen_fft_plan_fc32(fft_point, caps);
+        if (!handle->plan) {
+            ESP_LOGE(TAG, "Failed to generate FFT plan");
+            dl_fft_f32_deinit(handle);
+            return NULL;
+        }
+        return handle;
+    }
+
     // Allocate and generate FFT table
     handle->fft_table = dl_gen_fftr2_table_f32(fft_point, caps);
     if (!handle->fft_table) {
@@ -49,6 +61,10 @@ void dl_fft_f32_deinit(dl_fft_f32_t *handle)
         if (handle->bitrev_table) {
             free(handle->bitrev_table);
         }
+        dl_free_fft_plan_fc32(handle->plan);
+        if (handle->batch_buf) {
+            heap_caps_free(handle->batch_buf);
+        }
         free(handle);
     }
 }
@@ -61,6 +77,9 @@ esp_err_t dl_fft_f32_run(dl_fft_f32_t *handle, float *data)
     }
 
     int fft_point = handle->fft_point;
+    if (handle->plan) {
+        return dl_fft_plan_fc32_ansi(handle->plan, data);
+    }
     dl_fft2r_fc32(data, fft_point, handle->fft_table);
     dl_bitrev2r_fc32_ansi(data, fft_point, handle->bitrev_table, handle->bitrev_size);
 
@@ -76,8 +95,12 @@ esp_err_t dl_ifft_f32_run(dl_fft_f32_t *handle, float *data)
     int fft_point = handle->fft_point;
     float scale = 1.0f / fft_point;
 
-    dl_ifft2r_fc32(data, fft_point, handle->fft_table);
-    dl_bitrev2r_fc32_ansi(data, fft_point, handle->bitrev_table, handle->bitrev_size);
+    if (handle->plan) {
+        dl_ifft_plan_fc32_ansi(handle->plan, data);
+    } else {
+        dl_ifft2r_fc32(data, fft_point, handle->fft_table);
+        dl_bitrev2r_fc32_ansi(data, fft_point, handle->bitrev_table, handle->bitrev_size);
+    }
 
     // Scale by 1/N
     for (int i = 0; i < fft_point * 2; i++) {
@@ -24,7 +24,7 @@ dl_fft_s16_t *dl_fft_s16_init(int fft_point, uint32_t caps)
     handle->log2n = dl_power_of_two(fft_point);
 
     // Allocate and generate FFT table
-    handle->fft_table = dl_gen_fft_table_sc16(fft_point, caps);
+    handle->fft_table = dl_gen_fft4r_table_sc16(fft_point, caps);
     if (!handle->fft_table) {
         ESP_LOGE(TAG, "Failed to generate FFT table");
         dl_fft_s16_deinit(handle);
@@ -53,7 +53,7 @@ esp_err_t dl_fft_s16_run(dl_fft_s16_t *handle, int16_t *data, int in_exponent, i
     }
 
     int fft_point = handle->fft_point;
-    dl_fft2r_sc16(data, fft_point, handle->fft_table);
+    dl_fft4r_sc16(data, fft_point, handle->fft_table);
     dl_bitrev2r_sc16_ansi(data, fft_point);
     out_exponent[0] = in_exponent + handle->log2n;
 
@@ -67,7 +67,7 @@ esp_err_t dl_ifft_s16_run(dl_fft_s16_t *handle, int16_t *data, int in_exponent,
     }
 
     int fft_point = handle->fft_point;
-    dl_ifft2r_sc16(data, fft_point, handle->fft_table);
+    dl_ifft4r_sc16(data, fft_point, handle->fft_table);
     dl_bitrev2r_sc16_ansi(data, fft_point);
 
     out_exponent[0] = in_exponent;
@@ -83,7 +83,7 @@ esp_err_t dl_fft_s16_hp_run(dl_fft_s16_t *handle, int16_t *data, int in_exponent
 
     int fft_point = handle->fft_point;
     out_exponent[0] = 0;
-    dl_fft2r_sc16_hp(data, fft_point, handle->fft_table, out_exponent);
+    dl_fft4r_sc16_hp(data, fft_point, handle->fft_table, out_exponent);
     dl_bitrev2r_sc16_ansi(data, fft_point);
     out_exponent[0] = in_exponent + out_exponent[0];
 
@@ -98,9 +98,69 @@ esp_err_t dl_ifft_s16_hp_run(dl_fft_s16_t *handle, int16_t *data, int in_exponen
 
     int fft_point = handle->fft_point;
     out_exponent[0] = 0;
-    dl_ifft2r_sc16_hp(data, fft_point, handle->fft_table, out_exponent);
+    dl_ifft4r_sc16_hp(data, fft_point, handle->fft_table, out_exponent);
     dl_bitrev2r_sc16_ansi(data, fft_point);
     out_exponent[0] = in_exponent + out_exponent[0] - handle->log2n;
 
     return ESP_OK;
 }
+
+esp_err_t dl_fft_s16_oop_run(dl_fft_s16_t *handle, int16_t *data, int16_t *out, int in_exponent, int *out_exponent)
+{
+    if (!handle || !data || !out) {
+        return ESP_FAIL;
+    }
+    if (out == data) {
+        return dl_fft_s16_run(handle, data, in_exponent, out_exponent);
+    }
+
+    dl_fft4r_sc16_oop(data, out, handle->fft_point, handle->fft_table);
+    out_exponent[0] = in_exponent + handle->log2n;
+
+    return ESP_OK;
+}
+
+esp_err_t dl_ifft_s16_oop_run(dl_fft_s16_t *handle, int16_t *data, int16_t *out, int in_exponent, int *out_exponent)
+{
+    if (!handle || !data || !out) {
+        return ESP_FAIL;
+    }
+    if (out == data) {
+        return dl_ifft_s16_run(handle, data, in_exponent, out_exponent);
+    }
+
+    dl_ifft4r_sc16_oop(data, out, handle->fft_point, handle->fft_table);
+    out_exponent[0] = in_exponent;
+
+    return ESP_OK;
+}
+
+esp_err_t dl_fft_s16_hp_oop_run(dl_fft_s16_t *handle, int16_t *data, int16_t *out, int in_exponent, int *out_exponent)
+{
+    if (!handle || !data || !out) {
+        return ESP_FAIL;
+    }
+    if (out == data) {
+        return dl_fft_s16_hp_run(handle, data, in_exponent, out_exponent);
+    }
+
+    dl_fft4r_sc16_hp_oop(data, out, handle->fft_point, handle->fft_table, out_exponent);
+    out_exponent[0] = in_exponent + out_exponent[0];
+
+    return ESP_OK;
+}
+
+esp_err_t dl_ifft_s16_hp_oop_run(dl_fft_s16_t *handle, int16_t *data, int16_t *out, int in_exponent, int *out_exponent)
+{
+    if (!handle || !data || !out) {
+        return ESP_FAIL;
+    }
+    if (out == data) {
+        return dl_ifft_s16_hp_run(handle, data, in_exponent, out_exponent);
+    }
+
+    dl_ifft4r_sc16_hp_oop(data, out, handle->fft_point, handle->fft_table, out_exponent);
+    out_exponent[0] = in_exponent + out_exponent[0] - handle->log2n;
+
+    return ESP_OK;
+}
@@ -18,7 +18,8 @@ symmetry x[0] = real part of DC component x[1] = real part of fft_point/2 compon
 
 /**
  * @brief Initialize a single-precision floating-point real FFT instance
- * @param fft_point  Number of FFT points (must be power of two)
+ * @param fft_point  Number of FFT points, must be even. If it is not a power of two, e.g. a 400 or 480 sample window,
+ *                   the complex FFT of fft_point / 2 points uses a mixed-radix or Bluestein plan.
  * @param caps       Configuration flags for memory allocation, same with esp-idf heap_caps_malloc
  *                   (e.g., MALLOC_CAP_8BIT, MALLOC_CAP_INTERNAL, MALLOC_CAP_SPIRAM)
  * @return dl_fft_f32_t*  Handle to FFT instance
@@ -141,6 +142,43 @@ esp_err_t dl_irfft_s16_run(dl_fft_s16_t *handle, int16_t *data, int in_exponent,
  * @return esp_err_t    ESP_OK on success, error code otherwise
  */
 esp_err_t dl_irfft_s16_hp_run(dl_fft_s16_t *handle, int16_t *data, int in_exponent, int *out_exponent);
+
+/**
+ * @brief Execute single-precision floating-point real FFT transform on a batch of planar signals
+ * @param handle  FFT instance handle
+ * @param data    Input/output buffer of batch signals stored one after the other, in-place fft calculation
+ * @param batch   Number of signals
+ * @param flags   DL_FFT_BATCH_DUAL_CORE or 0, DL_FFT_BATCH_INTERLEAVED is not supported for real signals
+ * @return esp_err_t  ESP_OK on success, error code otherwise
+ */
+esp_err_t dl_rfft_f32_batch_run(dl_fft_f32_t *handle, float *data, int batch, uint32_t flags);
+
+/**
+ * @brief Execute 16-bit fixed-point real FFT transform on a batch of planar signals
+ * @param handle        FFT instance handle
+ * @param data          Input/output buffer of batch signals stored one after the other, in-place fft calculation
+ * @param batch         Number of signals
+ * @param flags         DL_FFT_BATCH_DUAL_CORE or 0, DL_FFT_BATCH_INTERLEAVED is not supported for real signals
+ * @param in_exponent   Input data exponent (2^in_exponent scaling factor)
+ * @param out_exponent  Output data exponent of each signal, an array of batch elements
+ * @return esp_err_t    ESP_OK on success, error code otherwise
+ */
+esp_err_t dl_rfft_s16_batch_run(
+    dl_fft_s16_t *handle, int16_t *data, int batch, uint32_t flags, int in_exponent, int *out_exponent);
+
+/**
+ * @brief Execute 16-bit fixed-point real FFT with high-precision scaling on a batch of planar signals. The results
+ * are the same as dl_rfft_s16_hp_run() on each signal.
+ * @param handle        FFT instance handle
+ * @param data          Input/output buffer of batch signals stored one after the other, in-place fft calculation
+ * @param batch         Number of signals
+ * @param flags         DL_FFT_BATCH_DUAL_CORE or 0, DL_FFT_BATCH_INTERLEAVED is not supported for real signals
+ * @param in_exponent   Input data exponent (2^in_exponent scaling factor)
+ * @param out_exponent  Output data exponent of each signal, an array of batch elements
+ * @return esp_err_t    ESP_OK on success, error code otherwise
+ */
+esp_err_t dl_rfft_s16_hp_batch_run(
+    dl_fft_s16_t *handle, int16_t *data, int batch, uint32_t flags, int in_exponent, int *out_exponent);
 #ifdef __cplusplus
 }
 #endif
@@ -8,8 +8,8 @@ static const char *TAG = "dl rfft";
 
 dl_fft_f32_t *dl_rfft_f32_init(int fft_point, uint32_t caps)
 {
-    if (!dl_is_power_of_two(fft_point)) {
-        ESP_LOGE(TAG, "FFT point must be power of two");
+    if (fft_point < 2 || fft_point % 2 != 0) {
+        ESP_LOGE(TAG, "FFT point must be even");
         return NULL;
     }
 
@@ -21,6 +21,8 @@ dl_fft_f32_t *dl_rfft_f32_init(int fft_point, uint32_t caps)
     handle->fft_table = NULL;
     handle->rfft_table = NULL;
     handle->bitrev_table = NULL;
+    handle->plan = NULL;
+    handle->batch_buf = NULL;
     handle->fft_point = fft_point;
     handle->log2n = dl_power_of_two(fft_point);
 
@@ -32,7 +34,15 @@ dl_fft_f32_t *dl_rfft_f32_init(int fft_point, uint32_t caps)
         return NULL;
     }
 
-    if (handle->log2n % 2 == 1) {
+    if (!dl_is_power_of_two(fft_point)) {
+        // complex fft of fft_point / 2 points
+        handle->plan = dl_gen_fft_plan_fc32(fft_point >> 1, caps);
+        if (!handle->plan) {
+            ESP_LOGE(TAG, "Failed to generate FFT plan");
+            dl_rfft_f32_deinit(handle);
+            return NULL;
+        }
+    } else if (handle->log2n % 2 == 1) {
         handle->bitrev_table = dl_gen_bitrev4r_table(fft_point, caps, &handle->bitrev_size);
         handle->fft_table = dl_gen_fft4r_table_f32(fft_point, caps);
         if (!handle->fft_table) {
@@ -65,6 +75,10 @@ void dl_rfft_f32_deinit(dl_fft_f32_t *handle)
         if (handle->bitrev_table) {
             free(handle->bitrev_table);
         }
+        dl_free_fft_plan_fc32(handle->plan);
+        if (handle->batch_buf) {
+            heap_caps_free(handle->batch_buf);
+        }
         free(handle);
     }
 }
@@ -77,7 +91,9 @@ esp_err_t dl_rfft_f32_run(dl_fft_f32_t *handle, float *data)
     float *fft_table = handle->fft_table;
     float *rfft_table = handle->rfft_table;
 
-    if (handle->log2n % 2 == 1) {
+    if (handle->plan) {
+        dl_fft_plan_fc32_ansi(handle->plan, data);
+    } else if (handle->log2n % 2 == 1) {
         dl_fft4r_fc32(data, fft_point >> 1, fft_table, fft_point);
         dl_bitrev4r_fc32_ansi(data, fft_point >> 1, handle->bitrev_table, handle->bitrev_size);
     } else {
@@ -103,7 +119,9 @@ esp_err_t dl_irfft_f32_run(dl_fft_f32_t *handle, float *data)
 
     dl_rfft_pre_proc_fc32_ansi(data, fft_point >> 1, rfft_table);
 
-    if (handle->log2n % 2 == 1) {
+    if (handle->plan) {
+        dl_ifft_plan_fc32_ansi(handle->plan, data);
+    } else if (handle->log2n % 2 == 1) {
         dl_ifft4r_fc32(data, fft_point >> 1, fft_table, fft_point);
         dl_bitrev4r_fc32_ansi(data, fft_point >> 1, handle->bitrev_table, handle->bitrev_size);
     } else {
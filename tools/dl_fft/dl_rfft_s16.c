@@ -26,7 +26,7 @@ dl_fft_s16_t *dl_rfft_s16_init(int fft_point, uint32_t caps)
     }
 
     // fft table
-    handle->fft_table = dl_gen_fft_table_sc16(fft_point >> 1, caps);
+    handle->fft_table = dl_gen_fft4r_table_sc16(fft_point >> 1, caps);
     if (!handle->fft_table) {
         ESP_LOGE(TAG, "Failed to generate FFT table");
         dl_rfft_s16_deinit(handle);
@@ -58,7 +58,7 @@ esp_err_t dl_rfft_s16_run(dl_fft_s16_t *handle, int16_t *data, int in_exponent,
     }
 
     int cpx_point = handle->fft_point >> 1;
-    dl_fft2r_sc16(data, cpx_point, handle->fft_table);
+    dl_fft4r_sc16(data, cpx_point, handle->fft_table);
     dl_bitrev2r_sc16_ansi(data, cpx_point);
     dl_rfft_post_proc_sc16_ansi(data, cpx_point, handle->rfft_table);
     out_exponent[0] = in_exponent + handle->log2n;
@@ -74,7 +74,7 @@ esp_err_t dl_rfft_s16_hp_run(dl_fft_s16_t *handle, int16_t *data, int in_exponen
 
     int cpx_point = handle->fft_point >> 1;
     out_exponent[0] = 0;
-    dl_fft2r_sc16_hp(data, cpx_point, handle->fft_table, out_exponent);
+    dl_fft4r_sc16_hp(data, cpx_point, handle->fft_table, out_exponent);
     dl_bitrev2r_sc16_ansi(data, cpx_point);
     dl_rfft_post_proc_sc16_ansi(data, cpx_point, handle->rfft_table);
     out_exponent[0] = in_exponent + out_exponent[0] + 1;
@@ -92,7 +92,7 @@ esp_err_t dl_irfft_s16_run(dl_fft_s16_t *handle, int16_t *data, int in_exponent,
     out_exponent[0] = 0;
 
     dl_rfft_pre_proc_sc16_ansi(data, cpx_point, handle->rfft_table);
-    dl_ifft2r_sc16(data, cpx_point, handle->fft_table);
+    dl_ifft4r_sc16(data, cpx_point, handle->fft_table);
     dl_bitrev2r_sc16_ansi(data, cpx_point);
 
     out_exponent[0] = in_exponent + 1;
@@ -110,7 +110,7 @@ esp_err_t dl_irfft_s16_hp_run(dl_fft_s16_t *handle, int16_t *data, int in_expone
     out_exponent[0] = 0;
 
     dl_rfft_pre_proc_sc16_ansi(data, cpx_point, handle->rfft_table);
-    dl_ifft2r_sc16_hp(data, cpx_point, handle->fft_table, out_exponent);
+    dl_ifft4r_sc16_hp(data, cpx_point, handle->fft_table, out_exponent);
     dl_bitrev2r_sc16_ansi(data, cpx_point);
 
     out_exponent[0] = in_exponent + out_exponent[0] + 2 - handle->log2n;
@@ -0,0 +1,201 @@
+#include "dl_vad.h"
+#include "esp_log.h"
+#include <math.h>
+#include <string.h>
+
+static const char *TAG = "dl vad";
+
+// 10 * log10(2), dB of one unit of log2
+#define DL_VAD_DB_PER_LOG2 3.0103f
+
+/**
+ * @brief Voice activity detector instance structure. The features and thresholds are log2 values in Q16.
+ */
+struct dl_vad_s {
+    dl_vad_config_t config;
+    int num_bins;           /*!< fft_point / 2 + 1 */
+    int band_start;         /*!< first bin of the band */
+    int band_len;           /*!< number of bins of the band */
+    int32_t log2_band_len;  /*!< log2(band_len) */
+    int32_t margin;         /*!< energy_margin_db */
+    int32_t min_energy;     /*!< min_energy_db */
+    int32_t max_flatness;   /*!< log2(flatness_threshold) */
+    int32_t noise_rise;     /*!< noise_rise_db */
+    int32_t energy;         /*!< band energy of the last frame */
+    int32_t flatness;       /*!< log2 of the spectral flatness of the last frame */
+    int32_t noise_floor;    /*!< noise floor, valid if noise_valid */
+    bool noise_valid;       /*!< whether the noise floor was initialized by a frame */
+    bool open;              /*!< gate state */
+    bool open_since_check;  /*!< whether the gate was open after a frame since the last dl_vad_check() */
+    int onset;              /*!< consecutive active frames while the gate is closed */
+    int hangover;           /*!< frames left before the gate closes */
+    dl_vad_stats_t stats;
+};
+
+static inline int32_t dl_vad_db_to_q16(float db)
+{
+    return (int32_t)lroundf(db / DL_VAD_DB_PER_LOG2 * 65536.0f);
+}
+
+dl_vad_t *dl_vad_init(const dl_vad_config_t *config, uint32_t caps)
+{
+    float high_freq = config->high_freq > 0 ? config->high_freq : config->sample_rate * 0.5f;
+    if (config->sample_rate <= 0 || config->fft_point < 2 || config->fft_point % 2 != 0 || config->low_freq < 0 ||
+        high_freq > config->sample_rate * 0.5f || config->low_freq >= high_freq || config->flatness_threshold <= 0 ||
+        config->noise_rise_db < 0 || config->onset_frames < 1 || config->hangover_frames < 0) {
+        ESP_LOGE(TAG, "Invalid vad config");
+        return NULL;
+    }
+
+    dl_vad_t *handle = (dl_vad_t *)heap_caps_calloc(1, sizeof(dl_vad_t), caps);
+    if (!handle) {
+        ESP_LOGE(TAG, "Failed to allocate vad handle");
+        return NULL;
+    }
+    handle->config = *config;
+    handle->num_bins = config->fft_point / 2 + 1;
+
+    // the band without the dc bin
+    float bin_freq = (float)config->sample_rate / config->fft_point;
+    int start = (int)ceilf(config->low_freq / bin_freq);
+    int end = (int)floorf(high_freq / bin_freq);
+    start = start > 1 ? start : 1;
+    end = end < handle->num_bins - 1 ? end : handle->num_bins - 1;
+    if (end < start) {
+        ESP_LOGE(TAG, "No fft bin in the band, increase fft point");
+        heap_caps_free(handle);
+        return NULL;
+    }
+    handle->band_start = start;
+    handle->band_len = end - start + 1;
+    handle->log2_band_len = dl_log2_u64_q16(handle->band_len);
+
+    handle->margin = dl_vad_db_to_q16(config->energy_margin_db);
+    handle->min_energy = dl_vad_db_to_q16(config->min_energy_db);
+    handle->max_flatness = (int32_t)lroundf(log2f(config->flatness_threshold) * 65536.0f);
+    handle->noise_rise = dl_vad_db_to_q16(config->noise_rise_db);
+    return handle;
+}
+
+void dl_vad_deinit(dl_vad_t *handle)
+{
+    if (handle) {
+        heap_caps_free(handle);
+    }
+}
+
+/**
+ * @brief Track the noise floor and run the gate on the features of a frame.
+ */
+static bool dl_vad_update(dl_vad_t *handle)
+{
+    const dl_vad_config_t *config = &handle->config;
+    if (!handle->noise_valid || handle->energy < handle->noise_floor) {
+        handle->noise_floor = handle->energy;
+        handle->noise_valid = true;
+    } else {
+        int32_t floor = handle->noise_floor + handle->noise_rise;
+        handle->noise_floor = floor < handle->energy ? floor : handle->energy;
+    }
+
+    bool active = handle->energy > handle->noise_floor + handle->margin && handle->energy > handle->min_energy &&
+        handle->flatness <= handle->max_flatness;
+    if (active) {
+        handle->hangover = config->hangover_frames;
+        if (!handle->open && ++handle->onset >= config->onset_frames) {
+            handle->open = true;
+            handle->stats.segments++;
+        }
+    } else {
+        handle->onset = 0;
+        if (handle->open) {
+            if (handle->hangover > 0) {
+                handle->hangover--;
+            } else {
+                handle->open = false;
+            }
+        }
+    }
+
+    handle->stats.frames++;
+    if (handle->open) {
+        handle->stats.active_frames++;
+        handle->open_since_check = true;
+    }
+    return handle->open;
+}
+
+bool dl_vad_process_f32(dl_vad_t *handle, const float *power)
+{
+    const float *p = power + handle->band_start;
+    int len = handle->band_len;
+    float sum = 0, log_sum = 0;
+    for (int k = 0; k < len; k++) {
+        sum += p[k];
+        log_sum += log2f(p[k] > 1e-20f ? p[k] : 1e-20f);
+    }
+    float log2_energy = log2f(sum > 1e-20f ? sum : 1e-20f);
+    // flatness = geometric mean / arithmetic mean
+    float log2_flatness = log_sum / len - log2_energy + handle->log2_band_len / 65536.0f;
+    handle->energy = (int32_t)lroundf(log2_energy * 65536.0f);
+    handle->flatness = (int32_t)lroundf(log2_flatness * 65536.0f);
+    return dl_vad_update(handle);
+}
+
+bool dl_vad_process_s16(dl_vad_t *handle, const uint32_t *power, int exponent)
+{
+    const uint32_t *p = power + handle->band_start;
+    int len = handle->band_len;
+    uint64_t sum = 0;
+    int64_t log_sum = 0;
+    for (int k = 0; k < len; k++) {
+        sum += p[k];
+        log_sum += dl_log2_u64_q16(p[k] | 1);
+    }
+    int32_t log2_sum = dl_log2_u64_q16(sum | 1);
+    handle->energy = log2_sum + exponent * 65536;
+    handle->flatness = (int32_t)(log_sum / len) - log2_sum + handle->log2_band_len;
+    return dl_vad_update(handle);
+}
+
+bool dl_vad_check(dl_vad_t *handle)
+{
+    bool run = handle->open_since_check;
+    handle->open_since_check = handle->open;
+    handle->stats.checks++;
+    if (!run) {
+        handle->stats.skipped_checks++;
+    }
+    return run;
+}
+
+void dl_vad_reset(dl_vad_t *handle)
+{
+    if (handle) {
+        handle->noise_valid = false;
+        handle->open = false;
+        handle->open_since_check = false;
+        handle->onset = 0;
+        handle->hangover = 0;
+    }
+}
+
+void dl_vad_get_stats(dl_vad_t *handle, dl_vad_stats_t *stats)
+{
+    *stats = handle->stats;
+    stats->energy_db = handle->energy / 65536.0f * DL_VAD_DB_PER_LOG2;
+    stats->flatness = exp2f(handle->flatness / 65536.0f);
+    stats->noise_floor_db = handle->noise_floor / 65536.0f * DL_VAD_DB_PER_LOG2;
+}
+
+void dl_vad_reset_stats(dl_vad_t *handle)
+{
+    if (handle) {
+        memset(&handle->stats, 0, sizeof(dl_vad_stats_t));
+    }
+}
+
+int dl_vad_get_num_bins(dl_vad_t *handle)
+{
+    return handle->num_bins;
+}
@@ -0,0 +1,132 @@
+#pragma once
+#include "dl_rfft.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Energy and spectral flatness voice activity detector configuration
+ */
+typedef struct {
+    int sample_rate;          /*!< sample rate of the signal in Hz */
+    int fft_point;            /*!< rfft length of the power spectra, fft_point / 2 + 1 bins */
+    float low_freq;           /*!< lower edge of the band of the features in Hz */
+    float high_freq;          /*!< upper edge of the band of the features in Hz, 0 selects sample_rate / 2 */
+    float energy_margin_db;   /*!< a frame is active if its band energy is this much above the noise floor */
+    float min_energy_db;      /*!< and above this absolute band energy */
+    float flatness_threshold; /*!< and its spectral flatness is below this, in (0, 1], 1 disables the check */
+    float noise_rise_db;      /*!< the noise floor follows a rising energy by this much per frame, a falling one
+                                   at once */
+    int onset_frames;         /*!< consecutive active frames which open the gate */
+    int hangover_frames;      /*!< frames the gate stays open after the last active frame */
+} dl_vad_config_t;
+
+/**
+ * The band energy is in dB of the power spectrum of dl_fbank, whose samples are scaled to [-1, 1): a full scale sine
+ * in a 400 sample hann window is about 40 dB. White noise has a spectral flatness of about 0.56, about 0.33 after the
+ * pre-emphasis of dl_fbank, voiced speech and tones much less.
+ */
+#define DL_VAD_DEFAULT_CONFIG()      \
+    {                                \
+        .sample_rate = 16000,        \
+        .fft_point = 512,            \
+        .low_freq = 300,             \
+        .high_freq = 4000,           \
+        .energy_margin_db = 9,       \
+        .min_energy_db = -30,        \
+        .flatness_threshold = 0.2f,  \
+        .noise_rise_db = 0.05f,      \
+        .onset_frames = 2,           \
+        .hangover_frames = 20,       \
+    }
+
+/**
+ * @brief Statistics of a voice activity detector since dl_vad_init() or dl_vad_reset_stats()
+ */
+typedef struct {
+    uint32_t frames;         /*!< processed frames */
+    uint32_t active_frames;  /*!< frames after which the gate was open, frames - active_frames were skipped */
+    uint32_t segments;       /*!< times the gate opened */
+    uint32_t checks;         /*!< calls of dl_vad_check(), e.g. steps of the streaming model */
+    uint32_t skipped_checks; /*!< calls of dl_vad_check() which returned false, e.g. skipped model runs */
+    float energy_db;         /*!< band energy of the last frame */
+    float flatness;          /*!< spectral flatness of the last frame */
+    float noise_floor_db;    /*!< noise floor after the last frame */
+} dl_vad_stats_t;
+
+/**
+ * @brief Voice activity detector instance
+ */
+typedef struct dl_vad_s dl_vad_t;
+
+/**
+ * @brief Initialize a voice activity detector, which gates a streaming model on the band energy and the spectral
+ * flatness of the power spectrum of each frame.
+ * @param config  Detector configuration
+ * @param caps    Configuration flags for memory allocation, same with esp-idf heap_caps_malloc
+ * @return dl_vad_t*  Handle to detector instance, NULL if the configuration is invalid or allocation failed
+ */
+dl_vad_t *dl_vad_init(const dl_vad_config_t *config, uint32_t caps);
+
+/**
+ * @brief Deinitialize a voice activity detector
+ * @param handle  Detector instance handle created by dl_vad_init()
+ */
+void dl_vad_deinit(dl_vad_t *handle);
+
+/**
+ * @brief Process the float power spectrum of a frame, e.g. |X[k]|^2 of dl_rfft_f32_run()
+ * @param handle  Detector instance handle
+ * @param power   fft_point / 2 + 1 power spectrum bins
+ * @return bool   Whether the gate is open after this frame
+ */
+bool dl_vad_process_f32(dl_vad_t *handle, const float *power);
+
+/**
+ * @brief Process the fixed point power spectrum of a frame, the power of bin k is power[k] * 2^exponent. Only
+ * integer arithmetic is used, for chips without fpu.
+ * @param handle    Detector instance handle
+ * @param power     fft_point / 2 + 1 power spectrum bins
+ * @param exponent  Exponent of power, e.g. 2 * the output exponent of dl_rfft_s16_hp_run()
+ * @return bool     Whether the gate is open after this frame
+ */
+bool dl_vad_process_s16(dl_vad_t *handle, const uint32_t *power, int exponent);
+
+/**
+ * @brief Whether the gate was open after any frame since the last call, i.e. whether the streaming model should run
+ * on the frames pushed since its last step. Call it once per step of the model.
+ * @param handle  Detector instance handle
+ * @return bool   true to run the model, false to skip the run
+ */
+bool dl_vad_check(dl_vad_t *handle);
+
+/**
+ * @brief Close the gate and learn the noise floor again from the next frame. The statistics are kept.
+ * @param handle  Detector instance handle
+ */
+void dl_vad_reset(dl_vad_t *handle);
+
+/**
+ * @brief Get the statistics
+ * @param handle  Detector instance handle
+ * @param stats   Output statistics
+ */
+void dl_vad_get_stats(dl_vad_t *handle, dl_vad_stats_t *stats);
+
+/**
+ * @brief Zero the counters of the statistics
+ * @param handle  Detector instance handle
+ */
+void dl_vad_reset_stats(dl_vad_t *handle);
+
+/**
+ * @brief Get the number of power spectrum bins of a frame
+ * @param handle  Detector instance handle
+ * @return int    fft_point / 2 + 1
+ */
+int dl_vad_get_num_bins(dl_vad_t *handle);
+
+#ifdef __cplusplus
+}
+#endif
@@ -126,3 +126,104 @@ def REVERSESEQUENCE_TEST(config) -> ModelProto:
     print("The model is checked!")
 
     return model_def
+
+
+def NONMAXSUPPRESSION_TEST(config) -> ModelProto:
+    """
+    NonMaxSuppression operator
+
+    Inputs
+    input (heterogeneous) - T:
+        Tensor [1, N, 5], split into boxes [1, N, 4] and scores [1, 1, N].
+
+    Outputs
+    selected_indices (heterogeneous) - tensor(int64):
+        Selected indices [num_selected_indices, 3]. ESP-DL pads them with -1 to
+        [max_output_boxes_per_class, 3].
+    """
+
+    input_shape = config["input_shape"]
+    max_output_boxes_per_class = config["max_output_boxes_per_class"]
+    iou_threshold = config["iou_threshold"]
+    score_threshold = config["score_threshold"]
+    export_name_prefix = config.get("export_name_prefix", "onnx-model")
+    num_boxes = input_shape[1]
+
+    # Create value info
+    input_tensor = helper.make_tensor_value_info(
+        "input", TensorProto.FLOAT, input_shape
+    )
+    output_tensor = helper.make_tensor_value_info(
+        "selected_indices", TensorProto.INT64, [None, 3]
+    )
+
+    # Create constant initializers
+    split_tensor = helper.make_tensor(
+        name="split", data_type=TensorProto.INT64, dims=[2], vals=[4, 1]
+    )
+    max_output_tensor = helper.make_tensor(
+        name="max_output_boxes_per_class",
+        data_type=TensorProto.INT64,
+        dims=[1],
+        vals=[max_output_boxes_per_class],
+    )
+    iou_threshold_tensor = helper.make_tensor(
+        name="iou_threshold",
+        data_type=TensorProto.FLOAT,
+        dims=[1],
+        vals=[iou_threshold],
+    )
+    score_threshold_tensor = helper.make_tensor(
+        name="score_threshold",
+        data_type=TensorProto.FLOAT,
+        dims=[1],
+        vals=[score_threshold],
+    )
+
+    split_node = helper.make_node(
+        "Split",
+        inputs=["input", "split"],
+        outputs=["boxes", "box_scores"],
+        axis=2,
+    )
+    transpose_node = helper.make_node(
+        "Transpose",
+        inputs=["box_scores"],
+        outputs=["scores"],
+        perm=[0, 2, 1],
+    )
+    nms_node = helper.make_node(
+        "NonMaxSuppression",
+        inputs=[
+            "boxes",
+            "scores",
+            "max_output_boxes_per_class",
+            "iou_threshold",
+            "score_threshold",
+        ],
+        outputs=["selected_indices"],
+        center_point_box=0,
+    )
+
+    # Create GraphProto
+    graph_def = helper.make_graph(
+        [split_node, transpose_node, nms_node],
+        "non_max_suppression_model",
+        [input_tensor],
+        [output_tensor],
+        initializer=[
+            split_tensor,
+            max_output_tensor,
+            iou_threshold_tensor,
+            score_threshold_tensor,
+        ],
+    )
+
+    # Create ModelProto
+    model_def = helper.make_model(graph_def, producer_name=export_name_prefix)
+
+    # Check model
+    onnx.checker.check_model(model_def)
+    print("The model is checked!")
+
+    return model_def